@@ -0,0 +1,158 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_BENCH_H_
+#define PIPEBB_BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+namespace pipebb {
+namespace bench {
+
+
+/*!
+ * \brief Keeps the compiler from optimizing away the computation of `value`.
+ */
+template <typename T>
+inline void do_not_optimize(const T & value) noexcept {
+  __asm__ __volatile__("" : : "r"(&value) : "memory");
+}
+
+
+/*!
+ * \brief Result of a single benchmark run.
+ */
+struct result
+{
+  std::string gate;
+  std::string config;
+  std::size_t samples;
+  double      ns_per_sample;
+
+  double samples_per_second() const noexcept { return 1.0e9 / ns_per_sample; }
+};
+
+
+/*!
+ * \brief   Time `body(samples)` and return the best of several repetitions.
+ * \param   gate Name of the measured gate or container.
+ * \param   config Free form description of the measured configuration.
+ * \param   samples Number of samples `body` processes per repetition.
+ * \param   body Callable processing the given number of samples.
+ * \returns Benchmark result, normalized to one sample.
+ */
+template <class F>
+inline result measure(std::string gate,
+                      std::string config,
+                      std::size_t samples,
+                      F &&        body,
+                      unsigned    repetitions = 5) {
+  using clock_t = std::chrono::steady_clock;
+
+  // warm up caches and branch predictors
+  body(samples / 10 + 1);
+
+  double best = std::numeric_limits<double>::max();
+  for (unsigned i = 0; i < repetitions; ++i) {
+    auto start = clock_t::now();
+    body(samples);
+    auto stop = clock_t::now();
+
+    best = std::min(
+      best, std::chrono::duration<double, std::nano>(stop - start).count());
+  }
+
+  return {gate, config, samples, best / samples};
+}
+
+
+/*!
+ * \brief Output formats of the `reporter`.
+ */
+enum class format { csv, json };
+
+
+/*!
+ * \brief   Read the output format from the command line.
+ * \returns `format::json` if `--format=json` was passed, `format::csv` if not.
+ */
+inline format parse_format(int argc, char ** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--format=json") == 0) { return format::json; }
+  }
+  return format::csv;
+}
+
+
+/*!
+ * \brief Collects benchmark results and prints them as CSV or JSON.
+ */
+class reporter
+{
+public:
+  void add(result res) { _results.push_back(std::move(res)); }
+
+  void print(std::ostream & os, format fmt = format::csv) const {
+    if (fmt == format::json) {
+      print_json(os);
+    } else {
+      print_csv(os);
+    }
+  }
+
+private:
+  void print_csv(std::ostream & os) const {
+    os << "gate,config,samples,ns_per_sample,samples_per_second\n";
+
+    for (auto & res : _results) {
+      os << res.gate << ',' << res.config << ',' << res.samples << ','
+         << res.ns_per_sample << ',' << res.samples_per_second() << '\n';
+    }
+  }
+
+  // one object per result; names and configs never contain quotes
+  void print_json(std::ostream & os) const {
+    os << "[\n";
+
+    for (std::size_t i = 0; i < _results.size(); ++i) {
+      auto & res = _results[i];
+
+      os << "  {\"gate\": \"" << res.gate << "\", \"config\": \""
+         << res.config << "\", \"samples\": " << res.samples
+         << ", \"ns_per_sample\": " << res.ns_per_sample
+         << ", \"samples_per_second\": " << res.samples_per_second() << '}'
+         << (i + 1 < _results.size() ? ",\n" : "\n");
+    }
+
+    os << "]\n";
+  }
+
+private:
+  std::vector<result> _results;
+};
+
+}  // namespace bench
+}  // namespace pipebb
+
+#endif  // PIPEBB_BENCH_H_
@@ -0,0 +1,110 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "factor.h"
+#include "offset.h"
+#include "threshold.h"
+
+constexpr std::size_t SAMPLES = 1 << 20;
+
+
+//
+// recorded samples fed through channel -> factor -> offset -> threshold
+//
+std::vector<double> make_recording() {
+  std::vector<double> rec(SAMPLES);
+  for (std::size_t i = 0; i < rec.size(); ++i) {
+    rec[i] = 1000.0 * std::sin(0.001 * i);
+  }
+  return rec;
+}
+
+
+pipebb::bench::result scalar(const std::vector<double> & rec) {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto fac    = pipebb::make_factor(p_manifold, 0.5);
+  auto off    = pipebb::make_offset(fac, 20.0);
+  auto thresh = pipebb::make_threshold(off, 100.0);
+
+  return pipebb::bench::measure(
+    "channel>factor>offset>threshold",
+    "mode=scalar",
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        p_manifold << rec[i];
+        bool out = thresh();
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+}
+
+
+pipebb::bench::result block(const std::vector<double> & rec,
+                            std::size_t                 block_size) {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto fac    = pipebb::make_factor(p_manifold, 0.5);
+  auto off    = pipebb::make_offset(fac, 20.0);
+  auto thresh = pipebb::make_threshold(off, 100.0);
+
+  std::vector<double> a(block_size), b(block_size);
+  std::unique_ptr<bool[]> out(new bool[block_size]);
+
+  pipebb::span<bool> flags{out.get(), block_size};
+
+  return pipebb::bench::measure(
+    "channel>factor>offset>threshold",
+    "mode=block;block=" + std::to_string(block_size),
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; i += block_size) {
+        std::size_t n = std::min(block_size, samples - i);
+
+        pipebb::span<const double> in{rec.data() + i, n};
+
+        p_manifold.process(in, a);
+        fac.process(pipebb::make_span(a).first(n), b);
+        off.process(pipebb::make_span(b).first(n), a);
+        thresh.process(pipebb::make_span(a).first(n), flags);
+        pipebb::bench::do_not_optimize(out[n - 1]);
+      }
+    });
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  auto rec = make_recording();
+
+  rep.add(scalar(rec));
+  rep.add(block(rec, 64));
+  rep.add(block(rec, 1024));
+  rep.add(block(rec, 4096));
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
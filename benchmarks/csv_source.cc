@@ -0,0 +1,113 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "csv_source.h"
+
+constexpr std::size_t ROWS    = 1 << 20;
+constexpr std::size_t COLUMNS = 8;
+
+const std::string path = "bench_csv_source.csv";
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  std::vector<pipebb::channel<double>> channels;
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    for (std::size_t c = 0; c < COLUMNS; ++c) {
+      channels.emplace_back("s" + std::to_string(c));
+      file << (c ? "," : "") << channels.back().name();
+    }
+    file << '\n';
+
+    for (std::size_t i = 0; i < ROWS; ++i) {
+      for (std::size_t c = 0; c < COLUMNS; ++c) {
+        file << (c ? "," : "")
+             << std::round(1e4 * std::sin(0.001 * i + c)) / 1e3;
+      }
+      file << '\n';
+    }
+  }
+  std::size_t bytes = std::ifstream(path, std::ios::ate).tellg();
+  std::string config =
+    "bytes_per_row=" + std::to_string(bytes / ROWS) + ";mode=";
+
+  // baseline: getline, stod, channel << value
+  rep.add(pipebb::bench::measure(
+    "getline", config + "scalar", ROWS, [&](std::size_t samples) {
+      std::ifstream file(path);
+      std::string   line, field;
+      std::getline(file, line);
+      for (std::size_t i = 0; i < samples && std::getline(file, line); ++i) {
+        std::istringstream fields(line);
+        for (auto & ch : channels) {
+          std::getline(fields, field, ',');
+          ch << std::stod(field);
+        }
+        pipebb::bench::do_not_optimize(channels[0]());
+      }
+    }));
+
+  std::size_t hardware = std::max(std::thread::hardware_concurrency(), 1u);
+  for (std::size_t threads : {std::size_t{1}, hardware}) {
+    rep.add(pipebb::bench::measure(
+      "csv_source",
+      config + "scalar;threads=" + std::to_string(threads),
+      ROWS,
+      [&](std::size_t samples) {
+        pipebb::csv_source source(path, 1024, threads);
+        for (auto & ch : channels) { source.bind(ch); }
+        for (std::size_t i = 0; i < samples && source.step(); ++i) {
+          pipebb::bench::do_not_optimize(channels[0]());
+        }
+      }));
+
+    std::vector<double> out(1024);
+    rep.add(pipebb::bench::measure(
+      "csv_source",
+      config + "block;threads=" + std::to_string(threads),
+      ROWS,
+      [&](std::size_t samples) {
+        pipebb::csv_source source(path, 1024, threads);
+        for (auto & ch : channels) { source.bind(ch); }
+        for (std::size_t i = 0; i < samples;) {
+          std::size_t n = source.next();
+          if (n == 0) { break; }
+          for (auto & ch : channels) {
+            ch.process(source.block(ch), pipebb::make_span(out));
+          }
+          pipebb::bench::do_not_optimize(out[n - 1]);
+          i += n;
+        }
+      }));
+  }
+
+  std::remove(path.c_str());
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
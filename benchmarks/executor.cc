@@ -0,0 +1,114 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <deque>
+#include <string>
+#include <thread>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "executor.h"
+#include "gradient.h"
+#include "moving_average.h"
+#include "node.h"
+#include "threshold.h"
+
+constexpr std::size_t SINKS = 512;
+constexpr std::size_t TICKS = 256;
+
+
+//
+// independent knock detection pipelines, one sink each
+//
+struct pipeline
+{
+  using channel_t = pipebb::channel<double>;
+  using average_t = pipebb::moving_average<channel_t, 256>;
+  using knock_t   = pipebb::threshold<average_t>;
+
+  channel_t                        in{"in", "-", 1.0, 0.0};
+  average_t                        avg{in, true};
+  knock_t                          knock{avg, 0.0};
+  pipebb::boolean_counter<knock_t> count{knock};
+};
+
+
+void feed(std::deque<pipeline> & pipelines, std::size_t t) {
+  for (std::size_t i = 0; i < pipelines.size(); ++i) {
+    pipelines[i].in << static_cast<double>((t * 31 + i * 17) % 101) - 50.0;
+  }
+}
+
+
+pipebb::bench::result sequential() {
+  std::deque<pipeline> pipelines(SINKS);
+
+  return pipebb::bench::measure(
+    "executor",
+    "mode=sequential;sinks=" + std::to_string(SINKS),
+    SINKS * TICKS,
+    [&](std::size_t samples) {
+      for (std::size_t t = 0; t < samples / SINKS; ++t) {
+        feed(pipelines, t);
+
+        pipebb::tick();
+        for (auto & p : pipelines) {
+          auto out = p.count();
+          pipebb::bench::do_not_optimize(out);
+        }
+      }
+    });
+}
+
+
+pipebb::bench::result parallel(std::size_t threads) {
+  std::deque<pipeline> pipelines(SINKS);
+
+  pipebb::executor exec{threads};
+  for (auto & p : pipelines) { exec.add_sink(p.count); }
+
+  return pipebb::bench::measure(
+    "executor",
+    "mode=parallel;sinks=" + std::to_string(SINKS) +
+      ";threads=" + std::to_string(threads),
+    SINKS * TICKS,
+    [&](std::size_t samples) {
+      for (std::size_t t = 0; t < samples / SINKS; ++t) {
+        feed(pipelines, t);
+
+        exec.run();
+        pipebb::bench::do_not_optimize(pipelines.back().count());
+      }
+    });
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  rep.add(sequential());
+
+  std::size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+  for (std::size_t threads = 1; threads < cores; threads *= 2) {
+    rep.add(parallel(threads));
+  }
+  rep.add(parallel(cores));
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
@@ -0,0 +1,121 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "expression.h"
+#include "factor.h"
+#include "offset.h"
+#include "threshold.h"
+
+constexpr std::size_t SAMPLES = 1 << 20;
+constexpr std::size_t BLOCK   = 1024;
+
+
+//
+// channel -> factor -> offset -> threshold, as gate objects and as a fused
+// expression
+//
+std::vector<double> make_recording() {
+  std::vector<double> rec(SAMPLES);
+  for (std::size_t i = 0; i < rec.size(); ++i) {
+    rec[i] = 1000.0 * std::sin(0.001 * static_cast<double>(i));
+  }
+  return rec;
+}
+
+
+pipebb::bench::result gates(const std::vector<double> & rec) {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto fac    = pipebb::make_factor(p_manifold, 0.5);
+  auto off    = pipebb::make_offset(fac, 20.0);
+  auto thresh = pipebb::make_threshold(off, 100.0);
+
+  return pipebb::bench::measure(
+    "factor>offset>threshold",
+    "mode=gates",
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        p_manifold << rec[i];
+        bool out = thresh();
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+}
+
+
+pipebb::bench::result scalar(const std::vector<double> & rec) {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto thresh = pipebb::expr(p_manifold) * 0.5 + 20.0 > 100.0;
+
+  return pipebb::bench::measure(
+    "factor>offset>threshold",
+    "mode=expression",
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        p_manifold << rec[i];
+        bool out = thresh();
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+}
+
+
+pipebb::bench::result block(const std::vector<double> & rec) {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto thresh = pipebb::expr(p_manifold) * 0.5 + 20.0 > 100.0;
+
+  std::unique_ptr<bool[]> out(new bool[BLOCK]);
+  pipebb::span<bool>      flags{out.get(), BLOCK};
+
+  return pipebb::bench::measure(
+    "factor>offset>threshold",
+    "mode=expression_block;block=" + std::to_string(BLOCK),
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; i += BLOCK) {
+        std::size_t n = std::min(BLOCK, samples - i);
+
+        pipebb::process(thresh, pipebb::make_span(rec.data() + i, n), flags);
+        pipebb::bench::do_not_optimize(out[n - 1]);
+      }
+    });
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  auto rec = make_recording();
+
+  rep.add(gates(rec));
+  rep.add(scalar(rec));
+  rep.add(block(rec));
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
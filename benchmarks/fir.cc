@@ -0,0 +1,114 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "fir.h"
+#include "ringbuffer.h"
+
+constexpr std::size_t SAMPLES = 1 << 18;
+
+
+std::vector<double> make_recording() {
+  std::vector<double> rec(SAMPLES);
+  for (std::size_t i = 0; i < rec.size(); ++i) {
+    rec[i] = std::sin(0.01 * i) + 0.1 * std::sin(2.1 * i);
+  }
+  return rec;
+}
+
+
+//
+// the hand-written convolution over ringbuffer iterators this gate replaces
+//
+template <std::size_t Taps>
+pipebb::bench::result naive(const std::vector<double> & rec) {
+  auto coeffs = pipebb::fir_coefficients<double, Taps>::lowpass(0.05, 1.0);
+
+  pipebb::ringbuffer<double, Taps> window;
+  window.fill(0.0);
+
+  return pipebb::bench::measure(
+    "fir",
+    "taps=" + std::to_string(Taps) + ";mode=ringbuffer",
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        window << rec[i];
+
+        double      y = 0.0;
+        std::size_t k = Taps;
+        for (auto x : window) { y += coeffs[--k] * x; }
+        pipebb::bench::do_not_optimize(y);
+      }
+    });
+}
+
+
+template <std::size_t Taps, std::size_t D>
+void bench_taps(pipebb::bench::reporter & rep,
+                const std::vector<double> & rec) {
+  const std::string config =
+    "taps=" + std::to_string(Taps) + ";decimation=" + std::to_string(D);
+
+  auto coeffs = pipebb::fir_coefficients<double, Taps>::lowpass(0.05, 1.0);
+
+  pipebb::channel<double> in{"in"};
+  auto                    filter = pipebb::make_fir<D>(in, coeffs);
+
+  rep.add(pipebb::bench::measure(
+    "fir", config + ";mode=scalar", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        in << rec[i];
+        double y = filter();
+        pipebb::bench::do_not_optimize(y);
+      }
+    }));
+
+  std::vector<double> out(1024);
+  rep.add(pipebb::bench::measure(
+    "fir", config + ";mode=block", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; i += out.size()) {
+        std::size_t n = std::min(out.size(), samples - i);
+        filter.process({rec.data() + i, n}, out);
+        pipebb::bench::do_not_optimize(out[0]);
+      }
+    }));
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  auto rec = make_recording();
+
+  rep.add(naive<64>(rec));
+  bench_taps<64, 1>(rep, rec);
+  bench_taps<64, 4>(rep, rec);
+
+  rep.add(naive<256>(rec));
+  bench_taps<256, 1>(rep, rec);
+  bench_taps<256, 4>(rep, rec);
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
@@ -0,0 +1,307 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+
+#include "accumulator.h"
+#include "channel.h"
+#include "counter.h"
+#include "derivative.h"
+#include "factor.h"
+#include "gradient.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "moving_extremum.h"
+#include "moving_variance.h"
+#include "node.h"
+#include "threshold.h"
+
+constexpr std::size_t SAMPLES = 1 << 18;
+
+
+//
+// recorded samples; the value changes every `hold` samples
+//
+std::vector<double> make_recording(std::size_t hold = 1) {
+  std::vector<double> rec(SAMPLES);
+  for (std::size_t i = 0; i < rec.size(); ++i) {
+    rec[i] = 1000.0 * std::sin(0.001 * static_cast<double>(i / hold));
+  }
+  return rec;
+}
+
+std::vector<std::uint32_t> make_bit_recording() {
+  std::vector<std::uint32_t> rec(SAMPLES);
+  std::uint32_t              state = 0x9e3779b9;
+  for (auto & bits : rec) {
+    // xorshift32, skewed towards set bits so wide and gates don't short
+    // circuit on the first input every time
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    bits = state | (state >> 1) | (state >> 2);
+  }
+  return rec;
+}
+
+
+//
+// feed `rec` into `in` and pull `gate` once per sample
+//
+template <class G>
+pipebb::bench::result run(std::string                 name,
+                          std::string                 config,
+                          pipebb::channel<double> &   in,
+                          G &                         gate,
+                          const std::vector<double> & rec) {
+  return pipebb::bench::measure(
+    std::move(name), std::move(config), rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        in << rec[i];
+        auto out = gate();
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+}
+
+
+//
+// single gates
+//
+void bench_channel(pipebb::bench::reporter & rep,
+                   const std::vector<double> & rec) {
+  pipebb::channel<double> in{"in", "-", 0.5, 20.0};
+  rep.add(run("channel", "", in, in, rec));
+}
+
+void bench_factor(pipebb::bench::reporter & rep,
+                  const std::vector<double> & rec) {
+  pipebb::channel<double> in{"in"};
+  auto                    fac = pipebb::make_factor(in, 0.5);
+  rep.add(run("factor", "", in, fac, rec));
+}
+
+void bench_gradient(pipebb::bench::reporter & rep,
+                    const std::vector<double> & rec) {
+  pipebb::channel<double> in{"in"};
+  auto                    grad = pipebb::make_gradient(in);
+  rep.add(run("gradient", "", in, grad, rec));
+}
+
+//
+// timestamped samples with jitter
+//
+template <class G>
+pipebb::bench::result run_timed(std::string                 name,
+                                std::string                 config,
+                                pipebb::channel<double> &   in,
+                                G &                         gate,
+                                const std::vector<double> & rec) {
+  return pipebb::bench::measure(
+    std::move(name), std::move(config), rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        in.write(rec[i], 0.01 * static_cast<double>(i) + 0.001 * (i % 3));
+        auto out = gate();
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+}
+
+void bench_derivative(pipebb::bench::reporter & rep,
+                      const std::vector<double> & rec) {
+  pipebb::channel<double> in{"in"};
+
+  auto deriv = pipebb::make_derivative(in);
+  rep.add(run_timed("derivative", "", in, deriv, rec));
+
+  auto vderiv = pipebb::make_varstep_derivative<16>(in);
+  rep.add(run_timed("varstep_derivative", "N=16", in, vderiv, rec));
+}
+
+template <std::size_t N>
+void bench_windows(pipebb::bench::reporter & rep,
+                   const std::vector<double> & rec) {
+  const std::string config = "N=" + std::to_string(N);
+
+  pipebb::channel<double> in{"in"};
+
+  auto vgrad = pipebb::make_varstep_gradient<N>(in);
+  rep.add(run("varstep_gradient", config, in, vgrad, rec));
+
+  auto avg = pipebb::make_moving_average<N>(in);
+  rep.add(run("moving_average", config, in, avg, rec));
+
+  auto acc = pipebb::make_accumulator<N>(in);
+  rep.add(run("accumulator", config, in, acc, rec));
+
+  auto lo = pipebb::make_moving_min<N>(in);
+  rep.add(run("moving_min", config, in, lo, rec));
+
+  auto hi = pipebb::make_moving_max<N>(in);
+  rep.add(run("moving_max", config, in, hi, rec));
+
+  auto range = pipebb::make_moving_range<N>(in);
+  rep.add(run("moving_range", config, in, range, rec));
+
+  // mean and standard deviation over one shared window
+  auto mean   = pipebb::make_moving_average<N>(in);
+  auto var    = pipebb::make_moving_variance(mean);
+  auto stddev = pipebb::make_moving_stddev(var);
+  rep.add(run("moving_stddev", config, in, stddev, rec));
+}
+
+
+template <std::size_t, class T>
+using repeat_t = T;
+
+template <std::size_t... Is>
+void bench_and_gate(pipebb::bench::reporter &          rep,
+                    const std::vector<std::uint32_t> & rec,
+                    std::index_sequence<Is...>) {
+  constexpr std::size_t K = sizeof...(Is);
+
+  std::array<pipebb::channel<bool>, K> in{
+    {repeat_t<Is, pipebb::channel<bool>>{"in"}...}};
+
+  pipebb::and_gate<repeat_t<Is, pipebb::channel<bool>>...> gate{in[Is]...};
+
+  rep.add(pipebb::bench::measure(
+    "logic_gate",
+    "op=and;inputs=" + std::to_string(K),
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        for (std::size_t k = 0; k < K; ++k) { in[k] << ((rec[i] >> k) & 1u); }
+        bool out = gate();
+        pipebb::bench::do_not_optimize(out);
+      }
+    }));
+}
+
+void bench_counters(pipebb::bench::reporter &          rep,
+                    const std::vector<std::uint32_t> & rec) {
+  auto c = pipebb::make_counter();
+  rep.add(pipebb::bench::measure(
+    "counter", "op=step", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        auto out = c.step();
+        pipebb::bench::do_not_optimize(out);
+      }
+    }));
+
+  pipebb::channel<bool> in{"in"};
+
+  auto reset = pipebb::make_reset_counter(in);
+  auto count = pipebb::make_boolean_counter(in);
+
+  rep.add(pipebb::bench::measure(
+    "reset_counter", "", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        in << (rec[i] & 1u);
+        auto out = reset();
+        pipebb::bench::do_not_optimize(out);
+      }
+    }));
+
+  rep.add(pipebb::bench::measure(
+    "boolean_counter", "", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        in << (rec[i] & 1u);
+        auto out = count();
+        pipebb::bench::do_not_optimize(out);
+      }
+    }));
+}
+
+
+//
+// composite graph: overboost detection on a manifold pressure channel;
+// the smoothed pressure is above its limit while the pressure still rises,
+// counted for as long as that holds
+//
+void bench_overboost(pipebb::bench::reporter &   rep,
+                     const std::vector<double> & rec,
+                     const std::string &         changes,
+                     bool                        ticked) {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto scaled   = pipebb::make_factor(p_manifold, 0.001);
+  auto smoothed = pipebb::make_moving_average<16>(scaled);
+  auto high     = pipebb::make_threshold(smoothed, 0.5);
+  auto slope    = pipebb::make_gradient(p_manifold);
+  auto rising   = pipebb::make_threshold(slope, 0.0);
+  auto boost    = pipebb::make_and_gate(high, rising);
+  auto duration = pipebb::make_boolean_counter(boost);
+
+  const std::string config =
+    "changes=" + changes + ";tick=" + (ticked ? "on" : "off");
+
+  rep.add(pipebb::bench::measure(
+    "overboost_graph", config, rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        p_manifold << rec[i];
+        if (ticked) { pipebb::tick(); }
+        auto out = duration();
+        pipebb::bench::do_not_optimize(out);
+      }
+    }));
+
+  pipebb::reset_epoch();
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  auto rec  = make_recording();
+  auto bits = make_bit_recording();
+
+  bench_channel(rep, rec);
+  bench_factor(rep, rec);
+  bench_gradient(rep, rec);
+  bench_derivative(rep, rec);
+
+  bench_windows<4>(rep, rec);
+  bench_windows<16>(rep, rec);
+  bench_windows<64>(rep, rec);
+  bench_windows<256>(rep, rec);
+  bench_windows<1024>(rep, rec);
+
+  bench_and_gate(rep, bits, std::make_index_sequence<2>());
+  bench_and_gate(rep, bits, std::make_index_sequence<4>());
+  bench_and_gate(rep, bits, std::make_index_sequence<8>());
+  bench_and_gate(rep, bits, std::make_index_sequence<16>());
+
+  bench_counters(rep, bits);
+
+  // every sample changes the input vs. one change in twenty samples (5%)
+  auto held = make_recording(20);
+
+  bench_overboost(rep, rec, "100%", false);
+  bench_overboost(rep, rec, "100%", true);
+  bench_overboost(rep, held, "5%", false);
+  bench_overboost(rep, held, "5%", true);
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
@@ -0,0 +1,103 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "iir.h"
+#include "moving_average.h"
+
+constexpr std::size_t SAMPLES = 1 << 20;
+
+
+//
+// a slow sine with some noise on top
+//
+std::vector<double> make_recording() {
+  std::vector<double> rec(SAMPLES);
+  for (std::size_t i = 0; i < rec.size(); ++i) {
+    rec[i] = 1000.0 * std::sin(0.001 * i) + 10.0 * std::sin(1.7 * i);
+  }
+  return rec;
+}
+
+
+template <class G>
+pipebb::bench::result scalar(std::string                 name,
+                             pipebb::channel<double> &   in,
+                             G &                         gate,
+                             const std::vector<double> & rec) {
+  return pipebb::bench::measure(
+    name, "mode=scalar", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        in << rec[i];
+        auto out = gate();
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+}
+
+
+template <class G>
+pipebb::bench::result block(std::string                 name,
+                            G &                         gate,
+                            const std::vector<double> & rec,
+                            std::size_t                 block_size) {
+  std::vector<double> out(block_size);
+
+  return pipebb::bench::measure(
+    name,
+    "mode=block;block=" + std::to_string(block_size),
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; i += block_size) {
+        std::size_t n = std::min(block_size, samples - i);
+
+        gate.process({rec.data() + i, n}, out);
+        pipebb::bench::do_not_optimize(out[n - 1]);
+      }
+    });
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  auto rec = make_recording();
+
+  pipebb::channel<double> in{"in"};
+
+  auto avg = pipebb::make_moving_average<512>(in, true);
+  rep.add(scalar("moving_average<512>", in, avg, rec));
+  rep.add(block("moving_average<512>", avg, rec, 1024));
+
+  auto smooth = pipebb::make_ema(in, 1.0 / 256);
+  rep.add(scalar("ema", in, smooth, rec));
+  rep.add(block("ema", smooth, rec, 1024));
+
+  auto coeffs = pipebb::biquad_coefficients<double>::lowpass(1.0, 1000.0, 0.7);
+  auto lp     = pipebb::make_biquad(in, coeffs);
+  rep.add(scalar("biquad", in, lp, rec));
+  rep.add(block("biquad", lp, rec, 64));
+  rep.add(block("biquad", lp, rec, 1024));
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
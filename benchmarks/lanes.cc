@@ -0,0 +1,126 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cmath>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "lanes.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "node.h"
+#include "threshold.h"
+
+constexpr std::size_t TICKS = 64;
+
+
+//
+// overboost detection for a fleet of vehicles: the smoothed boost pressure is
+// above its limit while the raw pressure is above a second one, counted for
+// as long as that holds
+//
+std::vector<double> make_recording(std::size_t lanes) {
+  std::vector<double> rec(TICKS * lanes);
+  for (std::size_t i = 0; i < rec.size(); ++i) {
+    rec[i] = 1000.0 + 1000.0 * std::sin(0.001 * static_cast<double>(i));
+  }
+  return rec;
+}
+
+
+struct vehicle
+{
+  using channel_t = pipebb::channel<double>;
+  using average_t = pipebb::moving_average<channel_t, 16>;
+  using high_t    = pipebb::threshold<average_t>;
+  using peak_t    = pipebb::threshold<channel_t>;
+  using boost_t   = pipebb::and_gate<high_t, peak_t>;
+
+  channel_t                        p_boost{"p_boost", "mbar", 1.0, 0.0};
+  average_t                        smoothed{p_boost, true};
+  high_t                           high{smoothed, 1500.0};
+  peak_t                           peak{p_boost, 1800.0};
+  boost_t                          boost{high, peak};
+  pipebb::boolean_counter<boost_t> duration{boost};
+};
+
+
+pipebb::bench::result scalar(const std::vector<double> & rec,
+                             std::size_t                 lanes) {
+  std::deque<vehicle> fleet(lanes);
+
+  return pipebb::bench::measure(
+    "overboost_fleet",
+    "mode=scalar;lanes=" + std::to_string(lanes),
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t t = 0; t < samples / lanes; ++t) {
+        const double * row = rec.data() + t * lanes;
+
+        pipebb::tick();
+        for (std::size_t l = 0; l < lanes; ++l) {
+          fleet[l].p_boost << row[l];
+          auto out = fleet[l].duration();
+          pipebb::bench::do_not_optimize(out);
+        }
+      }
+    });
+}
+
+
+pipebb::bench::result lanes(const std::vector<double> & rec,
+                            std::size_t                 lanes) {
+  auto p_boost  = pipebb::make_lane_channel<double>(lanes, "p_boost", "mbar");
+  auto smoothed = pipebb::make_lane_moving_average<16>(p_boost);
+  auto high     = pipebb::make_lane_threshold(smoothed, 1500.0);
+  auto peak     = pipebb::make_lane_threshold(p_boost, 1800.0);
+  auto boost    = pipebb::make_lane_and_gate(high, peak);
+  auto duration = pipebb::make_lane_boolean_counter(boost);
+
+  return pipebb::bench::measure(
+    "overboost_fleet",
+    "mode=lanes;lanes=" + std::to_string(lanes),
+    rec.size(),
+    [&](std::size_t samples) {
+      for (std::size_t t = 0; t < samples / lanes; ++t) {
+        p_boost << pipebb::make_span(rec.data() + t * lanes, lanes);
+
+        pipebb::tick();
+        auto out = duration();
+        pipebb::bench::do_not_optimize(out[lanes - 1]);
+      }
+    });
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  for (std::size_t fleet : {64, 1024, 20000}) {
+    auto rec = make_recording(fleet);
+
+    rep.add(scalar(rec, fleet));
+    rep.add(lanes(rec, fleet));
+  }
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
@@ -0,0 +1,104 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "gradient.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "node.h"
+#include "parallel_run.h"
+#include "threshold.h"
+
+constexpr std::size_t STREAMS = 256;
+constexpr std::size_t LENGTH  = 4096;
+
+
+//
+// knock detection on one recorded stream per cylinder and trip
+//
+struct knock_graph
+{
+  using channel_t  = pipebb::channel<double>;
+  using average_t  = pipebb::moving_average<channel_t, 64>;
+  using gradient_t = pipebb::gradient<channel_t>;
+  using loud_t     = pipebb::threshold<average_t>;
+  using sharp_t    = pipebb::threshold<gradient_t>;
+  using knock_t    = pipebb::and_gate<loud_t, sharp_t>;
+
+  channel_t                        vibration{"vibration", "g", 1.0, 0.0};
+  average_t                        level{vibration, true};
+  gradient_t                       slope{vibration};
+  loud_t                           loud{level, 0.2};
+  sharp_t                          sharp{slope, 4};
+  knock_t                          knock{loud, sharp};
+  pipebb::boolean_counter<knock_t> count{knock};
+};
+
+
+std::uint64_t run_stream(knock_graph & graph, std::size_t stream) {
+  std::uint32_t state = static_cast<std::uint32_t>(stream) * 2654435761u + 1;
+
+  for (std::size_t i = 0; i < LENGTH; ++i) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    graph.vibration << static_cast<double>(state % 21) - 10.0;
+    pipebb::tick();
+    graph.count();
+  }
+
+  return graph.count();
+}
+
+
+pipebb::bench::result run(std::size_t threads) {
+  pipebb::run_options options;
+  options.threads = threads;
+
+  return pipebb::bench::measure(
+    "parallel_run",
+    "streams=" + std::to_string(STREAMS) + ";threads=" +
+      std::to_string(threads),
+    STREAMS * LENGTH,
+    [&](std::size_t samples) {
+      auto counts = pipebb::parallel_run<knock_graph>(
+        std::max<std::size_t>(samples / LENGTH, 1), run_stream, options);
+      pipebb::bench::do_not_optimize(counts.back());
+    },
+    3);
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  std::size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+  for (std::size_t threads = 1; threads < cores; threads *= 2) {
+    rep.add(run(threads));
+  }
+  rep.add(run(cores));
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
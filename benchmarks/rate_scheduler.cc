@@ -0,0 +1,109 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <deque>
+#include <string>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "moving_average.h"
+#include "rate_scheduler.h"
+#include "threshold.h"
+
+constexpr std::size_t FAST  = 16;
+constexpr std::size_t SLOW  = 256;
+constexpr double      RATIO = 100.0;
+
+
+//
+// a knock detection pipeline per signal, a few fast ones and many slow ones
+//
+struct pipeline
+{
+  using channel_t = pipebb::channel<double>;
+  using average_t = pipebb::moving_average<channel_t, 16>;
+  using knock_t   = pipebb::threshold<average_t>;
+
+  channel_t                        in{"in", "-", 1.0, 0.0};
+  average_t                        avg{in, true};
+  knock_t                          knock{avg, 0.0};
+  pipebb::boolean_counter<knock_t> count{knock};
+
+  void feed(std::size_t t, std::size_t i) {
+    in << static_cast<double>((t * 31 + i * 17) % 101) - 50.0;
+  }
+};
+
+
+// every pipeline on every tick, the slow ones fed on their ticks only
+pipebb::bench::result single_rate() {
+  std::deque<pipeline> fast(FAST), slow(SLOW);
+
+  return pipebb::bench::measure(
+    "rate_scheduler",
+    "mode=single_rate;fast=" + std::to_string(FAST) +
+      ";slow=" + std::to_string(SLOW),
+    1000,
+    [&](std::size_t samples) {
+      for (std::size_t t = 0; t < samples; ++t) {
+        for (std::size_t i = 0; i < FAST; ++i) { fast[i].feed(t, i); }
+        if (t % static_cast<std::size_t>(RATIO) == 0) {
+          for (std::size_t i = 0; i < SLOW; ++i) { slow[i].feed(t, i); }
+        }
+
+        pipebb::tick();
+        for (auto & p : fast) { pipebb::bench::do_not_optimize(p.count()); }
+        for (auto & p : slow) { pipebb::bench::do_not_optimize(p.count()); }
+      }
+    });
+}
+
+
+pipebb::bench::result multi_rate() {
+  std::deque<pipeline> fast(FAST), slow(SLOW);
+
+  pipebb::rate_scheduler sched{RATIO};
+  for (std::size_t i = 0; i < FAST; ++i) {
+    sched.add_source([&, i] { fast[i].feed(sched.now(), i); }, RATIO);
+    sched.add_sink(fast[i].count, RATIO);
+  }
+  for (std::size_t i = 0; i < SLOW; ++i) {
+    sched.add_source([&, i] { slow[i].feed(sched.now(), i); }, 1.0);
+    sched.add_sink(slow[i].count, 1.0);
+  }
+
+  return pipebb::bench::measure(
+    "rate_scheduler",
+    "mode=multi_rate;fast=" + std::to_string(FAST) +
+      ";slow=" + std::to_string(SLOW),
+    1000,
+    [&](std::size_t samples) {
+      for (std::size_t t = 0; t < samples; ++t) { sched.run(); }
+      pipebb::bench::do_not_optimize(fast.back().count());
+    });
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  rep.add(single_rate());
+  rep.add(multi_rate());
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
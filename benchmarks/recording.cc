@@ -0,0 +1,134 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "recorder.h"
+#include "recording.h"
+#include "threshold.h"
+
+constexpr std::size_t SAMPLES = 1 << 22;
+
+const std::string path = "bench_recording.rec";
+
+constexpr std::size_t GATES = 64;
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  pipebb::channel<double> p_rail{"p_rail", "bar", 0.1, 0.0};
+
+  std::vector<double> raw(SAMPLES);
+  std::string         text;
+  for (std::size_t i = 0; i < raw.size(); ++i) {
+    raw[i] = std::round(1000.0 * std::sin(0.001 * i)) / 8;
+    text += std::to_string(raw[i]) + '\n';
+  }
+
+  pipebb::recording_writer writer;
+  writer.add(p_rail, raw);
+  writer.write(path);
+
+  pipebb::recording rec(path);
+
+  // baseline: parse text, one sample at a time
+  rep.add(pipebb::bench::measure(
+    "text", "mode=scalar", SAMPLES, [&](std::size_t samples) {
+      const char * pos = text.c_str();
+      for (std::size_t i = 0; i < samples; ++i) {
+        char * end;
+        p_rail << std::strtod(pos, &end);
+        pos = end;
+        pipebb::bench::do_not_optimize(p_rail());
+      }
+    }));
+
+  rep.add(pipebb::bench::measure(
+    "replay", "mode=scalar", SAMPLES, [&](std::size_t samples) {
+      pipebb::replay source(rec);
+      source.bind(p_rail);
+      for (std::size_t i = 0; i < samples && source.step(); ++i) {
+        pipebb::bench::do_not_optimize(p_rail());
+      }
+    }));
+
+  for (std::size_t block_size : {64, 1024}) {
+    std::vector<double> out(block_size);
+    rep.add(pipebb::bench::measure(
+      "replay",
+      "mode=block;block=" + std::to_string(block_size),
+      SAMPLES,
+      [&](std::size_t samples) {
+        pipebb::replay source(rec, block_size);
+        source.bind(p_rail);
+        for (std::size_t i = 0; i < samples;) {
+          std::size_t n = source.next();
+          if (n == 0) { break; }
+          p_rail.process(source.block(p_rail), out);
+          pipebb::bench::do_not_optimize(out[n - 1]);
+          i += n;
+        }
+      }));
+  }
+
+  // logging the outputs of many gates every tick
+  std::deque<pipebb::threshold<pipebb::channel<double>>> gates;
+  for (std::size_t g = 0; g < GATES; ++g) {
+    gates.push_back(pipebb::make_threshold(p_rail, 10.0 * g));
+  }
+
+  const std::size_t ticks  = SAMPLES / 16;
+  const std::string config = "gates=" + std::to_string(GATES);
+
+  rep.add(pipebb::bench::measure(
+    "ostream", config, ticks, [&](std::size_t samples) {
+      std::ofstream out(path);
+      for (std::size_t i = 0; i < samples; ++i) {
+        p_rail << raw[i];
+        pipebb::tick();
+        for (auto & gate : gates) { out << gate() << ' '; }
+        out << '\n';
+      }
+    }));
+
+  rep.add(pipebb::bench::measure(
+    "recorder", config, ticks, [&](std::size_t samples) {
+      pipebb::recorder rec(path);
+      for (std::size_t g = 0; g < GATES; ++g) {
+        rec.add(gates[g], "g" + std::to_string(g));
+      }
+      for (std::size_t i = 0; i < samples; ++i) {
+        p_rail << raw[i];
+        pipebb::tick();
+        rec();
+      }
+      rec.close();
+    }));
+
+  std::remove(path.c_str());
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
@@ -0,0 +1,120 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <numeric>
+#include <string>
+
+#include "bench.h"
+
+#include "ringbuffer.h"
+
+constexpr std::size_t SAMPLES = 1 << 16;
+
+
+//
+// push one sample, then walk the whole window through the iterators, as the
+// windowed gates used to do on every call
+//
+template <std::size_t N, class P>
+pipebb::bench::result iterate(const std::string & layout) {
+  pipebb::ringbuffer<double, N, P> buf;
+  buf.fill(1.0);
+
+  return pipebb::bench::measure(
+    "ringbuffer<" + layout + ">",
+    "N=" + std::to_string(N) + ";op=push_iterate",
+    SAMPLES,
+    [&buf](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        buf << static_cast<double>(i);
+        double sum = std::accumulate(buf.begin(), buf.end(), 0.0);
+        pipebb::bench::do_not_optimize(sum);
+      }
+    });
+}
+
+
+//
+// push one sample, then walk the whole window through operator[]
+//
+template <std::size_t N, class P>
+pipebb::bench::result index(const std::string & layout) {
+  pipebb::ringbuffer<double, N, P> buf;
+  buf.fill(1.0);
+
+  return pipebb::bench::measure(
+    "ringbuffer<" + layout + ">",
+    "N=" + std::to_string(N) + ";op=push_index",
+    SAMPLES,
+    [&buf](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        buf << static_cast<double>(i);
+        double sum = 0.0;
+        for (std::size_t j = 0; j < buf.size(); ++j) { sum += buf[j]; }
+        pipebb::bench::do_not_optimize(sum);
+      }
+    });
+}
+
+
+//
+// push one sample, then read both ends of the window like varstep_gradient
+//
+template <std::size_t N, class P>
+pipebb::bench::result ends(const std::string & layout) {
+  pipebb::ringbuffer<double, N, P> buf;
+  buf.fill(1.0);
+
+  return pipebb::bench::measure(
+    "ringbuffer<" + layout + ">",
+    "N=" + std::to_string(N) + ";op=push_front_back",
+    SAMPLES * 64,
+    [&buf](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        buf << static_cast<double>(i);
+        double diff = buf.back() - buf.front();
+        pipebb::bench::do_not_optimize(diff);
+      }
+    });
+}
+
+
+template <std::size_t N>
+void compare(pipebb::bench::reporter & rep) {
+  rep.add(iterate<N, pipebb::modulo_indexing>("modulo"));
+  rep.add(iterate<N, pipebb::masked_indexing>("masked"));
+  rep.add(index<N, pipebb::modulo_indexing>("modulo"));
+  rep.add(index<N, pipebb::masked_indexing>("masked"));
+  rep.add(ends<N, pipebb::modulo_indexing>("modulo"));
+  rep.add(ends<N, pipebb::masked_indexing>("masked"));
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  // window sizes used by varstep_gradient, accumulator and moving_average in
+  // the tests, plus typical production windows
+  compare<3>(rep);
+  compare<5>(rep);
+  compare<50>(rep);
+  compare<63>(rep);
+  compare<512>(rep);
+  compare<1023>(rep);
+  compare<1024>(rep);
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
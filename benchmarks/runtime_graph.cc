@@ -0,0 +1,126 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cmath>
+#include <vector>
+
+#include "bench.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "factor.h"
+#include "gradient.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "node.h"
+#include "runtime_graph.h"
+#include "threshold.h"
+
+constexpr std::size_t SAMPLES = 1 << 18;
+
+const char * description = R"(
+  p_manifold = channel(unit=mbar)
+  scaled     = factor(p_manifold, 0.001)
+  smoothed   = moving_average(scaled, 16)
+  high       = threshold(smoothed, 0.5)
+  slope      = gradient(p_manifold)
+  rising     = threshold(slope, 0)
+  boost      = and(high, rising)
+  duration   = boolean_counter(boost)
+)";
+
+
+std::vector<double> make_recording() {
+  std::vector<double> rec(SAMPLES);
+  for (std::size_t i = 0; i < rec.size(); ++i) {
+    rec[i] = 1000.0 * std::sin(0.001 * static_cast<double>(i));
+  }
+  return rec;
+}
+
+
+//
+// the same overboost graph as in bench_gates, every gate pulled per tick
+//
+pipebb::bench::result templated(const std::vector<double> & rec) {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto scaled   = pipebb::make_factor(p_manifold, 0.001);
+  auto smoothed = pipebb::make_moving_average<16>(scaled, true);
+  auto high     = pipebb::make_threshold(smoothed, 0.5);
+  auto slope    = pipebb::make_gradient(p_manifold);
+  auto rising   = pipebb::make_threshold(slope, 0);
+  auto boost    = pipebb::make_and_gate(high, rising);
+  auto duration = pipebb::make_boolean_counter(boost);
+
+  auto result = pipebb::bench::measure(
+    "overboost_graph", "mode=template", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        p_manifold << rec[i];
+        pipebb::tick();
+        slope();
+        auto out = duration();
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+
+  pipebb::reset_epoch();
+  return result;
+}
+
+
+pipebb::bench::result interpreted(const std::vector<double> & rec) {
+  auto graph = pipebb::make_runtime_graph(description);
+
+  auto p_manifold = graph.index("p_manifold");
+  auto duration   = graph.index("duration");
+
+  return pipebb::bench::measure(
+    "overboost_graph", "mode=runtime", rec.size(), [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        graph.set(p_manifold, rec[i]);
+        graph.run();
+        auto out = graph.value(duration);
+        pipebb::bench::do_not_optimize(out);
+      }
+    });
+}
+
+
+// one "sample" is one full reconfiguration: parse, sort and compile
+pipebb::bench::result rebuild() {
+  return pipebb::bench::measure(
+    "runtime_graph", "op=build;nodes=8", 1000, [&](std::size_t samples) {
+      for (std::size_t i = 0; i < samples; ++i) {
+        auto graph = pipebb::make_runtime_graph(description);
+        pipebb::bench::do_not_optimize(graph);
+      }
+    });
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  auto rec = make_recording();
+
+  rep.add(templated(rec));
+  rep.add(interpreted(rec));
+  rep.add(rebuild());
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
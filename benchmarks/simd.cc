@@ -0,0 +1,90 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "simd.h"
+
+constexpr std::size_t SAMPLES = 1 << 14;
+
+
+const char * isa_name(pipebb::simd::isa isa) {
+  switch (isa) {
+    case pipebb::simd::isa::avx512: return "avx512";
+    case pipebb::simd::isa::avx2: return "avx2";
+    case pipebb::simd::isa::scalar: break;
+  }
+  return "scalar";
+}
+
+
+//
+// each kernel over a block of SAMPLES values that stays in L1/L2 cache
+//
+template <typename T>
+void kernels(pipebb::bench::reporter & rep, const std::string & type) {
+  std::vector<T>             in(SAMPLES), out(SAMPLES);
+  std::vector<std::uint64_t> mask(pipebb::simd::mask_words(SAMPLES));
+
+  for (std::size_t i = 0; i < SAMPLES; ++i) {
+    in[i] = static_cast<T>(i % 1000) - T(500);
+  }
+
+  for (auto isa : {pipebb::simd::isa::scalar,
+                   pipebb::simd::isa::avx2,
+                   pipebb::simd::isa::avx512}) {
+    if (pipebb::simd::select_isa(isa) != isa) { continue; }
+
+    std::string config = std::string("isa=") + isa_name(isa) + ";type=" + type;
+
+    rep.add(pipebb::bench::measure(
+      "simd::scale", config, SAMPLES, [&](std::size_t samples) {
+        pipebb::simd::scale(in.data(), T(3), out.data(), samples);
+        pipebb::bench::do_not_optimize(out[0]);
+      }));
+
+    rep.add(pipebb::bench::measure(
+      "simd::greater", config, SAMPLES, [&](std::size_t samples) {
+        pipebb::simd::greater(in.data(), T(7), mask.data(), samples);
+        pipebb::bench::do_not_optimize(mask[0]);
+      }));
+
+    rep.add(pipebb::bench::measure(
+      "simd::affine_greater", config, SAMPLES, [&](std::size_t samples) {
+        pipebb::simd::affine_greater(
+          in.data(), T(3), T(-2), T(7), mask.data(), samples);
+        pipebb::bench::do_not_optimize(mask[0]);
+      }));
+  }
+
+  pipebb::simd::select_isa(pipebb::simd::detected_isa());
+}
+
+
+int main(int argc, char ** argv) {
+  pipebb::bench::reporter rep;
+
+  kernels<float>(rep, "float");
+  kernels<double>(rep, "double");
+  kernels<std::int32_t>(rep, "int32");
+  kernels<std::int64_t>(rep, "int64");
+
+  rep.print(std::cout, pipebb::bench::parse_format(argc, argv));
+}
@@ -0,0 +1,33 @@
+//
+// columns are matched to channels by name; other columns are skipped
+//
+pipebb::channel<double>       p_rail{"p_rail", "bar", 1.0, 0.0};
+pipebb::channel<std::int32_t> n_eng{"n_eng"};
+
+auto overload = pipebb::make_threshold(p_rail, 1800.0);
+
+pipebb::csv_source source("archive.csv", 1024);
+source.bind(p_rail);
+source.bind(n_eng);
+//
+
+//
+// sample by sample, through the whole graph
+//
+while (source.step()) {
+  pipebb::tick();
+  overload();
+}
+//
+
+//
+// or block by block, straight into the block paths of the gates
+//
+std::array<double, 1024> scaled;
+std::array<bool, 1024>   high;
+while (std::size_t count = source.next()) {
+  p_rail.process(source.block(p_rail), pipebb::make_span(scaled));
+  overload.process(pipebb::make_span(scaled.data(), count),
+                   pipebb::make_span(high));
+}
+//
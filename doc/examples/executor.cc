@@ -0,0 +1,18 @@
+//
+// one pipeline per cylinder, all independent of each other
+//
+std::deque<cylinder_pipeline> cylinders(12);
+
+pipebb::executor exec{4};
+for (auto & cylinder : cylinders) { exec.add_sink(cylinder.knock_count); }
+//
+
+while (true) {
+  for (auto & cylinder : cylinders) { cylinder.feed_channels(); }
+
+  exec.run();  // evaluates the cylinders on 4 threads
+
+  for (auto & cylinder : cylinders) {
+    auto knocks = cylinder.knock_count();  // cached during run()
+  }
+}
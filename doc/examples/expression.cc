@@ -0,0 +1,22 @@
+//
+// channel -> factor -> offset -> threshold, as one value-typed expression
+//
+pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+auto overboost = pipebb::expr(p_manifold) * 0.5 + 20.0 > 1800.0;
+auto in_range  = pipebb::and_(pipebb::expr(p_manifold) > 200.0,
+                              !(pipebb::expr(p_manifold) > 2500.0));
+//
+
+//
+// per sample, or on a whole block in one vectorizable loop
+//
+bool res = overboost();
+pipebb::process(overboost, recorded_block, flags);
+//
+
+//
+// wrapped into a gate, to feed other gates
+//
+auto fused    = pipebb::make_fused(overboost);
+auto duration = pipebb::make_boolean_counter(fused);
@@ -0,0 +1,17 @@
+//
+// one channel, one graph, 20000 vehicles
+//
+constexpr std::size_t fleet = 20000;
+
+auto p_boost  = pipebb::make_lane_channel<double>(fleet, "p_boost", "mbar");
+auto smoothed = pipebb::make_lane_moving_average<16>(p_boost);
+auto high     = pipebb::make_lane_threshold(smoothed, 1800.0);
+auto duration = pipebb::make_lane_boolean_counter(high);
+//
+
+while (true) {
+  p_boost << read_fleet_samples();  // one value per vehicle
+  pipebb::tick();
+
+  auto counts = duration();  // one count per vehicle
+}
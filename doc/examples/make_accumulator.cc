@@ -20,3 +20,18 @@ auto res = acc.value();  // sum of last five values of `input_object`
 // make_accumulator function.
 scrubb::accumulator<decltype(input_object), 5> acc{input_object};
 //
+
+
+//
+// RUNTIME WINDOW SIZE
+//
+// If the window size is only known at runtime (e.g. read from a config file),
+// pass it as an argument instead. Windows can be drawn from an arena so that
+// many of them are laid out contiguously in one caller-owned block.
+//
+std::vector<unsigned char> memory(1 << 20);
+pipebb::arena              pool{memory.data(), memory.size()};
+
+auto acc = pipebb::make_accumulator(
+  input_object, window_size, pipebb::arena_allocator<double>{pool});
+//
@@ -0,0 +1,28 @@
+//
+// event-driven samples carry their time, e.g. in seconds
+//
+pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+auto rate     = pipebb::make_derivative(p_rail);             // bar/s
+auto smoothed = pipebb::make_varstep_derivative<8>(p_rail);  // over 8 samples
+
+p_rail.write(1200.0, 0.000);
+rate();
+p_rail.write(1230.0, 0.012);
+rate();  // 2500.0
+//
+
+//
+// differentiate a filtered signal with the timestamps of its channel
+//
+auto filtered = pipebb::make_moving_average<4>(p_rail);
+auto trend    = pipebb::make_derivative(filtered, p_rail);
+//
+
+//
+// or whole blocks of (time, value) columns, e.g. from a recording
+//
+rate.process(rec.data<double>(time_column),
+             rec.data<double>(value_column),
+             pipebb::make_span(rates));
+//
@@ -0,0 +1,23 @@
+//
+// the queue is filled by the acquisition thread, the channel is read by the
+// pipeline thread
+pipebb::spsc_ringbuffer<double, 1024> queue;
+pipebb::channel<double>               input_object{"p_rail", "bar", 1.0, 0.0};
+//
+
+//
+// producer side, e.g. in the CAN receive loop
+//
+std::thread acquisition{[&queue] {
+  while (true) { queue.try_push(read_sample()); }
+}};
+
+//
+// consumer side: make a queue_source and use it in place of the channel.
+//
+auto source = pipebb::make_queue_source(input_object, queue);
+auto grad   = pipebb::make_gradient(source);
+
+while (true) {
+  auto res = grad();  // drains the queue, then evaluates as usual
+}
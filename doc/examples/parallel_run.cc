@@ -0,0 +1,35 @@
+//
+// the graph every stream is fed through; the window draws from the worker's
+// arena
+//
+struct trip
+{
+  using channel_t = pipebb::channel<double>;
+  using alloc_t   = pipebb::arena_allocator<double>;
+  using average_t = pipebb::moving_average<channel_t, pipebb::dynamic_extent,
+                                           alloc_t>;
+
+  explicit trip(pipebb::arena & source)
+   : smoothed{p_boost, 500, true, alloc_t{source}} {}
+
+  channel_t                    p_boost{"p_boost", "mbar", 1.0, 0.0};
+  average_t                    smoothed;
+  pipebb::threshold<average_t> high{smoothed, 1800.0};
+};
+//
+
+pipebb::run_options options;
+options.arena_size = 64 * 1024;
+
+// one result per recorded trip, computed on all cores
+auto overboosts = pipebb::parallel_run<trip>(
+  recordings.size(),
+  [&](trip & graph, std::size_t stream) {
+    std::size_t count = 0;
+    for (double sample : recordings[stream]) {
+      graph.p_boost << sample;
+      count += graph.high();
+    }
+    return count;
+  },
+  options);
@@ -0,0 +1,24 @@
+//
+// compile every translation unit with -DPIPEBB_PROFILE to instrument every
+// gate
+//
+pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+auto scaled    = pipebb::make_factor(p_manifold, 0.5);
+auto overboost = pipebb::make_threshold(scaled, 900.0);
+scaled.graph_node().set_name("p_scaled");
+//
+
+//
+// run the graph, then dump calls, cache-hit rate and cycles per gate
+//
+for (auto sample : recorded) {
+  p_manifold << sample;
+  pipebb::tick();
+  overboost();
+}
+
+pipebb::profile::print_table(std::cout, pipebb::profile::snapshot());
+pipebb::profile::print_json(json_file, pipebb::profile::snapshot());
+pipebb::profile::reset();
+//
@@ -0,0 +1,32 @@
+//
+// vibration sampled at 1 kHz, oil temperature at 1 Hz, one base tick per
+// millisecond
+//
+pipebb::rate_scheduler sched{1000.0};
+auto &                 second = sched.clock(1.0);
+
+pipebb::channel<double> accel{"accel", "g", 1.0, 0.0};
+pipebb::channel<double> t_oil{"t_oil", "degC", 1.0, 0.0};
+
+sched.add_source([&] { accel << read_accelerometer(); }, 1000.0);
+sched.add_source([&] { t_oil << read_oil_temperature(); }, 1.0);
+//
+
+//
+// slow to fast: the oil temperature, held or interpolated per millisecond
+//
+auto t_held   = pipebb::make_sample_and_hold(t_oil, second);
+auto t_smooth = pipebb::make_interpolator(t_oil, second);
+sched.add_sink(t_held, 1000.0);
+sched.add_sink(t_smooth, 1000.0);
+
+//
+// fast to slow: the vibration level averaged over each second
+//
+auto level = pipebb::make_decimating_average<1000>(accel, second);
+sched.add_sink(level, 1000.0);  // sees every sample, changes once a second
+//
+
+while (true) {
+  sched.run();  // runs what is due on this millisecond only
+}
@@ -0,0 +1,23 @@
+//
+// log the outputs of a few gates every tick; full buffers are written to
+// disk on a background thread
+//
+pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+auto overpressure = pipebb::make_threshold(p_rail, 1800.0);
+auto duration     = pipebb::make_boolean_counter(overpressure);
+
+pipebb::recorder log("run.rec");
+log.add(p_rail, "p_rail", "bar");
+log.add(overpressure, "overpressure");
+log.add(duration, "duration", "ticks");
+
+while (running) {
+  p_rail << read_sample();
+  pipebb::tick();
+  log();
+}
+
+// write the recording; it can then be opened with `pipebb::recording`
+log.close();
+//
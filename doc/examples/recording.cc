@@ -0,0 +1,29 @@
+//
+// record raw samples along with the channel's name, unit, factor and offset
+//
+pipebb::channel<double> p_rail{"p_rail", "bar", 0.1, 0.0};
+
+pipebb::recording_writer writer;
+writer.add(p_rail, raw_samples);
+writer.write("incident.rec");
+//
+
+//
+// set up the same channel from the recording and replay it block by block,
+// straight from the mapped file
+//
+pipebb::recording rec("incident.rec");
+
+auto p_replayed = rec.make_channel<double>(rec.index("p_rail"));
+auto overload   = pipebb::make_threshold(p_replayed, 1800.0);
+
+pipebb::replay source(rec, 1024);
+source.bind(p_replayed);
+
+std::vector<double> scaled(source.block_size());
+while (source.next()) {
+  p_replayed.process(source.block(p_replayed), pipebb::make_span(scaled));
+  pipebb::tick();
+  overload();
+}
+//
@@ -0,0 +1,24 @@
+//
+// overboost detection, as exported from the graph editor
+//
+auto graph = pipebb::make_runtime_graph(R"(
+  p_boost  = channel(unit=mbar, factor=1.0, offset=0.0)
+  scaled   = factor(p_boost, 0.001)
+  smoothed = moving_average(scaled, 16)
+  high     = threshold(smoothed, 1.8)
+  slope    = gradient(p_boost)
+  rising   = threshold(slope, 0)
+  boost    = and(high, rising)
+  duration = boolean_counter(boost)   # ticks spent in overboost
+)");
+//
+
+auto p_boost  = graph.index("p_boost");
+auto duration = graph.index("duration");
+
+while (true) {
+  graph.set(p_boost, read_sample());
+  graph.run();
+
+  auto ticks = graph.value(duration);
+}
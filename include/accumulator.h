@@ -17,9 +17,16 @@
 #ifndef PIPEBB_ACCUMULATOR_H_
 #define PIPEBB_ACCUMULATOR_H_
 
-#include <numeric>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 
+#include "dynamic_ringbuffer.h"
+#include "node.h"
 #include "ringbuffer.h"
+#include "running_sum.h"
+#include "span.h"
+#include "utils.h"
 
 
 namespace pipebb {
@@ -28,7 +35,10 @@ namespace pipebb {
 /*!
  * \brief Class which accumulates values from its input object.
  * \param I Template parameter specifying the type of the input object.
- * \param N Template parameter specifying the size of the `accumulator`.
+ * \param N Template parameter specifying the size of the `accumulator`, or
+ *        `dynamic_extent` to set it at construction.
+ * \param A Template parameter specifying the allocator used for the window
+ *        if `N` is `dynamic_extent`.
  *
  * The `accumulator` gate is used to collect values from another gate and sum
  * them up. Let's assume you have a throughput measurement and you want to know
@@ -36,17 +46,26 @@ namespace pipebb {
  * case, you could use the `accumulator` gate with a size of 5 and call its
  * `value()` function every time step.
  *
+ * The sum is kept up to date incrementally from the value entering and the
+ * value leaving the window, so both `operator()` and `report()` are O(1)
+ * regardless of `N`. For floating point types, the sum is compensated and
+ * periodically recomputed from the window content to keep rounding errors
+ * bounded.
+ *
  * **Usage**
  * \include make_accumulator.cc
  *
  * For further examples, look into the tests.
  */
-template <class I, std::size_t N>
+template <class I,
+          std::size_t N,
+          class A = std::allocator<typename I::value_t>>
 class accumulator
 {
-  using self_t   = accumulator<I, N>;
+  using self_t   = accumulator<I, N, A>;
   using input_t  = I;
-  using buffer_t = ringbuffer<typename input_t::value_t, N>;
+  using buffer_t = detail::window_buffer_t<typename input_t::value_t, N, A>;
+  using sum_t    = detail::running_sum<typename input_t::value_t>;
 
 public:
   using value_t = typename input_t::value_t;
@@ -57,21 +76,49 @@ public:
    * \param input Input object.
    * \param use_zeros Specifies if zeros get used or not. Default: true.
    */
-  accumulator(input_t & input, bool use_zeros = true) noexcept
-   : _input(input), _use_zeros(use_zeros) {}
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  accumulator(input_t & input, bool use_zeros = true)
+   : _input(input), _use_zeros(use_zeros), _sum(resync_factor * N) {
+    _node.attach(_input);
+  }
+
+  /*!
+   * \brief Constructor for `accumulator` class with runtime window size.
+   * \param input Input object.
+   * \param window Number of accumulated values.
+   * \param use_zeros Specifies if zeros get used or not. Default: true.
+   * \param alloc Allocator to draw the window storage from.
+   * \throws std::invalid_argument if `window` is 0.
+   *
+   * Only available if `N` is `dynamic_extent`.
+   */
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  accumulator(input_t &   input,
+              std::size_t window,
+              bool        use_zeros = true,
+              const A &   alloc     = A())
+   : _input(input),
+     _use_zeros(use_zeros),
+     _buffer(detail::checked_window(window, "accumulator"), alloc),
+     _sum(resync_factor * window) {
+    _node.attach(_input);
+  }
 
   /*!
    * \brief Resets the buffer inside `accumulator` object.
    */
-  void reset() noexcept { _buffer.fill(value_t()); }
+  void reset() noexcept {
+    _buffer.fill(value_t());
+    _sum.clear();
+    _run = 0;
+    _node.invalidate();
+  }
 
   /*!
    * \brief   Get value of `accumulator` object without updating content.
    * \returns Current (non-updated) value of the gate.
    */
-  value_t report() noexcept {
-    return std::accumulate(_buffer.begin(), _buffer.end(), value_t());
-  }
+  value_t report() noexcept { return _sum.value(); }
 
   /*!
    * \brief   Update `accumulator` content, then get value.
@@ -81,34 +128,73 @@ public:
    * takes appropriate action with the result.
    */
   value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("accumulator");
+    if (_node.current()) { return _sum.value(); }
+    _node.update();
+
     value_t val = _input();
-    if (val || _use_zeros) { _buffer << val; }
-
-    /* --------------------------------------------------------------------- *
-     * std::reduce is a C++17 feature; use when it is part of libstdc++.
-     *
-     * That is, libstdc++ has to implement execution_policy support, described
-     * in proposal P0024R2 (called "The Parallelism TS should be Standardized")
-     * first, the implement std::reduce.
-     *
-     * libstdc++ C++17 progress:
-     * https://gcc.gnu.org/onlinedocs/libstdc++/manual/status.html#status.iso.201z
-     *
-     * If this has happened, uncomment the return call to std::reduce below and
-     * get rid of the return call to std::accumulate below that. Afterwards,
-     * this comment can be removed.
-     * --------------------------------------------------------------------- */
-    //
-    // return std::reduce(std::execution::par, _buffer.begin(), _buffer.end());
-    //
-
-    return std::accumulate(_buffer.begin(), _buffer.end(), value_t());
+    if (val || _use_zeros) {
+      push(val);
+
+      // the window only stops changing once it is filled with the same value
+      if (_run < _buffer.max_size()) { _node.mark_dirty(); }
+    }
+
+    return _sum.value();
+  }
+
+  /*!
+   * \brief   Update `accumulator` content with a block of input values.
+   * \param   in Values as produced by the input object.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smaller of both sizes.
+   *
+   * Equivalent to calling `operator()` once per input value, without the
+   * per-sample round trip through the input object.
+   */
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      if (in[i] || _use_zeros) { push(in[i]); }
+      out[i] = _sum.value();
+    }
+
+    _node.invalidate();
+    return count;
+  }
+
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
+private:
+  /*!
+   * \brief Number of window lengths worth of sum updates after which the sum
+   *        is recomputed from the window content. Amortizes to a constant
+   *        cost per pushed value.
+   */
+  static constexpr std::size_t resync_factor = 32;
+
+  void push(value_t value) noexcept {
+    _run = (!_buffer.empty() && value == _buffer.back()) ? _run + 1 : 1;
+
+    if (_buffer.size() == _buffer.max_size()) { _sum.remove(_buffer.front()); }
+    _buffer << value;
+    _sum.add(value);
+
+    if (_sum.stale()) { _sum.assign(_buffer.segments()); }
   }
 
 private:
-  input_t & _input;
-  bool      _use_zeros;
-  buffer_t  _buffer;
+  input_t &   _input;
+  bool        _use_zeros;
+  buffer_t    _buffer;
+  sum_t       _sum;
+  std::size_t _run{0};
+  node        _node;
 };
 
 
@@ -130,10 +216,29 @@ private:
  * \include make_accumulator.cc
  */
 template <std::size_t N, class I>
-inline accumulator<I, N> make_accumulator(I & input) noexcept {
+inline accumulator<I, N> make_accumulator(I & input) {
   return {input};
 }
 
+/*!
+ * \brief   Maker function for `accumulator` objects with runtime window size.
+ * \param   I Template parameter specifying the type of `input`.
+ * \param   A Template parameter specifying the allocator type.
+ * \param   input Input object.
+ * \param   window Number of accumulated values.
+ * \param   alloc Allocator to draw the window storage from.
+ * \returns Ready to use `accumulator` object.
+ * \throws  std::invalid_argument if `window` is 0.
+ *
+ * **Usage**
+ * \include make_accumulator.cc
+ */
+template <class I, class A = std::allocator<typename I::value_t>>
+inline accumulator<I, dynamic_extent, A> make_accumulator(
+  I & input, std::size_t window, const A & alloc = A()) {
+  return {input, window, true, alloc};
+}
+
 }  // namespace pipebb
 
 #endif  // PIPEBB_ACCUMULATOR_H_
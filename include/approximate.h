@@ -17,8 +17,26 @@
 #ifndef PIPEBB_APPROXIMATE_H_
 #define PIPEBB_APPROXIMATE_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+
 
 namespace pipebb {
+namespace detail {
+
+
+// comparison shared by approximate and runtime_graph
+template <typename A, typename B, typename T>
+inline bool within_tolerance(A lhs, B rhs, T tolerance) noexcept {
+  return (lhs > rhs ? lhs - rhs : rhs - lhs) <= tolerance;
+}
+
+}  // namespace detail
 
 
 /*!
@@ -52,14 +70,20 @@ public:
    * \param second Second input object.
    * \param tolerance Acceptable distance between input objects values'.
    */
-  approximate(I & first, J & second, value_t tolerance) noexcept
-   : _first(first), _second(second), _tolerance(tolerance) {}
+  approximate(I & first, J & second, value_t tolerance)
+   : _first(first), _second(second), _tolerance(tolerance) {
+    _node.attach(_first);
+    _node.attach(_second);
+  }
 
   /*!
    * \brief Set new tolerance value for the gate.
    * \param tolerance New tolerance.
    */
-  void set_tolerance(value_t tolerance) noexcept { _tolerance = tolerance; }
+  void set_tolerance(value_t tolerance) noexcept {
+    _tolerance = tolerance;
+    _node.invalidate();
+  }
 
   /*!
    * \brief   Update `approximate` content, then get value.
@@ -69,20 +93,72 @@ public:
    * takes appropriate action with the result.
    */
   bool operator()() noexcept {
-    auto lhs = _first();
-    auto rhs = _second();
+    PIPEBB_PROFILE_GATE("approximate");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value =
+             detail::within_tolerance(_first(), _second(), _tolerance);
+  }
+
+  /*!
+   * \brief   Compare two blocks of input values.
+   * \param   first Values as produced by the first input object.
+   * \param   second Values as produced by the second input object.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smallest of all sizes.
+   *
+   * Equivalent to calling `operator()` once per pair of input values, but in
+   * a single loop the compiler can vectorize.
+   */
+  std::size_t process(span<const typename I::value_t> first,
+                      span<const typename J::value_t> second,
+                      span<bool>                      out) noexcept {
+    std::size_t count = std::min({first.size(), second.size(), out.size()});
 
-    if (lhs > rhs) {
-      return (lhs - rhs) <= _tolerance;
-    } else {
-      return (rhs - lhs) <= _tolerance;
+    auto   lhs = first.data();
+    auto   rhs = second.data();
+    bool * dst = out.data();
+    for (std::size_t i = 0; i < count; ++i) {
+      dst[i] = detail::within_tolerance(lhs[i], rhs[i], _tolerance);
     }
+
+    _node.invalidate();
+    return count;
+  }
+
+  /*!
+   * \brief   Compare two blocks of input values into a packed bitmask.
+   * \param   first Values as produced by the first input object.
+   * \param   second Values as produced by the second input object.
+   * \param   mask Output bitmask, one bit per pair of input values, see
+   *          `simd::within()`.
+   * \returns Number of processed values, i.e. the smallest of all sizes.
+   */
+  std::size_t process(span<const typename I::value_t> first,
+                      span<const typename J::value_t> second,
+                      span<std::uint64_t>             mask) noexcept {
+    std::size_t count =
+      std::min({first.size(), second.size(), mask.size() * 64});
+
+    simd::within(first.data(), second.data(), _tolerance, mask.data(), count);
+
+    _node.invalidate();
+    return count;
   }
 
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   I &     _first;
   J &     _second;
   value_t _tolerance;
+  node    _node;
+  bool    _value{false};
 };
 
 
@@ -105,7 +181,7 @@ private:
  */
 template <class I, class J>
 inline approximate<I, J> make_approximate(
-  I & first, J & second, typename I::value_t tolerance) noexcept {
+  I & first, J & second, typename I::value_t tolerance) {
   return {first, second, tolerance};
 }
 
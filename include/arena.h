@@ -0,0 +1,138 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_ARENA_H_
+#define PIPEBB_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Monotonic allocator handing out memory from a caller-supplied block.
+ *
+ * The `arena` never frees individual allocations; memory is only reclaimed
+ * as a whole by `release()`. Allocations are laid out back to back in the
+ * order they are made, so e.g. thousands of window buffers created one
+ * after the other end up in one contiguous block of memory. The block itself
+ * is owned by the caller and must outlive the arena and everything allocated
+ * from it.
+ *
+ * Use it through `arena_allocator`.
+ */
+class arena
+{
+public:
+  /*!
+   * \brief Constructor for `arena` class.
+   * \param buffer Memory block to allocate from.
+   * \param size Size of the memory block in bytes.
+   */
+  arena(void * buffer, std::size_t size) noexcept
+   : _begin(static_cast<unsigned char *>(buffer)), _size(size) {}
+
+  arena(const arena &) = delete;
+  arena & operator=(const arena &) = delete;
+
+  /*!
+   * \brief   Allocate `size` bytes aligned to `alignment`.
+   * \returns Pointer to the allocated memory.
+   * \throws  std::bad_alloc if the arena is exhausted.
+   */
+  void * allocate(std::size_t size, std::size_t alignment) {
+    auto address = reinterpret_cast<std::uintptr_t>(_begin + _used);
+    auto padding = (alignment - address % alignment) % alignment;
+
+    if (padding + size > _size - _used) { throw std::bad_alloc(); }
+
+    void * result = _begin + _used + padding;
+    _used += padding + size;
+    return result;
+  }
+
+  /*!
+   * \brief Deallocation is a no-op; see `release()`.
+   */
+  void deallocate(void *, std::size_t) noexcept {}
+
+  /*!
+   * \brief Make the whole memory block available again. Everything allocated
+   *        from the arena must have been destroyed before.
+   */
+  void release() noexcept { _used = 0; }
+
+  std::size_t size() const noexcept { return _size; }
+  std::size_t used() const noexcept { return _used; }
+  std::size_t available() const noexcept { return _size - _used; }
+
+private:
+  unsigned char * _begin;
+  std::size_t     _size;
+  std::size_t     _used{0};
+};
+
+
+/*!
+ * \brief Standard conforming allocator drawing memory from an `arena`.
+ * \param T Template parameter specifying the allocated type.
+ */
+template <typename T>
+class arena_allocator
+{
+  template <typename U>
+  friend class arena_allocator;
+
+public:
+  using value_type = T;
+
+public:
+  arena_allocator(arena & source) noexcept : _arena(&source) {}
+
+  template <typename U>
+  arena_allocator(const arena_allocator<U> & other) noexcept
+   : _arena(other._arena) {}
+
+  T * allocate(std::size_t n) {
+    return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    _arena->deallocate(p, n * sizeof(T));
+  }
+
+  arena & source() const noexcept { return *_arena; }
+
+  template <typename U>
+  bool operator==(const arena_allocator<U> & rhs) const noexcept {
+    return _arena == rhs._arena;
+  }
+
+  template <typename U>
+  bool operator!=(const arena_allocator<U> & rhs) const noexcept {
+    return _arena != rhs._arena;
+  }
+
+private:
+  arena * _arena;
+};
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_ARENA_H_
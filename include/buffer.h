@@ -17,6 +17,8 @@
 #ifndef PIPEBB_BUFFER_H_
 #define PIPEBB_BUFFER_H_
 
+#include "node.h"
+
 
 namespace pipebb {
 
@@ -51,7 +53,7 @@ public:
    * \brief Constructor for `buffer` class.
    * \param input Input object.
    */
-  buffer(input_t & input) noexcept : _input(input) {}
+  buffer(input_t & input) : _input(input) { _node.attach(_input); }
 
   /*!
    * \brief Reset function for `buffer` class/gate.
@@ -60,7 +62,10 @@ public:
    * input object anew on the next call to `value()`. Call this at the end of
    * your loop.
    */
-  void reset() noexcept { _value = {}; }
+  void reset() noexcept {
+    _value = {};
+    _node.invalidate();
+  }
 
   /*!
    * \brief   Provides the `buffer`'s value.
@@ -68,14 +73,25 @@ public:
    *          is empty or the value stored in the `buffer`.
    */
   value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("buffer");
+    if (_node.current()) { return _value; }
+    _node.update();
+
     if (!_value) { _value = _input(); }
 
     return _value;
   }
 
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t & _input;
   value_t   _value{};
+  node      _node;
 };
 
 
@@ -94,7 +110,7 @@ private:
  * \include make_buffer.cc
  */
 template <class I>
-inline buffer<I> make_buffer(I & input) noexcept {
+inline buffer<I> make_buffer(I & input) {
   return {input};
 }
 
@@ -128,7 +144,7 @@ public:
    * \brief Constructor for `switched_buffer` class.
    * \param input Input object.
    */
-  switched_buffer(input_t & input) : _input(input) {}
+  switched_buffer(input_t & input) : _input(input) { _node.attach(_input); }
 
   /*!
    * \brief Move copy constructor for `buffer` class.
@@ -156,6 +172,7 @@ public:
     } else {
       _switch = true;
     }
+    _node.invalidate();
   }
 
   /*!
@@ -165,7 +182,10 @@ public:
    * input object anew on the next call to `value()`. Call this at the end of
    * your loop.
    */
-  void reset() noexcept { _switch = false; }
+  void reset() noexcept {
+    _switch = false;
+    _node.invalidate();
+  }
 
   /*!
    * \brief   Provides the buffer's value.
@@ -174,6 +194,10 @@ public:
    *          the buffer is active (switch is `true`).
    */
   auto operator()() noexcept {
+    PIPEBB_PROFILE_GATE("switched_buffer");
+    if (_node.current()) { return _value; }
+    _node.update();
+
     if (!_switch) {
       _switch = true;
       _value  = _input();
@@ -187,10 +211,17 @@ public:
    */
   bool state() noexcept { return _switch; }
 
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t & _input;
   value_t   _value;
   bool      _switch{false};
+  node      _node;
 };
 
 
@@ -209,7 +240,7 @@ private:
  * \include make_switched_buffer.cc
  */
 template <class I>
-inline switched_buffer<I> make_switched_buffer(I & input) noexcept {
+inline switched_buffer<I> make_switched_buffer(I & input) {
   return {input};
 }
 
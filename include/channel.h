@@ -17,14 +17,27 @@
 #ifndef PIPEBB_CHANNEL_H_
 #define PIPEBB_CHANNEL_H_
 
+#include <algorithm>
 #include <ostream>
 #include <sstream>
 #include <string>
 
+#include "node.h"
+#include "span.h"
 #include "utils.h"
 
 
 namespace pipebb {
+namespace detail {
+
+
+// normalization applied by every channel, scalar or lane-wise
+template <typename T>
+inline T normalize(T raw, T offset, T factor) noexcept {
+  return (raw + offset) * factor;
+}
+
+}  // namespace detail
 
 
 /* forward declarations ---------------------------------------------------- */
@@ -76,8 +89,10 @@ public:
   explicit channel(std::string name,
                    std::string unit,
                    value_t     factor,
-                   value_t     offset) noexcept
-   : _name(name), _unit(unit), _factor(factor), _offset(offset) {}
+                   value_t     offset)
+   : _name(name), _unit(unit), _factor(factor), _offset(offset) {
+    _node.set_name(_name);
+  }
 
   /*!
    * \brief Simplified constructor for the channel class.
@@ -86,7 +101,9 @@ public:
    * Using this constructor, the channel will have an empty unit, the factor
    * will be 1.0 and the offset will be 0.0.
    */
-  explicit channel(std::string name) noexcept : _name(name) {}
+  explicit channel(std::string name) : _name(name) {
+    _node.set_name(_name);
+  }
 
   /*!
    * \brief Default constructor for the channel class.
@@ -101,14 +118,21 @@ public:
   const self_t * dynamic_factor() const noexcept { return _dynamic_factor; }
   value_t        offset() const noexcept { return _offset; }
   const self_t * dynamic_offset() const noexcept { return _dynamic_offset; }
+  timestamp_t    timestamp() const noexcept { return _time; }
   /*!@}*/ /* --------------------------------------------------------------- */
 
   /*! \name Setters */ /*!@{*/
   /*! Setter. */       /* -------------------------------------------------- */
-  void factor(value_t factor) noexcept { _factor = factor; }
-  void factor(self_t * other) noexcept { _dynamic_factor = other; }
-  void offset(value_t offset) noexcept { _offset = offset; }
-  void offset(self_t * other) noexcept { _dynamic_offset = other; }
+  void factor(value_t factor) noexcept {
+    _factor = factor;
+    _node.invalidate();
+  }
+  void factor(self_t * other) { rewire(_dynamic_factor, other); }
+  void offset(value_t offset) noexcept {
+    _offset = offset;
+    _node.invalidate();
+  }
+  void offset(self_t * other) { rewire(_dynamic_offset, other); }
   /*!@}*/ /* --------------------------------------------------------------- */
 
   /*!
@@ -122,7 +146,25 @@ public:
   void operator<<(value_t value) noexcept {
     if (value != _raw_val) {
       _raw_val = value;
-      _updated = true;
+      _node.invalidate();
+    }
+  }
+
+  /*!
+   * \brief Write a timestamped data value.
+   * \param value Data value.
+   * \param time Time of the sample, see `timestamp_t`.
+   *
+   * Like `operator<<`, but also stores the time of the sample, which
+   * time-aware gates like `derivative` read through `timestamp()`. A new
+   * timestamp marks everything downstream dirty even if the value is
+   * unchanged, as it makes for a new sample.
+   */
+  void write(value_t value, timestamp_t time) noexcept {
+    if (value != _raw_val || time != _time) {
+      _raw_val = value;
+      _time    = time;
+      _node.invalidate();
     }
   }
 
@@ -131,14 +173,16 @@ public:
    * \returns Normalized data value.
    *
    * Every pipeBB class implements operator(). In the channel object, it is
-   * first checked if the stored value has been updated; if so, the
-   * normalization factor (static and/or from another channel or gate) and the
-   * normalization offset (static and/or from another channel or gate) are
-   * applied, then the normalized value is returned.
+   * first checked if the stored value or one of the dynamic normalization
+   * channels has been updated; if so, the normalization factor (static and/or
+   * from another channel or gate) and the normalization offset (static and/or
+   * from another channel or gate) are applied, then the normalized value is
+   * returned.
    */
   value_t operator()() noexcept {
-    if (_updated) {
-      _updated = false;
+    PIPEBB_PROFILE_GATE("channel");
+    if (!_node.current()) {
+      _node.update();
 
       value_t factor = _factor;
       if (_dynamic_factor) { factor *= _dynamic_factor->operator()(); }
@@ -146,16 +190,84 @@ public:
       value_t offset = _offset;
       if (_dynamic_offset) { offset += _dynamic_offset->operator()(); }
 
-      _out_val = (_raw_val + offset) * factor;
+      _out_val = detail::normalize(_raw_val, offset, factor);
     }
 
     return _out_val;
   }
 
+  /*!
+   * \brief   Normalize a block of data values.
+   * \param   raw Data values, as they would be written into the channel.
+   * \param   out Normalized data values.
+   * \returns Number of processed values, i.e. the smaller of both sizes.
+   *
+   * Equivalent to writing each value into the channel and calling
+   * `operator()` after each, but in a single loop the compiler can vectorize.
+   * Dynamic factor and offset are read once per block. The last value remains
+   * stored in the channel.
+   */
+  std::size_t process(span<const value_t> raw, span<value_t> out) noexcept {
+    std::size_t count = std::min(raw.size(), out.size());
+    if (!count) { return 0; }
+
+    value_t factor = _factor;
+    if (_dynamic_factor) { factor *= _dynamic_factor->operator()(); }
+
+    value_t offset = _offset;
+    if (_dynamic_offset) { offset += _dynamic_offset->operator()(); }
+
+    const value_t * src = raw.data();
+    value_t *       dst = out.data();
+    for (std::size_t i = 0; i < count; ++i) {
+      dst[i] = detail::normalize(src[i], offset, factor);
+    }
+
+    operator<<(src[count - 1]);
+    return count;
+  }
+
+  /*!
+   * \brief   Normalize a block of timestamped data values.
+   * \param   time Timestamps of the data values.
+   * \param   raw Data values, as they would be written into the channel.
+   * \param   out Normalized data values.
+   * \returns Number of processed values, i.e. the smallest of the sizes.
+   *
+   * Like `process(raw, out)`; the last value remains stored in the channel
+   * along with its timestamp.
+   */
+  std::size_t process(span<const timestamp_t> time,
+                      span<const value_t>     raw,
+                      span<value_t>           out) noexcept {
+    std::size_t count = std::min(time.size(), raw.size());
+    count = process(make_span(raw.data(), count), out);
+    if (!count) { return 0; }
+
+    write(raw[count - 1], time[count - 1]);
+    return count;
+  }
+
+  /*!
+   * \brief   Get the channel's node in the evaluation graph.
+   * \returns Reference to the channel's `node`.
+   *
+   * Writing a new value into the channel marks every gate downstream of it
+   * dirty, so that gates whose inputs have not changed can skip evaluation.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   template <typename U>
   friend std::ostream & operator<<(std::ostream &, channel<U> &);
 
+  void rewire(self_t *& current, self_t * other) {
+    if (current) { _node.detach(*current); }
+    current = other;
+    if (current) { _node.attach(*current); }
+    _node.invalidate();
+  }
+
 private:
   std::string _name;
   std::string _unit;
@@ -163,9 +275,10 @@ private:
   self_t *    _dynamic_factor{nullptr};
   value_t     _offset{0};
   self_t *    _dynamic_offset{nullptr};
-  value_t     _raw_val;
-  value_t     _out_val;
-  bool        _updated{false};
+  value_t     _raw_val{};
+  value_t     _out_val{};
+  timestamp_t _time{};
+  node        _node;
 };
 
 
@@ -196,7 +309,9 @@ public:
    * \brief Simplified constructor for the channel class.
    * \param name Nmae of the channel.
    */
-  explicit channel(std::string name) noexcept : _name(name) {}
+  explicit channel(std::string name) : _name(name) {
+    _node.set_name(_name);
+  }
 
   /*!
    * \brief Default constructor for the channel class.
@@ -207,6 +322,7 @@ public:
   /*! Getter. */       /* -------------------------------------------------- */
   std::string name() const noexcept { return _name; }
   std::string unit() const noexcept { return _unit; }
+  timestamp_t timestamp() const noexcept { return _time; }
   /*!@}*/ /* --------------------------------------------------------------- */
 
   /*!
@@ -220,7 +336,25 @@ public:
   void operator<<(value_t value) noexcept {
     if (value != _raw_val) {
       _raw_val = value;
-      _updated = true;
+      _node.invalidate();
+    }
+  }
+
+  /*!
+   * \brief Write a timestamped data value.
+   * \param value Data value.
+   * \param time Time of the sample, see `timestamp_t`.
+   *
+   * Like `operator<<`, but also stores the time of the sample, which
+   * time-aware gates like `derivative` read through `timestamp()`. A new
+   * timestamp marks everything downstream dirty even if the value is
+   * unchanged, as it makes for a new sample.
+   */
+  void write(value_t value, timestamp_t time) noexcept {
+    if (value != _raw_val || time != _time) {
+      _raw_val = value;
+      _time    = time;
+      _node.invalidate();
     }
   }
 
@@ -229,22 +363,67 @@ public:
    * \returns Boolean data value.
    */
   value_t operator()() noexcept {
-    if (_updated) {
-      _updated = false;
+    PIPEBB_PROFILE_GATE("channel");
+    if (!_node.current()) {
+      _node.update();
       _out_val = _raw_val;
     }
     return _out_val;
   }
 
+  /*!
+   * \brief   Pass a block of data values through the channel.
+   * \param   raw Data values, as they would be written into the channel.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smaller of both sizes.
+   */
+  std::size_t process(span<const value_t> raw, span<value_t> out) noexcept {
+    std::size_t count = std::min(raw.size(), out.size());
+    if (!count) { return 0; }
+
+    std::copy(raw.begin(), raw.begin() + count, out.begin());
+
+    operator<<(raw[count - 1]);
+    return count;
+  }
+
+  /*!
+   * \brief   Pass a block of timestamped data values through the channel.
+   * \param   time Timestamps of the data values.
+   * \param   raw Data values, as they would be written into the channel.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smallest of the sizes.
+   *
+   * Like `process(raw, out)`; the last value remains stored in the channel
+   * along with its timestamp.
+   */
+  std::size_t process(span<const timestamp_t> time,
+                      span<const value_t>     raw,
+                      span<value_t>           out) noexcept {
+    std::size_t count = std::min(time.size(), raw.size());
+    count = process(make_span(raw.data(), count), out);
+    if (!count) { return 0; }
+
+    write(raw[count - 1], time[count - 1]);
+    return count;
+  }
+
+  /*!
+   * \brief   Get the channel's node in the evaluation graph.
+   * \returns Reference to the channel's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   friend std::ostream & operator<<(std::ostream &, channel<bool> &);
 
 private:
   std::string _name;
   std::string _unit;
-  value_t     _raw_val;
-  value_t     _out_val;
-  bool        _updated{false};
+  value_t     _raw_val{};
+  value_t     _out_val{};
+  timestamp_t _time{};
+  node        _node;
 };
 
 
@@ -17,6 +17,8 @@
 #ifndef PIPEBB_COUNTER_H_
 #define PIPEBB_COUNTER_H_
 
+#include "node.h"
+
 
 namespace pipebb {
 
@@ -52,7 +54,10 @@ public:
   /*!
    * \brief Function to reset `counter` value to 0.
    */
-  void reset() noexcept { _counter = 0; }
+  void reset() noexcept {
+    _counter = 0;
+    _node.mark_dirty();
+  }
 
   /*!
    * \brief   Get current value of `counter`.
@@ -61,13 +66,19 @@ public:
    * Every pipeBB gate is callable. When called, it calls the input object and
    * takes appropriate action with the result.
    */
-  value_t operator()() noexcept { return _counter; }
+  value_t operator()() noexcept {
+    _node.update();
+    return _counter;
+  }
 
   /*!
    * \brief   Function to move `counter` up by one, i.e. increment it by one.
    * \returns New value of `counter` (after stepping).
    */
-  value_t step() noexcept { return ++_counter; }
+  value_t step() noexcept {
+    _node.mark_dirty();
+    return ++_counter;
+  }
 
   /*!
    * \brief   Synonymous with `step()`.
@@ -90,10 +101,17 @@ public:
    * is provided to be consistent with probably user expectation, i.e. the user
    * will expect a `counter` to be incrementable in the usual manner.
    */
-  value_t operator++(int)noexcept { return ++_counter; }
+  value_t operator++(int)noexcept { return step(); }
+
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
 
 private:
   value_t _counter{0};
+  node    _node;
 };
 
 
@@ -141,7 +159,9 @@ public:
    * \brief Constructor for `reset_counter` class.
    * \param input Input object.
    */
-  reset_counter(input_t & input) noexcept : _input(input) {}
+  reset_counter(input_t & input) : _input(input) {
+    _node.attach(_input);
+  }
 
   /*!
    * \brief Move copy constructor for `reset_counter` class.
@@ -161,18 +181,32 @@ public:
    * takes appropriate action with the result.
    */
   value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("reset_counter");
+    if (_node.current()) { return _counter(); }
+    _node.update();
+
+    // a counter held at zero by its input has settled, one that counts up
+    // has to be evaluated again on the next call
     if (_input()) {
       _counter.reset();
     } else {
       _counter.step();
+      _node.mark_dirty();
     }
 
     return _counter();
   }
 
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t & _input;
   counter   _counter;
+  node      _node;
 };
 
 
@@ -191,7 +225,7 @@ private:
  * \include make_counter.cc
  */
 template <class I>
-inline reset_counter<I> make_reset_counter(I & input) noexcept {
+inline reset_counter<I> make_reset_counter(I & input) {
   return {input};
 }
 
@@ -225,7 +259,9 @@ public:
    * \brief Constructor for `boolean_counter` class.
    * \param input Input object.
    */
-  boolean_counter(input_t & input) noexcept : _input(input) {}
+  boolean_counter(input_t & input) : _input(input) {
+    _node.attach(_input);
+  }
 
   /*!
    * \brief Move copy constructor for `boolean_counter` class.
@@ -245,12 +281,27 @@ public:
    * takes appropriate action with the result.
    */
   value_t operator()() noexcept {
-    return (_input() ? _counter.step() : _counter());
+    PIPEBB_PROFILE_GATE("boolean_counter");
+    if (_node.current()) { return _counter(); }
+    _node.update();
+
+    if (!_input()) { return _counter(); }
+
+    // counts up for as long as the input holds
+    _node.mark_dirty();
+    return _counter.step();
   }
 
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t & _input;
   counter   _counter;
+  node      _node;
 };
 
 
@@ -269,7 +320,7 @@ private:
  * \include make_counter.cc
  */
 template <class I>
-inline boolean_counter<I> make_boolean_counter(I & input) noexcept {
+inline boolean_counter<I> make_boolean_counter(I & input) {
   return {input};
 }
 
@@ -296,7 +347,9 @@ public:
    * \brief Constructor for `counter_watchdog` class.
    * \param c The counter to watch.
    */
-  counter_watchdog(counter & c) : _counter(c), _value(_counter()) {}
+  counter_watchdog(counter & c) : _counter(c), _value(_counter()) {
+    _node.attach(_counter);
+  }
 
   /*!
    * \brief Move copy constructor for `counter_watchdog` class.
@@ -316,19 +369,34 @@ public:
    * takes appropriate action with the result.
    */
   bool operator()() noexcept {
+    PIPEBB_PROFILE_GATE("counter_watchdog");
+    if (_node.current()) { return _changed; }
+    _node.update();
+
     auto val = _counter();
 
     if (_value != val) {
       _value = val;
-      return true;
+
+      // reports the change once, settles on the next call
+      _node.mark_dirty();
+      return _changed = true;
     } else {
-      return false;
+      return _changed = false;
     }
   }
 
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   counter & _counter;
   value_t   _value;
+  node      _node;
+  bool      _changed{false};
 };
 
 
@@ -343,7 +411,7 @@ private:
  * **Usage**
  * \include make_counter.cc
  */
-inline counter_watchdog make_counter_watchdog(counter & c) noexcept {
+inline counter_watchdog make_counter_watchdog(counter & c) {
   return {c};
 }
 
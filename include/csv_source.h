@@ -0,0 +1,572 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_CSV_SOURCE_H_
+#define PIPEBB_CSV_SOURCE_H_
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "channel.h"
+#include "executor.h"
+#include "mapped_file.h"
+#include "recording.h"
+#include "span.h"
+
+
+namespace pipebb {
+namespace detail {
+
+
+inline bool is_blank(char c) noexcept { return c == ' ' || c == '\t'; }
+
+inline bool is_digit(char c) noexcept {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+
+/*!
+ * \brief Decimal number being parsed: `mantissa * 10^exponent`.
+ *
+ * At most 19 digits are kept in the mantissa, so it can't overflow; `exact`
+ * is cleared if a non-zero digit had to be dropped.
+ */
+struct decimal
+{
+  std::uint64_t mantissa{0};
+  int           digits{0};
+  int           exponent{0};
+  bool          exact{true};
+};
+
+
+/*!
+ * \brief Appends the digits at `p` to a decimal.
+ * \param fraction Whether the digits follow the decimal point.
+ * \returns Position behind the digits.
+ */
+inline const char * parse_digits(const char * p,
+                                 const char * end,
+                                 decimal &    d,
+                                 bool         fraction) noexcept {
+  for (; p != end && is_digit(*p); ++p) {
+    if (d.digits < 19) {
+      d.mantissa = d.mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+      ++d.digits;
+      d.exponent -= fraction;
+    } else {
+      d.exponent += !fraction;
+      d.exact &= *p == '0';
+    }
+  }
+  return p;
+}
+
+
+/*!
+ * \brief Parses a decimal integer.
+ * \returns Position behind the number, `nullptr` if there is none or it
+ *          doesn't fit into `T`.
+ */
+template <typename T>
+inline const char *
+parse_integer(const char * p, const char * end, T & value) noexcept {
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  decimal      d;
+  const char * start = p;
+  p                  = parse_digits(p, end, d, false);
+  if (p == start || !d.exact || d.exponent != 0) {
+    // no digits at all or more than 19, only the latter may still fit
+    if (p == start || p - start > 20) { return nullptr; }
+
+    constexpr std::uint64_t limit =
+      std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t last = static_cast<std::uint64_t>(p[-1] - '0');
+    if (d.mantissa > (limit - last) / 10) { return nullptr; }
+    d.mantissa = d.mantissa * 10 + last;
+  }
+
+  auto max = static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+  if (std::is_signed<T>::value) {
+    if (d.mantissa > max + negative) { return nullptr; }
+    value = static_cast<T>(negative ? 0 - d.mantissa : d.mantissa);
+  } else {
+    if ((negative && d.mantissa != 0) || d.mantissa > max) { return nullptr; }
+    value = static_cast<T>(d.mantissa);
+  }
+  return p;
+}
+
+
+/*!
+ * \brief Parses a decimal floating point number.
+ * \returns Position behind the number, `nullptr` if there is none.
+ *
+ * Numbers whose significant digits form an integer of at most 2^53 and
+ * whose decimal exponent is at most 22 in magnitude are converted exactly
+ * and correctly rounded with a single multiplication or division by an
+ * exact power of ten. Everything else, including `inf` and `nan`, is handed
+ * to `std::strtod()`.
+ */
+inline const char *
+parse_real(const char * p, const char * end, double & value) {
+  static const double powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  const char * start = p;
+
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  decimal      d;
+  const char * digits = p;
+  p                   = parse_digits(p, end, d, false);
+  if (p != end && *p == '.') { p = parse_digits(p + 1, end, d, true); }
+  bool any = p - digits > (p[-1] == '.' ? 1 : 0);
+
+  if (any && p != end && (*p == 'e' || *p == 'E')) {
+    const char * q                 = p + 1;
+    bool         negative_exponent = false;
+    if (q != end && (*q == '-' || *q == '+')) {
+      negative_exponent = *q == '-';
+      ++q;
+    }
+    if (q != end && is_digit(*q)) {
+      int e = 0;
+      for (; q != end && is_digit(*q); ++q) {
+        if (e < 10000) { e = e * 10 + (*q - '0'); }
+      }
+      d.exponent += negative_exponent ? -e : e;
+      p = q;
+    }
+  }
+
+  if (any && d.exact && d.mantissa <= (std::uint64_t{1} << 53) &&
+      d.exponent >= -22 && d.exponent <= 22) {
+    double result = static_cast<double>(d.mantissa);
+    result = d.exponent < 0 ? result / powers[-d.exponent]
+                            : result * powers[d.exponent];
+    value  = negative ? -result : result;
+    return p;
+  }
+
+  // the field isn't terminated, strtod() needs a copy
+  const char * stop = start;
+  while (stop != end &&
+         (std::isalnum(static_cast<unsigned char>(*stop)) || *stop == '+' ||
+          *stop == '-' || *stop == '.')) {
+    ++stop;
+  }
+  std::string field(start, stop);
+  char *      parsed;
+  value = std::strtod(field.c_str(), &parsed);
+  if (parsed == field.c_str()) { return nullptr; }
+  return start + (parsed - field.c_str());
+}
+
+
+template <typename T>
+inline const char *
+parse_field(const char * p, const char * end, T & value, std::true_type) {
+  return parse_integer(p, end, value);
+}
+
+template <typename T>
+inline const char *
+parse_field(const char * p, const char * end, T & value, std::false_type) {
+  double real;
+  p     = parse_real(p, end, real);
+  value = static_cast<T>(real);
+  return p;
+}
+
+// any integer but 0 is true, no matter whether it fits into an integer type
+inline const char *
+parse_field(const char * p, const char * end, bool & value, std::true_type) {
+  if (p != end && (*p == '-' || *p == '+')) { ++p; }
+
+  const char * start = p;
+  value              = false;
+  for (; p != end && is_digit(*p); ++p) { value |= *p != '0'; }
+  return p == start ? nullptr : p;
+}
+
+template <typename T>
+inline const char *
+parse_sample(const char * p, const char * end, char * slot) {
+  T value;
+  p = parse_field(p, end, value, std::is_integral<T>{});
+  if (p) { std::memcpy(slot, &value, sizeof(T)); }
+  return p;
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Source feeding channels from a CSV file.
+ *
+ * The first line of the file names the columns; every further line holds
+ * one sample per column, separated by `delimiter`. Blanks around fields are
+ * ignored, as are empty lines and carriage returns before line feeds.
+ * Channels are bound to columns by name, columns without a channel are
+ * skipped.
+ *
+ * The file is mapped into memory and parsed a window at a time: each window
+ * is cut into chunks at line boundaries, which are parsed in parallel on a
+ * pool of threads into one array per bound column. The samples are then
+ * handed out like by `replay`: sample by sample with `step()`, or block by
+ * block with `next()` and `block()`, ready for `channel::process()`. Blocks
+ * end at chunk boundaries, so they may be shorter than `block_size`.
+ *
+ * Integers are parsed exactly, with a range check. Floating point numbers
+ * whose significant digits form an integer of at most 2^53 and whose
+ * decimal exponent is at most 22 in magnitude are converted on a fast path
+ * which is exact and correctly rounded; everything else is left to
+ * `std::strtod()`. `float` samples are parsed as `double` and then rounded.
+ * Boolean columns hold integers of any length, any value but 0 is `true`.
+ *
+ * Malformed lines are reported by throwing `std::runtime_error`, naming the
+ * offending line. Bound channels must not be moved.
+ *
+ * \include csv_source.cc
+ */
+class csv_source
+{
+public:
+  /*!
+   * \brief Constructor for `csv_source` class.
+   * \param path Path of the CSV file.
+   * \param block_size Maximum number of samples per block.
+   * \param threads Number of threads to parse on, including the one calling
+   *        `next()` or `step()`. Default: number of hardware threads.
+   * \param chunk_size Number of bytes parsed per task.
+   * \param delimiter Field separator.
+   * \throws std::runtime_error if the file can't be read.
+   */
+  explicit csv_source(
+    const std::string & path,
+    std::size_t         block_size = 1024,
+    std::size_t threads    = std::max(std::thread::hardware_concurrency(), 1u),
+    std::size_t chunk_size = std::size_t{1} << 20,
+    char        delimiter  = ',')
+   : _file(path),
+     _pool(threads),
+     _block_size(std::max<std::size_t>(block_size, 1)),
+     _chunk_size(std::max<std::size_t>(chunk_size, 1)),
+     _delimiter(delimiter) {
+    const char * p   = _file.data();
+    const char * end = p + _file.size();
+
+    // the header: one name per field
+    for (;;) {
+      const char * stop = p;
+      while (stop != end && *stop != _delimiter && *stop != '\n') { ++stop; }
+
+      const char * first = p;
+      const char * last  = stop;
+      while (first != last && detail::is_blank(*first)) { ++first; }
+      while (first != last &&
+             (detail::is_blank(last[-1]) || last[-1] == '\r')) {
+        --last;
+      }
+      if (last - first >= 2 && *first == '"' && last[-1] == '"') {
+        ++first;
+        --last;
+      }
+      _names.emplace_back(first, last);
+
+      p = stop;
+      if (p == end || *p++ == '\n') { break; }
+    }
+
+    _cursor = p - _file.data();
+    _line   = 2;
+    _fields.assign(_names.size(), std::size_t{no_binding});
+  }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  const std::vector<std::string> & columns() const noexcept { return _names; }
+  std::size_t block_size() const noexcept { return _block_size; }
+  std::size_t threads() const noexcept { return _pool.size(); }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  /*!
+   * \brief Binds a channel to the column of the same name.
+   * \throws std::runtime_error if there is no such column, it is bound
+   *         already, or samples have been read already.
+   */
+  template <typename T>
+  void bind(channel<T> & ch) {
+    auto found = std::find(_names.begin(), _names.end(), ch.name());
+    if (found == _names.end()) {
+      throw std::runtime_error("unknown column '" + ch.name() + "'");
+    }
+
+    std::size_t field = static_cast<std::size_t>(found - _names.begin());
+    if (_started || _fields[field] != no_binding) {
+      throw std::runtime_error("cannot bind '" + ch.name() + "'");
+    }
+
+    _fields[field] = _bindings.size();
+    _bindings.push_back({&ch, field, sizeof(T), &detail::parse_sample<T>,
+                         &detail::feed_channel<T>});
+  }
+
+  /*!
+   * \brief Writes the next sample of each column into its channel.
+   * \return False if the file is exhausted.
+   * \throws std::runtime_error if a line is malformed.
+   */
+  bool step() {
+    if (advance(1) == 0) { return false; }
+
+    const chunk_t & c = _chunks[_current];
+    for (std::size_t b = 0; b < _bindings.size(); ++b) {
+      _bindings[b].feed(_bindings[b].target,
+                        reinterpret_cast<const char *>(c.data[b].data()),
+                        _begin);
+    }
+    return true;
+  }
+
+  /*!
+   * \brief Advances to the next block.
+   * \return Number of samples in the block, 0 if the file is exhausted.
+   * \throws std::runtime_error if a line is malformed.
+   */
+  std::size_t next() { return advance(_block_size); }
+
+  /*!
+   * \brief Samples of the current block for a bound channel.
+   * \throws std::runtime_error if the channel is not bound.
+   */
+  template <typename T>
+  span<const T> block(const channel<T> & ch) const {
+    for (std::size_t b = 0; b < _bindings.size(); ++b) {
+      if (_bindings[b].target == &ch) {
+        const auto & data = _chunks[_current].data[b];
+        return make_span(reinterpret_cast<const T *>(data.data()) + _begin,
+                         _count);
+      }
+    }
+    throw std::runtime_error("channel '" + ch.name() + "' is not bound");
+  }
+
+private:
+  static constexpr std::size_t no_binding = static_cast<std::size_t>(-1);
+
+  struct binding_t
+  {
+    void *      target;
+    std::size_t field;
+    std::size_t size;
+    const char * (*parse)(const char *, const char *, char *);
+    void (*feed)(void *, const char *, std::size_t);
+  };
+
+  struct chunk_t
+  {
+    const char *                               begin;
+    const char *                               end;
+    std::size_t                                line;
+    std::size_t                                rows;
+    std::vector<std::vector<std::max_align_t>> data;
+    std::exception_ptr                         error;
+  };
+
+  std::size_t advance(std::size_t limit) {
+    _started = true;
+
+    while (_current >= _chunks.size() || _row == _chunks[_current].rows) {
+      if (_current + 1 < _chunks.size()) {
+        ++_current;
+        _row = 0;
+      } else if (!parse_window()) {
+        _count = 0;
+        return 0;
+      }
+    }
+
+    _begin = _row;
+    _count = std::min(limit, _chunks[_current].rows - _row);
+    _row += _count;
+    return _count;
+  }
+
+  // cuts the next window of the file into chunks at line ends and parses
+  // them on the pool
+  bool parse_window() {
+    const char * p   = _file.data() + _cursor;
+    const char * end = _file.data() + _file.size();
+    if (p == end) { return false; }
+
+    std::size_t tasks = _pool.size();
+    _chunks.resize(tasks);
+
+    std::size_t used = 0;
+    for (std::size_t t = 0; t < tasks && p != end; ++t, ++used) {
+      const char * stop = p + std::min<std::size_t>(_chunk_size, end - p);
+      if (stop != end) {
+        auto found = static_cast<const char *>(
+          std::memchr(stop, '\n', static_cast<std::size_t>(end - stop)));
+        stop = found ? found + 1 : end;
+      }
+
+      chunk_t & c = _chunks[t];
+      c.begin     = p;
+      c.end       = stop;
+      c.line      = _line;
+      c.rows      = 0;
+      c.error     = nullptr;
+      for (const char * q = p; q != stop; ++c.rows) {
+        auto found = static_cast<const char *>(
+          std::memchr(q, '\n', static_cast<std::size_t>(stop - q)));
+        q = found ? found + 1 : stop;
+      }
+
+      _line += c.rows;
+      p = stop;
+    }
+    _chunks.resize(used);
+    _cursor = p - _file.data();
+
+    std::vector<std::size_t> order(used);
+    for (std::size_t t = 0; t < used; ++t) { order[t] = t; }
+    _pool.run(order, [this](std::size_t t) { parse_chunk(_chunks[t]); });
+
+    for (auto & c : _chunks) {
+      if (c.error) { std::rethrow_exception(c.error); }
+    }
+
+    _current = 0;
+    _row     = 0;
+    return true;
+  }
+
+  void parse_chunk(chunk_t & c) noexcept {
+    try {
+      std::vector<char *> slots(_bindings.size());
+      c.data.resize(_bindings.size());
+      for (std::size_t b = 0; b < _bindings.size(); ++b) {
+        std::size_t bytes = c.rows * _bindings[b].size;
+        c.data[b].resize(bytes / sizeof(std::max_align_t) + 1);
+        slots[b] = reinterpret_cast<char *>(c.data[b].data());
+      }
+
+      const char * p    = c.begin;
+      std::size_t  rows = 0;
+      for (std::size_t line = c.line; p != c.end; ++line) {
+        if (*p == '\n' || (*p == '\r' && p + 1 != c.end && p[1] == '\n')) {
+          p += *p == '\r' ? 2 : 1;
+          continue;
+        }
+        p = parse_line(p, c.end, slots, rows++, line);
+      }
+      c.rows = rows;
+    } catch (...) {
+      c.error = std::current_exception();
+    }
+  }
+
+  const char * parse_line(const char *                p,
+                          const char *                end,
+                          const std::vector<char *> & slots,
+                          std::size_t                 row,
+                          std::size_t                 line) const {
+    auto fail = [&](const std::string & what) {
+      return std::runtime_error("line " + std::to_string(line) + ": " + what);
+    };
+
+    for (std::size_t f = 0; f < _fields.size(); ++f) {
+      if (f > 0) {
+        if (p == end || *p != _delimiter) {
+          throw fail("expected " + std::to_string(_fields.size()) +
+                     " fields");
+        }
+        ++p;
+      }
+
+      std::size_t b = _fields[f];
+      if (b == no_binding) {
+        while (p != end && *p != _delimiter && *p != '\n') { ++p; }
+        continue;
+      }
+
+      while (p != end && detail::is_blank(*p)) { ++p; }
+      const binding_t & binding = _bindings[b];
+      // most archives hold doubles, which skip the indirect call
+      char *       slot = slots[b] + row * binding.size;
+      const char * next = binding.parse == &detail::parse_sample<double>
+                            ? detail::parse_sample<double>(p, end, slot)
+                            : binding.parse(p, end, slot);
+      if (!next) { throw fail("invalid value for '" + _names[f] + "'"); }
+      p = next;
+      while (p != end && (detail::is_blank(*p) || *p == '\r')) { ++p; }
+    }
+
+    if (p != end && *p != '\n') {
+      throw fail("expected " + std::to_string(_fields.size()) + " fields");
+    }
+    return p == end ? p : p + 1;
+  }
+
+private:
+  detail::mapped_file        _file;
+  detail::work_stealing_pool _pool;
+  std::size_t                _block_size;
+  std::size_t                _chunk_size;
+  char                       _delimiter;
+
+  std::vector<std::string> _names;
+  std::vector<std::size_t> _fields;
+  std::vector<binding_t>   _bindings;
+  bool                     _started{false};
+
+  std::size_t          _cursor{0};
+  std::size_t          _line{0};
+  std::vector<chunk_t> _chunks;
+  std::size_t          _current{0};
+  std::size_t          _row{0};
+  std::size_t          _begin{0};
+  std::size_t          _count{0};
+};
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_CSV_SOURCE_H_
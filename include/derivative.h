@@ -0,0 +1,579 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_DERIVATIVE_H_
+#define PIPEBB_DERIVATIVE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "dynamic_ringbuffer.h"
+#include "node.h"
+#include "ringbuffer.h"
+#include "span.h"
+#include "utils.h"
+
+
+namespace pipebb {
+namespace detail {
+
+
+// rates of integral signals are fractional
+template <typename T>
+using rate_t = std::conditional_t<std::is_floating_point<T>::value, T, double>;
+
+}  // namespace detail
+
+
+/*!
+ * \brief Class which calculates the rate of change between two timestamped
+ *        samples.
+ * \param I Template parameter specifying the type of the input object.
+ * \param C Template parameter specifying the type of the object providing
+ *        the timestamps through `timestamp()`, usually a `channel`.
+ *
+ * The `derivative` gate is the time-aware counterpart of `gradient`: it
+ * divides the difference between the last two samples by the difference
+ * between their timestamps (see `channel::write()`), so event-driven sources
+ * with jitter yield proper rates. The result is floating point, integral
+ * inputs are not truncated.
+ *
+ * A sample is new if its timestamp differs from the previous one; a value
+ * evaluated with the same timestamp replaces the last sample. Until two
+ * samples have been seen, the derivative is zero. The timestamps may come
+ * from another object than the values, e.g. to differentiate a filtered
+ * signal using the timestamps of the channel it is computed from.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ *
+ * For further examples, look into the tests.
+ */
+template <class I, class C = I>
+class derivative
+{
+  using self_t   = derivative<I, C>;
+  using input_t  = I;
+  using source_t = C;
+
+public:
+  using value_t = detail::rate_t<typename input_t::value_t>;
+
+public:
+  /*!
+   * \brief Constructor for `derivative` class, for inputs carrying their own
+   *        timestamps.
+   * \param input Input object.
+   */
+  template <class S = C, REQUIRES(std::is_same<S, I>::value)>
+  derivative(input_t & input) : derivative(input, input) {}
+
+  /*!
+   * \brief Constructor for `derivative` class.
+   * \param input Input object.
+   * \param source Object providing the timestamps of the input's samples.
+   */
+  derivative(input_t & input, source_t & source)
+   : _input(input), _source(source) {
+    _node.attach(_input);
+    if (static_cast<void *>(&_source) != static_cast<void *>(&_input)) {
+      _node.attach(_source);
+    }
+  }
+
+  /*!
+   * \brief Move copy constructor for `derivative` class.
+   * \param other Universal reference to object to acquire membership of.
+   */
+  derivative(self_t && other) = default;
+
+  /*!
+   * \brief Function to reset the gate.
+   */
+  void reset() noexcept {
+    _count = 0;
+    _node.invalidate();
+  }
+
+  /*!
+   * \brief   Update `derivative` content, then get value.
+   * \returns Current (updated) value of the gate.
+   *
+   * Every pipeBB gate is callable. When called, it calls the input object and
+   * takes appropriate action with the result.
+   */
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("derivative");
+    if (_node.current()) { return rate(); }
+    _node.update();
+
+    auto value = static_cast<value_t>(_input());
+    step(_source.timestamp(), value);
+
+    return rate();
+  }
+
+  /*!
+   * \brief   Calculate the derivatives of a block of timestamped values.
+   * \param   time Timestamps of the input values.
+   * \param   in Values as produced by the input object.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smallest of the sizes.
+   *
+   * Equivalent to calling `operator()` once per input value. Blocks without
+   * repeated timestamps are computed in a single loop the compiler can
+   * vectorize. Afterwards, the gate continues from the last input value.
+   */
+  std::size_t process(span<const timestamp_t>               time,
+                      span<const typename input_t::value_t> in,
+                      span<value_t>                         out) noexcept {
+    std::size_t count = std::min({time.size(), in.size(), out.size()});
+    if (!count) { return 0; }
+
+    const timestamp_t * ts  = time.data();
+    auto                src = in.data();
+    value_t *           dst = out.data();
+
+    step(ts[0], static_cast<value_t>(src[0]));
+    dst[0] = rate();
+
+    bool repeated = false;
+    for (std::size_t i = 1; i < count; ++i) {
+      dst[i] = (static_cast<value_t>(src[i]) -
+                static_cast<value_t>(src[i - 1])) /
+               static_cast<value_t>(ts[i] - ts[i - 1]);
+      repeated |= ts[i] == ts[i - 1];
+    }
+
+    if (repeated) {
+      for (std::size_t i = 1; i < count; ++i) {
+        step(ts[i], static_cast<value_t>(src[i]));
+        dst[i] = rate();
+      }
+    } else if (count > 1) {
+      _first  = {ts[count - 2], static_cast<value_t>(src[count - 2])};
+      _second = {ts[count - 1], static_cast<value_t>(src[count - 1])};
+      _count  = 2;
+    }
+
+    _node.invalidate();
+    return count;
+  }
+
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
+private:
+  struct sample_t
+  {
+    timestamp_t time;
+    value_t     value;
+  };
+
+  void step(timestamp_t time, value_t value) noexcept {
+    if (_count > 0 && time == _second.time) {
+      _second.value = value;
+      return;
+    }
+
+    _first  = _second;
+    _second = {time, value};
+    _count  = std::min(_count + 1, 2);
+  }
+
+  value_t rate() const noexcept {
+    if (_count < 2) { return value_t(); }
+    return (_second.value - _first.value) /
+           static_cast<value_t>(_second.time - _first.time);
+  }
+
+private:
+  input_t &  _input;
+  source_t & _source;
+  sample_t   _first{};
+  sample_t   _second{};
+  int        _count{0};
+  node       _node;
+};
+
+
+/*!
+ * \brief  Maker function to facilitate creating `derivative` objects.
+ * \param  I Template parameter specifying type of input.
+ * \param  input Input object, carrying its own timestamps.
+ * \return Ready to use `derivative` object.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ */
+template <class I>
+inline derivative<I> make_derivative(I & input) {
+  return {input};
+}
+
+/*!
+ * \brief  Maker function for `derivative` objects with a separate source of
+ *         timestamps.
+ * \param  I Template parameter specifying type of input.
+ * \param  C Template parameter specifying type of the timestamp source.
+ * \param  input Input object.
+ * \param  source Object providing the timestamps of the input's samples.
+ * \return Ready to use `derivative` object.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ */
+template <class I, class C>
+inline derivative<I, C> make_derivative(I & input, C & source) {
+  return {input, source};
+}
+
+
+/*!
+ * \brief Class which calculates the rate of change over a range of
+ *        timestamped samples.
+ * \param I Template parameter specifying the type of the input object.
+ * \param N Template parameter specifying the number of samples in the
+ *        range, or `dynamic_extent` to set it at construction.
+ * \param C Template parameter specifying the type of the object providing
+ *        the timestamps through `timestamp()`, usually a `channel`.
+ * \param A Template parameter specifying the allocator used for the range if
+ *        `N` is `dynamic_extent`.
+ *
+ * The `varstep_derivative` gate is the time-aware counterpart of
+ * `varstep_gradient`: it divides the difference between the newest and the
+ * oldest of the last `N` samples by the difference between their
+ * timestamps. Samples are told apart by their timestamps like in
+ * `derivative`. Until the range is filled, the oldest sample seen so far is
+ * used; with fewer than two samples, the derivative is zero.
+ *
+ * The timestamps are kept in a range of their own next to the values, so
+ * only this gate pays for them; `ringbuffer`s and the windows of all other
+ * gates hold values only.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ *
+ * For further examples, look into the tests.
+ */
+template <class I,
+          std::size_t N,
+          class C = I,
+          class A = std::allocator<detail::rate_t<typename I::value_t>>>
+class varstep_derivative
+{
+  using self_t   = varstep_derivative<I, N, C, A>;
+  using input_t  = I;
+  using source_t = C;
+
+public:
+  using value_t = detail::rate_t<typename input_t::value_t>;
+
+private:
+  using time_alloc_t =
+    typename std::allocator_traits<A>::template rebind_alloc<timestamp_t>;
+  using values_t = detail::window_buffer_t<value_t, N, A>;
+  using times_t  = detail::window_buffer_t<timestamp_t, N, time_alloc_t>;
+
+public:
+  /*!
+   * \brief Constructor for `varstep_derivative` class, for inputs carrying
+   *        their own timestamps.
+   * \param input Input object.
+   */
+  template <std::size_t M = N,
+            class S       = C,
+            REQUIRES(M != dynamic_extent && std::is_same<S, I>::value)>
+  varstep_derivative(input_t & input) : varstep_derivative(input, input) {}
+
+  /*!
+   * \brief Constructor for `varstep_derivative` class.
+   * \param input Input object.
+   * \param source Object providing the timestamps of the input's samples.
+   */
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  varstep_derivative(input_t & input, source_t & source)
+   : _input(input), _source(source) {
+    attach();
+  }
+
+  /*!
+   * \brief Constructor for `varstep_derivative` class with runtime range,
+   *        for inputs carrying their own timestamps.
+   * \param input Input object.
+   * \param distance Number of samples in the range.
+   * \param alloc Allocator to draw the range storage from.
+   * \throws std::invalid_argument if `distance` is 0.
+   *
+   * Only available if `N` is `dynamic_extent`.
+   */
+  template <std::size_t M = N,
+            class S       = C,
+            REQUIRES(M == dynamic_extent && std::is_same<S, I>::value)>
+  varstep_derivative(input_t &   input,
+                     std::size_t distance,
+                     const A &   alloc = A())
+   : varstep_derivative(input, input, distance, alloc) {}
+
+  /*!
+   * \brief Constructor for `varstep_derivative` class with runtime range.
+   * \param input Input object.
+   * \param source Object providing the timestamps of the input's samples.
+   * \param distance Number of samples in the range.
+   * \param alloc Allocator to draw the range storage from.
+   * \throws std::invalid_argument if `distance` is 0.
+   *
+   * Only available if `N` is `dynamic_extent`.
+   */
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  varstep_derivative(input_t &   input,
+                     source_t &  source,
+                     std::size_t distance,
+                     const A &   alloc = A())
+   : _input(input),
+     _source(source),
+     _values(detail::checked_window(distance, "varstep_derivative"), alloc),
+     _times(distance, time_alloc_t(alloc)) {
+    attach();
+  }
+
+  /*!
+   * \brief Move copy constructor for `varstep_derivative` class.
+   * \param other Universal reference to object to acquire ownership of.
+   */
+  varstep_derivative(self_t && other) = default;
+
+  /*!
+   * \brief Function to reset gate.
+   */
+  void reset() noexcept {
+    while (!_values.empty()) {
+      _values.pop_back();
+      _times.pop_back();
+    }
+    _node.invalidate();
+  }
+
+  /*!
+   * \brief   Update `varstep_derivative` content, then get value.
+   * \returns Current (updated) value of the gate.
+   *
+   * Every pipeBB gate is callable. When called, it calls the input object and
+   * takes appropriate action with the result.
+   */
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("varstep_derivative");
+    if (_node.current()) { return rate(); }
+    _node.update();
+
+    auto value = static_cast<value_t>(_input());
+    step(_source.timestamp(), value);
+
+    return rate();
+  }
+
+  /*!
+   * \brief   Calculate the derivatives of a block of timestamped values.
+   * \param   time Timestamps of the input values.
+   * \param   in Values as produced by the input object.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smallest of the sizes.
+   *
+   * Equivalent to calling `operator()` once per input value. Unless the
+   * block repeats timestamps, only the first `N - 1` outputs reach back into
+   * the range; the rest are computed within the block, in a loop the
+   * compiler can vectorize.
+   */
+  std::size_t process(span<const timestamp_t>               time,
+                      span<const typename input_t::value_t> in,
+                      span<value_t>                         out) noexcept {
+    std::size_t count = std::min({time.size(), in.size(), out.size()});
+
+    const timestamp_t * ts  = time.data();
+    auto                src = in.data();
+    value_t *           dst = out.data();
+
+    bool repeated = false;
+    for (std::size_t i = 1; i < count; ++i) {
+      repeated |= ts[i] == ts[i - 1];
+    }
+
+    std::size_t reach = _values.max_size() - 1;
+    std::size_t head  = (repeated || reach == 0) ? count
+                                                  : std::min(count, reach);
+
+    for (std::size_t i = 0; i < head; ++i) {
+      step(ts[i], static_cast<value_t>(src[i]));
+      dst[i] = rate();
+    }
+    for (std::size_t i = head; i < count; ++i) {
+      dst[i] = (static_cast<value_t>(src[i]) -
+                static_cast<value_t>(src[i - reach])) /
+               static_cast<value_t>(ts[i] - ts[i - reach]);
+    }
+
+    // only the last samples of the block end up in the range
+    std::size_t keep = std::max(head, count - std::min(count, reach + 1));
+    for (std::size_t i = keep; i < count; ++i) {
+      _values.push(static_cast<value_t>(src[i]));
+      _times.push(ts[i]);
+    }
+
+    _node.invalidate();
+    return count;
+  }
+
+  /*!
+   * \brief   Get the range of values used for calculating the derivative.
+   * \returns Circular buffer containing the current values, oldest first.
+   */
+  const values_t & range() const noexcept { return _values; }
+
+  /*!
+   * \brief   Get the timestamps of the values in the range.
+   * \returns Circular buffer containing the current timestamps.
+   */
+  const times_t & times() const noexcept { return _times; }
+
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
+private:
+  void attach() {
+    _node.attach(_input);
+    if (static_cast<void *>(&_source) != static_cast<void *>(&_input)) {
+      _node.attach(_source);
+    }
+  }
+
+  void step(timestamp_t time, value_t value) noexcept {
+    if (!_times.empty() && time == _times.back()) {
+      _values.pop_back();
+      _times.pop_back();
+    }
+    _values.push(value);
+    _times.push(time);
+  }
+
+  value_t rate() const noexcept {
+    if (_values.size() < 2) { return value_t(); }
+    return (_values.back() - _values.front()) /
+           static_cast<value_t>(_times.back() - _times.front());
+  }
+
+private:
+  input_t &  _input;
+  source_t & _source;
+  values_t   _values;
+  times_t    _times;
+  node       _node;
+};
+
+
+/*!
+ * \brief   Maker function to facilitate creating `varstep_derivative`
+ *          objects.
+ * \param   N Template parameter specifying the number of samples in the
+ *          range.
+ * \param   I Template parameter specifying the type of `input`.
+ * \param   input Input object, carrying its own timestamps.
+ * \returns Ready to use `varstep_derivative` object.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ */
+template <std::size_t N, class I>
+inline varstep_derivative<I, N> make_varstep_derivative(I & input) {
+  return {input};
+}
+
+/*!
+ * \brief   Maker function for `varstep_derivative` objects with a separate
+ *          source of timestamps.
+ * \param   N Template parameter specifying the number of samples in the
+ *          range.
+ * \param   I Template parameter specifying the type of `input`.
+ * \param   C Template parameter specifying the type of `source`.
+ * \param   input Input object.
+ * \param   source Object providing the timestamps of the input's samples.
+ * \returns Ready to use `varstep_derivative` object.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ */
+template <std::size_t N, class I, class C>
+inline varstep_derivative<I, N, C>
+make_varstep_derivative(I & input, C & source) {
+  return {input, source};
+}
+
+/*!
+ * \brief   Maker function for `varstep_derivative` objects with runtime
+ *          range.
+ * \param   I Template parameter specifying the type of `input`.
+ * \param   A Template parameter specifying the allocator type.
+ * \param   input Input object, carrying its own timestamps.
+ * \param   distance Number of samples in the range.
+ * \param   alloc Allocator to draw the range storage from.
+ * \returns Ready to use `varstep_derivative` object.
+ * \throws  std::invalid_argument if `distance` is 0.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ */
+template <class I,
+          class A = std::allocator<detail::rate_t<typename I::value_t>>>
+inline varstep_derivative<I, dynamic_extent, I, A> make_varstep_derivative(
+  I & input, std::size_t distance, const A & alloc = A()) {
+  return {input, distance, alloc};
+}
+
+/*!
+ * \brief   Maker function for `varstep_derivative` objects with runtime range
+ *          and a separate source of timestamps.
+ * \param   I Template parameter specifying the type of `input`.
+ * \param   C Template parameter specifying the type of `source`.
+ * \param   A Template parameter specifying the allocator type.
+ * \param   input Input object.
+ * \param   source Object providing the timestamps of the input's samples.
+ * \param   distance Number of samples in the range.
+ * \param   alloc Allocator to draw the range storage from.
+ * \returns Ready to use `varstep_derivative` object.
+ * \throws  std::invalid_argument if `distance` is 0.
+ *
+ * **Usage**
+ * \include make_derivative.cc
+ */
+template <class I,
+          class C,
+          class A = std::allocator<detail::rate_t<typename I::value_t>>>
+inline varstep_derivative<I, dynamic_extent, C, A> make_varstep_derivative(
+  I & input, C & source, std::size_t distance, const A & alloc = A()) {
+  return {input, source, distance, alloc};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_DERIVATIVE_H_
@@ -0,0 +1,366 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_DYNAMIC_RINGBUFFER_H_
+#define PIPEBB_DYNAMIC_RINGBUFFER_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "ringbuffer.h"
+#include "span.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Window size marking a windowed gate as sized at runtime.
+ *
+ * Gates like `moving_average<I, dynamic_extent>` take their window size as a
+ * constructor argument and store the window in a `dynamic_ringbuffer`.
+ */
+constexpr std::size_t dynamic_extent = std::numeric_limits<std::size_t>::max();
+
+
+/*!
+ * \brief Circular buffer whose capacity is set at construction.
+ * \param T Template parameter specifying the element type.
+ * \param A Template parameter specifying the allocator type.
+ *
+ * The `dynamic_ringbuffer` has the same interface and semantics as
+ * `ringbuffer<T, N>`, but allocates its `capacity + 1` slots through `A`
+ * instead of embedding them. Combined with an `arena_allocator`, many windows
+ * can be laid out back to back in one caller-owned block of memory.
+ */
+template <typename T, class A = std::allocator<T>>
+class dynamic_ringbuffer
+{
+  using self_t   = dynamic_ringbuffer<T, A>;
+  using value_t  = T;
+  using alloc_t  = typename std::allocator_traits<A>::template rebind_alloc<T>;
+  using traits_t = std::allocator_traits<alloc_t>;
+
+public:
+  using value_type       = value_t;
+  using allocator_type   = alloc_t;
+  using size_type        = std::size_t;
+  using difference_type  = std::ptrdiff_t;
+  using reference        = value_t &;
+  using const_reference  = const value_t &;
+  using pointer          = value_t *;
+  using const_pointer    = const value_t *;
+  using iterator         = detail::ringbuffer_iterator<self_t>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using storage_type     = span<const value_t>;
+  using segments_type    = std::array<span<const value_t>, 2>;
+
+  friend iterator;
+
+public:
+  /*!
+   * \brief Constructor for `dynamic_ringbuffer` class.
+   * \param capacity Maximum number of elements.
+   * \param alloc Allocator to draw the storage from.
+   */
+  explicit dynamic_ringbuffer(std::size_t capacity, const A & alloc = A())
+   : _capacity(capacity), _alloc(alloc) {
+    allocate();
+  }
+
+  dynamic_ringbuffer(const self_t & other)
+   : _begin_pos(other._begin_pos),
+     _end_pos(other._end_pos),
+     _capacity(other._capacity),
+     _size(other._size),
+     _alloc(traits_t::select_on_container_copy_construction(other._alloc)) {
+    allocate();
+    std::copy(other._data, other._data + slots(), _data);
+  }
+
+  dynamic_ringbuffer(self_t && other) noexcept
+   : _begin_pos(other._begin_pos),
+     _end_pos(other._end_pos),
+     _capacity(other._capacity),
+     _size(other._size),
+     _alloc(std::move(other._alloc)),
+     _data(other._data) {
+    other._data = nullptr;
+  }
+
+  self_t & operator=(const self_t &) = delete;
+  self_t & operator=(self_t &&) = delete;
+
+  ~dynamic_ringbuffer() { deallocate(); }
+
+  /* Element access -------------------------------------------------------- */
+  void push(value_t value) noexcept {
+    _data[_end_pos] = value;
+    _end_pos        = next_pos(_end_pos);
+
+    // once full, the oldest element is overwritten, so move _begin_pos along
+    if (_size == _capacity) {
+      _begin_pos = next_pos(_begin_pos);
+    } else {
+      ++_size;
+    }
+
+    _data[_end_pos] = value_t();
+  }
+
+  self_t & operator<<(value_t value) noexcept {
+    push(value);
+    return *this;
+  }
+
+  void push_n(const value_t * values, std::size_t count) noexcept {
+    if (count >= _capacity) {
+      values += count - _capacity;
+      std::copy(values, values + _capacity, _data);
+      _begin_pos = 0;
+      _end_pos   = _capacity;
+      _size      = _capacity;
+    } else {
+      std::size_t first = std::min(count, slots() - _end_pos);
+      std::copy(values, values + first, _data + _end_pos);
+      std::copy(values + first, values + count, _data);
+
+      _end_pos   = wrap(_end_pos + count);
+      _size      = std::min(_size + count, _capacity);
+      _begin_pos = wrap(_end_pos + slots() - _size);
+    }
+
+    _data[_end_pos] = value_t();
+  }
+
+  std::size_t pop_n(value_t * values, std::size_t count) noexcept {
+    count = std::min(count, _size);
+
+    if (values) {
+      auto segs  = segments();
+      auto first = std::min(count, segs[0].size());
+      std::copy(segs[0].begin(), segs[0].begin() + first, values);
+      std::copy(segs[1].begin(), segs[1].begin() + (count - first),
+                values + first);
+    }
+
+    _begin_pos = wrap(_begin_pos + count);
+    _size -= count;
+
+    return count;
+  }
+
+  /*!
+   * \brief Remove the oldest value. The buffer must not be empty.
+   */
+  void pop_front() noexcept {
+    _begin_pos = next_pos(_begin_pos);
+    --_size;
+  }
+
+  /*!
+   * \brief Remove the newest value. The buffer must not be empty.
+   */
+  void pop_back() noexcept {
+    _end_pos        = prev_pos(_end_pos);
+    _data[_end_pos] = value_t();
+    --_size;
+  }
+
+  reference at(std::size_t i) noexcept { return operator[](i); }
+
+  reference operator[](const std::size_t i) noexcept {
+    return _data[wrap(_begin_pos + i)];
+  }
+
+  const_reference operator[](const std::size_t i) const noexcept {
+    return _data[wrap(_begin_pos + i)];
+  }
+
+  const_reference front() const noexcept { return _data[_begin_pos]; }
+
+  const_reference back() const noexcept { return _data[prev_pos(_end_pos)]; }
+
+  pointer data() noexcept { return _data; }
+
+  storage_type raw() const noexcept { return {_data, slots()}; }
+
+  segments_type segments() const noexcept {
+    if (_begin_pos + _size <= slots()) {
+      return {{{_data + _begin_pos, _size}, {}}};
+    }
+
+    std::size_t first = slots() - _begin_pos;
+    return {{{_data + _begin_pos, first}, {_data, _size - first}}};
+  }
+  /* ----------------------------------------------------------------------- */
+
+  /* Iterator -------------------------------------------------------------- */
+  iterator begin() const noexcept { return {*this, _begin_pos}; }
+
+  iterator end() const noexcept { return {*this, _end_pos}; }
+
+  reverse_iterator rbegin() const noexcept {
+    return std::make_reverse_iterator(end());
+  }
+
+  reverse_iterator rend() const noexcept {
+    return std::make_reverse_iterator(begin());
+  }
+  /* ----------------------------------------------------------------------- */
+
+  /* Capacity -------------------------------------------------------------- */
+  bool        empty() const noexcept { return _size == 0; }
+  std::size_t size() const noexcept { return _size; }
+  std::size_t max_size() const noexcept { return _capacity; }
+  /* ----------------------------------------------------------------------- */
+
+  /* Operations ------------------------------------------------------------ */
+  void fill(value_t value) noexcept {
+    std::fill(_data, _data + slots(), value);
+    _begin_pos = 0;
+    _end_pos   = _capacity;
+    _size      = _capacity;
+  }
+
+  allocator_type get_allocator() const noexcept { return _alloc; }
+  /* ----------------------------------------------------------------------- */
+
+  /* Comparison ------------------------------------------------------------ */
+  bool operator==(const self_t & rhs) const noexcept {
+    if (this->_capacity != rhs._capacity) { return false; }
+    return std::equal(begin(), end(), rhs.begin(), rhs.end());
+  }
+
+  bool operator!=(const self_t & other) const noexcept {
+    return !(*this == other);
+  }
+  /* ----------------------------------------------------------------------- */
+
+private:
+  /* Raw slot access for iterator ------------------------------------------ */
+  reference       slot(std::size_t pos) noexcept { return _data[pos]; }
+  const_reference slot(std::size_t pos) const noexcept { return _data[pos]; }
+
+  std::size_t next_pos(std::size_t pos) const noexcept {
+    return pos == _capacity ? 0 : pos + 1;
+  }
+
+  std::size_t prev_pos(std::size_t pos) const noexcept {
+    return pos == 0 ? _capacity : pos - 1;
+  }
+  /* ----------------------------------------------------------------------- */
+
+  std::size_t slots() const noexcept { return _capacity + 1; }
+
+  // all positions passed in are below 2 * slots(), so a single subtraction
+  // replaces the modulo
+  std::size_t wrap(std::size_t pos) const noexcept {
+    return pos >= slots() ? pos - slots() : pos;
+  }
+
+  void allocate() {
+    _data = traits_t::allocate(_alloc, slots());
+    for (std::size_t i = 0; i < slots(); ++i) {
+      traits_t::construct(_alloc, _data + i);
+    }
+  }
+
+  void deallocate() noexcept {
+    if (!_data) { return; }
+
+    for (std::size_t i = 0; i < slots(); ++i) {
+      traits_t::destroy(_alloc, _data + i);
+    }
+    traits_t::deallocate(_alloc, _data, slots());
+  }
+
+private:
+  std::size_t _begin_pos{0};
+  std::size_t _end_pos{0};
+  std::size_t _capacity;
+  std::size_t _size{0};
+  alloc_t     _alloc;
+  pointer     _data{nullptr};
+};
+
+
+template <typename T, class A>
+std::ostream & operator<<(std::ostream &                    os,
+                          const dynamic_ringbuffer<T, A> & rb) {
+  std::ostringstream ss;
+  ss << "size: " << rb.size() << ", max_size: " << rb.max_size()
+     << ", content: [";
+
+  for (auto & element : rb) { ss << element << ", "; }
+
+  // if elements have been written, get rid of the comma at the end
+  if (rb.size() != 0) { ss.seekp(-2, std::ios_base::end); }
+
+  ss << "]";
+  return operator<<(os, ss.str());
+}
+
+
+namespace detail {
+
+
+/*!
+ * \brief Selects the window storage of the windowed gates: a `ringbuffer` for
+ *        a window size known at compile time, a `dynamic_ringbuffer` for
+ *        `dynamic_extent`.
+ */
+template <typename T, std::size_t N, class A>
+struct window_buffer
+{
+  using type = ringbuffer<T, N>;
+};
+
+template <typename T, class A>
+struct window_buffer<T, dynamic_extent, A>
+{
+  using type = dynamic_ringbuffer<T, A>;
+};
+
+template <typename T, std::size_t N, class A>
+using window_buffer_t = typename window_buffer<T, N, A>::type;
+
+
+/*!
+ * \brief   Check the runtime window size of a windowed gate.
+ * \param   window Window size, at least 1.
+ * \param   gate Name of the gate, for the error message.
+ * \returns `window`.
+ * \throws  std::invalid_argument if `window` is 0.
+ */
+inline std::size_t checked_window(std::size_t window, const char * gate) {
+  if (window == 0) {
+    throw std::invalid_argument(std::string(gate) +
+                                ": window size must be at least 1");
+  }
+  return window;
+}
+
+}  // namespace detail
+}  // namespace pipebb
+
+#endif  // PIPEBB_DYNAMIC_RINGBUFFER_H_
@@ -0,0 +1,388 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_EXECUTOR_H_
+#define PIPEBB_EXECUTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "node.h"
+#include "utils.h"
+
+
+namespace pipebb {
+namespace detail {
+
+
+/*!
+ * \brief Task queue owned by one thread of a `work_stealing_pool`.
+ *
+ * The owner takes tasks from the front, thieves from the back. The queues of
+ * a pool are allocated as one array; trailing padding keeps neighbouring
+ * queues off each other's cache lines (`alignas` is not honoured by `new`
+ * prior to C++17).
+ */
+struct task_queue
+{
+  std::mutex              mutex;
+  std::deque<std::size_t> tasks;
+  char                    padding[cache_line_size];
+
+  void push(std::size_t task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(task);
+  }
+
+  bool pop(std::size_t & task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tasks.empty()) { return false; }
+
+    task = tasks.front();
+    tasks.pop_front();
+    return true;
+  }
+
+  bool steal(std::size_t & task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tasks.empty()) { return false; }
+
+    task = tasks.back();
+    tasks.pop_back();
+    return true;
+  }
+};
+
+
+/*!
+ * \brief Fixed size thread pool running batches of indexed tasks.
+ *
+ * The calling thread takes part in every batch as thread 0, so a pool of
+ * size 1 starts no threads at all and runs everything inline.
+ */
+class work_stealing_pool
+{
+public:
+  using job_t = std::function<void(std::size_t)>;
+
+public:
+  explicit work_stealing_pool(std::size_t threads)
+   : _queues(new task_queue[std::max<std::size_t>(threads, 1)]),
+     _size(std::max<std::size_t>(threads, 1)) {
+    for (std::size_t i = 1; i < _size; ++i) {
+      _workers.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  work_stealing_pool(const work_stealing_pool &) = delete;
+  work_stealing_pool & operator=(const work_stealing_pool &) = delete;
+
+  ~work_stealing_pool() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _wake.notify_all();
+
+    for (auto & worker : _workers) { worker.join(); }
+  }
+
+  std::size_t size() const noexcept { return _size; }
+
+  /*!
+   * \brief Run `job(task)` for each of the given tasks, return when all are
+   *        done.
+   * \param tasks Task indices; they are dealt out to the threads in order,
+   *        so put the most expensive ones first.
+   * \param job Callable to run for each task.
+   */
+  void run(const std::vector<std::size_t> & tasks, job_t job) {
+    if (tasks.empty()) { return; }
+
+    _job = std::move(job);
+    _remaining.store(tasks.size());
+
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+      _queues[i % _size].push(tasks[i]);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_generation;
+    }
+    _wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _remaining.load() == 0; });
+  }
+
+private:
+  void work(std::size_t self) {
+    std::size_t seen = 0;
+
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [&] { return _stop || _generation != seen; });
+        if (_stop) { return; }
+        seen = _generation;
+      }
+
+      drain(self);
+    }
+  }
+
+  void drain(std::size_t self) {
+    std::size_t task;
+
+    while (next(self, task)) {
+      _job(task);
+
+      if (_remaining.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done.notify_all();
+      }
+    }
+  }
+
+  // own queue first, then steal from the others, nearest first
+  bool next(std::size_t self, std::size_t & task) {
+    if (_queues[self].pop(task)) { return true; }
+
+    for (std::size_t k = 1; k < _size; ++k) {
+      if (_queues[(self + k) % _size].steal(task)) { return true; }
+    }
+    return false;
+  }
+
+private:
+  std::unique_ptr<task_queue[]> _queues;
+  std::size_t                   _size;
+  std::vector<std::thread>      _workers;
+  job_t                         _job;
+  std::atomic<std::size_t>      _remaining{0};
+  std::mutex                    _mutex;
+  std::condition_variable       _wake;
+  std::condition_variable       _done;
+  std::size_t                   _generation{0};
+  bool                          _stop{false};
+};
+
+}  // namespace detail
+
+
+/*!
+ * \brief Evaluates a set of sink gates per tick on a pool of threads.
+ *
+ * The `executor` takes the gates whose values the application reads (the
+ * sinks) and follows the links between their nodes to split the evaluation
+ * graph into independent subgraphs: two sinks end up in the same subgraph
+ * if any gate, channel or counter connects them, up- or downstream. The
+ * subgraphs are packed into a few batches per thread of similar size (in
+ * nodes). Each call to `run()` starts a new epoch (see `tick()`) and
+ * evaluates the batches on a work-stealing thread pool, largest first.
+ *
+ * Within a subgraph, sinks are evaluated in the order they were added, on a
+ * single thread; subgraphs share no state. The results are therefore the
+ * same as calling every sink in that order on a single thread after
+ * `tick()`, including those of stateful gates like `gradient`, `counter` or
+ * the windowed gates.
+ *
+ * Feed the channels before calling `run()` and read the sinks afterwards,
+ * both from the thread calling `run()`: sinks return their values cached
+ * during the run. Gates must not be moved, added or removed while
+ * registered. Inputs without a `graph_node()` are invisible to the
+ * partitioning and must therefore not be shared between subgraphs.
+ *
+ * \include executor.cc
+ */
+class executor
+{
+  struct sink
+  {
+    const node * graph_node;
+    void *       gate;
+    void (*evaluate)(void *);
+  };
+
+  struct component
+  {
+    std::vector<std::size_t> sinks;
+    std::size_t              nodes;
+  };
+
+  struct batch
+  {
+    std::vector<std::size_t> components;
+    std::size_t              nodes;
+  };
+
+  // enough batches per thread for stealing to even out the load, few enough
+  // to keep the per-task overhead small against the evaluation itself
+  static constexpr std::size_t batches_per_thread = 8;
+
+public:
+  /*!
+   * \brief Constructor for `executor` class.
+   * \param threads Number of threads to evaluate on, including the one
+   *        calling `run()`. Default: number of hardware threads.
+   */
+  explicit executor(
+    std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u))
+   : _pool(threads) {}
+
+  /*!
+   * \brief Register a sink gate.
+   * \param gate Gate to evaluate on every `run()`.
+   */
+  template <class G>
+  void add_sink(G & gate) {
+    _sinks.push_back({&gate.graph_node(), &gate, [](void * sink_gate) {
+                        (*static_cast<G *>(sink_gate))();
+                      }});
+    _partitioned = false;
+  }
+
+  /*!
+   * \brief   Get the number of threads evaluating the sinks.
+   * \returns Number of threads, including the one calling `run()`.
+   */
+  std::size_t threads() const noexcept { return _pool.size(); }
+
+  /*!
+   * \brief   Get the number of independent subgraphs.
+   * \returns Number of tasks each `run()` is split into.
+   */
+  std::size_t components() {
+    partition();
+    return _components.size();
+  }
+
+  /*!
+   * \brief   Start a new epoch and evaluate all sinks.
+   * \returns The new epoch.
+   */
+  epoch_t run() {
+    partition();
+
+    epoch_t epoch = tick();
+
+    _pool.run(_order, [this, epoch](std::size_t b) {
+      // the epoch is per thread, workers adopt the caller's
+      detail::epoch() = epoch;
+      for (auto c : _batches[b].components) {
+        for (auto s : _components[c].sinks) {
+          _sinks[s].evaluate(_sinks[s].gate);
+        }
+      }
+    });
+
+    return epoch;
+  }
+
+private:
+  void partition() {
+    if (_partitioned) { return; }
+
+    std::unordered_map<const node *, std::size_t> owner;
+    std::vector<const node *>                     pending;
+
+    _components.clear();
+
+    for (std::size_t s = 0; s < _sinks.size(); ++s) {
+      auto found = owner.find(_sinks[s].graph_node);
+      if (found != owner.end()) {
+        _components[found->second].sinks.push_back(s);
+        continue;
+      }
+
+      // flood the new sink's subgraph, following links both ways
+      std::size_t c = _components.size();
+      _components.push_back({{s}, 0});
+
+      owner.emplace(_sinks[s].graph_node, c);
+      pending.push_back(_sinks[s].graph_node);
+
+      while (!pending.empty()) {
+        const node * current = pending.back();
+        pending.pop_back();
+        ++_components[c].nodes;
+
+        for (auto links : {&current->inputs(), &current->dependents()}) {
+          for (const node * next : *links) {
+            if (owner.emplace(next, c).second) { pending.push_back(next); }
+          }
+        }
+      }
+    }
+
+    pack();
+    _partitioned = true;
+  }
+
+  // cuts the components, in the order their sinks were added, into runs of
+  // about equal size; gates created together tend to lie next to each other
+  // in memory, so each batch walks its memory front to back
+  void pack() {
+    std::size_t total = 0;
+    for (auto & c : _components) { total += c.nodes; }
+
+    std::size_t count =
+      std::min(_components.size(), _pool.size() * batches_per_thread);
+    _batches.assign(count, batch{{}, 0});
+
+    std::size_t b = 0, done = 0;
+    for (std::size_t c = 0; c < _components.size(); ++c) {
+      if (done * count >= total * (b + 1) && b + 1 < count) { ++b; }
+
+      _batches[b].components.push_back(c);
+      _batches[b].nodes += _components[c].nodes;
+      done += _components[c].nodes;
+    }
+
+    _order.resize(_batches.size());
+    for (std::size_t b = 0; b < _order.size(); ++b) { _order[b] = b; }
+
+    std::stable_sort(
+      _order.begin(), _order.end(), [this](std::size_t a, std::size_t b) {
+        return _batches[a].nodes > _batches[b].nodes;
+      });
+  }
+
+private:
+  detail::work_stealing_pool _pool;
+  std::vector<sink>          _sinks;
+  std::vector<component>     _components;
+  std::vector<batch>         _batches;
+  std::vector<std::size_t>   _order;
+  bool                       _partitioned{false};
+};
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_EXECUTOR_H_
@@ -0,0 +1,398 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_EXPRESSION_H_
+#define PIPEBB_EXPRESSION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "node.h"
+#include "span.h"
+#include "utils.h"
+
+
+namespace pipebb {
+namespace detail {
+
+
+struct expression_tag
+{};
+
+template <class E>
+using is_expression = std::is_base_of<expression_tag, std::decay_t<E>>;
+
+}  // namespace detail
+
+
+/*!
+ * \brief Leaf of an expression, reading from a channel or gate.
+ * \param I Template parameter specifying the type of the input object.
+ *
+ * Expressions are the value-typed counterpart of the gate objects: a chain
+ * like
+ *
+ *     auto e = pipebb::expr(p_manifold) * 0.5 + 20.0 > 100.0;
+ *
+ * computes the same as `make_threshold(make_offset(make_factor(...)))`, but
+ * is a single object of nested structs holding the constants, with the
+ * input object as the only reference. Calling it compiles down to one
+ * inlined function; `process()` runs the whole chain on a block of samples
+ * in one loop the compiler can vectorize.
+ *
+ * Supported are `e * k`, `k * e`, `e + k`, `e - k`, `-e` (`factor`,
+ * `offset`, `inverter`), `e > k` (`threshold`), and `and_(e, ...)`,
+ * `or_(e, ...)`, `!e` (`and_gate`, `or_gate`, `not_gate`). Expressions are
+ * not memoized; wrap one into a gate with `make_fused()` to use it as an
+ * input of other gates.
+ *
+ * \include expression.cc
+ */
+template <class I>
+class source_expr : detail::expression_tag
+{
+  using input_t = I;
+
+public:
+  using value_t  = typename input_t::value_t;
+  using sample_t = value_t;
+
+public:
+  explicit source_expr(input_t & input) noexcept : _input(input) {}
+
+  value_t operator()() const noexcept { return _input(); }
+
+  value_t apply(sample_t sample) const noexcept { return sample; }
+
+  void attach_to(node & n) const { n.attach(_input); }
+
+private:
+  input_t & _input;
+};
+
+
+template <class E>
+class scale_expr : detail::expression_tag
+{
+public:
+  using value_t  = typename E::value_t;
+  using sample_t = typename E::sample_t;
+
+public:
+  scale_expr(E inner, value_t constant) noexcept
+   : _inner(inner), _constant(constant) {}
+
+  value_t operator()() const noexcept { return _inner() * _constant; }
+
+  value_t apply(sample_t sample) const noexcept {
+    return _inner.apply(sample) * _constant;
+  }
+
+  void attach_to(node & n) const { _inner.attach_to(n); }
+
+private:
+  E       _inner;
+  value_t _constant;
+};
+
+
+template <class E>
+class shift_expr : detail::expression_tag
+{
+public:
+  using value_t  = typename E::value_t;
+  using sample_t = typename E::sample_t;
+
+public:
+  shift_expr(E inner, value_t offset) noexcept
+   : _inner(inner), _offset(offset) {}
+
+  value_t operator()() const noexcept { return _inner() + _offset; }
+
+  value_t apply(sample_t sample) const noexcept {
+    return _inner.apply(sample) + _offset;
+  }
+
+  void attach_to(node & n) const { _inner.attach_to(n); }
+
+private:
+  E       _inner;
+  value_t _offset;
+};
+
+
+template <class E>
+class negate_expr : detail::expression_tag
+{
+public:
+  using value_t  = typename E::value_t;
+  using sample_t = typename E::sample_t;
+
+public:
+  explicit negate_expr(E inner) noexcept : _inner(inner) {}
+
+  value_t operator()() const noexcept { return -_inner(); }
+
+  value_t apply(sample_t sample) const noexcept {
+    return -_inner.apply(sample);
+  }
+
+  void attach_to(node & n) const { _inner.attach_to(n); }
+
+private:
+  E _inner;
+};
+
+
+template <class E>
+class greater_expr : detail::expression_tag
+{
+  using limit_t = typename E::value_t;
+
+public:
+  using value_t  = bool;
+  using sample_t = typename E::sample_t;
+
+public:
+  greater_expr(E inner, limit_t limit) noexcept
+   : _inner(inner), _limit(limit) {}
+
+  value_t operator()() const noexcept { return _inner() > _limit; }
+
+  value_t apply(sample_t sample) const noexcept {
+    return _inner.apply(sample) > _limit;
+  }
+
+  void attach_to(node & n) const { _inner.attach_to(n); }
+
+private:
+  E       _inner;
+  limit_t _limit;
+};
+
+
+template <class E>
+class not_expr : detail::expression_tag
+{
+public:
+  using value_t  = bool;
+  using sample_t = typename E::sample_t;
+
+public:
+  explicit not_expr(E inner) noexcept : _inner(inner) {}
+
+  value_t operator()() const noexcept { return !_inner(); }
+
+  value_t apply(sample_t sample) const noexcept {
+    return !_inner.apply(sample);
+  }
+
+  void attach_to(node & n) const { _inner.attach_to(n); }
+
+private:
+  E _inner;
+};
+
+
+//
+// folds its operands with L, first operand outermost, like logic_gate
+//
+template <class L, class E, class... Es>
+class logic_expr : detail::expression_tag
+{
+  using rest_t     = logic_expr<L, Es...>;
+  using logical_op = L;
+
+public:
+  using value_t  = bool;
+  using sample_t = typename E::sample_t;
+
+public:
+  logic_expr(E first, Es... rest) noexcept : _first(first), _rest(rest...) {}
+
+  value_t operator()() const noexcept {
+    return logical_op()(_first(), _rest());
+  }
+
+  value_t apply(sample_t sample) const noexcept {
+    return logical_op()(_first.apply(sample), _rest.apply(sample));
+  }
+
+  void attach_to(node & n) const {
+    _first.attach_to(n);
+    _rest.attach_to(n);
+  }
+
+private:
+  E      _first;
+  rest_t _rest;
+};
+
+template <class L, class E>
+class logic_expr<L, E> : detail::expression_tag
+{
+public:
+  using value_t  = bool;
+  using sample_t = typename E::sample_t;
+
+public:
+  explicit logic_expr(E first) noexcept : _first(first) {}
+
+  value_t operator()() const noexcept { return _first(); }
+
+  value_t apply(sample_t sample) const noexcept {
+    return _first.apply(sample);
+  }
+
+  void attach_to(node & n) const { _first.attach_to(n); }
+
+private:
+  E _first;
+};
+
+
+/*!
+ * \brief   Evaluate an expression on a block of samples.
+ * \param   e Expression.
+ * \param   in Samples, as the expression's source would produce them.
+ * \param   out Output values.
+ * \returns Number of processed values, i.e. the smaller of both sizes.
+ *
+ * Every source of the expression reads from `in`, so all of them must stand
+ * for the same input object, as in `and_(expr(x) > 1.0, !(expr(x) > 2.0))`.
+ */
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline std::size_t process(const E &                        e,
+                           span<const typename E::sample_t> in,
+                           span<typename E::value_t>        out) noexcept {
+  std::size_t count = std::min(in.size(), out.size());
+
+  auto src = in.data();
+  auto dst = out.data();
+  for (std::size_t i = 0; i < count; ++i) { dst[i] = e.apply(src[i]); }
+
+  return count;
+}
+
+
+/*!
+ * \brief Gate wrapping an expression, so it can be used as an input object.
+ * \param E Template parameter specifying the type of the expression.
+ *
+ * The gate's node is attached to every source of the expression, so its
+ * value is memoized and recomputed only when one of them has changed.
+ */
+template <class E>
+class fused
+{
+  using self_t = fused<E>;
+  using expr_t = E;
+
+public:
+  using value_t = typename expr_t::value_t;
+
+public:
+  explicit fused(expr_t e) : _expr(e) { _expr.attach_to(_node); }
+
+  fused(self_t && other) = default;
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("fused");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value = _expr();
+  }
+
+  std::size_t process(span<const typename expr_t::sample_t> in,
+                      span<value_t>                         out) noexcept {
+    std::size_t count = pipebb::process(_expr, in, out);
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  expr_t  _expr;
+  node    _node;
+  value_t _value{};
+};
+
+
+template <class I>
+inline source_expr<I> expr(I & input) noexcept {
+  return source_expr<I>{input};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline fused<E> make_fused(E e) {
+  return fused<E>{e};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline scale_expr<E> operator*(E e, typename E::value_t constant) noexcept {
+  return {e, constant};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline scale_expr<E> operator*(typename E::value_t constant, E e) noexcept {
+  return {e, constant};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline shift_expr<E> operator+(E e, typename E::value_t offset) noexcept {
+  return {e, offset};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline shift_expr<E> operator-(E e, typename E::value_t offset) noexcept {
+  return {e, -offset};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline negate_expr<E> operator-(E e) noexcept {
+  return negate_expr<E>{e};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline greater_expr<E> operator>(E e, typename E::value_t limit) noexcept {
+  return {e, limit};
+}
+
+template <class E, REQUIRES(detail::is_expression<E>::value)>
+inline not_expr<E> operator!(E e) noexcept {
+  return not_expr<E>{e};
+}
+
+template <class... Es>
+inline logic_expr<std::logical_and<bool>, Es...> and_(Es... es) noexcept {
+  return logic_expr<std::logical_and<bool>, Es...>{es...};
+}
+
+template <class... Es>
+inline logic_expr<std::logical_or<bool>, Es...> or_(Es... es) noexcept {
+  return logic_expr<std::logical_or<bool>, Es...>{es...};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_EXPRESSION_H_
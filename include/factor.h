@@ -17,6 +17,13 @@
 #ifndef PIPEBB_FACTOR_H_
 #define PIPEBB_FACTOR_H_
 
+#include <algorithm>
+#include <cstddef>
+
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+
 
 namespace pipebb {
 
@@ -49,8 +56,10 @@ public:
    * \param input Input object.
    * \param constant Constant to multiply with.
    */
-  factor(input_t & input, value_t constant) noexcept
-   : _input(input), _constant(constant) {}
+  factor(input_t & input, value_t constant)
+   : _input(input), _constant(constant) {
+    _node.attach(_input);
+  }
 
   /*!
    * \brief Move copy constructor for `factor` class.
@@ -69,7 +78,10 @@ public:
    * \brief Function to set the constant to a new value.
    * \param constant Constant to set.
    */
-  void set_constant(value_t constant) noexcept { _constant = constant; }
+  void set_constant(value_t constant) noexcept {
+    _constant = constant;
+    _node.invalidate();
+  }
 
   /*!
    * \brief   Get value from input object, multiply by the constant and return.
@@ -78,11 +90,43 @@ public:
    * Every pipeBB gate is callable. When called, it calls the input object and
    * takes appropriate action with the result.
    */
-  value_t operator()() noexcept { return _input() * _constant; }
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("factor");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value = _input() * _constant;
+  }
+
+  /*!
+   * \brief   Multiply a block of input values by the constant.
+   * \param   in Values as produced by the input object.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smaller of both sizes.
+   *
+   * Equivalent to calling `operator()` once per input value, but runs the
+   * vectorized `simd::scale()` kernel.
+   */
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    simd::scale(in.data(), _constant, out.data(), count);
+
+    _node.invalidate();
+    return count;
+  }
+
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
 
 private:
   input_t & _input;
   value_t   _constant;
+  node      _node;
+  value_t   _value{};
 };
 
 
@@ -102,8 +146,7 @@ private:
  * \include make_factor.cc
  */
 template <class I>
-inline factor<I> make_factor(I &                 input,
-                             typename I::value_t constant) noexcept {
+inline factor<I> make_factor(I & input, typename I::value_t constant) {
   return {input, constant};
 }
 
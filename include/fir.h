@@ -0,0 +1,231 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_FIR_H_
+#define PIPEBB_FIR_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+#include "utils.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Windowed-sinc designs of FIR filter coefficients.
+ * \param T Template parameter specifying the value type.
+ * \param Taps Template parameter specifying the number of taps.
+ *
+ * The ideal impulse response is truncated to `Taps` samples centered on the
+ * filter's delay of `(Taps - 1) / 2` samples, tapered with a Hamming window,
+ * and normalized to unity gain at DC (low-pass) or at the center frequency
+ * (band-pass). Frequencies are given in the unit of the sample rate.
+ */
+template <typename T, std::size_t Taps>
+struct fir_coefficients
+{
+  using type = std::array<T, Taps>;
+
+  static type lowpass(T cutoff, T sample_rate) noexcept {
+    type h = sinc(cutoff / sample_rate);
+
+    T gain = T();
+    for (auto c : h) { gain += c; }
+    for (auto & c : h) { c /= gain; }
+    return h;
+  }
+
+  static type bandpass(T low, T high, T sample_rate) noexcept {
+    type h  = sinc(high / sample_rate);
+    type lo = sinc(low / sample_rate);
+    for (std::size_t i = 0; i < Taps; ++i) { h[i] -= lo[i]; }
+
+    // normalize by the magnitude of the response at the center frequency
+    T w  = detail::pi<T>() * (low + high) / sample_rate;
+    T re = T();
+    T im = T();
+    for (std::size_t i = 0; i < Taps; ++i) {
+      re += h[i] * std::cos(w * i);
+      im += h[i] * std::sin(w * i);
+    }
+    T gain = std::sqrt(re * re + im * im);
+    for (auto & c : h) { c /= gain; }
+    return h;
+  }
+
+private:
+  // Hamming windowed sinc low-pass, f relative to the sample rate
+  static type sinc(T f) noexcept {
+    type h;
+    T    center = T(Taps - 1) / 2;
+
+    for (std::size_t i = 0; i < Taps; ++i) {
+      T t      = T(i) - center;
+      T phase  = 2 * detail::pi<T>() * i / std::max<T>(Taps - 1, 1);
+      T window = T(0.54) - T(0.46) * std::cos(phase);
+      T ideal  = t == T() ? 2 * f
+                          : std::sin(2 * detail::pi<T>() * f * t) /
+                            (detail::pi<T>() * t);
+      h[i] = ideal * window;
+    }
+    return h;
+  }
+};
+
+
+/*!
+ * \brief Finite impulse response filter: `y[n] = sum_k h[k] x[n-k]`.
+ * \param I Template parameter specifying the input type.
+ * \param Taps Template parameter specifying the number of coefficients.
+ * \param D Template parameter specifying the decimation factor.
+ *
+ * The last `Taps` inputs are kept twice, in a buffer of `2 Taps` values: each
+ * input is written to slot `p` and `p + Taps`, so the window always starts at
+ * the slot after the newest write and is contiguous, oldest value first. Each
+ * output is then a single `simd::dot` of the window with the reversed
+ * coefficients, without any wrap-around in the inner loop.
+ *
+ * With a decimation factor `D > 1`, each input still enters the window, but
+ * a new output is only computed for every `D`th input, starting with the
+ * first; in between, the last output is held. This yields the same outputs
+ * and cost as a polyphase decomposition into `D` subfilters running at the
+ * output rate.
+ *
+ * `process()` pushes a whole block through the window and writes only the
+ * computed outputs.
+ */
+template <class I, std::size_t Taps, std::size_t D = 1>
+class fir
+{
+  using self_t  = fir<I, Taps, D>;
+  using input_t = I;
+
+public:
+  using value_t        = typename input_t::value_t;
+  using coefficients_t = std::array<value_t, Taps>;
+
+  static_assert(Taps > 0, "fir requires at least one tap");
+  static_assert(D > 0, "fir requires a decimation factor of at least one");
+
+public:
+  fir(input_t & input, const coefficients_t & coeffs) : _input(input) {
+    set_coefficients(coeffs);
+    _node.attach(_input);
+  }
+
+  fir(self_t && other) = default;
+
+  void set_coefficients(const coefficients_t & coeffs) noexcept {
+    std::reverse_copy(coeffs.begin(), coeffs.end(), _reversed.begin());
+    _node.invalidate();
+  }
+
+  void reset() noexcept {
+    _history.fill(value_t());
+    _pos   = 0;
+    _phase = 0;
+    _run   = 0;
+    _value = value_t();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("fir");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    if (push(_input())) { _value = convolve(); }
+
+    // the window only stops changing once it is filled with the same value,
+    // and the output once it has been computed from such a window
+    if (_run < Taps + D) { _node.mark_dirty(); }
+
+    return _value;
+  }
+
+  /*!
+   * \brief   Filter a block of input values.
+   * \param   in Values as produced by the input object.
+   * \param   out Output values, one per `D` inputs.
+   * \returns Number of output values written.
+   *
+   * Equivalent to calling `operator()` once per input value and keeping the
+   * newly computed outputs. Consumes all of `in`, or as much of it as there
+   * is room for outputs in `out`.
+   */
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t written = 0;
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      if (_phase == 0 && written == out.size()) { break; }
+      if (push(in[i])) { out[written++] = _value = convolve(); }
+    }
+
+    _node.invalidate();
+    return written;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  // returns true if an output is due for this input
+  bool push(value_t value) noexcept {
+    value_t newest = _history[_pos == 0 ? 2 * Taps - 1 : _pos + Taps - 1];
+    _run           = value == newest ? _run + 1 : 1;
+
+    _history[_pos]        = value;
+    _history[_pos + Taps] = value;
+    _pos                  = _pos + 1 == Taps ? 0 : _pos + 1;
+
+    bool due = _phase == 0;
+    _phase   = _phase + 1 == D ? 0 : _phase + 1;
+    return due;
+  }
+
+  value_t convolve() const noexcept {
+    return simd::dot(_reversed.data(), _history.data() + _pos, Taps);
+  }
+
+private:
+  input_t &                     _input;
+  coefficients_t                _reversed;
+  std::array<value_t, 2 * Taps> _history{};
+  std::size_t                   _pos{0};
+  std::size_t                   _phase{0};
+  std::size_t                   _run{0};
+  value_t                       _value{};
+  node                          _node;
+};
+
+
+template <std::size_t D = 1, class I, std::size_t Taps>
+inline fir<I, Taps, D>
+make_fir(I & input, const std::array<typename I::value_t, Taps> & coeffs) {
+  return {input, coeffs};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_FIR_H_
@@ -17,13 +17,33 @@
 #ifndef PIPEBB_GRADIENT_H_
 #define PIPEBB_GRADIENT_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <utility>
 
+#include "dynamic_ringbuffer.h"
+#include "node.h"
 #include "ringbuffer.h"
+#include "span.h"
+#include "utils.h"
 
 
 namespace pipebb {
+namespace detail {
+
+
+// gradient and lane_gradient take differences of integral points: every input
+// value is truncated towards zero first
+using gradient_value_t = std::int_fast32_t;
+
+template <typename T>
+inline gradient_value_t gradient_point(T value) noexcept {
+  return static_cast<gradient_value_t>(value);
+}
+
+}  // namespace detail
 
 
 /*!
@@ -45,7 +65,7 @@ class gradient
   using input_t = I;
 
 public:
-  using value_t = std::int_fast32_t;
+  using value_t = detail::gradient_value_t;
 
 private:
   using pair_t = std::pair<value_t, value_t>;
@@ -55,7 +75,7 @@ public:
    * \brief Constructor for `gradient` class.
    * \param input Input object.
    */
-  gradient(input_t & input) noexcept : _input(input) {}
+  gradient(input_t & input) : _input(input) { _node.attach(_input); }
 
   /*!
    * \brief Move copy constructor for `gradient` class.
@@ -69,6 +89,7 @@ public:
   void reset() noexcept {
     _pair.first  = value_t();
     _pair.second = value_t();
+    _node.invalidate();
   }
 
   /*!
@@ -79,14 +100,61 @@ public:
    * takes appropriate action with the result.
    */
   value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("gradient");
+    if (_node.current()) { return _pair.second - _pair.first; }
+    _node.update();
+
     std::swap(_pair.first, _pair.second);
-    _pair.second = _input();
+    _pair.second = detail::gradient_point(_input());
+
+    // an unchanged input yields a zero gradient only once both points agree
+    if (_pair.first != _pair.second) { _node.mark_dirty(); }
+
     return _pair.second - _pair.first;
   }
 
+  /*!
+   * \brief   Calculate the gradients of a block of input values.
+   * \param   in Values as produced by the input object.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smaller of both sizes.
+   *
+   * Equivalent to calling `operator()` once per input value, but in a single
+   * loop the compiler can vectorize. Afterwards, the gate continues from the
+   * last input value.
+   */
+  std::size_t process(span<const typename input_t::value_t> in,
+                      span<value_t>                         out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+    if (!count) { return 0; }
+
+    auto      src = in.data();
+    value_t * dst = out.data();
+
+    dst[0] = detail::gradient_point(src[0]) - _pair.second;
+    for (std::size_t i = 1; i < count; ++i) {
+      dst[i] = detail::gradient_point(src[i]) -
+               detail::gradient_point(src[i - 1]);
+    }
+
+    _pair.first  = count > 1 ? detail::gradient_point(src[count - 2])
+                             : _pair.second;
+    _pair.second = detail::gradient_point(src[count - 1]);
+
+    _node.invalidate();
+    return count;
+  }
+
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t & _input;
   pair_t    _pair;
+  node      _node;
 };
 
 
@@ -105,7 +173,7 @@ private:
  * \include make_gradient.cc
  */
 template <class I>
-inline gradient<I> make_gradient(I & input) noexcept {
+inline gradient<I> make_gradient(I & input) {
   return {input};
 }
 
@@ -114,7 +182,9 @@ inline gradient<I> make_gradient(I & input) noexcept {
  * \brief Class which calculates the difference between two measurement points.
  * \param I Template parameter specifying the type of the input object.
  * \param N Template parameter specifying the distance between the measurement
- *        points.
+ *        points, or `dynamic_extent` to set it at construction.
+ * \param A Template parameter specifying the allocator used for the range if
+ *        `N` is `dynamic_extent`.
  *
  * The `varstep_gradient` gate is used to calculate the difference between two
  * measurement points of an incoming signal, i.e. the gradient, at a fixed
@@ -125,12 +195,14 @@ inline gradient<I> make_gradient(I & input) noexcept {
  *
  * For further examples, look into the tests.
  */
-template <class I, std::size_t N>
+template <class I,
+          std::size_t N,
+          class A = std::allocator<typename I::value_t>>
 class varstep_gradient
 {
-  using self_t  = varstep_gradient<I, N>;
+  using self_t  = varstep_gradient<I, N, A>;
   using input_t = I;
-  using range_t = ringbuffer<typename input_t::value_t, N>;
+  using range_t = detail::window_buffer_t<typename input_t::value_t, N, A>;
 
 public:
   using value_t = typename input_t::value_t;
@@ -140,7 +212,30 @@ public:
    * \brief Constructor for `varstep_gradient` class.
    * \param input Input object.
    */
-  varstep_gradient(input_t & input) noexcept : _input(input) { reset(); }
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  varstep_gradient(input_t & input) : _input(input) {
+    _node.attach(_input);
+    reset();
+  }
+
+  /*!
+   * \brief Constructor for `varstep_gradient` class with runtime distance.
+   * \param input Input object.
+   * \param distance Distance between the measurement points.
+   * \param alloc Allocator to draw the range storage from.
+   * \throws std::invalid_argument if `distance` is 0.
+   *
+   * Only available if `N` is `dynamic_extent`.
+   */
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  varstep_gradient(input_t &   input,
+                   std::size_t distance,
+                   const A &   alloc = A())
+   : _input(input),
+     _range(detail::checked_window(distance, "varstep_gradient"), alloc) {
+    _node.attach(_input);
+    reset();
+  }
 
   /*!
    * \brief Move copy constructor for `gradient` class.
@@ -151,7 +246,11 @@ public:
   /*!
    * \brief Function to reset gate.
    */
-  void reset() noexcept { _range.fill(value_t()); }
+  void reset() noexcept {
+    _range.fill(value_t());
+    _run = 0;
+    _node.invalidate();
+  }
 
   /*!
    * \brief   Update `varstep_gradient` content, then get value.
@@ -161,10 +260,52 @@ public:
    * takes appropriate action with the result.
    */
   value_t operator()() noexcept {
-    _range.push(_input());
+    PIPEBB_PROFILE_GATE("varstep_gradient");
+    if (_node.current()) { return _range.back() - _range.front(); }
+    _node.update();
+
+    value_t value = _input();
+
+    // the range only stops changing once it is filled with the same value
+    _run = (value == _range.back()) ? _run + 1 : 1;
+    if (_run < _range.max_size()) { _node.mark_dirty(); }
+
+    _range.push(value);
     return _range.back() - _range.front();
   }
 
+  /*!
+   * \brief   Calculate the gradients of a block of input values.
+   * \param   in Values as produced by the input object.
+   * \param   out Output values.
+   * \returns Number of processed values, i.e. the smaller of both sizes.
+   *
+   * Equivalent to calling `operator()` once per input value. Only the first
+   * `N - 1` outputs reach back into the range; the rest are differences
+   * within the block, computed in a loop the compiler can vectorize.
+   */
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+    std::size_t reach = _range.max_size() - 1;
+    std::size_t head  = std::min(count, reach);
+
+    const value_t * src = in.data();
+    value_t *       dst = out.data();
+
+    for (std::size_t i = 0; i < head; ++i) {
+      dst[i] = src[i] - _range[i + 1];
+    }
+    for (std::size_t i = head; i < count; ++i) {
+      dst[i] = src[i] - src[i - reach];
+    }
+
+    _range.push_n(src, count);
+    _run = 0;
+
+    _node.invalidate();
+    return count;
+  }
+
   /*!
    * \brief   Get the range used for calculating the gradient.
    * \returns Circular buffer containing current range.
@@ -179,10 +320,18 @@ public:
    */
   range_t & range() noexcept { return _range; }
 
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t &   _input;
   std::size_t _size;
   range_t     _range;
+  std::size_t _run{0};
+  node        _node;
 };
 
 
@@ -204,10 +353,30 @@ private:
  * \include make_varstep_gradient.cc
  */
 template <std::size_t N, class I>
-inline varstep_gradient<I, N> make_varstep_gradient(I & input) noexcept {
+inline varstep_gradient<I, N> make_varstep_gradient(I & input) {
   return {input};
 }
 
+/*!
+ * \brief   Maker function for `varstep_gradient` objects with runtime
+ *          distance.
+ * \param   I Template parameter specifying the type of `input`.
+ * \param   A Template parameter specifying the allocator type.
+ * \param   input Input object.
+ * \param   distance Distance between the measurement points.
+ * \param   alloc Allocator to draw the range storage from.
+ * \returns Ready to use `varstep_gradient` object.
+ * \throws  std::invalid_argument if `distance` is 0.
+ *
+ * **Usage**
+ * \include make_varstep_gradient.cc
+ */
+template <class I, class A = std::allocator<typename I::value_t>>
+inline varstep_gradient<I, dynamic_extent, A> make_varstep_gradient(
+  I & input, std::size_t distance, const A & alloc = A()) {
+  return {input, distance, alloc};
+}
+
 }  // namespace pipebb
 
 #endif  // PIPEBB_GRADIENT_H_
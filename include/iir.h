@@ -0,0 +1,731 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_IIR_H_
+#define PIPEBB_IIR_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "node.h"
+#include "span.h"
+#include "utils.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Coefficients of a biquad (second order IIR) section, normalized to
+ *        `a0 = 1`:
+ *        `y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]`.
+ * \param T Template parameter specifying the value type.
+ *
+ * The static members design common filters after the formulas of Robert
+ * Bristow-Johnson's "Audio EQ Cookbook".
+ */
+template <typename T>
+struct biquad_coefficients
+{
+  T b0{1};
+  T b1{};
+  T b2{};
+  T a1{};
+  T a2{};
+
+  static biquad_coefficients lowpass(T cutoff, T sample_rate, T q) noexcept {
+    T w = omega(cutoff, sample_rate);
+    T c = std::cos(w);
+    return normalize((1 - c) / 2, 1 - c, (1 - c) / 2, w, q);
+  }
+
+  static biquad_coefficients highpass(T cutoff, T sample_rate, T q) noexcept {
+    T w = omega(cutoff, sample_rate);
+    T c = std::cos(w);
+    return normalize((1 + c) / 2, -(1 + c), (1 + c) / 2, w, q);
+  }
+
+  // constant 0 dB peak gain
+  static biquad_coefficients bandpass(T center, T sample_rate, T q) noexcept {
+    T w     = omega(center, sample_rate);
+    T alpha = std::sin(w) / (2 * q);
+    return normalize(alpha, 0, -alpha, w, q);
+  }
+
+  static biquad_coefficients notch(T center, T sample_rate, T q) noexcept {
+    T w = omega(center, sample_rate);
+    return normalize(1, -2 * std::cos(w), 1, w, q);
+  }
+
+  bool operator==(const biquad_coefficients & rhs) const noexcept {
+    return b0 == rhs.b0 && b1 == rhs.b1 && b2 == rhs.b2 && a1 == rhs.a1 &&
+           a2 == rhs.a2;
+  }
+
+  bool operator!=(const biquad_coefficients & rhs) const noexcept {
+    return !(*this == rhs);
+  }
+
+private:
+  static T omega(T frequency, T sample_rate) noexcept {
+    return 2 * detail::pi<T>() * frequency / sample_rate;
+  }
+
+  static biquad_coefficients normalize(T b0, T b1, T b2, T w, T q) noexcept {
+    T alpha = std::sin(w) / (2 * q);
+    T a0    = 1 + alpha;
+    return {b0 / a0, b1 / a0, b2 / a0, -2 * std::cos(w) / a0,
+            (1 - alpha) / a0};
+  }
+};
+
+
+namespace detail {
+
+
+/*!
+ * \brief IIR section of order `Order` in direct form I.
+ * \param T Template parameter specifying the value type.
+ * \param Order Template parameter specifying the filter order.
+ *
+ * The state is the last `Order` inputs and outputs, independent of the length
+ * of the impulse response. Unlike the transposed forms, that state doesn't
+ * depend on the coefficients, so they may change between samples without
+ * glitches.
+ *
+ * `step()` advances by one sample. A serial recurrence like this doesn't
+ * vectorize, so `run()` uses the block state-space form instead: the outputs
+ * of `width` consecutive samples are linear in the state before them and
+ * the inputs,
+ *
+ *     y[k] = sum_i Ys[i][k] s[i] + sum_{j<=k} h[k-j] x[j],
+ *
+ * with `Ys[i]` the response to unit state `i` and `h` the impulse response.
+ * A block thus costs two small matrix-vector products whose inner loops run
+ * across the samples of the block and vectorize; the state after the block is
+ * just its last inputs and outputs. The matrices are allocated and computed
+ * from the coefficients on first use, so `run()` may throw `std::bad_alloc`,
+ * and kept until the coefficients change. The block form sums in a different
+ * order than `step()`, so results differ in the last bits.
+ */
+template <typename T, std::size_t Order>
+class iir_section
+{
+  using value_t = T;
+
+public:
+  static constexpr std::size_t width = 8;
+
+  iir_section() noexcept { _b[0] = value_t(1); }
+
+  iir_section(iir_section && other) = default;
+
+  // b0..b(Order), a1..a(Order)
+  void set(const std::array<value_t, Order + 1> & b,
+           const std::array<value_t, Order> &     a) noexcept {
+    if (b == _b && a == _a) { return; }
+
+    _b = b;
+    _a = a;
+    if (_block) { _block->stale = true; }
+  }
+
+  value_t step(value_t x) noexcept {
+    value_t y = _b[0] * x;
+    for (std::size_t i = 0; i < Order; ++i) {
+      y += _b[i + 1] * _x[i] - _a[i] * _y[i];
+    }
+
+    state_t xs = _x;
+    state_t ys = _y;
+    shift(_x, x);
+    shift(_y, y);
+
+    _settled = xs == _x && ys == _y;
+    return y;
+  }
+
+  void run(const value_t * in, value_t * out, std::size_t n) {
+    std::size_t i = 0;
+
+    if (n >= width) {
+      if (!_block) { _block.reset(new block); }
+      if (_block->stale) { compute_block(); }
+
+      for (; i + width <= n; i += width) { run_block(in + i, out + i); }
+      _settled = false;
+    }
+
+    for (; i < n; ++i) { out[i] = step(in[i]); }
+  }
+
+  void clear() noexcept {
+    _x.fill(value_t());
+    _y.fill(value_t());
+    _settled = false;
+  }
+
+  // the last step left the state unchanged, so the output will not change
+  // as long as the input doesn't
+  bool settled() const noexcept { return _settled; }
+
+private:
+  using row_t   = std::array<value_t, width>;
+  using state_t = std::array<value_t, Order>;
+
+  // y = sum_i ys[i] s[i] + sum_j h[j] x[j], s = (x[-1].., y[-1]..)
+  struct block
+  {
+    std::array<row_t, width>     h;   // [j][k], Toeplitz
+    std::array<row_t, 2 * Order> ys;  // [i][k]
+    bool                         stale{true};
+  };
+
+  static void shift(state_t & state, value_t value) noexcept {
+    for (std::size_t i = Order - 1; i > 0; --i) { state[i] = state[i - 1]; }
+    state[0] = value;
+  }
+
+  // response of a copy of this section from the given state and input
+  row_t response(const state_t & x, const state_t & y, value_t x0) const {
+    iir_section probe;
+    probe.set(_b, _a);
+    probe._x = x;
+    probe._y = y;
+
+    row_t out;
+    for (std::size_t k = 0; k < width; ++k) {
+      out[k] = probe.step(k == 0 ? x0 : value_t());
+    }
+    return out;
+  }
+
+  void compute_block() {
+    auto & blk = *_block;
+
+    row_t h = response({}, {}, value_t(1));
+    for (std::size_t j = 0; j < width; ++j) {
+      for (std::size_t k = 0; k < width; ++k) {
+        blk.h[j][k] = k < j ? value_t() : h[k - j];
+      }
+    }
+
+    for (std::size_t i = 0; i < Order; ++i) {
+      state_t unit{};
+      unit[i] = value_t(1);
+
+      blk.ys[i]         = response(unit, {}, value_t());
+      blk.ys[Order + i] = response({}, unit, value_t());
+    }
+
+    blk.stale = false;
+  }
+
+  void run_block(const value_t * x, value_t * out) noexcept {
+    auto & blk = *_block;
+    row_t  y{};
+
+    for (std::size_t i = 0; i < Order; ++i) {
+      for (std::size_t k = 0; k < width; ++k) {
+        y[k] += blk.ys[i][k] * _x[i] + blk.ys[Order + i][k] * _y[i];
+      }
+    }
+    for (std::size_t j = 0; j < width; ++j) {
+      for (std::size_t k = 0; k < width; ++k) { y[k] += blk.h[j][k] * x[j]; }
+    }
+
+    for (std::size_t i = 0; i < Order; ++i) {
+      _x[i] = x[width - 1 - i];
+      _y[i] = y[width - 1 - i];
+    }
+    std::copy(y.begin(), y.end(), out);
+  }
+
+private:
+  std::array<value_t, Order + 1> _b{};
+  std::array<value_t, Order>     _a{};
+  state_t                        _x{};
+  state_t                        _y{};
+  bool                           _settled{false};
+  std::unique_ptr<block>         _block;
+};
+
+
+/*!
+ * \brief Source of a filter coefficient: a constant, or the output of
+ *        another gate if `C` is that gate's type.
+ */
+template <typename V, class C>
+class coefficient_source
+{
+public:
+  using param_t = C &;
+
+  explicit coefficient_source(C & gate) noexcept : _gate(&gate) {}
+
+  void attach(node & n) { n.attach(*_gate); }
+
+  V operator()() noexcept { return (*_gate)(); }
+
+private:
+  C * _gate;
+};
+
+template <typename V>
+class coefficient_source<V, void>
+{
+public:
+  using param_t = V;
+
+  explicit coefficient_source(V value) noexcept : _value(value) {}
+
+  void attach(node &) noexcept {}
+
+  V operator()() const noexcept { return _value; }
+
+  void set(V value) noexcept { _value = value; }
+
+private:
+  V _value;
+};
+
+
+template <typename T>
+inline T decay(T cutoff, T sample_rate) noexcept {
+  return std::exp(-2 * pi<T>() * cutoff / sample_rate);
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Exponential moving average: `y[n] = y[n-1] + alpha (x[n] - y[n-1])`.
+ * \param I Template parameter specifying the input type.
+ * \param C Template parameter specifying the type of a gate providing
+ *        `alpha`, or `void` for a constant `alpha`.
+ *
+ * Smooths like a `moving_average`, but keeps the last input and output
+ * instead of a window. The average starts from zero. A coefficient gate is
+ * pulled on every evaluation, and once per block by `process()`.
+ */
+template <class I, class C = void>
+class ema
+{
+  using self_t    = ema<I, C>;
+  using input_t   = I;
+  using section_t = detail::iir_section<typename I::value_t, 1>;
+  using source_t  = detail::coefficient_source<typename I::value_t, C>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+  static_assert(std::is_floating_point<value_t>::value,
+                "ema requires a floating point value type");
+
+public:
+  ema(input_t & input, typename source_t::param_t alpha)
+   : _input(input), _alpha(alpha) {
+    _node.attach(_input);
+    _alpha.attach(_node);
+  }
+
+  ema(self_t && other) = default;
+
+  template <class D = C, REQUIRES(std::is_void<D>::value)>
+  void set_alpha(value_t alpha) noexcept {
+    _alpha.set(alpha);
+    _node.invalidate();
+  }
+
+  void reset() noexcept {
+    _section.clear();
+    _value = value_t();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("ema");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    configure();
+    _value = _section.step(_input());
+    if (!_section.settled()) { _node.mark_dirty(); }
+
+    return _value;
+  }
+
+  std::size_t process(span<const value_t> in, span<value_t> out) {
+    std::size_t count = std::min(in.size(), out.size());
+
+    configure();
+    _section.run(in.data(), out.data(), count);
+    if (count) { _value = out[count - 1]; }
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  void configure() noexcept {
+    value_t alpha = _alpha();
+    _section.set({{alpha, value_t()}}, {{alpha - 1}});
+  }
+
+private:
+  input_t & _input;
+  source_t  _alpha;
+  section_t _section;
+  value_t   _value{};
+  node      _node;
+};
+
+
+/*!
+ * \brief First order low-pass filter.
+ * \param I Template parameter specifying the input type.
+ * \param C Template parameter specifying the type of a gate providing the
+ *        cutoff frequency, or `void` for a constant one.
+ *
+ * An `ema` with `alpha = 1 - exp(-2 pi cutoff / sample_rate)`, i.e. the
+ * discretized RC low-pass with time constant `1 / (2 pi cutoff)`. Cutoff and
+ * sample rate are given in the same unit, e.g. Hz.
+ */
+template <class I, class C = void>
+class lowpass
+{
+  using self_t    = lowpass<I, C>;
+  using input_t   = I;
+  using section_t = detail::iir_section<typename I::value_t, 1>;
+  using source_t  = detail::coefficient_source<typename I::value_t, C>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+  static_assert(std::is_floating_point<value_t>::value,
+                "lowpass requires a floating point value type");
+
+public:
+  lowpass(input_t &                 input,
+          typename source_t::param_t cutoff,
+          value_t                    sample_rate)
+   : _input(input), _cutoff(cutoff), _sample_rate(sample_rate) {
+    _node.attach(_input);
+    _cutoff.attach(_node);
+  }
+
+  lowpass(self_t && other) = default;
+
+  template <class D = C, REQUIRES(std::is_void<D>::value)>
+  void set_cutoff(value_t cutoff) noexcept {
+    _cutoff.set(cutoff);
+    _node.invalidate();
+  }
+
+  void reset() noexcept {
+    _section.clear();
+    _value = value_t();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lowpass");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    configure();
+    _value = _section.step(_input());
+    if (!_section.settled()) { _node.mark_dirty(); }
+
+    return _value;
+  }
+
+  std::size_t process(span<const value_t> in, span<value_t> out) {
+    std::size_t count = std::min(in.size(), out.size());
+
+    configure();
+    _section.run(in.data(), out.data(), count);
+    if (count) { _value = out[count - 1]; }
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  void configure() noexcept {
+    value_t cutoff = _cutoff();
+    if (cutoff == _configured) { return; }
+
+    value_t decay = detail::decay(cutoff, _sample_rate);
+    _section.set({{1 - decay, value_t()}}, {{-decay}});
+    _configured = cutoff;
+  }
+
+private:
+  input_t & _input;
+  source_t  _cutoff;
+  value_t   _sample_rate;
+  value_t   _configured{-1};
+  section_t _section;
+  value_t   _value{};
+  node      _node;
+};
+
+
+/*!
+ * \brief First order high-pass filter:
+ *        `y[n] = d (y[n-1] + x[n] - x[n-1])`, `d = exp(-2 pi cutoff /
+ *        sample_rate)`.
+ * \param I Template parameter specifying the input type.
+ * \param C Template parameter specifying the type of a gate providing the
+ *        cutoff frequency, or `void` for a constant one.
+ *
+ * The discretized RC high-pass, the complement of `lowpass`; it removes the
+ * DC component and slow drift of a signal.
+ */
+template <class I, class C = void>
+class highpass
+{
+  using self_t    = highpass<I, C>;
+  using input_t   = I;
+  using section_t = detail::iir_section<typename I::value_t, 1>;
+  using source_t  = detail::coefficient_source<typename I::value_t, C>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+  static_assert(std::is_floating_point<value_t>::value,
+                "highpass requires a floating point value type");
+
+public:
+  highpass(input_t &                  input,
+           typename source_t::param_t cutoff,
+           value_t                    sample_rate)
+   : _input(input), _cutoff(cutoff), _sample_rate(sample_rate) {
+    _node.attach(_input);
+    _cutoff.attach(_node);
+  }
+
+  highpass(self_t && other) = default;
+
+  template <class D = C, REQUIRES(std::is_void<D>::value)>
+  void set_cutoff(value_t cutoff) noexcept {
+    _cutoff.set(cutoff);
+    _node.invalidate();
+  }
+
+  void reset() noexcept {
+    _section.clear();
+    _value = value_t();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("highpass");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    configure();
+    _value = _section.step(_input());
+    if (!_section.settled()) { _node.mark_dirty(); }
+
+    return _value;
+  }
+
+  std::size_t process(span<const value_t> in, span<value_t> out) {
+    std::size_t count = std::min(in.size(), out.size());
+
+    configure();
+    _section.run(in.data(), out.data(), count);
+    if (count) { _value = out[count - 1]; }
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  void configure() noexcept {
+    value_t cutoff = _cutoff();
+    if (cutoff == _configured) { return; }
+
+    value_t decay = detail::decay(cutoff, _sample_rate);
+    _section.set({{decay, -decay}}, {{-decay}});
+    _configured = cutoff;
+  }
+
+private:
+  input_t & _input;
+  source_t  _cutoff;
+  value_t   _sample_rate;
+  value_t   _configured{-1};
+  section_t _section;
+  value_t   _value{};
+  node      _node;
+};
+
+
+/*!
+ * \brief General second order IIR filter (biquad).
+ * \param I Template parameter specifying the input type.
+ * \param C Template parameter specifying the type of a gate providing the
+ *        `biquad_coefficients`, or `void` for constant ones.
+ *
+ * Design the coefficients with the static members of `biquad_coefficients`;
+ * higher order filters are built by chaining biquads.
+ */
+template <class I, class C = void>
+class biquad
+{
+  using self_t       = biquad<I, C>;
+  using input_t      = I;
+  using section_t    = detail::iir_section<typename I::value_t, 2>;
+  using coefficients = biquad_coefficients<typename I::value_t>;
+  using source_t     = detail::coefficient_source<coefficients, C>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+  static_assert(std::is_floating_point<value_t>::value,
+                "biquad requires a floating point value type");
+
+public:
+  biquad(input_t & input, typename source_t::param_t coeffs)
+   : _input(input), _coeffs(coeffs) {
+    _node.attach(_input);
+    _coeffs.attach(_node);
+  }
+
+  biquad(self_t && other) = default;
+
+  template <class D = C, REQUIRES(std::is_void<D>::value)>
+  void set_coefficients(const coefficients & coeffs) noexcept {
+    _coeffs.set(coeffs);
+    _node.invalidate();
+  }
+
+  void reset() noexcept {
+    _section.clear();
+    _value = value_t();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("biquad");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    configure();
+    _value = _section.step(_input());
+    if (!_section.settled()) { _node.mark_dirty(); }
+
+    return _value;
+  }
+
+  std::size_t process(span<const value_t> in, span<value_t> out) {
+    std::size_t count = std::min(in.size(), out.size());
+
+    configure();
+    _section.run(in.data(), out.data(), count);
+    if (count) { _value = out[count - 1]; }
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  void configure() noexcept {
+    coefficients c = _coeffs();
+    _section.set({{c.b0, c.b1, c.b2}}, {{c.a1, c.a2}});
+  }
+
+private:
+  input_t & _input;
+  source_t  _coeffs;
+  section_t _section;
+  value_t   _value{};
+  node      _node;
+};
+
+
+template <class I>
+inline ema<I> make_ema(I & input, typename I::value_t alpha) {
+  return {input, alpha};
+}
+
+template <class I, class C, REQUIRES(!std::is_arithmetic<C>::value)>
+inline ema<I, C> make_ema(I & input, C & alpha) {
+  return {input, alpha};
+}
+
+template <class I>
+inline lowpass<I> make_lowpass(I &                 input,
+                               typename I::value_t cutoff,
+                               typename I::value_t sample_rate) {
+  return {input, cutoff, sample_rate};
+}
+
+template <class I, class C, REQUIRES(!std::is_arithmetic<C>::value)>
+inline lowpass<I, C> make_lowpass(I &                 input,
+                                  C &                 cutoff,
+                                  typename I::value_t sample_rate) {
+  return {input, cutoff, sample_rate};
+}
+
+template <class I>
+inline highpass<I> make_highpass(I &                 input,
+                                 typename I::value_t cutoff,
+                                 typename I::value_t sample_rate) {
+  return {input, cutoff, sample_rate};
+}
+
+template <class I, class C, REQUIRES(!std::is_arithmetic<C>::value)>
+inline highpass<I, C> make_highpass(I &                 input,
+                                    C &                 cutoff,
+                                    typename I::value_t sample_rate) {
+  return {input, cutoff, sample_rate};
+}
+
+template <class I>
+inline biquad<I>
+make_biquad(I &                                              input,
+            const biquad_coefficients<typename I::value_t> & coeffs) {
+  return {input, coeffs};
+}
+
+template <class I,
+          class C,
+          class K = biquad_coefficients<typename I::value_t>,
+          REQUIRES(!std::is_same<C, K>::value)>
+inline biquad<I, C> make_biquad(I & input, C & coeffs) {
+  return {input, coeffs};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_IIR_H_
@@ -17,6 +17,13 @@
 #ifndef PIPEBB_INVERTER_H_
 #define PIPEBB_INVERTER_H_
 
+#include <algorithm>
+#include <cstddef>
+
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+
 
 namespace pipebb {
 
@@ -31,19 +38,38 @@ public:
   using value_t = typename input_t::value_t;
 
 public:
-  inverter(input_t & input) noexcept : _input(input) {}
+  inverter(input_t & input) : _input(input) { _node.attach(_input); }
 
   inverter(self_t && other) = default;
 
-  value_t operator()() noexcept { return -_input(); }
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("inverter");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value = -_input();
+  }
+
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    simd::negate(in.data(), out.data(), count);
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
 
 private:
   input_t & _input;
+  node      _node;
+  value_t   _value{};
 };
 
 
 template <class I>
-inline inverter<I> make_inverter(I & input) noexcept {
+inline inverter<I> make_inverter(I & input) {
   return {input};
 }
 
@@ -0,0 +1,846 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_LANES_H_
+#define PIPEBB_LANES_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "channel.h"
+#include "counter.h"
+#include "gradient.h"
+#include "moving_average.h"
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+#include "threshold.h"
+#include "utils.h"
+
+
+namespace pipebb {
+namespace detail {
+
+
+/*!
+ * \brief Fixed size, zero initialized array holding one value per lane.
+ * \param T Template parameter specifying the element type.
+ *
+ * Unlike `std::vector`, this also stores `bool` as plain contiguous values,
+ * so every lane gate can hand out its outputs as a `span`.
+ */
+template <typename T>
+class lane_array
+{
+public:
+  explicit lane_array(std::size_t size) : _data(new T[size]()), _size(size) {}
+
+  T *         data() noexcept { return _data.get(); }
+  const T *   data() const noexcept { return _data.get(); }
+  std::size_t size() const noexcept { return _size; }
+
+  T &       operator[](std::size_t i) noexcept { return _data[i]; }
+  const T & operator[](std::size_t i) const noexcept { return _data[i]; }
+
+  span<const T> view() const noexcept { return {_data.get(), _size}; }
+
+  void fill(T value) noexcept {
+    std::fill(_data.get(), _data.get() + _size, value);
+  }
+
+  void swap(lane_array & other) noexcept {
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+  }
+
+private:
+  std::unique_ptr<T[]> _data;
+  std::size_t          _size;
+};
+
+
+/*!
+ * \brief Sliding window over `N` rows of one value per lane.
+ * \param T Template parameter specifying the value type.
+ * \param N Template parameter specifying the window length.
+ *
+ * The rows are stored one after the other, lane by lane, so pushing a row and
+ * updating the per-lane sums touches contiguous memory only. The sums are
+ * updated in O(1) per lane and recomputed from the window content every
+ * `resync_factor` window lengths, which bounds the floating point rounding
+ * error the same way `running_sum` does for the scalar windows.
+ */
+template <typename T, std::size_t N>
+class lane_window
+{
+  static_assert(N > 0, "lane windows need at least one row");
+
+  static constexpr std::size_t resync_factor = 32;
+
+public:
+  explicit lane_window(std::size_t lanes)
+   : _rows(N * lanes), _sums(lanes), _lanes(lanes) {}
+
+  std::size_t lanes() const noexcept { return _lanes; }
+
+  // number of consecutive identical rows pushed last, at most N
+  std::size_t run() const noexcept { return _run; }
+
+  const T * sums() const noexcept { return _sums.data(); }
+
+  void clear() noexcept {
+    _rows.fill(T());
+    _sums.fill(T());
+    _head = _size = _run = _updates = 0;
+  }
+
+  void push(span<const T> row) noexcept {
+    std::size_t count = std::min(row.size(), _lanes);
+
+    const T * src  = row.data();
+    const T * last = _rows.data() + ((_head + N - 1) % N) * _lanes;
+    T *       slot = _rows.data() + _head * _lanes;
+    T *       sums = _sums.data();
+
+    bool same = _size > 0;
+    for (std::size_t l = 0; l < count; ++l) { same &= src[l] == last[l]; }
+
+    if (_size == N) {
+      for (std::size_t l = 0; l < count; ++l) { sums[l] += src[l] - slot[l]; }
+    } else {
+      for (std::size_t l = 0; l < count; ++l) { sums[l] += src[l]; }
+      ++_size;
+    }
+
+    std::copy(src, src + count, slot);
+    _head = (_head + 1) % N;
+    _run  = same ? std::min(_run + 1, N) : 1;
+
+    if (++_updates >= resync_factor * N) { resync(); }
+  }
+
+private:
+  void resync() noexcept {
+    T * sums = _sums.data();
+
+    _sums.fill(T());
+    for (std::size_t r = 0; r < N; ++r) {
+      const T * row = _rows.data() + r * _lanes;
+      for (std::size_t l = 0; l < _lanes; ++l) { sums[l] += row[l]; }
+    }
+
+    _updates = 0;
+  }
+
+private:
+  lane_array<T> _rows;
+  lane_array<T> _sums;
+  std::size_t   _lanes;
+  std::size_t   _head{0};
+  std::size_t   _size{0};
+  std::size_t   _run{0};
+  std::size_t   _updates{0};
+};
+
+}  // namespace detail
+
+
+/*!
+ * \brief Channel carrying one signal for each of many identical sources.
+ * \param T Template parameter specifying the value type.
+ *
+ * A `lane_channel` is the structure-of-arrays counterpart of `channel`: name,
+ * unit, factor and offset are shared, while the raw and normalized values are
+ * stored in one contiguous array each, indexed by lane. Gates built on top of
+ * it with the `make_lane_*` functions (`lane_factor`, `lane_gradient`,
+ * `lane_moving_average`, ...) keep their state the same way, so a single call
+ * to the last gate of a graph advances every lane in vectorizable loops,
+ * instead of walking thousands of separate gate graphs.
+ *
+ * Calling a lane gate returns a `span` over its output, one value per lane.
+ * The span stays valid as long as the gate does; it is updated in place by
+ * the next evaluation. Lane gates take part in the evaluation graph exactly
+ * like their scalar counterparts: they are memoized per tick and only
+ * recomputed when an input has changed.
+ *
+ * \include lanes.cc
+ */
+template <typename T,
+          REQUIRES(std::is_arithmetic<T>() && !std::is_same<T, bool>())>
+class lane_channel
+{
+public:
+  using value_t = T;
+
+public:
+  /*!
+   * \brief Constructor for the `lane_channel` class.
+   * \param lanes Number of lanes.
+   * \param name Name of the channel.
+   * \param unit Unit for the channel.
+   * \param factor Factor applied to incoming data.
+   * \param offset Offset applied to incoming data.
+   */
+  explicit lane_channel(std::size_t lanes,
+                        std::string name,
+                        std::string unit,
+                        value_t     factor,
+                        value_t     offset)
+   : _name(name),
+     _unit(unit),
+     _factor(factor),
+     _offset(offset),
+     _raw(lanes),
+     _out(lanes) {}
+
+  /*!
+   * \brief Simplified constructor for the `lane_channel` class.
+   * \param lanes Number of lanes.
+   * \param name Name of the channel.
+   *
+   * Using this constructor, the channel will have an empty unit, the factor
+   * will be 1 and the offset will be 0.
+   */
+  explicit lane_channel(std::size_t lanes, std::string name)
+   : lane_channel(lanes, name, "", value_t(1), value_t(0)) {}
+
+  lane_channel(lane_channel && other) = default;
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  std::string name() const noexcept { return _name; }
+  std::string unit() const noexcept { return _unit; }
+  value_t     factor() const noexcept { return _factor; }
+  value_t     offset() const noexcept { return _offset; }
+  std::size_t lanes() const noexcept { return _raw.size(); }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  /*! \name Setters */ /*!@{*/
+  /*! Setter. */       /* -------------------------------------------------- */
+  void factor(value_t factor) noexcept {
+    _factor = factor;
+    _node.invalidate();
+  }
+  void offset(value_t offset) noexcept {
+    _offset = offset;
+    _node.invalidate();
+  }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  /*!
+   * \brief Stream operator taking one raw value per lane.
+   * \param values Raw values, starting at lane 0; surplus values are ignored.
+   */
+  void operator<<(span<const value_t> values) noexcept {
+    std::size_t count = std::min(values.size(), _raw.size());
+
+    std::copy(values.begin(), values.begin() + count, _raw.data());
+    _node.invalidate();
+  }
+
+  /*!
+   * \brief Set the raw value of a single lane.
+   * \param lane Index of the lane.
+   * \param value Raw value.
+   */
+  void set(std::size_t lane, value_t value) noexcept {
+    if (value != _raw[lane]) {
+      _raw[lane] = value;
+      _node.invalidate();
+    }
+  }
+
+  /*!
+   * \brief   Retrieve the normalized values of all lanes.
+   * \returns One normalized value per lane.
+   */
+  span<const value_t> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_channel");
+    if (!_node.current()) {
+      _node.update();
+
+      const value_t * src = _raw.data();
+      value_t *       dst = _out.data();
+      for (std::size_t l = 0; l < _out.size(); ++l) {
+        dst[l] = detail::normalize(src[l], _offset, _factor);
+      }
+    }
+
+    return _out.view();
+  }
+
+  /*!
+   * \brief   Get the channel's node in the evaluation graph.
+   * \returns Reference to the channel's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
+private:
+  std::string                 _name;
+  std::string                 _unit;
+  value_t                     _factor;
+  value_t                     _offset;
+  detail::lane_array<value_t> _raw;
+  detail::lane_array<value_t> _out;
+  node                        _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `factor`.
+ */
+template <class I>
+class lane_factor
+{
+  using self_t  = lane_factor<I>;
+  using input_t = I;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  lane_factor(input_t & input, value_t constant)
+   : _input(input), _constant(constant), _out(input.lanes()) {
+    _node.attach(_input);
+  }
+
+  lane_factor(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _out.size(); }
+
+  void set_constant(value_t constant) noexcept {
+    _constant = constant;
+    _node.invalidate();
+  }
+
+  span<const value_t> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_factor");
+    if (_node.current()) { return _out.view(); }
+    _node.update();
+
+    auto        in    = _input();
+    std::size_t count = std::min(in.size(), _out.size());
+    simd::scale(in.data(), _constant, _out.data(), count);
+
+    return _out.view();
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t &                   _input;
+  value_t                     _constant;
+  detail::lane_array<value_t> _out;
+  node                        _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `offset`.
+ */
+template <class I>
+class lane_offset
+{
+  using self_t  = lane_offset<I>;
+  using input_t = I;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  lane_offset(input_t & input, value_t constant)
+   : _input(input), _constant(constant), _out(input.lanes()) {
+    _node.attach(_input);
+  }
+
+  lane_offset(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _out.size(); }
+
+  void set_constant(value_t constant) noexcept {
+    _constant = constant;
+    _node.invalidate();
+  }
+
+  span<const value_t> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_offset");
+    if (_node.current()) { return _out.view(); }
+    _node.update();
+
+    auto        in    = _input();
+    std::size_t count = std::min(in.size(), _out.size());
+    simd::shift(in.data(), _constant, _out.data(), count);
+
+    return _out.view();
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t &                   _input;
+  value_t                     _constant;
+  detail::lane_array<value_t> _out;
+  node                        _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `threshold`; outputs one `bool` per lane.
+ */
+template <class I>
+class lane_threshold
+{
+  using self_t  = lane_threshold<I>;
+  using input_t = I;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  lane_threshold(input_t & input, value_t limit)
+   : _input(input), _limit(limit), _out(input.lanes()) {
+    _node.attach(_input);
+  }
+
+  lane_threshold(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _out.size(); }
+
+  void set_limit(value_t limit) noexcept {
+    _limit = limit;
+    _node.invalidate();
+  }
+
+  span<const bool> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_threshold");
+    if (_node.current()) { return _out.view(); }
+    _node.update();
+
+    auto        in    = _input();
+    std::size_t count = std::min(in.size(), _out.size());
+
+    const value_t * src = in.data();
+    bool *          dst = _out.data();
+    for (std::size_t l = 0; l < count; ++l) {
+      dst[l] = detail::exceeds(src[l], _limit);
+    }
+
+    return _out.view();
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t &                _input;
+  value_t                  _limit;
+  detail::lane_array<bool> _out;
+  node                     _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `gradient`.
+ *
+ * The two most recent input values of all lanes are kept in two arrays,
+ * which swap roles on every evaluation instead of being copied. As with
+ * `gradient`, the input values are truncated to `std::int_fast32_t` points
+ * before the differences are taken.
+ */
+template <class I>
+class lane_gradient
+{
+  using self_t  = lane_gradient<I>;
+  using input_t = I;
+
+public:
+  using value_t = detail::gradient_value_t;
+
+public:
+  lane_gradient(input_t & input)
+   : _input(input),
+     _first(input.lanes()),
+     _second(input.lanes()),
+     _out(input.lanes()) {
+    _node.attach(_input);
+  }
+
+  lane_gradient(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _out.size(); }
+
+  void reset() noexcept {
+    _first.fill(value_t());
+    _second.fill(value_t());
+    _out.fill(value_t());
+    _node.invalidate();
+  }
+
+  span<const value_t> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_gradient");
+    if (_node.current()) { return _out.view(); }
+    _node.update();
+
+    auto        in    = _input();
+    std::size_t count = std::min(in.size(), _out.size());
+
+    _first.swap(_second);
+
+    auto            src    = in.data();
+    const value_t * first  = _first.data();
+    value_t *       second = _second.data();
+    value_t *       dst    = _out.data();
+
+    bool settled = true;
+    for (std::size_t l = 0; l < count; ++l) {
+      second[l] = detail::gradient_point(src[l]);
+      dst[l]    = second[l] - first[l];
+      settled &= second[l] == first[l];
+    }
+
+    // as for gradient: stay dirty until both points agree in every lane
+    if (!settled) { _node.mark_dirty(); }
+
+    return _out.view();
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t &                   _input;
+  detail::lane_array<value_t> _first;
+  detail::lane_array<value_t> _second;
+  detail::lane_array<value_t> _out;
+  node                        _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `moving_average`.
+ *
+ * Every evaluation pushes one value per lane; unlike `moving_average`, zeros
+ * cannot be skipped, since all lanes share a single window position.
+ */
+template <class I, std::size_t N>
+class lane_moving_average
+{
+  using self_t   = lane_moving_average<I, N>;
+  using input_t  = I;
+  using window_t = detail::lane_window<typename input_t::value_t, N>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  lane_moving_average(input_t & input)
+   : _input(input), _window(input.lanes()), _out(input.lanes()) {
+    _node.attach(_input);
+  }
+
+  lane_moving_average(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _out.size(); }
+
+  void reset() noexcept {
+    _window.clear();
+    _out.fill(value_t());
+    _node.invalidate();
+  }
+
+  span<const value_t> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_moving_average");
+    if (_node.current()) { return _out.view(); }
+    _node.update();
+
+    _window.push(_input());
+
+    const value_t * sums = _window.sums();
+    value_t *       dst  = _out.data();
+    for (std::size_t l = 0; l < _out.size(); ++l) {
+      dst[l] = detail::average(sums[l], N);
+    }
+
+    if (_window.run() < N) { _node.mark_dirty(); }
+
+    return _out.view();
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t &                   _input;
+  window_t                    _window;
+  detail::lane_array<value_t> _out;
+  node                        _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `accumulator`.
+ *
+ * Every evaluation pushes one value per lane; unlike `accumulator`, zeros
+ * cannot be skipped, since all lanes share a single window position.
+ */
+template <class I, std::size_t N>
+class lane_accumulator
+{
+  using self_t   = lane_accumulator<I, N>;
+  using input_t  = I;
+  using window_t = detail::lane_window<typename input_t::value_t, N>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  lane_accumulator(input_t & input)
+   : _input(input), _window(input.lanes()) {
+    _node.attach(_input);
+  }
+
+  lane_accumulator(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _window.lanes(); }
+
+  void reset() noexcept {
+    _window.clear();
+    _node.invalidate();
+  }
+
+  span<const value_t> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_accumulator");
+    if (!_node.current()) {
+      _node.update();
+      _window.push(_input());
+
+      if (_window.run() < N) { _node.mark_dirty(); }
+    }
+
+    return {_window.sums(), _window.lanes()};
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t & _input;
+  window_t  _window;
+  node      _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `boolean_counter`.
+ */
+template <class I>
+class lane_boolean_counter
+{
+  using self_t  = lane_boolean_counter<I>;
+  using input_t = I;
+
+public:
+  using value_t = typename counter::value_t;
+
+public:
+  lane_boolean_counter(input_t & input)
+   : _input(input), _counts(input.lanes()) {
+    _node.attach(_input);
+  }
+
+  lane_boolean_counter(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _counts.size(); }
+
+  void reset() noexcept {
+    _counts.fill(0);
+    _node.invalidate();
+  }
+
+  span<const value_t> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_boolean_counter");
+    if (_node.current()) { return _counts.view(); }
+    _node.update();
+
+    auto        in    = _input();
+    std::size_t count = std::min(in.size(), _counts.size());
+
+    const bool * src    = in.data();
+    value_t *    counts = _counts.data();
+
+    bool counting = false;
+    for (std::size_t l = 0; l < count; ++l) {
+      counts[l] += src[l];
+      counting |= src[l];
+    }
+
+    // counts up for as long as the input holds in any lane
+    if (counting) { _node.mark_dirty(); }
+
+    return _counts.view();
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t &                   _input;
+  detail::lane_array<value_t> _counts;
+  node                        _node;
+};
+
+
+/*!
+ * \brief Lane-wise counterpart of `logic_gate`.
+ * \param L Template parameter specifying the logical operation.
+ * \param Is Template parameter pack specifying the types of the inputs.
+ *
+ * All inputs are evaluated in every lane, there is no short circuit.
+ */
+template <class L, class I, class... Is>
+class lane_logic_gate
+{
+  using self_t     = lane_logic_gate<L, I, Is...>;
+  using logical_op = L;
+  using inputs_t   = std::tuple<I &, Is &...>;
+
+public:
+  using value_t = bool;
+
+public:
+  lane_logic_gate(I & input, Is &... inputs)
+   : _inputs(input, inputs...), _out(input.lanes()) {
+    attach(std::index_sequence_for<I, Is...>());
+  }
+
+  lane_logic_gate(self_t && other) = default;
+
+  std::size_t lanes() const noexcept { return _out.size(); }
+
+  span<const bool> operator()() noexcept {
+    PIPEBB_PROFILE_GATE("lane_logic_gate");
+    if (_node.current()) { return _out.view(); }
+    _node.update();
+
+    fold<0>();
+
+    return _out.view();
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  template <std::size_t... Ks>
+  void attach(std::index_sequence<Ks...>) {
+    int expand[] = {(_node.attach(std::get<Ks>(_inputs)), 0)...};
+    (void)expand;
+  }
+
+  // folds the inputs into the output one at a time, last input first, like
+  // logic_gate::process()
+  template <std::size_t K>
+  std::enable_if_t<K == sizeof...(Is)> fold() noexcept {
+    auto        in    = std::get<K>(_inputs)();
+    std::size_t count = std::min(in.size(), _out.size());
+
+    std::copy(in.begin(), in.begin() + count, _out.data());
+  }
+
+  template <std::size_t K>
+  std::enable_if_t<K != sizeof...(Is)> fold() noexcept {
+    fold<K + 1>();
+
+    auto        in    = std::get<K>(_inputs)();
+    std::size_t count = std::min(in.size(), _out.size());
+
+    const bool * src = in.data();
+    bool *       dst = _out.data();
+    for (std::size_t l = 0; l < count; ++l) {
+      dst[l] = logical_op()(src[l], dst[l]);
+    }
+  }
+
+private:
+  inputs_t                 _inputs;
+  detail::lane_array<bool> _out;
+  node                     _node;
+};
+
+
+template <typename T>
+inline lane_channel<T> make_lane_channel(std::size_t lanes,
+                                         std::string name,
+                                         std::string unit   = "",
+                                         T           factor = T(1),
+                                         T           offset = T(0)) {
+  return lane_channel<T>{lanes, name, unit, factor, offset};
+}
+
+template <class I>
+inline lane_factor<I> make_lane_factor(I &                 input,
+                                       typename I::value_t constant) {
+  return {input, constant};
+}
+
+template <class I>
+inline lane_offset<I> make_lane_offset(I &                 input,
+                                       typename I::value_t constant) {
+  return {input, constant};
+}
+
+template <class I>
+inline lane_threshold<I> make_lane_threshold(I &                 input,
+                                             typename I::value_t limit) {
+  return {input, limit};
+}
+
+template <class I>
+inline lane_gradient<I> make_lane_gradient(I & input) {
+  return {input};
+}
+
+template <std::size_t N, class I>
+inline lane_moving_average<I, N> make_lane_moving_average(I & input) {
+  return {input};
+}
+
+template <std::size_t N, class I>
+inline lane_accumulator<I, N> make_lane_accumulator(I & input) {
+  return {input};
+}
+
+template <class I>
+inline lane_boolean_counter<I> make_lane_boolean_counter(I & input) {
+  return {input};
+}
+
+template <class... Is>
+inline lane_logic_gate<std::logical_and<bool>, Is...> make_lane_and_gate(
+  Is &... inputs) {
+  return {inputs...};
+}
+
+template <class... Is>
+inline lane_logic_gate<std::logical_or<bool>, Is...> make_lane_or_gate(
+  Is &... inputs) {
+  return {inputs...};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_LANES_H_
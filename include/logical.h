@@ -17,59 +17,126 @@
 #ifndef PIPEBB_LOGIC_H_
 #define PIPEBB_LOGIC_H_
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <functional>
 #include <utility>
 
+#include "node.h"
+#include "span.h"
+
 
 namespace pipebb {
 
 
+namespace detail {
+
+
+//
+// holds the inputs of a logic_gate and folds their values with L, first input
+// outermost: L(first, L(second, ...))
+//
 template <class L, class... Is>
-class logic_gate
+class logic_inputs
 {};
 
 template <class L, class I, class... Is>
-class logic_gate<L, I, Is...> : logic_gate<L, Is...>
+class logic_inputs<L, I, Is...> : logic_inputs<L, Is...>
 {
-  using self_t     = logic_gate<L, I, Is...>;
-  using parent_t   = logic_gate<L, Is...>;
+  using parent_t   = logic_inputs<L, Is...>;
   using logical_op = L;
 
 public:
-  using value_t = bool;
+  logic_inputs(I & input, Is &... inputs) noexcept
+   : parent_t(inputs...), _input(input) {}
 
-public:
-  logic_gate(I & input, Is &... inputs) noexcept
-   : logic_gate<logical_op, Is...>(inputs...), _input(input) {}
+  bool evaluate() noexcept {
+    return logical_op()(_input(), parent_t::evaluate());
+  }
 
-  value_t operator()() noexcept {
-    return logical_op()(_input(), parent_t::operator()());
+  void attach_to(node & n) {
+    n.attach(_input);
+    parent_t::attach_to(n);
   }
 
 private:
   I & _input;
 };
 
-template <class L, class I, class J>
-class logic_gate<L, I, J>
+template <class L, class I>
+class logic_inputs<L, I>
+{
+public:
+  logic_inputs(I & input) noexcept : _input(input) {}
+
+  bool evaluate() noexcept { return _input(); }
+
+  void attach_to(node & n) { n.attach(_input); }
+
+private:
+  I & _input;
+};
+
+}  // namespace detail
+
+
+template <class L, class... Is>
+class logic_gate
+{};
+
+template <class L, class I, class... Is>
+class logic_gate<L, I, Is...>
 {
-  using self_t     = logic_gate<L, I, J>;
+  using self_t     = logic_gate<L, I, Is...>;
   using logical_op = L;
-  using lhs_t      = I;
-  using rhs_t      = J;
+  using inputs_t   = detail::logic_inputs<L, I, Is...>;
 
 public:
   using value_t = bool;
 
+  //! one block of values per input object, in the order of the inputs
+  using blocks_t = std::array<span<const bool>, sizeof...(Is) + 1>;
+
 public:
-  logic_gate(lhs_t & first, rhs_t & second) noexcept
-   : _first(first), _second(second) {}
+  logic_gate(I & input, Is &... inputs) : _inputs(input, inputs...) {
+    _inputs.attach_to(_node);
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("logic_gate");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value = _inputs.evaluate();
+  }
+
+  // equivalent to calling operator() once per sample; folds the blocks one
+  // input at a time, last input first, in loops the compiler can vectorize
+  std::size_t process(const blocks_t & in, span<bool> out) noexcept {
+    std::size_t count = out.size();
+    for (auto & block : in) { count = std::min(count, block.size()); }
+
+    bool * dst = out.data();
+    std::copy(in.back().begin(), in.back().begin() + count, dst);
 
-  value_t operator()() noexcept { return logical_op()(_first(), _second()); }
+    for (std::size_t k = in.size() - 1; k-- > 0;) {
+      const bool * src = in[k].data();
+      for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = logical_op()(src[i], dst[i]);
+      }
+    }
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
 
 private:
-  lhs_t & _first;
-  rhs_t & _second;
+  inputs_t _inputs;
+  node     _node;
+  value_t  _value{false};
 };
 
 
@@ -84,7 +151,7 @@ class and_gate<I, Is...> : public logic_gate<std::logical_and<bool>, I, Is...>
   using parent_t = logic_gate<std::logical_and<bool>, I, Is...>;
 
 public:
-  and_gate(I & input, Is &... inputs) noexcept : parent_t(input, inputs...) {}
+  and_gate(I & input, Is &... inputs) : parent_t(input, inputs...) {}
 };
 
 template <class I, class J>
@@ -96,12 +163,12 @@ class and_gate<I, J> : public logic_gate<std::logical_and<bool>, I, J>
   using rhs_t    = J;
 
 public:
-  and_gate(lhs_t & first, rhs_t & second) noexcept : parent_t(first, second) {}
+  and_gate(lhs_t & first, rhs_t & second) : parent_t(first, second) {}
 };
 
 
 template <class... Is>
-inline and_gate<Is...> make_and_gate(Is &... inputs) noexcept {
+inline and_gate<Is...> make_and_gate(Is &... inputs) {
   return {inputs...};
 }
 
@@ -117,7 +184,7 @@ class or_gate<I, Is...> : public logic_gate<std::logical_or<bool>, I, Is...>
   using parent_t = logic_gate<std::logical_or<bool>, I, Is...>;
 
 public:
-  or_gate(I & input, Is &... inputs) noexcept : parent_t(input, inputs...) {}
+  or_gate(I & input, Is &... inputs) : parent_t(input, inputs...) {}
 };
 
 template <class I, class J>
@@ -129,12 +196,12 @@ class or_gate<I, J> : public logic_gate<std::logical_or<bool>, I, J>
   using rhs_t    = J;
 
 public:
-  or_gate(lhs_t & first, rhs_t & second) noexcept : parent_t(first, second) {}
+  or_gate(lhs_t & first, rhs_t & second) : parent_t(first, second) {}
 };
 
 
 template <class... Is>
-inline or_gate<Is...> make_or_gate(Is &... inputs) noexcept {
+inline or_gate<Is...> make_or_gate(Is &... inputs) {
   return {inputs...};
 }
 
@@ -149,18 +216,41 @@ public:
   using value_t = bool;
 
 public:
-  explicit not_gate(input_t & input) noexcept : _input(input) {}
+  explicit not_gate(input_t & input) : _input(input) {
+    _node.attach(_input);
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("not_gate");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value = !_input();
+  }
+
+  std::size_t process(span<const bool> in, span<bool> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    const bool * src = in.data();
+    bool *       dst = out.data();
+    for (std::size_t i = 0; i < count; ++i) { dst[i] = !src[i]; }
+
+    _node.invalidate();
+    return count;
+  }
 
-  value_t operator()() noexcept { return !_input(); }
+  node & graph_node() noexcept { return _node; }
 
 private:
   input_t & _input;
+  node      _node;
+  value_t   _value{false};
 };
 
 
 template <class I>
-inline not_gate<I> make_not_gate(I & input) noexcept {
-  return {input};
+inline not_gate<I> make_not_gate(I & input) {
+  return not_gate<I>{input};
 }
 
 }  // namespace pipebb
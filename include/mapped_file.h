@@ -0,0 +1,120 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_MAPPED_FILE_H_
+#define PIPEBB_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PIPEBB_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace pipebb {
+namespace detail {
+
+
+/*!
+ * \brief Read-only view of a whole file.
+ *
+ * Maps the file into memory where POSIX `mmap()` is available, so pages are
+ * read on first access and shared with the page cache instead of being
+ * copied; elsewhere, the file is read into a buffer. The data is suitably
+ * aligned for any fundamental type in either case.
+ *
+ * \throws std::runtime_error if the file can't be opened or mapped.
+ */
+class mapped_file
+{
+public:
+  explicit mapped_file(const std::string & path) {
+#ifdef PIPEBB_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { throw std::runtime_error("cannot open " + path); }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("cannot stat " + path);
+    }
+
+    _size = static_cast<std::size_t>(st.st_size);
+    if (_size > 0) {
+      void * addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("cannot map " + path);
+      }
+      _data = static_cast<const char *>(addr);
+
+      // data is read front to back
+      ::madvise(addr, _size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) { throw std::runtime_error("cannot open " + path); }
+
+    _size = static_cast<std::size_t>(file.tellg());
+    _buffer.resize(_size / sizeof(std::max_align_t) + 1);
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(_buffer.data()),
+              static_cast<std::streamsize>(_size));
+    _data = reinterpret_cast<const char *>(_buffer.data());
+#endif
+  }
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file & operator=(const mapped_file &) = delete;
+
+  mapped_file(mapped_file && other) noexcept
+   : _data(other._data),
+     _size(other._size),
+     _buffer(std::move(other._buffer)) {
+    other._data = nullptr;
+    other._size = 0;
+  }
+
+  ~mapped_file() {
+#ifdef PIPEBB_HAVE_MMAP
+    if (_data) { ::munmap(const_cast<char *>(_data), _size); }
+#endif
+  }
+
+  const char * data() const noexcept { return _data; }
+  std::size_t  size() const noexcept { return _size; }
+
+private:
+  const char *                  _data{nullptr};
+  std::size_t                   _size{0};
+  std::vector<std::max_align_t> _buffer;
+};
+
+}  // namespace detail
+}  // namespace pipebb
+
+#endif  // PIPEBB_MAPPED_FILE_H_
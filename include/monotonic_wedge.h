@@ -0,0 +1,116 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_MONOTONIC_WEDGE_H_
+#define PIPEBB_MONOTONIC_WEDGE_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "dynamic_ringbuffer.h"
+#include "ringbuffer.h"
+#include "span.h"
+#include "utils.h"
+
+
+namespace pipebb {
+namespace detail {
+
+
+/*!
+ * \brief Minimum or maximum over a sliding window, updated in amortized O(1)
+ *        per pushed value.
+ * \param T Template parameter specifying the value type.
+ * \param N Template parameter specifying the window size, or
+ *        `dynamic_extent`.
+ * \param C Template parameter specifying the ordering; `std::less<T>` keeps
+ *        the minimum, `std::greater<T>` the maximum.
+ * \param A Template parameter specifying the allocator for dynamic windows.
+ *
+ * Keeps the candidates for the extremum of the window in a `ringbuffer` used
+ * as a deque (Lemire's monotonic wedge): values are strictly ordered by `C`
+ * from front to back, each tagged with the number of the push that brought
+ * it in. A new value evicts all candidates at the back it beats or ties,
+ * since they leave the window before it. The candidate at the front is the
+ * extremum, and is evicted once it falls out of the window. Each value enters
+ * and leaves the deque once, and the deque never holds more than the window
+ * size.
+ */
+template <typename T, std::size_t N, class C, class A = std::allocator<T>>
+class monotonic_wedge
+{
+  using value_t = T;
+
+  struct candidate
+  {
+    value_t     value;
+    std::size_t stamp;
+  };
+
+  using alloc_t =
+    typename std::allocator_traits<A>::template rebind_alloc<candidate>;
+  using buffer_t = window_buffer_t<candidate, N, alloc_t>;
+
+public:
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  monotonic_wedge() noexcept {}
+
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  explicit monotonic_wedge(std::size_t window, const A & alloc = A())
+   : _buffer(window, alloc_t(alloc)) {}
+
+  void push(value_t value) noexcept {
+    while (!_buffer.empty() && !_compare(_buffer.back().value, value)) {
+      _buffer.pop_back();
+    }
+    // a full deque holds exactly the window, so pushing overwrites the
+    // candidate that is about to expire anyway
+    _buffer.push({value, _stamp});
+
+    if (_stamp - _buffer.front().stamp >= _buffer.max_size()) {
+      _buffer.pop_front();
+    }
+    ++_stamp;
+  }
+
+  void clear() noexcept {
+    while (!_buffer.empty()) { _buffer.pop_back(); }
+    _stamp = 0;
+  }
+
+  // the extremum of the values pushed so far, at most window() of them;
+  // T() if none
+  value_t value() const noexcept {
+    return _buffer.empty() ? value_t() : _buffer.front().value;
+  }
+
+  // true if the newest value is the extremum and will stay it as long as
+  // equal values are pushed
+  bool settled() const noexcept { return _buffer.size() == 1; }
+
+  std::size_t window() const noexcept { return _buffer.max_size(); }
+
+private:
+  buffer_t    _buffer;
+  C           _compare;
+  std::size_t _stamp{0};
+};
+
+}  // namespace detail
+}  // namespace pipebb
+
+#endif  // PIPEBB_MONOTONIC_WEDGE_H_
@@ -17,73 +17,173 @@
 #ifndef PIPEBB_MOVING_AVERAGE_H_
 #define PIPEBB_MOVING_AVERAGE_H_
 
-#include <numeric>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 
+#include "dynamic_ringbuffer.h"
+#include "node.h"
 #include "ringbuffer.h"
+#include "running_sum.h"
+#include "span.h"
+#include "utils.h"
 
 
 namespace pipebb {
+namespace detail {
 
 
-template <class I, std::size_t N>
+// mean of a window sum, shared by moving_average and lane_moving_average;
+// the length is converted first, so negative integral sums stay signed
+template <typename T>
+inline T average(T sum, std::size_t window) noexcept {
+  return sum / static_cast<T>(window);
+}
+
+}  // namespace detail
+
+
+template <class I,
+          std::size_t N,
+          class A = std::allocator<typename I::value_t>>
 class moving_average
 {
-  using self_t   = moving_average<I, N>;
+  using self_t   = moving_average<I, N, A>;
   using input_t  = I;
-  using buffer_t = ringbuffer<typename input_t::value_t, N>;
+  using buffer_t = detail::window_buffer_t<typename input_t::value_t, N, A>;
+  using sum_t    = detail::running_sum<typename input_t::value_t>;
 
 public:
   using value_t = typename input_t::value_t;
 
 public:
-  moving_average(input_t & input, bool use_zeros = true) noexcept
-   : _input(input), _use_zeros(use_zeros) {}
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  moving_average(input_t & input, bool use_zeros = true)
+   : _input(input), _use_zeros(use_zeros), _sum(resync_factor * N) {
+    _node.attach(_input);
+  }
 
-  moving_average(self_t && other) = default;
+  // window size chosen at runtime, storage drawn from alloc
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  moving_average(input_t &   input,
+                 std::size_t window,
+                 bool        use_zeros = true,
+                 const A &   alloc     = A())
+   : _input(input),
+     _use_zeros(use_zeros),
+     _buffer(detail::checked_window(window, "moving_average"), alloc),
+     _sum(resync_factor * window) {
+    _node.attach(_input);
+  }
 
-  void reset() noexcept { _buffer.fill(value_t()); }
+  moving_average(self_t && other) = default;
 
-  value_t report() noexcept {
-    return std::accumulate(_buffer.begin(), _buffer.end(), value_t()) / N;
+  void reset() noexcept {
+    _buffer.fill(value_t());
+    _sum.clear();
+    _run = 0;
+    _evicted = value_t();
+    _updates += _buffer.max_size() + 1;
+    _node.invalidate();
   }
 
+  value_t report() noexcept { return detail::average(_sum.value(), window()); }
+
   value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("moving_average");
+    if (_node.current()) { return detail::average(_sum.value(), window()); }
+    _node.update();
+
     value_t val = _input();
-    if (val || _use_zeros) { _buffer << val; }
-    /* --------------------------------------------------------------------- *
-     * std::reduce is a C++17 feature; use when compiler is updated
-     *
-     * That is, libstdc++ has to implement execution_policy support, described
-     * in proposal P0024R2 (called "The Parallelism TS should be Standardized")
-     * first, the implement std::reduce.
-     *
-     * libstdc++ C++17 progress:
-     * https://gcc.gnu.org/onlinedocs/libstdc++/manual/status.html#status.iso.201z
-     *
-     * If this has happened, uncomment the return call to std::reduce below and
-     * get rid of the return call to std::accumulate below that. Afterwards,
-     * this comment can be removed.
-     * --------------------------------------------------------------------- */
-    //
-    // return std::reduce(std::execution::par, _buffer.begin(), _buffer.end());
-    //
-
-    return std::accumulate(_buffer.begin(), _buffer.end(), value_t()) / N;
+    if (val || _use_zeros) {
+      push(val);
+
+      // the window only stops changing once it is filled with the same value
+      if (_run < _buffer.max_size()) { _node.mark_dirty(); }
+    }
+
+    return detail::average(_sum.value(), window());
+  }
+
+  // equivalent to calling operator() once per input value, without the
+  // per-sample round trip through the input object
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      if (in[i] || _use_zeros) { push(in[i]); }
+      out[i] = detail::average(_sum.value(), window());
+    }
+
+    _node.invalidate();
+    return count;
   }
 
+  node & graph_node() noexcept { return _node; }
+
+  /*! \name Window access */ /*!@{*/
+  /*! For gates sharing the window, see `moving_variance`. */ /* --------- */
+  const buffer_t & samples() const noexcept { return _buffer; }
+
+  // value pushed out of the window by the last update, T() if none
+  value_t evicted() const noexcept { return _evicted; }
+
+  // grows by one per value pushed into the window, by more if the window
+  // changed otherwise (reset)
+  std::size_t updates() const noexcept { return _updates; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
 private:
-  input_t & _input;
-  bool      _use_zeros;
-  buffer_t  _buffer;
+  // the running sum is recomputed from the window content after this many
+  // window lengths worth of updates, see detail::running_sum
+  static constexpr std::size_t resync_factor = 32;
+
+  std::size_t window() const noexcept {
+    return N == dynamic_extent ? _buffer.max_size() : N;
+  }
+
+  void push(value_t value) noexcept {
+    _run = (!_buffer.empty() && value == _buffer.back()) ? _run + 1 : 1;
+
+    _evicted = value_t();
+    if (_buffer.size() == _buffer.max_size()) {
+      _evicted = _buffer.front();
+      _sum.remove(_evicted);
+    }
+    _buffer << value;
+    _sum.add(value);
+    ++_updates;
+
+    if (_sum.stale()) { _sum.assign(_buffer.segments()); }
+  }
+
+private:
+  input_t &   _input;
+  bool        _use_zeros;
+  buffer_t    _buffer;
+  sum_t       _sum;
+  std::size_t _run{0};
+  value_t     _evicted{};
+  std::size_t _updates{0};
+  node        _node;
 };
 
 
 template <std::size_t N, class I>
 inline moving_average<I, N> make_moving_average(
-  I & input, bool use_zeros = false) noexcept {
+  I & input, bool use_zeros = false) {
   return {input, use_zeros};
 }
 
+template <class I, class A = std::allocator<typename I::value_t>>
+inline moving_average<I, dynamic_extent, A> make_moving_average(
+  I &         input,
+  std::size_t window,
+  bool        use_zeros = false,
+  const A &   alloc     = A()) {
+  return {input, window, use_zeros, alloc};
+}
+
 }  // namespace pipebb
 
 #endif  // PIPEBB_MOVING_AVERAGE_H_
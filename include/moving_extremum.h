@@ -0,0 +1,260 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_MOVING_EXTREMUM_H_
+#define PIPEBB_MOVING_EXTREMUM_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "monotonic_wedge.h"
+#include "node.h"
+#include "span.h"
+#include "utils.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Minimum or maximum of the last `N` input values.
+ * \param I Template parameter specifying the input type.
+ * \param N Template parameter specifying the window size, or
+ *        `dynamic_extent` to choose it at runtime.
+ * \param C Template parameter specifying the ordering; use the `moving_min`
+ *        and `moving_max` aliases.
+ * \param A Template parameter specifying the allocator for dynamic windows.
+ *
+ * Updates in amortized constant time, independent of `N`, see
+ * `detail::monotonic_wedge`. Until the window is filled, the extremum of the
+ * values seen so far is returned.
+ */
+template <class I,
+          std::size_t N,
+          class C,
+          class A = std::allocator<typename I::value_t>>
+class moving_extremum
+{
+  using input_t = I;
+  using wedge_t = detail::monotonic_wedge<typename I::value_t, N, C, A>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  explicit moving_extremum(input_t & input) : _input(input) {
+    _node.attach(_input);
+  }
+
+  // window size chosen at runtime, storage drawn from alloc
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  moving_extremum(input_t & input, std::size_t window, const A & alloc = A())
+   : _input(input),
+     _wedge(detail::checked_window(window, "moving_extremum"), alloc) {
+    _node.attach(_input);
+  }
+
+  moving_extremum(moving_extremum && other) = default;
+
+  void reset() noexcept {
+    _wedge.clear();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("moving_extremum");
+    if (_node.current()) { return _wedge.value(); }
+    _node.update();
+
+    _wedge.push(_input());
+
+    // older values may still be evicted while the input stays unchanged
+    if (!_wedge.settled()) { _node.mark_dirty(); }
+
+    return _wedge.value();
+  }
+
+  // equivalent to calling operator() once per input value, without the
+  // per-sample round trip through the input object
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      _wedge.push(in[i]);
+      out[i] = _wedge.value();
+    }
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t & _input;
+  wedge_t   _wedge;
+  node      _node;
+};
+
+
+/*!
+ * \brief Minimum of the last `N` input values, see `moving_extremum`.
+ */
+template <class I,
+          std::size_t N,
+          class A = std::allocator<typename I::value_t>>
+using moving_min =
+  moving_extremum<I, N, std::less<typename I::value_t>, A>;
+
+/*!
+ * \brief Maximum of the last `N` input values, see `moving_extremum`.
+ */
+template <class I,
+          std::size_t N,
+          class A = std::allocator<typename I::value_t>>
+using moving_max =
+  moving_extremum<I, N, std::greater<typename I::value_t>, A>;
+
+
+/*!
+ * \brief Peak-to-peak value (maximum minus minimum) of the last `N` input
+ *        values.
+ * \param I Template parameter specifying the input type.
+ * \param N Template parameter specifying the window size, or
+ *        `dynamic_extent` to choose it at runtime.
+ * \param A Template parameter specifying the allocator for dynamic windows.
+ *
+ * Keeps a minimum and a maximum wedge over the same window, so it updates in
+ * amortized constant time as well.
+ */
+template <class I,
+          std::size_t N,
+          class A = std::allocator<typename I::value_t>>
+class moving_range
+{
+  using input_t = I;
+  using min_t   = detail::
+    monotonic_wedge<typename I::value_t, N, std::less<typename I::value_t>, A>;
+  using max_t = detail::monotonic_wedge<typename I::value_t,
+                                        N,
+                                        std::greater<typename I::value_t>,
+                                        A>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  explicit moving_range(input_t & input) : _input(input) {
+    _node.attach(_input);
+  }
+
+  // window size chosen at runtime, storage drawn from alloc
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  moving_range(input_t & input, std::size_t window, const A & alloc = A())
+   : _input(input),
+     _min(detail::checked_window(window, "moving_range"), alloc),
+     _max(window, alloc) {
+    _node.attach(_input);
+  }
+
+  moving_range(moving_range && other) = default;
+
+  void reset() noexcept {
+    _min.clear();
+    _max.clear();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("moving_range");
+    if (_node.current()) { return _max.value() - _min.value(); }
+    _node.update();
+
+    value_t val = _input();
+    _min.push(val);
+    _max.push(val);
+
+    if (!_min.settled() || !_max.settled()) { _node.mark_dirty(); }
+
+    return _max.value() - _min.value();
+  }
+
+  // equivalent to calling operator() once per input value, without the
+  // per-sample round trip through the input object
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      _min.push(in[i]);
+      _max.push(in[i]);
+      out[i] = _max.value() - _min.value();
+    }
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t & _input;
+  min_t     _min;
+  max_t     _max;
+  node      _node;
+};
+
+
+template <std::size_t N, class I>
+inline moving_min<I, N> make_moving_min(I & input) {
+  return moving_min<I, N>{input};
+}
+
+template <class I, class A = std::allocator<typename I::value_t>>
+inline moving_min<I, dynamic_extent, A> make_moving_min(
+  I & input, std::size_t window, const A & alloc = A()) {
+  return {input, window, alloc};
+}
+
+template <std::size_t N, class I>
+inline moving_max<I, N> make_moving_max(I & input) {
+  return moving_max<I, N>{input};
+}
+
+template <class I, class A = std::allocator<typename I::value_t>>
+inline moving_max<I, dynamic_extent, A> make_moving_max(
+  I & input, std::size_t window, const A & alloc = A()) {
+  return {input, window, alloc};
+}
+
+template <std::size_t N, class I>
+inline moving_range<I, N> make_moving_range(I & input) {
+  return moving_range<I, N>{input};
+}
+
+template <class I, class A = std::allocator<typename I::value_t>>
+inline moving_range<I, dynamic_extent, A> make_moving_range(
+  I & input, std::size_t window, const A & alloc = A()) {
+  return {input, window, alloc};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_MOVING_EXTREMUM_H_
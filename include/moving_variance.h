@@ -0,0 +1,277 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_MOVING_VARIANCE_H_
+#define PIPEBB_MOVING_VARIANCE_H_
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "moving_average.h"
+#include "node.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Variance of the window of a `moving_average`.
+ * \param M Template parameter specifying the `moving_average` type.
+ *
+ * Reads the window of the `moving_average` it is attached to instead of
+ * keeping a second copy of it, so a rolling mean and standard deviation of
+ * the same input share one `ringbuffer`. Mean and sum of squared deviations
+ * are updated in O(1) per value entering the window with Welford's method,
+ * extended to evict the value dropping out of it. This avoids the
+ * cancellation of the sum/sum-of-squares formula for signals with a large
+ * mean. To bound the error accumulated over long runs, both are recomputed
+ * from the window in two passes after `resync_factor` window lengths worth of
+ * updates, or whenever the window changed by more than one value since the
+ * last evaluation (e.g. after `process()` or `reset()` of the average).
+ *
+ * The result is the population variance of the values currently in the
+ * window; unlike `moving_average`, which always divides by the window size,
+ * a partially filled window only counts the values in it. Values skipped by
+ * an average not using zeros are not in the window and thus not counted.
+ */
+template <class M>
+class moving_variance
+{
+  using self_t  = moving_variance<M>;
+  using input_t = M;
+
+public:
+  using value_t = typename input_t::value_t;
+
+  static_assert(std::is_floating_point<value_t>::value,
+                "moving_variance requires a floating point value type");
+
+public:
+  explicit moving_variance(input_t & mean) : _input(mean) {
+    _node.attach(_input);
+    resync();
+  }
+
+  moving_variance(self_t && other) = default;
+
+  void reset() noexcept {
+    resync();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("moving_variance");
+    if (_node.current()) { return variance(); }
+    _node.update();
+
+    _input();
+    update();
+
+    return variance();
+  }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  // mean of the values in the window, as of the last evaluation
+  value_t mean() const noexcept { return _mean; }
+
+  // newest value in the window, as of the last evaluation
+  value_t last() const noexcept {
+    return _count ? _input.samples().back() : value_t();
+  }
+
+  std::size_t count() const noexcept { return _count; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  static constexpr std::size_t resync_factor = 32;
+
+  value_t variance() const noexcept {
+    return _count ? std::fmax(_m2, value_t()) / _count : value_t();
+  }
+
+  void update() noexcept {
+    std::size_t updates = _input.updates();
+    if (updates == _updates) { return; }
+
+    auto & samples = _input.samples();
+
+    if (updates != _updates + 1 ||
+        ++_since_resync >= resync_factor * samples.max_size())
+    {
+      resync();
+      return;
+    }
+
+    value_t value = samples.back();
+
+    if (_count < samples.size()) {
+      // window growing: plain Welford update
+      ++_count;
+      value_t delta = value - _mean;
+      _mean += delta / _count;
+      _m2 += delta * (value - _mean);
+    } else {
+      // window sliding: replace the evicted value
+      value_t evicted = _input.evicted();
+      value_t mean    = _mean + (value - evicted) / _count;
+      _m2 += (value - evicted) * (value - mean + evicted - _mean);
+      _mean = mean;
+    }
+
+    _updates = updates;
+  }
+
+  void resync() noexcept {
+    auto & samples = _input.samples();
+    auto   segs    = samples.segments();
+
+    _count = samples.size();
+    _mean  = value_t();
+    _m2    = value_t();
+
+    if (_count) {
+      value_t sum = value_t();
+      for (auto & seg : segs) {
+        for (auto value : seg) { sum += value; }
+      }
+      _mean = sum / _count;
+
+      for (auto & seg : segs) {
+        for (auto value : seg) { _m2 += (value - _mean) * (value - _mean); }
+      }
+    }
+
+    _updates      = _input.updates();
+    _since_resync = 0;
+  }
+
+private:
+  input_t &   _input;
+  value_t     _mean{};
+  value_t     _m2{};
+  std::size_t _count{0};
+  std::size_t _updates{0};
+  std::size_t _since_resync{0};
+  node        _node;
+};
+
+
+/*!
+ * \brief Standard deviation of the window of a `moving_average`, computed
+ *        from a `moving_variance`.
+ * \param V Template parameter specifying the `moving_variance` type.
+ */
+template <class V>
+class moving_stddev
+{
+  using self_t  = moving_stddev<V>;
+  using input_t = V;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  explicit moving_stddev(input_t & variance) : _input(variance) {
+    _node.attach(_input);
+  }
+
+  moving_stddev(self_t && other) = default;
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("moving_stddev");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    _value = std::sqrt(_input());
+    return _value;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t & _input;
+  value_t   _value{};
+  node      _node;
+};
+
+
+/*!
+ * \brief Distance of the newest value in the window of a `moving_average`
+ *        from the window's mean, in standard deviations.
+ * \param V Template parameter specifying the `moving_variance` type.
+ *
+ * Yields 0 as long as the window has no spread.
+ */
+template <class V>
+class zscore
+{
+  using self_t  = zscore<V>;
+  using input_t = V;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  explicit zscore(input_t & variance) : _input(variance) {
+    _node.attach(_input);
+  }
+
+  zscore(self_t && other) = default;
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("zscore");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    value_t variance = _input();
+    _value           = variance > value_t()
+               ? (_input.last() - _input.mean()) / std::sqrt(variance)
+               : value_t();
+    return _value;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  input_t & _input;
+  value_t   _value{};
+  node      _node;
+};
+
+
+template <class M>
+inline moving_variance<M> make_moving_variance(M & mean) {
+  return moving_variance<M>{mean};
+}
+
+template <class V>
+inline moving_stddev<V> make_moving_stddev(V & variance) {
+  return moving_stddev<V>{variance};
+}
+
+template <class V>
+inline zscore<V> make_zscore(V & variance) {
+  return zscore<V>{variance};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_MOVING_VARIANCE_H_
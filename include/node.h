@@ -0,0 +1,400 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_NODE_H_
+#define PIPEBB_NODE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef PIPEBB_PROFILE
+#include "profile.h"
+#endif
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Type of the evaluation epoch (tick) counter.
+ */
+using epoch_t = std::uint64_t;
+
+
+namespace detail {
+
+
+inline epoch_t & epoch() noexcept {
+  static thread_local epoch_t epoch{0};
+  return epoch;
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief   Get the current evaluation epoch of the calling thread.
+ * \returns Current epoch; 0 if epochs are not in use.
+ */
+inline epoch_t current_epoch() noexcept {
+  return detail::epoch();
+}
+
+
+/*!
+ * \brief   Start a new evaluation epoch (tick) on the calling thread.
+ * \returns The new epoch.
+ *
+ * As long as no epoch has been started, every call to a gate evaluates it
+ * anew, as it always has. Once `tick()` has been called, every gate evaluates
+ * at most once per epoch and returns its cached value on further calls during
+ * the same epoch. That makes fan-out free and deterministic: a stateful gate
+ * like `gradient` feeding two downstream gates advances its state only once
+ * per tick, no matter how often it is pulled. Call `tick()` once at the start
+ * of each time step, after feeding the channels.
+ *
+ * The epoch is kept per thread, so independent pipelines can run on separate
+ * threads.
+ */
+inline epoch_t tick() noexcept {
+  return ++detail::epoch();
+}
+
+
+/*!
+ * \brief Leave epoch mode on the calling thread, so that every call to a
+ *        gate evaluates it anew again.
+ */
+inline void reset_epoch() noexcept {
+  detail::epoch() = 0;
+}
+
+
+namespace detail {
+
+
+template <class G>
+auto has_graph_node_impl(int)
+  -> decltype(std::declval<G &>().graph_node(), std::true_type{});
+
+template <class G>
+std::false_type has_graph_node_impl(...);
+
+template <class G>
+using has_graph_node = decltype(has_graph_node_impl<G>(0));
+
+}  // namespace detail
+
+
+/*!
+ * \brief Evaluation bookkeeping embedded in every pipeBB gate.
+ *
+ * A gate asks its `node` whether its cached value is still valid
+ * (`current()`) and, if so, returns it instead of pulling its inputs again.
+ * Otherwise it marks itself evaluated (`update()`) and computes as usual.
+ *
+ * The cached value is valid if the gate has already been evaluated during the
+ * current epoch (see `tick()`), or if nothing it depends on has changed since
+ * its last evaluation. For the latter, nodes are linked into a graph: each
+ * gate `attach()`es its inputs in its constructor, and a `channel` receiving a
+ * new value marks itself and everything downstream of it dirty. A gate whose
+ * inputs are all clean thus returns its cached value without touching their
+ * subtrees.
+ *
+ * Stateful gates whose next evaluation would yield a different value even if
+ * their inputs stay unchanged (e.g. a `gradient` falling back to zero) call
+ * `mark_dirty()` after evaluating, until they have settled. Inputs which do
+ * not carry a `node` of their own cannot report changes; a gate attached to
+ * one is `volatile` and evaluated on every call, as are all gates downstream
+ * of it.
+ *
+ * With `PIPEBB_PROFILE` defined, the node also owns the gate's
+ * `profile::record`, and hands its statistics over to the profile when it
+ * is destroyed.
+ */
+class node
+{
+public:
+  node() = default;
+
+  /*!
+   * \brief Copy constructor for `node` class.
+   * \param other Node to copy.
+   *
+   * The copy reads from the same inputs as `other`, but has no dependents.
+   */
+  node(const node & other)
+   : _inputs(other._inputs), _volatile(other._volatile) {
+    for (auto input : _inputs) { input->_dependents.push_back(this); }
+  }
+
+  /*!
+   * \brief Move constructor for `node` class.
+   * \param other Node to take the place of in the graph.
+   */
+  node(node && other) noexcept
+   : _inputs(std::move(other._inputs)),
+     _dependents(std::move(other._dependents)),
+     _epoch(other._epoch),
+     _dirty(other._dirty),
+     _volatile(other._volatile) {
+#ifdef PIPEBB_PROFILE
+    _record       = other._record;
+    other._record = nullptr;
+#endif
+    other._inputs.clear();
+    other._dependents.clear();
+
+    for (auto input : _inputs) { replace(input->_dependents, &other, this); }
+    for (auto dependent : _dependents) {
+      replace(dependent->_inputs, &other, this);
+    }
+  }
+
+  /*!
+   * \brief Copy assignment operator for `node` class.
+   * \param other Node to copy the inputs of.
+   *
+   * Keeps the dependents of this node, but reads from the inputs of `other`.
+   */
+  node & operator=(const node & other) {
+    if (this != &other) {
+      detach_inputs();
+      for (auto input : other._inputs) { link(*input); }
+      if (other._volatile) { set_volatile(); }
+      invalidate();
+    }
+    return *this;
+  }
+
+  /*!
+   * \brief Move assignment operator for `node` class.
+   * \param other Node to copy the inputs of.
+   */
+  node & operator=(node && other) {
+    return operator=(static_cast<const node &>(other));
+  }
+
+  /*!
+   * \brief Destructor for `node` class, removes the node from the graph.
+   */
+  ~node() {
+#ifdef PIPEBB_PROFILE
+    if (_record) { profile::detail::records().retire(_record); }
+#endif
+    detach_inputs();
+    for (auto dependent : _dependents) { erase(dependent->_inputs, this); }
+  }
+
+  /*!
+   * \brief Register an input of the owning gate.
+   * \param input Input object; if it provides no `graph_node()`, the owning
+   *        gate becomes volatile.
+   */
+  template <class G>
+  void attach(G & input) {
+    attach(input, detail::has_graph_node<G>{});
+  }
+
+  /*!
+   * \brief Remove an input previously registered with `attach()`.
+   * \param input Input object.
+   */
+  template <class G>
+  void detach(G & input) {
+    detach(input, detail::has_graph_node<G>{});
+  }
+
+  /*!
+   * \brief   Check if the owning gate's cached value is valid.
+   * \returns `true` if the gate was evaluated in this epoch or nothing it
+   *          depends on has changed since, `false` if not.
+   */
+  bool current() const noexcept {
+    epoch_t epoch = current_epoch();
+    bool    valid = !_dirty || (epoch != 0 && epoch == _epoch);
+#ifdef PIPEBB_PROFILE
+    if (valid && _record) { _record->hit(); }
+#endif
+    return valid;
+  }
+
+  /*!
+   * \brief Mark the owning gate as evaluated. Call before pulling inputs.
+   */
+  void update() noexcept {
+    epoch_t epoch = current_epoch();
+
+    _epoch = epoch;
+    _dirty = _volatile;
+
+    // an input evaluated earlier in this epoch which has to be evaluated
+    // again in the next one won't notify us anymore, so we stay dirty
+    if (epoch != 0) {
+      for (auto input : _inputs) {
+        if (input->_dirty && input->_epoch == epoch) { _dirty = true; }
+      }
+    }
+  }
+
+  /*!
+   * \brief Mark the owning gate and everything downstream of it dirty.
+   *
+   * A value cached in the current epoch stays valid until the next epoch.
+   */
+  void mark_dirty() noexcept {
+    if (_dirty) { return; }
+
+    _dirty = true;
+    for (auto dependent : _dependents) { dependent->mark_dirty(); }
+  }
+
+  /*!
+   * \brief Discard the cached value, e.g. when the owning gate is reset or
+   *        its input changes, and mark everything downstream dirty.
+   */
+  void invalidate() noexcept {
+    _epoch = 0;
+    mark_dirty();
+  }
+
+  /*!
+   * \brief Make the owning gate and everything downstream of it evaluate on
+   *        every call, e.g. because it reads from an external source.
+   */
+  void set_volatile() noexcept {
+    if (_volatile) { return; }
+
+    _volatile = true;
+    _dirty    = true;
+    for (auto dependent : _dependents) { dependent->set_volatile(); }
+  }
+
+  /*!
+   * \brief Name the owning gate in profiles (see `profile::snapshot()`).
+   * \param name Name; ignored unless `PIPEBB_PROFILE` is defined.
+   */
+  void set_name(const std::string & name) {
+#ifdef PIPEBB_PROFILE
+    record(nullptr).name(name);
+#else
+    static_cast<void>(name);
+#endif
+  }
+
+#ifdef PIPEBB_PROFILE
+  /*!
+   * \brief   Get the profiling record of the owning gate, created on demand.
+   * \param   kind Type of the owning gate, e.g. `"gradient"`.
+   * \returns Record.
+   */
+  profile::record & record(const char * kind) {
+    if (!_record) { _record = &profile::detail::records().create(kind); }
+    if (!_record->kind()) { _record->kind(kind); }
+    return *_record;
+  }
+#endif
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  bool dirty() const noexcept { return _dirty; }
+  bool is_volatile() const noexcept { return _volatile; }
+  const std::vector<node *> & inputs() const noexcept { return _inputs; }
+  const std::vector<node *> & dependents() const noexcept {
+    return _dependents;
+  }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+private:
+  template <class G>
+  void attach(G & input, std::true_type) {
+    link(input.graph_node());
+  }
+
+  template <class G>
+  void attach(G &, std::false_type) {
+    set_volatile();
+  }
+
+  template <class G>
+  void detach(G & input, std::true_type) {
+    // an input attached twice stays linked once
+    erase_one(_inputs, &input.graph_node());
+    erase_one(input.graph_node()._dependents, this);
+    invalidate();
+  }
+
+  template <class G>
+  void detach(G &, std::false_type) {}
+
+  void link(node & input) {
+    _inputs.push_back(&input);
+    input._dependents.push_back(this);
+
+    if (input._volatile) { set_volatile(); }
+    invalidate();
+  }
+
+  void detach_inputs() noexcept {
+    for (auto input : _inputs) { erase(input->_dependents, this); }
+    _inputs.clear();
+  }
+
+  static void
+  replace(std::vector<node *> & nodes, node * from, node * to) noexcept {
+    std::replace(nodes.begin(), nodes.end(), from, to);
+  }
+
+  static void erase(std::vector<node *> & nodes, node * n) noexcept {
+    nodes.erase(std::remove(nodes.begin(), nodes.end(), n), nodes.end());
+  }
+
+  static void erase_one(std::vector<node *> & nodes, node * n) noexcept {
+    auto it = std::find(nodes.begin(), nodes.end(), n);
+    if (it != nodes.end()) { nodes.erase(it); }
+  }
+
+private:
+  std::vector<node *> _inputs;
+  std::vector<node *> _dependents;
+  epoch_t             _epoch{0};
+  bool                _dirty{true};
+  bool                _volatile{false};
+#ifdef PIPEBB_PROFILE
+  profile::record * _record{nullptr};
+#endif
+};
+
+
+/*!
+ * \def   PIPEBB_PROFILE_GATE(kind)
+ * \brief Measure the enclosing `operator()` of a gate of type `kind`;
+ *        expands to nothing unless `PIPEBB_PROFILE` is defined.
+ */
+#ifdef PIPEBB_PROFILE
+#define PIPEBB_PROFILE_GATE(kind) \
+  ::pipebb::profile::probe pipebb_probe_ { _node.record(kind) }
+#else
+#define PIPEBB_PROFILE_GATE(kind) static_cast<void>(0)
+#endif
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_NODE_H_
@@ -17,6 +17,13 @@
 #ifndef PIPEBB_OFFSET_H_
 #define PIPEBB_OFFSET_H_
 
+#include <algorithm>
+#include <cstddef>
+
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+
 
 namespace pipebb {
 
@@ -31,25 +38,48 @@ public:
   using value_t = typename input_t::value_t;
 
 public:
-  offset(input_t & input, value_t offset) noexcept
-   : _input(input), _offset(offset) {}
+  offset(input_t & input, value_t offset) : _input(input), _offset(offset) {
+    _node.attach(_input);
+  }
 
   offset(self_t && other) = default;
 
   value_t get_offset() noexcept { return _offset; }
 
-  void set_offset(value_t offset) noexcept { _offset = offset; }
+  void set_offset(value_t offset) noexcept {
+    _offset = offset;
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("offset");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value = _input() + _offset;
+  }
+
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    simd::shift(in.data(), _offset, out.data(), count);
+
+    _node.invalidate();
+    return count;
+  }
 
-  value_t operator()() noexcept { return _input() + _offset; }
+  node & graph_node() noexcept { return _node; }
 
 private:
   input_t & _input;
   value_t   _offset;
+  node      _node;
+  value_t   _value{};
 };
 
 
 template <class I>
-inline offset<I> make_offset(I & input, typename I::value_t offset) noexcept {
+inline offset<I> make_offset(I & input, typename I::value_t offset) {
   return {input, offset};
 }
 
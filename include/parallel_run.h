@@ -0,0 +1,268 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_PARALLEL_RUN_H_
+#define PIPEBB_PARALLEL_RUN_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "arena.h"
+#include "utils.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Options for `parallel_run()`.
+ */
+struct run_options
+{
+  /*!
+   * \brief Number of worker threads. Default: number of hardware threads.
+   */
+  std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  /*!
+   * \brief Size in bytes of each worker's `arena`, for graphs constructed
+   *        from one. Default: 0, i.e. no arena.
+   */
+  std::size_t arena_size = 0;
+
+  /*!
+   * \brief Number of consecutive streams a worker claims at once.
+   */
+  std::size_t chunk = 1;
+
+  /*!
+   * \brief Pin worker `i` to the `i`-th CPU the process may run on (modulo
+   *        their number, see `sched_getaffinity`); only has an effect on
+   *        Linux. Default: false, concurrent runs would share the same CPUs.
+   */
+  bool pin_threads = false;
+};
+
+
+namespace detail {
+
+
+/*!
+ * \brief Heap block whose usable part starts and ends on a cache line
+ *        boundary.
+ *
+ * Prior to C++17, `new` does not honour alignments beyond the fundamental
+ * one, so the block is over-allocated and the start is rounded up. The size
+ * is rounded up to whole cache lines, so the end of the block shares no line
+ * with the next allocation either. The block is zeroed by the allocating
+ * thread: on NUMA systems, the first write to a page decides which node it
+ * is placed on.
+ */
+class cache_aligned_block
+{
+public:
+  explicit cache_aligned_block(std::size_t size)
+   : _size((size + cache_line_size - 1) / cache_line_size * cache_line_size),
+     _raw(new unsigned char[_size + cache_line_size]) {
+    void *      start = _raw.get();
+    std::size_t space = _size + cache_line_size;
+
+    _data = static_cast<unsigned char *>(
+      std::align(cache_line_size, _size, start, space));
+    std::memset(_data, 0, _size);
+  }
+
+  void *      data() noexcept { return _data; }
+  std::size_t size() const noexcept { return _size; }
+
+private:
+  std::size_t                      _size;
+  std::unique_ptr<unsigned char[]> _raw;
+  unsigned char *                  _data;
+};
+
+
+// the CPUs the calling thread may run on, as restricted by taskset, cgroups
+// and the like; empty if unknown
+inline std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+    }
+  }
+#endif
+  return cpus;
+}
+
+
+inline void pin_to_cpu(int cpu) noexcept {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+
+template <class G>
+inline G * construct_graph(void * storage, arena & source, std::true_type) {
+  return new (storage) G(source);
+}
+
+template <class G>
+inline G * construct_graph(void * storage, arena &, std::false_type) {
+  return new (storage) G();
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief   Run many independent streams through the same graph on all cores.
+ * \param   G Template parameter specifying the graph type: a class holding
+ *          channels and gates, constructible either from an `arena &` or by
+ *          default.
+ * \param   streams Number of streams.
+ * \param   body Callable `R body(G & graph, std::size_t stream)` feeding one
+ *          stream through a fresh graph and returning its result.
+ * \param   options See `run_options`.
+ * \returns The results of all streams, indexed by stream; the result type
+ *          must be default constructible.
+ * \throws  The first exception thrown by `body` or by the construction of a
+ *          graph, after all workers have stopped.
+ *
+ * Every worker thread owns a block of whole cache lines for one `G`, and, if
+ * `options.arena_size` is set, an `arena` for the graph's windows (pass it on
+ * to the gates' allocators). Both are allocated and first touched by the
+ * worker itself, so they are local to its NUMA node, and neither shares a
+ * cache line with another worker's blocks. Memory the gates allocate on their
+ * own, such as the links between their nodes or windows not drawn from the
+ * arena, comes from the general heap and has no such guarantee. Workers claim
+ * `options.chunk` streams at a time until all are done; for each stream, a new
+ * `G` is built in the worker's block, handed to `body` and destroyed again, so
+ * no state carries over from one stream to the next. Results are collected per
+ * worker and merged once all workers have finished.
+ *
+ * Since evaluation epochs are per thread (see `tick()`), `body` may use
+ * `tick()` freely. A stream may also be a block of lanes of a lane graph
+ * (see `lane_channel`).
+ *
+ * \include parallel_run.cc
+ */
+template <class G, class F>
+auto parallel_run(std::size_t         streams,
+                  F &&                body,
+                  const run_options & options = run_options())
+  -> std::vector<decltype(body(std::declval<G &>(), std::size_t()))> {
+  using result_t   = decltype(body(std::declval<G &>(), std::size_t()));
+  using shard_t    = std::vector<std::pair<std::size_t, result_t>>;
+  using uses_arena = std::is_constructible<G, arena &>;
+
+  std::size_t threads = std::max<std::size_t>(options.threads, 1);
+  std::size_t chunk   = std::max<std::size_t>(options.chunk, 1);
+
+  std::vector<shard_t>     shards(threads);
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool>        failed{false};
+  std::exception_ptr       error;
+  std::mutex               error_mutex;
+
+  std::vector<int> cpus;
+  if (options.pin_threads) { cpus = detail::allowed_cpus(); }
+
+  auto work = [&](std::size_t w) {
+    try {
+      if (!cpus.empty()) { detail::pin_to_cpu(cpus[w % cpus.size()]); }
+
+      detail::cache_aligned_block graph_block(sizeof(G));
+      detail::cache_aligned_block arena_block(options.arena_size);
+
+      arena source(arena_block.data(), options.arena_size);
+
+      shard_t shard;
+
+      for (;;) {
+        std::size_t first = next.fetch_add(chunk);
+        if (first >= streams || failed.load()) { break; }
+
+        std::size_t last = std::min(first + chunk, streams);
+        for (std::size_t s = first; s < last; ++s) {
+          G * graph = detail::construct_graph<G>(
+            graph_block.data(), source, uses_arena{});
+
+          try {
+            shard.emplace_back(s, body(*graph, s));
+          } catch (...) {
+            graph->~G();
+            throw;
+          }
+
+          graph->~G();
+          source.release();
+        }
+      }
+
+      shards[w] = std::move(shard);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) { error = std::current_exception(); }
+      failed.store(true);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (std::size_t w = 0; w < threads; ++w) { workers.emplace_back(work, w); }
+  for (auto & worker : workers) { worker.join(); }
+
+  if (error) { std::rethrow_exception(error); }
+
+  std::vector<result_t> results(streams);
+  for (auto & shard : shards) {
+    for (auto & entry : shard) {
+      results[entry.first] = std::move(entry.second);
+    }
+  }
+
+  return results;
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_PARALLEL_RUN_H_
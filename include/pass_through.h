@@ -17,6 +17,13 @@
 #ifndef PIPEBB_PASS_THROUGH_H_
 #define PIPEBB_PASS_THROUGH_H_
 
+#include <algorithm>
+#include <cstddef>
+
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+
 
 namespace pipebb {
 
@@ -32,26 +39,36 @@ public:
   using value_t = typename input_t::value_t;
 
 public:
-  pass_through(input_t & input, activator_t & activator) noexcept
-   : _input(input), _activator(activator) {}
+  pass_through(input_t & input, activator_t & activator)
+   : _input(input), _activator(activator) {
+    _node.attach(_input);
+    _node.attach(_activator);
+  }
 
   pass_through(self_t && other) = default;
 
   value_t operator()() noexcept {
-    if (_activator()) { return _input(); }
+    PIPEBB_PROFILE_GATE("pass_through");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    if (_activator()) { return _value = _input(); }
 
-    return {};
+    return _value = {};
   }
 
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t &     _input;
   activator_t & _activator;
+  node          _node;
+  value_t       _value{};
 };
 
 
 template <class I, class A>
-inline pass_through<I, A> make_pass_through(I & input,
-                                            A & activator) noexcept {
+inline pass_through<I, A> make_pass_through(I & input, A & activator) {
   return {input, activator};
 }
 
@@ -66,29 +83,49 @@ public:
   using value_t = typename input_t::value_t;
 
 public:
-  threshold_pass_through(input_t & input, value_t limit) noexcept
-   : _input(input), _limit(limit) {}
+  threshold_pass_through(input_t & input, value_t limit)
+   : _input(input), _limit(limit) {
+    _node.attach(_input);
+  }
 
   threshold_pass_through(self_t && other) = default;
 
   value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("threshold_pass_through");
+    if (_node.current()) { return _value; }
+    _node.update();
+
     auto val = _input();
     if (val > _limit) {
-      return val;
+      return _value = val;
     } else {
-      return {};
+      return _value = {};
     }
   }
 
+  // block version of operator(), see simd::pass_greater()
+  std::size_t process(span<const value_t> in, span<value_t> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    simd::pass_greater(in.data(), _limit, out.data(), count);
+
+    _node.invalidate();
+    return count;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t & _input;
   value_t   _limit;
+  node      _node;
+  value_t   _value{};
 };
 
 
 template <class I>
 inline threshold_pass_through<I> make_threshold_pass_through(
-  I & input, typename I::value_t limit) noexcept {
+  I & input, typename I::value_t limit) {
   return {input, limit};
 }
 
@@ -104,27 +141,37 @@ public:
   using value_t = typename input_t::value_t;
 
 public:
-  buffered_pass_through(input_t & input, activator_t & activator) noexcept
-   : _input(input), _activator(activator) {}
+  buffered_pass_through(input_t & input, activator_t & activator)
+   : _input(input), _activator(activator) {
+    _node.attach(_input);
+    _node.attach(_activator);
+  }
 
   buffered_pass_through(self_t && other) = default;
 
   value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("buffered_pass_through");
+    if (_node.current()) { return _value; }
+    _node.update();
+
     if (_activator()) { _value = _input(); }
     return _value;
   }
 
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t &     _input;
   activator_t & _activator;
   bool          _init{false};
+  node          _node;
   value_t       _value{};
 };
 
 
 template <class I, class A>
 inline buffered_pass_through<I, A> make_buffered_pass_through(
-  I & input, A & activator) noexcept {
+  I & input, A & activator) {
   return {input, activator};
 }
 
@@ -0,0 +1,447 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_PROFILE_H_
+#define PIPEBB_PROFILE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+
+namespace pipebb {
+
+
+/*!
+ * \namespace pipebb::profile
+ * \brief Opt-in per-gate instrumentation.
+ *
+ * Compiling with `PIPEBB_PROFILE` defined makes every gate record, per
+ * object, how often it was called, how often its cached value was returned
+ * (see `node`), and the cycles spent in its `operator()`: in total including
+ * its inputs, in total excluding them ("self"), and at most in a single
+ * call. Without `PIPEBB_PROFILE`, the gates carry no instrumentation at all
+ * and `snapshot()` is empty. The macro changes the layout of `node`, so all
+ * translation units of a program must agree on it; pass it on the compiler
+ * command line rather than defining it in a source file.
+ *
+ * Gates are listed under their name; channels are named after themselves,
+ * other gates can be named with `graph_node().set_name()`. Unnamed gates are
+ * listed by kind and a running number. When a gate is destroyed, its
+ * statistics are added up with those of the destroyed gates of the same name
+ * (or kind, if unnamed) and listed as "<name> (destroyed)", so pipelines that
+ * are built over and over again do not grow the profile.
+ *
+ * \include profile.cc
+ */
+namespace profile {
+
+
+#ifdef PIPEBB_PROFILE
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+
+/*!
+ * \brief   Read the time stamp counter.
+ * \returns Cycles on x86, nanoseconds of a steady clock elsewhere.
+ */
+inline std::uint64_t cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+#endif
+}
+
+
+namespace detail {
+class registry;
+}  // namespace detail
+
+
+/*!
+ * \brief Statistics of a single gate object.
+ *
+ * Counters are updated with relaxed atomics, so a snapshot may be taken
+ * while other threads evaluate. Records are created and destroyed by the
+ * `node` of the gate.
+ */
+class record
+{
+  friend class detail::registry;
+
+public:
+  explicit record(const char * kind) : _kind(kind) {}
+
+  const char * kind() const noexcept { return _kind; }
+  void         kind(const char * kind) noexcept { _kind = kind; }
+
+  std::string name() const {
+    std::lock_guard<std::mutex> lock(_name_mutex);
+    return _name;
+  }
+  void name(const std::string & name) {
+    std::lock_guard<std::mutex> lock(_name_mutex);
+    _name = name;
+  }
+
+  void hit() noexcept { _hits.fetch_add(1, std::memory_order_relaxed); }
+
+  void call(std::uint64_t total, std::uint64_t self) noexcept {
+    _calls.fetch_add(1, std::memory_order_relaxed);
+    _total.fetch_add(total, std::memory_order_relaxed);
+    _self.fetch_add(self, std::memory_order_relaxed);
+
+    auto max = _max.load(std::memory_order_relaxed);
+    while (total > max &&
+           !_max.compare_exchange_weak(max, total, std::memory_order_relaxed))
+    {}
+  }
+
+  std::uint64_t calls() const noexcept { return _calls.load(); }
+  std::uint64_t hits() const noexcept { return _hits.load(); }
+  std::uint64_t total() const noexcept { return _total.load(); }
+  std::uint64_t self() const noexcept { return _self.load(); }
+  std::uint64_t max() const noexcept { return _max.load(); }
+
+  void clear() noexcept {
+    _calls.store(0);
+    _hits.store(0);
+    _total.store(0);
+    _self.store(0);
+    _max.store(0);
+  }
+
+private:
+  const char *               _kind;
+  std::string                _name;
+  mutable std::mutex         _name_mutex;
+  std::atomic<std::uint64_t> _calls{0};
+  std::atomic<std::uint64_t> _hits{0};
+  std::atomic<std::uint64_t> _total{0};
+  std::atomic<std::uint64_t> _self{0};
+  std::atomic<std::uint64_t> _max{0};
+  record *                   _prev{nullptr};
+  record *                   _next{nullptr};
+};
+
+
+/*!
+ * \brief Statistics of a single gate object at the time of a `snapshot()`.
+ */
+struct entry
+{
+  std::string   name;
+  std::string   kind;
+  std::uint64_t calls;
+  std::uint64_t hits;
+  std::uint64_t total_cycles;
+  std::uint64_t self_cycles;
+  std::uint64_t max_cycles;
+
+  double hit_rate() const noexcept {
+    return calls ? static_cast<double>(hits) / calls : 0.0;
+  }
+
+  double cycles_per_call() const noexcept {
+    return calls ? static_cast<double>(total_cycles) / calls : 0.0;
+  }
+};
+
+
+namespace detail {
+
+
+// the records of live gates, in order of creation, and the summed up
+// statistics of destroyed ones, one entry per name and kind
+class registry
+{
+  using key_t = std::pair<std::string, std::string>;
+
+public:
+  record & create(const char * kind) {
+    auto * r = new record(kind);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    r->_prev = _tail;
+    (_tail ? _tail->_next : _head) = r;
+    _tail = r;
+    return *r;
+  }
+
+  // removes and frees the record of a destroyed gate; its statistics are
+  // lost only if there is no memory left to keep them
+  void retire(record * r) noexcept {
+    std::lock_guard<std::mutex> lock(_mutex);
+    (r->_prev ? r->_prev->_next : _head) = r->_next;
+    (r->_next ? r->_next->_prev : _tail) = r->_prev;
+
+    try {
+      if (r->calls()) { fold(*r); }
+    } catch (...) {}
+    delete r;
+  }
+
+  template <class F>
+  void for_each(F && f) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (record * r = _head; r; r = r->_next) { f(*r); }
+  }
+
+  template <class F>
+  void for_each_retired(F && f) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto & retired : _retired) { f(retired.second); }
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (record * r = _head; r; r = r->_next) { r->clear(); }
+    _retired.clear();
+  }
+
+private:
+  void fold(const record & r) {
+    key_t key{r.name(), r.kind() ? r.kind() : "gate"};
+
+    auto found = _retired.find(key);
+    if (found == _retired.end()) {
+      std::string name = key.first.empty() ? key.second : key.first;
+      entry       e{name + " (destroyed)", key.second, 0, 0, 0, 0, 0};
+
+      found = _retired.emplace(key, std::move(e)).first;
+    }
+
+    auto & e = found->second;
+    e.calls += r.calls();
+    e.hits += r.hits();
+    e.total_cycles += r.total();
+    e.self_cycles += r.self();
+    e.max_cycles = std::max(e.max_cycles, r.max());
+  }
+
+private:
+  std::mutex             _mutex;
+  record *               _head{nullptr};
+  record *               _tail{nullptr};
+  std::map<key_t, entry> _retired;
+};
+
+// never destroyed, gates with static storage duration may outlive any
+// static registry
+inline registry & records() {
+  static registry * instance = new registry;
+  return *instance;
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Measures one call of a gate; created at the top of its
+ *        `operator()` by `PIPEBB_PROFILE_GATE`.
+ *
+ * Probes of nested calls form a stack per thread, so the cycles of a call
+ * can be split into those spent in the gate itself and those spent in its
+ * inputs.
+ */
+class probe
+{
+public:
+  explicit probe(record & r) noexcept
+   : _record(r), _parent(top()), _start(cycles()) {
+    top() = this;
+  }
+
+  probe(const probe &) = delete;
+  probe & operator=(const probe &) = delete;
+
+  ~probe() {
+    std::uint64_t elapsed = cycles() - _start;
+
+    top() = _parent;
+    if (_parent) { _parent->_children += elapsed; }
+
+    _record.call(elapsed, elapsed - std::min(elapsed, _children));
+  }
+
+private:
+  static probe *& top() noexcept {
+    static thread_local probe * current = nullptr;
+    return current;
+  }
+
+private:
+  record &      _record;
+  probe *       _parent;
+  std::uint64_t _start;
+  std::uint64_t _children{0};
+};
+
+
+/*!
+ * \brief   Take a snapshot of the statistics of all instrumented gates.
+ * \returns One entry per live gate object called since the last `reset()`,
+ *          under unique names, followed by one entry per name (or kind) of
+ *          destroyed gates.
+ */
+inline std::vector<entry> snapshot() {
+  std::vector<entry>                           entries;
+  std::unordered_map<std::string, std::size_t> seen;
+
+  detail::records().for_each([&](const record & r) {
+    if (r.calls() == 0) { return; }
+
+    std::string name = r.name();
+    std::string kind = r.kind() ? r.kind() : "gate";
+    if (name.empty()) { name = kind; }
+
+    // make names unique: "slope", "slope#2", ...
+    std::size_t count = ++seen[name];
+    if (count > 1 || r.name().empty()) {
+      name += "#" + std::to_string(count);
+    }
+
+    entries.push_back(
+      {name, kind, r.calls(), r.hits(), r.total(), r.self(), r.max()});
+  });
+
+  detail::records().for_each_retired(
+    [&](const entry & e) { entries.push_back(e); });
+
+  return entries;
+}
+
+
+/*!
+ * \brief Clear the statistics of all instrumented gates.
+ */
+inline void reset() {
+  detail::records().clear();
+}
+
+
+/*!
+ * \brief Print a snapshot as a table, most expensive gates (self) first.
+ *
+ * The formatting flags of `os` are left untouched.
+ */
+inline void print_table(std::ostream & os, std::vector<entry> entries) {
+  std::stable_sort(
+    entries.begin(), entries.end(), [](const entry & a, const entry & b) {
+      return a.self_cycles > b.self_cycles;
+    });
+
+  std::size_t width = 4;
+  for (auto & e : entries) { width = std::max(width, e.name.size()); }
+
+  // formatted separately, so that the caller's stream keeps its flags
+  std::ostringstream table;
+
+  table << std::left << std::setw(static_cast<int>(width)) << "gate"
+        << std::right << std::setw(12) << "calls" << std::setw(10)
+        << "hit_rate" << std::setw(16) << "total_cycles" << std::setw(16)
+        << "self_cycles" << std::setw(12) << "max_cycles" << '\n';
+
+  for (auto & e : entries) {
+    table << std::left << std::setw(static_cast<int>(width)) << e.name
+          << std::right << std::setw(12) << e.calls << std::setw(10)
+          << std::fixed << std::setprecision(3) << e.hit_rate()
+          << std::setw(16) << e.total_cycles << std::setw(16)
+          << e.self_cycles << std::setw(12) << e.max_cycles << '\n';
+  }
+
+  os << table.str();
+}
+
+
+namespace detail {
+
+// escapes a string for use inside a JSON string literal
+inline std::string json_escape(const std::string & text) {
+  static const char hex[] = "0123456789abcdef";
+
+  std::string escaped;
+  for (char c : text) {
+    auto byte = static_cast<unsigned char>(c);
+    switch (c) {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      case '\r': escaped += "\\r"; break;
+      case '\t': escaped += "\\t"; break;
+      default:
+        if (byte < 0x20) {
+          escaped += "\\u00";
+          escaped += hex[byte >> 4];
+          escaped += hex[byte & 0xf];
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Print a snapshot as a JSON object keyed by gate name.
+ */
+inline void print_json(std::ostream & os, const std::vector<entry> & entries) {
+  os << "{\n";
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    auto & e = entries[i];
+
+    os << "  \"" << detail::json_escape(e.name) << "\": {\"kind\": \""
+       << detail::json_escape(e.kind)
+       << "\", \"calls\": " << e.calls << ", \"hits\": " << e.hits
+       << ", \"total_cycles\": " << e.total_cycles
+       << ", \"self_cycles\": " << e.self_cycles
+       << ", \"max_cycles\": " << e.max_cycles << '}'
+       << (i + 1 < entries.size() ? ",\n" : "\n");
+  }
+
+  os << "}\n";
+}
+
+}  // namespace profile
+}  // namespace pipebb
+
+#endif  // PIPEBB_PROFILE_H_
@@ -0,0 +1,327 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_RATE_SCHEDULER_H_
+#define PIPEBB_RATE_SCHEDULER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "node.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Gate which is `true` on the ticks of one rate of a
+ *        `rate_scheduler`.
+ *
+ * Clocks are created by the scheduler (see `rate_scheduler::clock()`) and
+ * invalidated by it only when their value changes, so gates downstream of a
+ * clock keep their cached values between its ticks. Use a clock as the
+ * activator of a `buffered_pass_through` or of the rate-transition gates in
+ * rate_transition.h.
+ */
+class rate_clock
+{
+  friend class rate_scheduler;
+
+public:
+  using value_t = bool;
+
+public:
+  rate_clock(const std::size_t & now, std::size_t period) noexcept
+   : _now(now), _period(period) {}
+
+  rate_clock(const rate_clock &) = delete;
+  rate_clock & operator=(const rate_clock &) = delete;
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("rate_clock");
+    if (_node.current()) { return _due; }
+    _node.update();
+
+    return _due;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  // number of base ticks between two ticks of this clock
+  std::size_t period() const noexcept { return _period; }
+
+  // number of base ticks since the last tick of this clock, 0 on its ticks
+  std::size_t elapsed() const noexcept { return _now % _period; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+private:
+  void set(bool due) noexcept {
+    if (_due != due) {
+      _due = due;
+      _node.invalidate();
+    }
+  }
+
+private:
+  const std::size_t & _now;
+  std::size_t         _period;
+  std::size_t         _tick{0};  // last tick the clock was due on
+  bool                _due{false};
+  node                _node;
+};
+
+
+/*!
+ * \brief Evaluates sink gates and feeds channels at different rates.
+ *
+ * Every rate is a whole fraction of the base rate given to the constructor,
+ * e.g. 1 kHz, 100 Hz and 1 Hz on a 1 kHz base; a rate running every
+ * `period` base ticks is due on the ticks divisible by `period`. Sources
+ * (callables writing channels) and sinks are registered with the rate they
+ * run at. Each call to `run()` advances by one base tick: it starts a new
+ * epoch (see `tick()`), runs the sources, then evaluates the sinks due on
+ * that tick, each group in the order it was added, fastest rate first. A
+ * slow subgraph is therefore only evaluated on its own ticks.
+ *
+ * The schedule is computed once, on the first `run()` after a registration:
+ * for each base tick of the hyperperiod (the least common multiple of all
+ * periods) it lists the rates due, so a tick costs time in proportion to
+ * the sources and sinks actually due on it, not to all of them.
+ *
+ * Where a signal crosses from one rate to another, put an explicit
+ * rate-transition gate (rate_transition.h) between them, driven by the
+ * clock of the slower rate. Like the `executor`, the scheduler keeps
+ * pointers to its sinks, which must therefore not be moved while
+ * registered.
+ *
+ * \include rate_scheduler.cc
+ */
+class rate_scheduler
+{
+  struct sink
+  {
+    void * gate;
+    void (*evaluate)(void *);
+  };
+
+  struct group
+  {
+    std::size_t                        period;
+    rate_clock *                       clock;
+    std::vector<std::function<void()>> sources;
+    std::vector<sink>                  sinks;
+  };
+
+public:
+  /*!
+   * \brief Upper bound of the hyperperiod, in base ticks. A schedule with a
+   *        longer one is rejected rather than tabulated.
+   */
+  static constexpr std::size_t max_hyperperiod = std::size_t{1} << 20;
+
+public:
+  /*!
+   * \brief Constructor for `rate_scheduler` class.
+   * \param base_rate Rate of `run()` calls, e.g. in Hz; the fastest rate.
+   */
+  explicit rate_scheduler(double base_rate) : _base_rate(base_rate) {
+    if (!(base_rate > 0.0)) {
+      throw std::invalid_argument("rate_scheduler: base rate must be > 0");
+    }
+  }
+
+  rate_scheduler(const rate_scheduler &) = delete;
+  rate_scheduler & operator=(const rate_scheduler &) = delete;
+
+  /*!
+   * \brief   Get the clock of a rate.
+   * \param   rate Rate, in the unit of the base rate.
+   * \returns Clock `true` on the ticks of `rate`; the same one on every call
+   *          with the same rate.
+   */
+  rate_clock & clock(double rate) { return *_groups[find(rate)].clock; }
+
+  /*!
+   * \brief Register a source, e.g. a callable writing a channel.
+   * \param source Callable run on every tick of `rate`, before the sinks.
+   * \param rate Rate, in the unit of the base rate.
+   */
+  template <class F>
+  void add_source(F source, double rate) {
+    _groups[find(rate)].sources.emplace_back(std::move(source));
+  }
+
+  /*!
+   * \brief Register a sink gate.
+   * \param gate Gate to evaluate on every tick of `rate`.
+   * \param rate Rate, in the unit of the base rate.
+   */
+  template <class G>
+  void add_sink(G & gate, double rate) {
+    _groups[find(rate)].sinks.push_back({&gate, [](void * sink_gate) {
+                                           (*static_cast<G *>(sink_gate))();
+                                         }});
+  }
+
+  /*!
+   * \brief   Advance by one base tick, running what is due on it.
+   * \returns The new epoch.
+   *
+   * The tick starts a new epoch on the calling thread via `tick()`, which
+   * leaves the thread in epoch mode after `run()` returns; call
+   * `reset_epoch()` to leave it.
+   */
+  epoch_t run() {
+    schedule();
+
+    epoch_t     epoch = tick();
+    std::size_t slot  = (_now = _ticks++) % _hyperperiod;
+    auto        first = _table.begin() + _offsets[slot];
+    auto        last  = _table.begin() + _offsets[slot + 1];
+
+    // only clocks due on either the last tick or this one change value
+    for (auto g = first; g != last; ++g) {
+      _groups[*g].clock->_tick = _now;
+      _groups[*g].clock->set(true);
+    }
+    for (auto clock : _due) {
+      if (clock->_tick != _now) { clock->set(false); }
+    }
+
+    _due.clear();
+    for (auto g = first; g != last; ++g) { _due.push_back(_groups[*g].clock); }
+
+    for (auto g = first; g != last; ++g) {
+      for (auto & source : _groups[*g].sources) { source(); }
+    }
+    for (auto g = first; g != last; ++g) {
+      for (auto & s : _groups[*g].sinks) { s.evaluate(s.gate); }
+    }
+
+    return epoch;
+  }
+
+  /*!
+   * \brief   Get the hyperperiod of the schedule.
+   * \returns Number of base ticks after which the schedule repeats.
+   */
+  std::size_t hyperperiod() {
+    schedule();
+    return _hyperperiod;
+  }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  double base_rate() const noexcept { return _base_rate; }
+
+  // number of base ticks run so far
+  std::size_t ticks() const noexcept { return _ticks; }
+
+  // index of the current base tick, i.e. of the last one run
+  std::size_t now() const noexcept { return _now; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+private:
+  static std::size_t gcd(std::size_t a, std::size_t b) noexcept {
+    while (b != 0) {
+      std::size_t r = a % b;
+      a             = b;
+      b             = r;
+    }
+    return a;
+  }
+
+  // index of the group of a rate, created on demand
+  std::size_t find(double rate) {
+    double ratio  = _base_rate / rate;
+    double period = std::round(ratio);
+
+    if (!(rate > 0.0) || period < 1.0 ||
+        std::abs(ratio - period) > 1e-9 * ratio) {
+      throw std::invalid_argument(
+        "rate_scheduler: rate " + std::to_string(rate) +
+        " is not a whole fraction of the base rate " +
+        std::to_string(_base_rate));
+    }
+
+    auto p = static_cast<std::size_t>(period);
+
+    // groups are kept sorted by period, so faster rates run first
+    auto pos = std::lower_bound(
+      _groups.begin(), _groups.end(), p, [](const group & g, std::size_t x) {
+        return g.period < x;
+      });
+    if (pos != _groups.end() && pos->period == p) {
+      return pos - _groups.begin();
+    }
+
+    _clocks.emplace_back(_now, p);
+    pos = _groups.insert(pos, group{p, &_clocks.back(), {}, {}});
+
+    _scheduled = false;
+    return pos - _groups.begin();
+  }
+
+  void schedule() {
+    if (_scheduled) { return; }
+
+    _hyperperiod = 1;
+    for (auto & g : _groups) {
+      _hyperperiod = _hyperperiod / gcd(_hyperperiod, g.period) * g.period;
+      if (_hyperperiod > max_hyperperiod) {
+        throw std::length_error(
+          "rate_scheduler: hyperperiod exceeds " +
+          std::to_string(max_hyperperiod) + " base ticks");
+      }
+    }
+
+    _offsets.assign(_hyperperiod + 1, 0);
+    _table.clear();
+    for (std::size_t t = 0; t < _hyperperiod; ++t) {
+      for (std::size_t g = 0; g < _groups.size(); ++g) {
+        if (t % _groups[g].period == 0) { _table.push_back(g); }
+      }
+      _offsets[t + 1] = _table.size();
+    }
+
+    _scheduled = true;
+  }
+
+private:
+  double                    _base_rate;
+  std::size_t               _ticks{0};
+  std::size_t               _now{0};
+  std::deque<rate_clock>    _clocks;
+  std::vector<group>        _groups;
+  std::vector<std::size_t>  _offsets;
+  std::vector<std::size_t>  _table;
+  std::vector<rate_clock *> _due;
+  std::size_t               _hyperperiod{1};
+  bool                      _scheduled{false};
+};
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_RATE_SCHEDULER_H_
@@ -0,0 +1,213 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_RATE_TRANSITION_H_
+#define PIPEBB_RATE_TRANSITION_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "dynamic_ringbuffer.h"
+#include "moving_average.h"
+#include "node.h"
+#include "pass_through.h"
+#include "rate_scheduler.h"
+#include "utils.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Holds the value of its input sampled on the ticks of a clock.
+ *
+ * Between slow and fast rates either way: the input is only pulled on the
+ * ticks of the clock, so a slower subgraph feeding a faster one is
+ * evaluated at its own rate.
+ */
+template <class I>
+using sample_and_hold = buffered_pass_through<I, rate_clock>;
+
+
+template <class I>
+inline sample_and_hold<I> make_sample_and_hold(I & input, rate_clock & clock) {
+  return {input, clock};
+}
+
+
+/*!
+ * \brief Average of the last N input values, updated on the ticks of a
+ *        slower clock.
+ *
+ * From a fast rate to a slow one. Evaluate it at the rate of its input
+ * (e.g. register it as a sink of that rate), so that every input value
+ * enters the window; its value only changes on the ticks of `clock`. With
+ * N equal to the ratio of the two rates, each output averages the input
+ * values since the previous one. The window warms up with zeros, like a
+ * `moving_average` with `use_zeros`.
+ */
+template <class I,
+          std::size_t N,
+          class A = std::allocator<typename I::value_t>>
+class decimating_average
+{
+  using self_t    = decimating_average<I, N, A>;
+  using input_t   = I;
+  using average_t = moving_average<I, N, A>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  template <std::size_t M = N, REQUIRES(M != dynamic_extent)>
+  decimating_average(input_t & input, rate_clock & clock)
+   : _average(input, true), _clock(clock) {
+    _node.attach(_average);
+    _node.attach(_clock);
+  }
+
+  // window size chosen at runtime, storage drawn from alloc
+  template <std::size_t M = N, REQUIRES(M == dynamic_extent)>
+  decimating_average(input_t &    input,
+                     rate_clock & clock,
+                     std::size_t  window,
+                     const A &    alloc = A())
+   : _average(input, window, true, alloc), _clock(clock) {
+    _node.attach(_average);
+    _node.attach(_clock);
+  }
+
+  decimating_average(self_t && other) = default;
+
+  void reset() noexcept {
+    _average.reset();
+    _value = value_t();
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("decimating_average");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    value_t average = _average();
+    if (_clock()) { _value = average; }
+    return _value;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  average_t    _average;
+  rate_clock & _clock;
+  node         _node;
+  value_t      _value{};
+};
+
+
+template <std::size_t N, class I>
+inline decimating_average<I, N> make_decimating_average(
+  I & input, rate_clock & clock) {
+  return {input, clock};
+}
+
+template <class I, class A = std::allocator<typename I::value_t>>
+inline decimating_average<I, dynamic_extent, A> make_decimating_average(
+  I &          input,
+  rate_clock & clock,
+  std::size_t  window,
+  const A &    alloc = A()) {
+  return {input, clock, window, alloc};
+}
+
+
+/*!
+ * \brief Linear interpolation between the last two input values sampled on
+ *        the ticks of a slower clock.
+ *
+ * From a slow rate to a fast one. The input is sampled on the ticks of
+ * `clock` (through a `sample_and_hold`); in between, the value moves in a
+ * straight line from the second to last sample towards the last one, which
+ * it reaches on the next tick of `clock`. The output thus lags the input by
+ * one period of the clock. Before the second sample, it holds the first.
+ *
+ * The value changes on every base tick, so the interpolator and everything
+ * downstream of it is volatile (see `node::set_volatile()`).
+ */
+template <class I>
+class interpolator
+{
+  using self_t  = interpolator<I>;
+  using input_t = I;
+  using hold_t  = sample_and_hold<I>;
+
+public:
+  using value_t = typename input_t::value_t;
+
+public:
+  interpolator(input_t & input, rate_clock & clock)
+   : _hold(input, clock), _clock(clock) {
+    _node.attach(_hold);
+    _node.set_volatile();
+  }
+
+  interpolator(self_t && other) = default;
+
+  void reset() noexcept {
+    _init = false;
+    _node.invalidate();
+  }
+
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("interpolator");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    value_t sample = _hold();
+    if (_clock()) {
+      _previous = _init ? _last : sample;
+      _last     = sample;
+      _init     = true;
+    }
+
+    _value = _previous + (_last - _previous) *
+                           static_cast<value_t>(_clock.elapsed()) /
+                           static_cast<value_t>(_clock.period());
+    return _value;
+  }
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  hold_t       _hold;
+  rate_clock & _clock;
+  bool         _init{false};
+  value_t      _previous{};
+  value_t      _last{};
+  value_t      _value{};
+  node         _node;
+};
+
+
+template <class I>
+inline interpolator<I> make_interpolator(I & input, rate_clock & clock) {
+  return {input, clock};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_RATE_TRANSITION_H_
@@ -0,0 +1,326 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_RECORDER_H_
+#define PIPEBB_RECORDER_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+#include "node.h"
+#include "recording.h"
+
+
+namespace pipebb {
+namespace detail {
+
+
+template <class G, typename T>
+inline void store_sample(void * gate, char * slot) {
+  *reinterpret_cast<T *>(slot) = (*static_cast<G *>(gate))();
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Sink gate recording the values of other gates into a file.
+ *
+ * Every call evaluates the recorded gates and appends their values to one
+ * column each; `close()` turns the columns into a recording (see
+ * `recording_writer`) that can be opened by `recording` and replayed. The
+ * columns are named as given to `add()`, their factor is 1 and their
+ * offset 0, so replay yields the recorded values.
+ *
+ * Values are stored into preallocated buffers of `chunk` samples per
+ * column, so recording a value is a store plus an index increment. Full
+ * buffers are handed to a background thread, which appends them to a spool
+ * file next to the recording while the other buffer fills up; recording
+ * only blocks if the disk falls behind. `close()` flushes the last, partial
+ * buffer and assembles the recording from the spool file.
+ *
+ * The recorder is volatile: it records one sample per call, even if none of
+ * its inputs changed. Use it like any sink, e.g. with `executor`, which
+ * evaluates it together with the gates it records. Gates must be added
+ * before the first sample is recorded and must not be moved afterwards.
+ *
+ * Errors writing the spool file are rethrown on the next handover of a full
+ * buffer or by `close()`, as `std::runtime_error`.
+ *
+ * \include recorder.cc
+ */
+class recorder
+{
+public:
+  using self_t  = recorder;
+  using value_t = std::size_t;
+
+public:
+  /*!
+   * \brief Constructor for `recorder` class.
+   * \param path Path of the recording to write.
+   * \param chunk Number of samples buffered per column before they are
+   *        handed to the background thread.
+   */
+  explicit recorder(std::string path, std::size_t chunk = 4096)
+   : _path(std::move(path)),
+     _spool_path(_path + ".spool"),
+     _chunk(std::max<std::size_t>(chunk, 1)) {
+    _node.set_volatile();
+  }
+
+  recorder(const recorder &) = delete;
+  recorder & operator=(const recorder &) = delete;
+
+  /*!
+   * \brief Destructor, closes the recorder; errors are dropped, call
+   *        `close()` to see them.
+   */
+  ~recorder() {
+    try {
+      close();
+    } catch (...) {}
+  }
+
+  /*!
+   * \brief Adds a gate to record.
+   * \param gate Gate whose value is recorded on every call.
+   * \param name Name of the column.
+   * \param unit Unit of the column.
+   * \throws std::runtime_error if recording has started already.
+   */
+  template <class G>
+  void add(G & gate, std::string name, std::string unit = "") {
+    using sample_t = std::decay_t<decltype(gate())>;
+
+    if (_started || _closed) {
+      throw std::runtime_error("cannot add '" + name +
+                               "' to a recorder in use");
+    }
+
+    recording_column desc;
+    desc.name = std::move(name);
+    desc.unit = std::move(unit);
+    desc.type = detail::sample_type_of<sample_t>::value;
+
+    _columns.push_back({&gate, &detail::store_sample<G, sample_t>, 0,
+                        sizeof(sample_t), std::move(desc)});
+    _node.attach(gate);
+  }
+
+  /*!
+   * \brief   Records the current values of all gates.
+   * \returns Number of samples recorded so far.
+   */
+  value_t operator()() {
+    PIPEBB_PROFILE_GATE("recorder");
+    if (!_started) { start(); }
+
+    char * front = _front.get();
+    for (const auto & c : _columns) {
+      c.store(c.gate, front + c.offset + _index * c.size);
+    }
+    if (++_index == _chunk) { hand_over(); }
+
+    return ++_samples;
+  }
+
+  /*!
+   * \brief Flushes the remaining samples and writes the recording.
+   *
+   * Further calls have no effect.
+   *
+   * \throws std::runtime_error if the spool file or the recording can't be
+   *         written.
+   */
+  void close() {
+    if (_closed) { return; }
+    _closed = true;
+
+    if (_started) {
+      // a failed handover leaves its error for below
+      try {
+        if (_index > 0) { hand_over(); }
+      } catch (...) {}
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait(lock, [this] { return !_pending; });
+        _stop = true;
+      }
+      _wake.notify_one();
+      _writer.join();
+      _spool.close();
+
+      if (_error) { std::rethrow_exception(_error); }
+    }
+
+    assemble();
+    std::remove(_spool_path.c_str());
+  }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  std::size_t size() const noexcept { return _samples; }
+  std::size_t columns() const noexcept { return _columns.size(); }
+  std::size_t chunk() const noexcept { return _chunk; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  node & graph_node() noexcept { return _node; }
+
+private:
+  struct column_t
+  {
+    void * gate;
+    void (*store)(void *, char *);
+    std::size_t      offset;
+    std::size_t      size;
+    recording_column desc;
+  };
+
+  void start() {
+    _buffer_bytes = 0;
+    for (auto & c : _columns) {
+      c.offset = _buffer_bytes;
+      _buffer_bytes += detail::align_up(_chunk * c.size,
+                                        detail::recording_alignment);
+    }
+
+    // value-initialized to touch the pages before the first sample
+    _front.reset(new char[_buffer_bytes]());
+    _back.reset(new char[_buffer_bytes]());
+
+    _spool.open(_spool_path, std::ios::binary | std::ios::trunc);
+    if (!_spool) { throw std::runtime_error("cannot open " + _spool_path); }
+
+    _writer  = std::thread([this] { write_back(); });
+    _started = true;
+  }
+
+  // waits for the background thread to finish the back buffer, then gives
+  // it the front buffer
+  void hand_over() {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _idle.wait(lock, [this] { return !_pending; });
+      if (_error) {
+        _index = 0;
+        std::rethrow_exception(_error);
+      }
+
+      std::swap(_front, _back);
+      _pending = true;
+    }
+    _wake.notify_one();
+    _index = 0;
+  }
+
+  void write_back() {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for (;;) {
+      _wake.wait(lock, [this] { return _pending || _stop; });
+      if (!_pending) { return; }
+
+      lock.unlock();
+      try {
+        _spool.write(_back.get(), static_cast<std::streamsize>(_buffer_bytes));
+        if (!_spool) {
+          throw std::runtime_error("cannot write " + _spool_path);
+        }
+      } catch (...) {
+        _error = std::current_exception();
+      }
+      lock.lock();
+
+      _pending = false;
+      _idle.notify_one();
+    }
+  }
+
+  // copies the columns out of the spooled chunks; all chunks are full but
+  // the last one
+  void assemble() {
+    std::vector<recording_column> descs;
+    for (const auto & c : _columns) { descs.push_back(c.desc); }
+
+    std::vector<std::size_t> positions;
+    std::string header = detail::recording_header(descs, _samples, positions);
+
+    std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+    if (!file) { throw std::runtime_error("cannot open " + _path); }
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    std::unique_ptr<detail::mapped_file> spool;
+    if (_samples > 0) { spool.reset(new detail::mapped_file(_spool_path)); }
+
+    std::size_t chunks   = (_samples + _chunk - 1) / _chunk;
+    std::size_t position = header.size();
+    for (std::size_t c = 0; c < _columns.size(); ++c) {
+      detail::pad(file, positions[c] - position);
+      for (std::size_t k = 0; k < chunks; ++k) {
+        std::size_t count = std::min(_chunk, _samples - k * _chunk);
+        file.write(spool->data() + k * _buffer_bytes + _columns[c].offset,
+                   static_cast<std::streamsize>(count * _columns[c].size));
+      }
+      position = positions[c] + _samples * _columns[c].size;
+    }
+
+    file.flush();
+    if (!file) { throw std::runtime_error("cannot write " + _path); }
+  }
+
+private:
+  std::string           _path;
+  std::string           _spool_path;
+  std::size_t           _chunk;
+  std::vector<column_t> _columns;
+  node                  _node;
+
+  std::unique_ptr<char[]> _front;
+  std::unique_ptr<char[]> _back;
+  std::size_t             _buffer_bytes{0};
+  std::size_t             _index{0};
+  std::size_t             _samples{0};
+  bool                    _started{false};
+  bool                    _closed{false};
+
+  std::ofstream           _spool;
+  std::thread             _writer;
+  std::mutex              _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _idle;
+  bool                    _pending{false};
+  bool                    _stop{false};
+  std::exception_ptr      _error;
+};
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_RECORDER_H_
@@ -0,0 +1,639 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_RECORDING_H_
+#define PIPEBB_RECORDING_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "channel.h"
+#include "mapped_file.h"
+#include "span.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Sample type of a recorded column.
+ */
+enum class sample_type : std::uint32_t {
+  boolean = 1,
+  int8,
+  uint8,
+  int16,
+  uint16,
+  int32,
+  uint32,
+  int64,
+  uint64,
+  float32,
+  float64
+};
+
+
+namespace detail {
+
+
+template <typename T>
+struct sample_type_of;
+
+#define PIPEBB_SAMPLE_TYPE(T, tag)                                            \
+  template <>                                                                 \
+  struct sample_type_of<T>                                                    \
+  {                                                                           \
+    static constexpr sample_type value = sample_type::tag;                    \
+  }
+
+PIPEBB_SAMPLE_TYPE(bool, boolean);
+PIPEBB_SAMPLE_TYPE(std::int8_t, int8);
+PIPEBB_SAMPLE_TYPE(std::uint8_t, uint8);
+PIPEBB_SAMPLE_TYPE(std::int16_t, int16);
+PIPEBB_SAMPLE_TYPE(std::uint16_t, uint16);
+PIPEBB_SAMPLE_TYPE(std::int32_t, int32);
+PIPEBB_SAMPLE_TYPE(std::uint32_t, uint32);
+PIPEBB_SAMPLE_TYPE(std::int64_t, int64);
+PIPEBB_SAMPLE_TYPE(std::uint64_t, uint64);
+PIPEBB_SAMPLE_TYPE(float, float32);
+PIPEBB_SAMPLE_TYPE(double, float64);
+
+#undef PIPEBB_SAMPLE_TYPE
+
+static_assert(sizeof(bool) == 1, "booleans are recorded as single bytes");
+
+
+inline std::size_t sample_size(sample_type type) noexcept {
+  switch (type) {
+    case sample_type::boolean:
+    case sample_type::int8:
+    case sample_type::uint8: return 1;
+    case sample_type::int16:
+    case sample_type::uint16: return 2;
+    case sample_type::int32:
+    case sample_type::uint32:
+    case sample_type::float32: return 4;
+    case sample_type::int64:
+    case sample_type::uint64:
+    case sample_type::float64: return 8;
+  }
+  return 0;
+}
+
+
+constexpr char          recording_magic[8]  = {'P', 'I', 'P', 'E',
+                                               'B', 'B', 'R', 'C'};
+constexpr std::uint32_t recording_order     = 0x01020304;
+constexpr std::uint32_t recording_version   = 1;
+constexpr std::size_t   recording_alignment = 64;
+
+
+inline std::size_t align_up(std::size_t size, std::size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+
+template <typename T>
+inline void put(std::string & out, T value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+
+/*!
+ * \brief Bounds-checked reader for the recording header.
+ */
+class header_reader
+{
+public:
+  header_reader(const char * data, std::size_t size) noexcept
+   : _data(data), _size(size) {}
+
+  template <typename T>
+  T get() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string get(std::size_t length) {
+    return std::string(take(length), length);
+  }
+
+  void align(std::size_t alignment) {
+    take(align_up(_pos, alignment) - _pos);
+  }
+
+private:
+  const char * take(std::size_t length) {
+    if (length > _size - _pos) {
+      throw std::runtime_error("recording: truncated header");
+    }
+    const char * data = _data + _pos;
+    _pos += length;
+    return data;
+  }
+
+  const char * _data;
+  std::size_t  _size;
+  std::size_t  _pos{0};
+};
+
+
+template <typename T>
+inline channel<T> make_recorded_channel(const std::string & name,
+                                        const std::string & unit,
+                                        double              factor,
+                                        double              offset) {
+  return channel<T>(name, unit, static_cast<T>(factor),
+                    static_cast<T>(offset));
+}
+
+template <>
+inline channel<bool> make_recorded_channel<bool>(const std::string & name,
+                                                 const std::string &,
+                                                 double,
+                                                 double) {
+  return channel<bool>(name);
+}
+
+
+template <typename T>
+inline void feed_channel(void * target, const char * data, std::size_t i) {
+  *static_cast<channel<T> *>(target)
+    << reinterpret_cast<const T *>(data)[i];
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Description of a recorded column.
+ *
+ * Name, unit, factor and offset are those of the recorded channel, so that
+ * an equivalent channel can be set up for replay. Booleans have no factor
+ * and offset; they are recorded as 1 and 0.
+ */
+struct recording_column
+{
+  std::string name;
+  std::string unit;
+  double      factor{1};
+  double      offset{0};
+  sample_type type{sample_type::float64};
+};
+
+
+namespace detail {
+
+
+/*!
+ * \brief Builds the header of a recording.
+ * \param columns Descriptions of the columns.
+ * \param samples Number of samples per column.
+ * \param positions Receives the position of each column's data in the file.
+ */
+inline std::string recording_header(
+  const std::vector<recording_column> & columns,
+  std::size_t                           samples,
+  std::vector<std::size_t> &            positions) {
+  std::string header;
+  header.append(recording_magic, sizeof(recording_magic));
+  put<std::uint32_t>(header, recording_order);
+  put<std::uint32_t>(header, recording_version);
+  put<std::uint64_t>(header, samples);
+  put<std::uint32_t>(header, static_cast<std::uint32_t>(columns.size()));
+  put<std::uint32_t>(header, 0);
+
+  std::size_t position = header.size();
+  for (const auto & desc : columns) {
+    position += 4 * sizeof(std::uint32_t) + 2 * sizeof(double) +
+                sizeof(std::uint64_t) +
+                align_up(desc.name.size() + desc.unit.size(), 8);
+  }
+
+  positions.clear();
+  for (const auto & desc : columns) {
+    position = align_up(position, recording_alignment);
+    positions.push_back(position);
+
+    put<std::uint32_t>(header, static_cast<std::uint32_t>(desc.type));
+    put<std::uint32_t>(header, static_cast<std::uint32_t>(desc.name.size()));
+    put<std::uint32_t>(header, static_cast<std::uint32_t>(desc.unit.size()));
+    put<std::uint32_t>(header, 0);
+    put<double>(header, desc.factor);
+    put<double>(header, desc.offset);
+    put<std::uint64_t>(header, position);
+    header += desc.name;
+    header += desc.unit;
+    header.resize(align_up(header.size(), 8), '\0');
+
+    position += samples * sample_size(desc.type);
+  }
+
+  return header;
+}
+
+
+inline void pad(std::ostream & out, std::size_t count) {
+  static const char zeros[recording_alignment] = {};
+  out.write(zeros, static_cast<std::streamsize>(count));
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Writes channel data to a columnar recording.
+ *
+ * A recording holds a fixed number of samples for each of its columns. The
+ * samples are stored raw, i.e. as they would be written into the channel,
+ * so that replaying them yields the same values through the channel's
+ * factor and offset.
+ *
+ * The file starts with a header: the magic `PIPEBBRC`, a byte order mark,
+ * the format version, the number of samples and the number of columns,
+ * followed by one descriptor per column holding its type, name, unit,
+ * factor, offset and the position of its data. Column data follows the
+ * header as plain arrays, each aligned to 64 bytes, so that they can be
+ * used in place once the file is mapped. Numbers are stored in native
+ * byte order; the byte order mark rejects files from a machine of the
+ * other kind.
+ *
+ * The writer only keeps views of the data passed to `add()`; the data must
+ * stay valid until `write()` has returned.
+ *
+ * \include recording.cc
+ */
+class recording_writer
+{
+public:
+  /*!
+   * \brief Adds a column, described by a channel.
+   * \param ch Channel whose name, unit, factor and offset are recorded.
+   * \param raw Raw data values of the channel, e.g. a `std::vector`.
+   * \throws std::runtime_error if the name is taken or the number of
+   *         samples differs from that of the columns added before.
+   */
+  template <typename T>
+  void add(const channel<T> & ch,
+           span<const typename channel<T>::value_t> raw) {
+    add_column(describe(ch), raw);
+  }
+
+  /*!
+   * \brief Writes the recording to a file, replacing it if it exists.
+   * \throws std::runtime_error if the file can't be written.
+   */
+  void write(const std::string & path) const {
+    std::vector<recording_column> descs;
+    for (const auto & column : _columns) { descs.push_back(column.desc); }
+
+    std::vector<std::size_t> positions;
+    std::string header = detail::recording_header(descs, _samples, positions);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) { throw std::runtime_error("cannot open " + path); }
+
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    std::size_t position = header.size();
+    for (std::size_t c = 0; c < _columns.size(); ++c) {
+      detail::pad(file, positions[c] - position);
+      file.write(_columns[c].data,
+                 static_cast<std::streamsize>(_columns[c].bytes));
+      position = positions[c] + _columns[c].bytes;
+    }
+
+    file.flush();
+    if (!file) { throw std::runtime_error("cannot write " + path); }
+  }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  std::size_t size() const noexcept { return _samples; }
+  std::size_t columns() const noexcept { return _columns.size(); }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+private:
+  struct column_t
+  {
+    recording_column desc;
+    const char *     data;
+    std::size_t      bytes;
+  };
+
+  template <typename T>
+  static recording_column describe(const channel<T> & ch) {
+    return {ch.name(), ch.unit(), static_cast<double>(ch.factor()),
+            static_cast<double>(ch.offset()),
+            detail::sample_type_of<T>::value};
+  }
+
+  static recording_column describe(const channel<bool> & ch) {
+    return {ch.name(), ch.unit(), 1, 0, sample_type::boolean};
+  }
+
+  template <typename T>
+  void add_column(recording_column desc, span<const T> raw) {
+    for (const auto & column : _columns) {
+      if (column.desc.name == desc.name) {
+        throw std::runtime_error("duplicate column '" + desc.name + "'");
+      }
+    }
+    if (!_columns.empty() && raw.size() != _samples) {
+      throw std::runtime_error("column '" + desc.name + "' holds " +
+                               std::to_string(raw.size()) +
+                               " samples instead of " +
+                               std::to_string(_samples));
+    }
+
+    _samples = raw.size();
+    _columns.push_back({std::move(desc),
+                        reinterpret_cast<const char *>(raw.data()),
+                        raw.size() * sizeof(T)});
+  }
+
+  std::vector<column_t> _columns;
+  std::size_t           _samples{0};
+};
+
+
+/*!
+ * \brief Read-only columnar recording, as written by `recording_writer`.
+ *
+ * The file is mapped into memory and its header checked when the recording
+ * is opened; column data is then accessed in place, without copies.
+ *
+ * \throws std::runtime_error if the file can't be read or is not a valid
+ *         recording.
+ *
+ * \include recording.cc
+ */
+class recording
+{
+public:
+  explicit recording(const std::string & path) : _file(path) {
+    detail::header_reader header(_file.data(), _file.size());
+
+    auto fail = [&path](const std::string & what) {
+      return std::runtime_error(path + ": " + what);
+    };
+
+    if (header.get(sizeof(detail::recording_magic)) !=
+        std::string(detail::recording_magic,
+                    sizeof(detail::recording_magic))) {
+      throw fail("not a recording");
+    }
+    if (header.get<std::uint32_t>() != detail::recording_order) {
+      throw fail("byte order mismatch");
+    }
+    if (header.get<std::uint32_t>() != detail::recording_version) {
+      throw fail("unsupported version");
+    }
+    _samples          = header.get<std::uint64_t>();
+    std::size_t count = header.get<std::uint32_t>();
+    header.get<std::uint32_t>();
+
+    _columns.reserve(count);
+    _data.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      recording_column desc;
+      std::uint32_t    type = header.get<std::uint32_t>();
+      std::size_t      name = header.get<std::uint32_t>();
+      std::size_t      unit = header.get<std::uint32_t>();
+      header.get<std::uint32_t>();
+      desc.factor          = header.get<double>();
+      desc.offset          = header.get<double>();
+      std::size_t position = header.get<std::uint64_t>();
+      desc.name            = header.get(name);
+      desc.unit            = header.get(unit);
+      header.align(8);
+
+      desc.type        = static_cast<sample_type>(type);
+      std::size_t size = detail::sample_size(desc.type);
+      if (size == 0) { throw fail("unknown type of '" + desc.name + "'"); }
+      if (position % size != 0 || position > _file.size() ||
+          _samples > (_file.size() - position) / size) {
+        throw fail("data of '" + desc.name + "' out of bounds");
+      }
+
+      _columns.push_back(std::move(desc));
+      _data.push_back(_file.data() + position);
+    }
+  }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  std::size_t size() const noexcept { return _samples; }
+  std::size_t columns() const noexcept { return _columns.size(); }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  /*!
+   * \brief Description of a column.
+   * \throws std::out_of_range if there is no column of that index.
+   */
+  const recording_column & column(std::size_t i) const {
+    if (i >= _columns.size()) {
+      throw std::out_of_range("column " + std::to_string(i) +
+                              " out of range, the recording has " +
+                              std::to_string(_columns.size()));
+    }
+    return _columns[i];
+  }
+
+  /*!
+   * \brief Index of the column of the given name.
+   * \throws std::runtime_error if there is no column of that name.
+   */
+  std::size_t index(const std::string & name) const {
+    for (std::size_t i = 0; i < _columns.size(); ++i) {
+      if (_columns[i].name == name) { return i; }
+    }
+    throw std::runtime_error("unknown column '" + name + "'");
+  }
+
+  /*!
+   * \brief Raw data of a column, in place in the mapped file.
+   * \throws std::out_of_range if there is no column of that index.
+   * \throws std::runtime_error if the column doesn't hold samples of type
+   *         `T`.
+   */
+  template <typename T>
+  span<const T> data(std::size_t column) const {
+    check<T>(column);
+    return make_span(reinterpret_cast<const T *>(_data[column]), _samples);
+  }
+
+  /*!
+   * \brief Creates a channel set up like the recorded one.
+   * \throws std::out_of_range if there is no column of that index.
+   * \throws std::runtime_error if the column doesn't hold samples of type
+   *         `T`.
+   */
+  template <typename T>
+  channel<T> make_channel(std::size_t column) const {
+    const auto & desc = check<T>(column);
+    return detail::make_recorded_channel<T>(desc.name, desc.unit,
+                                            desc.factor, desc.offset);
+  }
+
+private:
+  template <typename T>
+  const recording_column & check(std::size_t column) const {
+    const auto & desc = this->column(column);
+    if (desc.type != detail::sample_type_of<T>::value) {
+      throw std::runtime_error("column '" + desc.name +
+                               "' holds samples of another type");
+    }
+    return desc;
+  }
+
+  detail::mapped_file           _file;
+  std::vector<recording_column> _columns;
+  std::vector<const char *>     _data;
+  std::size_t                   _samples{0};
+};
+
+
+/*!
+ * \brief Source replaying a recording into channels.
+ *
+ * Channels are bound to columns by name. The recording is replayed either
+ * sample by sample, with `step()` writing the next sample of each column
+ * into its channel, or block by block: `next()` advances by up to one block
+ * and `block()` returns the current block of a channel's column in place,
+ * ready to be passed to `channel::process()`, which leaves the channel
+ * holding the last sample of the block.
+ *
+ * The recording must outlive the replay source and its bound channels must
+ * not be moved.
+ *
+ * \include recording.cc
+ */
+class replay
+{
+public:
+  /*!
+   * \param rec Recording to replay.
+   * \param block_size Maximum number of samples per block.
+   */
+  explicit replay(const recording & rec, std::size_t block_size = 1024)
+   : _recording(rec), _block_size(std::max<std::size_t>(block_size, 1)) {}
+
+  /*!
+   * \brief Binds a channel to the column of the same name.
+   * \throws std::runtime_error if there is no such column or its samples are
+   *         not of type `T`.
+   */
+  template <typename T>
+  void bind(channel<T> & ch) {
+    bind(ch, _recording.index(ch.name()));
+  }
+
+  /*!
+   * \brief Binds a channel to the given column.
+   * \throws std::out_of_range if there is no column of that index.
+   * \throws std::runtime_error if the column's samples are not of type `T`.
+   */
+  template <typename T>
+  void bind(channel<T> & ch, std::size_t column) {
+    auto data = _recording.data<T>(column);
+    _bindings.push_back({&ch, reinterpret_cast<const char *>(data.data()),
+                         column, &detail::feed_channel<T>});
+  }
+
+  /*!
+   * \brief Writes the next sample of each column into its channel.
+   * \return False if the recording is exhausted.
+   */
+  bool step() noexcept {
+    if (_position >= _recording.size()) { return false; }
+    for (const auto & b : _bindings) { b.feed(b.target, b.data, _position); }
+    _begin = _position++;
+    _count = 1;
+    return true;
+  }
+
+  /*!
+   * \brief Advances to the next block.
+   * \return Number of samples in the block, 0 if the recording is
+   *         exhausted.
+   */
+  std::size_t next() noexcept {
+    _begin = _position;
+    _count = std::min(_block_size, _recording.size() - _position);
+    _position += _count;
+    return _count;
+  }
+
+  /*!
+   * \brief Raw samples of the current block for a bound channel.
+   * \throws std::runtime_error if the channel is not bound.
+   */
+  template <typename T>
+  span<const T> block(const channel<T> & ch) const {
+    for (const auto & b : _bindings) {
+      if (b.target == &ch) {
+        return make_span(reinterpret_cast<const T *>(b.data) + _begin,
+                         _count);
+      }
+    }
+    throw std::runtime_error("channel '" + ch.name() + "' is not bound");
+  }
+
+  /*!
+   * \brief Restarts the replay at the first sample.
+   */
+  void rewind() noexcept {
+    _position = 0;
+    _begin    = 0;
+    _count    = 0;
+  }
+
+  /*! \name Getters */ /*!@{*/
+  /*! Getter. */       /* -------------------------------------------------- */
+  std::size_t position() const noexcept { return _position; }
+  std::size_t block_size() const noexcept { return _block_size; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+private:
+  struct binding_t
+  {
+    void *       target;
+    const char * data;
+    std::size_t  column;
+    void (*feed)(void *, const char *, std::size_t);
+  };
+
+  const recording &      _recording;
+  std::size_t            _block_size;
+  std::vector<binding_t> _bindings;
+  std::size_t            _position{0};
+  std::size_t            _begin{0};
+  std::size_t            _count{0};
+};
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_RECORDING_H_
@@ -17,6 +17,8 @@
 #ifndef PIPEBB_RESETTER_H_
 #define PIPEBB_RESETTER_H_
 
+#include "node.h"
+
 
 namespace pipebb {
 
@@ -29,25 +31,38 @@ class resetter
   using target_t = T;
 
 public:
-  resetter(input_t & input, target_t & target) noexcept
-   : _input(input), _target(target) {}
+  resetter(input_t & input, target_t & target)
+   : _input(input), _target(target) {
+    _node.attach(_input);
+  }
 
   resetter(self_t && other) = default;
 
   bool operator()() noexcept {
-    if (_input()) { _target.reset(); }
+    PIPEBB_PROFILE_GATE("resetter");
+    if (_node.current()) { return true; }
+    _node.update();
+
+    // while the input holds, the target is reset on every evaluation
+    if (_input()) {
+      _target.reset();
+      _node.mark_dirty();
+    }
 
     return true;
   }
 
+  node & graph_node() noexcept { return _node; }
+
 private:
   input_t &  _input;
   target_t & _target;
+  node       _node;
 };
 
 
 template <class I, class T>
-inline resetter<I, T> make_resetter(I & input, T & target) noexcept {
+inline resetter<I, T> make_resetter(I & input, T & target) {
   return {input, target};
 }
 
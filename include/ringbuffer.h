@@ -25,22 +25,93 @@
 
 #include <iostream>
 
+#include "span.h"
+
 
 namespace pipebb {
 
 
+/*!
+ * \brief Indexing policy tag: storage of `N + 1` slots, wrap-around by modulo.
+ *
+ * This is the default; it uses the least memory.
+ */
+struct modulo_indexing
+{};
+
+/*!
+ * \brief Indexing policy tag: storage rounded up to a power of two slots,
+ *        wrap-around by bit masking.
+ *
+ * Trades up to twice the memory for the integer division on every element
+ * access. Best used with `N` of the form `2^k - 1`, where no memory is lost.
+ */
+struct masked_indexing
+{};
+
+
 /* forward declarations ---------------------------------------------------- */
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, class P = modulo_indexing>
 class ringbuffer;
 
-template <typename T, std::size_t N>
-std::ostream & operator<<(std::ostream &, const ringbuffer<T, N> &);
+template <typename T, std::size_t N, class P>
+std::ostream & operator<<(std::ostream &, const ringbuffer<T, N, P> &);
 /* ------------------------------------------------------------------------- */
 
 
 namespace detail {
 
 
+constexpr std::size_t next_power_of_two(std::size_t n) noexcept {
+  std::size_t power = 1;
+  while (power < n) { power <<= 1; }
+  return power;
+}
+
+
+template <class P, std::size_t N>
+struct ringbuffer_layout;
+
+template <std::size_t N>
+struct ringbuffer_layout<modulo_indexing, N>
+{
+  static constexpr std::size_t size() noexcept { return N + 1; }
+
+  static constexpr std::size_t wrap(std::size_t i) noexcept {
+    return i % (N + 1);
+  }
+
+  static constexpr std::size_t next(std::size_t i) noexcept {
+    return i == N ? 0 : i + 1;
+  }
+
+  static constexpr std::size_t prev(std::size_t i) noexcept {
+    return i == 0 ? N : i - 1;
+  }
+};
+
+template <std::size_t N>
+struct ringbuffer_layout<masked_indexing, N>
+{
+  static constexpr std::size_t size() noexcept {
+    return next_power_of_two(N + 1);
+  }
+
+  static constexpr std::size_t wrap(std::size_t i) noexcept {
+    return i & (size() - 1);
+  }
+
+  static constexpr std::size_t next(std::size_t i) noexcept {
+    return wrap(i + 1);
+  }
+
+  static constexpr std::size_t prev(std::size_t i) noexcept {
+    return wrap(i - 1);
+  }
+};
+
+
+
 template <class ringbuffer_t>
 class ringbuffer_iterator
 {
@@ -70,19 +141,17 @@ public:
   }
 
   reference operator*() noexcept {
-    return const_cast<ringbuffer_t &>(_rb)[_pos - _rb._begin_pos];
+    return const_cast<ringbuffer_t &>(_rb).slot(_pos);
   }
 
-  const_reference operator*() const noexcept {
-    return _rb[_pos - _rb._begin_pos];
-  }
+  const_reference operator*() const noexcept { return _rb.slot(_pos); }
 
   const pointer operator->() const noexcept {
-    return &_rb[_pos - _rb._begin_pos];
+    return &const_cast<ringbuffer_t &>(_rb).slot(_pos);
   }
 
   self_t & operator++() noexcept {
-    _pos == _rb._capacity ? _pos = 0 : ++_pos;
+    _pos = _rb.next_pos(_pos);
     return *this;
   }
 
@@ -93,7 +162,7 @@ public:
   }
 
   self_t & operator--() noexcept {
-    _pos == 0 ? _pos = _rb._capacity : --_pos;
+    _pos = _rb.prev_pos(_pos);
     return *this;
   }
 
@@ -121,11 +190,22 @@ private:
 }  // namespace detail
 
 
-template <typename T, std::size_t N>
+/*!
+ * \brief Fixed size circular buffer used as window storage by pipeBB gates.
+ * \param T Template parameter specifying the element type.
+ * \param N Template parameter specifying the capacity.
+ * \param P Template parameter specifying the indexing policy, either
+ *        `modulo_indexing` (default) or `masked_indexing`.
+ *
+ * The slot behind the last element is always kept default constructed, so
+ * `*end()` yields `T()`.
+ */
+template <typename T, std::size_t N, class P>
 class ringbuffer
 {
-  using self_t  = ringbuffer<T, N>;
-  using value_t = T;
+  using self_t   = ringbuffer<T, N, P>;
+  using value_t  = T;
+  using layout_t = detail::ringbuffer_layout<P, N>;
 
 public:
   using value_type       = value_t;
@@ -137,6 +217,8 @@ public:
   using const_pointer    = const value_t *;
   using iterator         = detail::ringbuffer_iterator<self_t>;
   using reverse_iterator = std::reverse_iterator<iterator>;
+  using storage_type     = std::array<value_t, layout_t::size()>;
+  using segments_type    = std::array<span<const value_t>, 2>;
 
   friend iterator;
 
@@ -144,22 +226,13 @@ public:
   /* Element access -------------------------------------------------------- */
   void push(value_t value) noexcept {
     _data[_end_pos] = value;
+    _end_pos        = layout_t::next(_end_pos);
 
+    // once full, the oldest element is overwritten, so move _begin_pos along
     if (_size == _capacity) {
-      // check if we have reached the end of array, if yes jump to beginning
-      _end_pos == _capacity ? _end_pos = 0 : ++_end_pos;
-      // check if _end_pos points to last element now, if yes reset _begin_pos
-      // THIS IS NOT THE SAME AS ABOVE! _end_pos MAY HAVE BEEN INCREMENTED!
-      _end_pos == _capacity ? _begin_pos = 0 : ++_begin_pos;
+      _begin_pos = layout_t::next(_begin_pos);
     } else {
-      // when array is filled, reset both _pos. before, only inc _end_pos.
-      if (_end_pos == _capacity) {
-        _end_pos   = 0;
-        _begin_pos = 1;
-      } else {
-        ++_end_pos;
-        ++_size;
-      }
+      ++_size;
     }
 
     _data[_end_pos] = value_t();
@@ -170,25 +243,113 @@ public:
     return *this;
   }
 
-  reference at(std::size_t i) noexcept { operator[](i); }
+  /*!
+   * \brief Push a block of values, equivalent to calling `push()` on each.
+   * \param values Pointer to the first value.
+   * \param count Number of values.
+   *
+   * Copies the block in at most two pieces. If `count` exceeds the capacity,
+   * only the last `max_size()` values are kept.
+   */
+  void push_n(const value_t * values, std::size_t count) noexcept {
+    if (count >= _capacity) {
+      values += count - _capacity;
+      std::copy(values, values + _capacity, _data.begin());
+      _begin_pos = 0;
+      _end_pos   = _capacity;
+      _size      = _capacity;
+    } else {
+      std::size_t first = std::min(count, layout_t::size() - _end_pos);
+      std::copy(values, values + first, _data.begin() + _end_pos);
+      std::copy(values + first, values + count, _data.begin());
+
+      _end_pos   = layout_t::wrap(_end_pos + count);
+      _size      = std::min(_size + count, _capacity);
+      _begin_pos = layout_t::wrap(_end_pos + layout_t::size() - _size);
+    }
+
+    _data[_end_pos] = value_t();
+  }
+
+  /*!
+   * \brief   Remove up to `count` values from the front.
+   * \param   values Pointer to storage for the removed values; may be null if
+   *          they are not needed.
+   * \param   count Number of values to remove.
+   * \returns Number of values actually removed.
+   */
+  std::size_t pop_n(value_t * values, std::size_t count) noexcept {
+    count = std::min(count, _size);
+
+    if (values) {
+      auto segs  = segments();
+      auto first = std::min(count, segs[0].size());
+      std::copy(segs[0].begin(), segs[0].begin() + first, values);
+      std::copy(segs[1].begin(), segs[1].begin() + (count - first),
+                values + first);
+    }
+
+    _begin_pos = layout_t::wrap(_begin_pos + count);
+    _size -= count;
+
+    return count;
+  }
+
+  /*!
+   * \brief Remove the oldest value. The buffer must not be empty.
+   */
+  void pop_front() noexcept {
+    _begin_pos = layout_t::next(_begin_pos);
+    --_size;
+  }
+
+  /*!
+   * \brief Remove the newest value. The buffer must not be empty.
+   */
+  void pop_back() noexcept {
+    _end_pos        = layout_t::prev(_end_pos);
+    _data[_end_pos] = value_t();
+    --_size;
+  }
+
+  reference at(std::size_t i) noexcept { return operator[](i); }
 
   reference operator[](const std::size_t i) noexcept {
-    return _data[(_begin_pos + i) % (_capacity + 1)];
+    return _data[layout_t::wrap(_begin_pos + i)];
   }
 
   const_reference operator[](const std::size_t i) const noexcept {
-    return _data[(_begin_pos + i) % (_capacity + 1)];
+    return _data[layout_t::wrap(_begin_pos + i)];
   }
 
   const_reference front() const noexcept { return _data[_begin_pos]; }
 
   const_reference back() const noexcept {
-    return (_end_pos == 0 ? _data[_capacity] : _data[_end_pos - 1]);
+    return _data[layout_t::prev(_end_pos)];
   }
 
   pointer data() noexcept { return _data.data(); }
 
-  const std::array<T, N + 1> & raw() const noexcept { return _data; }
+  const storage_type & raw() const noexcept { return _data; }
+
+  /*!
+   * \brief   Get the content as contiguous pieces of memory, oldest first.
+   * \returns Two `span`s which, concatenated, hold the content. The second
+   *          one is empty unless the content wraps around the storage end.
+   *
+   * Algorithms running over the whole window (sums, extrema, copying out)
+   * should prefer this over the iterators, which have to check for the wrap
+   * on every step.
+   */
+  segments_type segments() const noexcept {
+    if (_begin_pos + _size <= layout_t::size()) {
+      return {{{_data.data() + _begin_pos, _size}, {}}};
+    }
+
+    std::size_t first = layout_t::size() - _begin_pos;
+    return {{{_data.data() + _begin_pos, first},
+             {_data.data(), _size - first}}};
+  }
   /* ----------------------------------------------------------------------- */
 
   /* Iterator -------------------------------------------------------------- */
@@ -232,16 +393,37 @@ public:
   /* ----------------------------------------------------------------------- */
 
 private:
-  std::size_t                _begin_pos{0};
-  std::size_t                _end_pos{0};
-  std::size_t                _capacity{N};
-  std::size_t                _size{0};
-  std::array<value_t, N + 1> _data{};
+  /* Raw slot access for iterator ------------------------------------------ */
+  reference       slot(std::size_t pos) noexcept { return _data[pos]; }
+  const_reference slot(std::size_t pos) const noexcept { return _data[pos]; }
+
+  static std::size_t next_pos(std::size_t pos) noexcept {
+    return layout_t::next(pos);
+  }
+
+  static std::size_t prev_pos(std::size_t pos) noexcept {
+    return layout_t::prev(pos);
+  }
+  /* ----------------------------------------------------------------------- */
+
+private:
+  std::size_t  _begin_pos{0};
+  std::size_t  _end_pos{0};
+  std::size_t  _capacity{N};
+  std::size_t  _size{0};
+  storage_type _data{};
 };
 
 
+/*!
+ * \brief Alias for a `ringbuffer` using the `masked_indexing` policy.
+ */
 template <typename T, std::size_t N>
-std::ostream & operator<<(std::ostream & os, const ringbuffer<T, N> & rb) {
+using masked_ringbuffer = ringbuffer<T, N, masked_indexing>;
+
+
+template <typename T, std::size_t N, class P>
+std::ostream & operator<<(std::ostream & os, const ringbuffer<T, N, P> & rb) {
   std::ostringstream ss;
   ss << "size: " << rb.size() << ", max_size: " << rb.max_size()
      << ", content: [";
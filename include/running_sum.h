@@ -0,0 +1,135 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_RUNNING_SUM_H_
+#define PIPEBB_RUNNING_SUM_H_
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+
+namespace pipebb {
+namespace detail {
+
+
+/*!
+ * \brief Sum over a sliding window, updated in O(1) per pushed value.
+ * \param T Template parameter specifying the summed value type.
+ *
+ * The windowed gates (`accumulator`, `moving_average`) keep one of these next
+ * to their `ringbuffer`: every value entering the window is added, every value
+ * evicted from it is subtracted. For integral types this is exact and nothing
+ * else is needed.
+ */
+template <typename T, typename = void>
+class running_sum
+{
+  using value_t = T;
+
+public:
+  explicit running_sum(std::size_t = 0) noexcept {}
+
+  void add(value_t value) noexcept { _sum += value; }
+
+  void remove(value_t value) noexcept { _sum -= value; }
+
+  void clear() noexcept { _sum = value_t(); }
+
+  bool stale() const noexcept { return false; }
+
+  template <class S>
+  void assign(const S & segments) noexcept {
+    clear();
+    for (auto & segment : segments) {
+      for (auto value : segment) { _sum += value; }
+    }
+  }
+
+  value_t value() const noexcept { return _sum; }
+
+private:
+  value_t _sum{};
+};
+
+
+/*!
+ * \brief Specialization of `running_sum` for floating point types.
+ *
+ * Adding and subtracting floating point values over billions of ticks lets
+ * rounding errors pile up in the sum. This specialization uses Neumaier's
+ * variant of Kahan summation to carry the lost low-order bits along, and
+ * reports itself as `stale()` after `resync_interval` updates so the owner can
+ * re-sum the window's contiguous segments from scratch via `assign()`. The
+ * error is thus bounded by the window content instead of growing with the
+ * number of ticks.
+ */
+template <typename T>
+class running_sum<T, std::enable_if_t<std::is_floating_point<T>::value>>
+{
+  using value_t = T;
+
+public:
+  explicit running_sum(std::size_t resync_interval = 0) noexcept
+   : _resync_interval(resync_interval) {}
+
+  void add(value_t value) noexcept {
+    value_t sum = _sum + value;
+
+    if (std::fabs(_sum) >= std::fabs(value)) {
+      _compensation += (_sum - sum) + value;
+    } else {
+      _compensation += (value - sum) + _sum;
+    }
+
+    _sum = sum;
+    ++_updates;
+  }
+
+  void remove(value_t value) noexcept { add(-value); }
+
+  void clear() noexcept {
+    _sum          = value_t();
+    _compensation = value_t();
+    _updates      = 0;
+  }
+
+  bool stale() const noexcept {
+    return _resync_interval && _updates >= _resync_interval;
+  }
+
+  template <class S>
+  void assign(const S & segments) noexcept {
+    clear();
+    for (auto & segment : segments) {
+      for (auto value : segment) { add(value); }
+    }
+    _updates = 0;
+  }
+
+  value_t value() const noexcept { return _sum + _compensation; }
+
+private:
+  value_t     _sum{};
+  value_t     _compensation{};
+  std::size_t _updates{0};
+  std::size_t _resync_interval;
+};
+
+}  // namespace detail
+}  // namespace pipebb
+
+#endif  // PIPEBB_RUNNING_SUM_H_
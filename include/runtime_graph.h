@@ -0,0 +1,592 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef PIPEBB_RUNTIME_GRAPH_H_
+#define PIPEBB_RUNTIME_GRAPH_H_
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "approximate.h"
+#include "channel.h"
+#include "gradient.h"
+#include "moving_average.h"
+#include "running_sum.h"
+#include "span.h"
+#include "threshold.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Gate graph built at runtime from a textual description.
+ *
+ * The description holds one node per line, in the form
+ *
+ *     name = kind(argument, ..., key=value, ...)
+ *
+ * where arguments are the names of other nodes or numbers. Everything after
+ * a `#` is a comment. The supported kinds mirror the gates:
+ *
+ * | kind                          | arguments and keys                      |
+ * |-------------------------------|-----------------------------------------|
+ * | `channel`                     | `factor=1`, `offset=0`, `unit=...`      |
+ * | `factor`, `offset`            | input, constant                         |
+ * | `inverter`, `not`, `gradient` | input                                   |
+ * | `threshold`                   | input, limit                            |
+ * | `approximate`                 | first, second, tolerance                |
+ * | `moving_average`              | input, window, `use_zeros=1`            |
+ * | `accumulator`                 | input, window, `use_zeros=1`            |
+ * | `and`, `or`                   | two or more inputs                      |
+ * | `boolean_counter`             | input                                   |
+ * | `reset_counter`               | input                                   |
+ *
+ * Nodes may be listed in any order. The description is compiled into a flat
+ * array of instructions in topological order, with one value slot per node,
+ * and each `run()` evaluates the whole array once in a single loop. Every
+ * node is thus evaluated on every run, as if each gate of the equivalent
+ * template graph were pulled once after `tick()`; logic gates do not short
+ * circuit. All values are stored as `double`, booleans as 0 and 1.
+ * The arithmetic is shared with the template gates, so `gradient` truncates
+ * its input to an integer and window sums use the same compensated
+ * `running_sum`, kept up to date in O(1) and recomputed from the window
+ * every 32 window lengths.
+ *
+ * Malformed descriptions, unknown nodes, keys a kind does not take, keys
+ * given twice and cycles are reported by throwing `std::runtime_error`,
+ * naming the offending line.
+ *
+ * \include runtime_graph.cc
+ */
+class runtime_graph
+{
+public:
+  using value_t = double;
+
+private:
+  enum class opcode : std::uint8_t {
+    channel,
+    factor,
+    offset,
+    inverter,
+    threshold,
+    approximate,
+    gradient,
+    moving_average,
+    accumulator,
+    logical_and,
+    logical_or,
+    logical_not,
+    boolean_counter,
+    reset_counter
+  };
+
+  // operands are value slots; for the logic gates, `first` is the start and
+  // `second` the length of the gate's run in `_operands`
+  struct instruction
+  {
+    opcode        op;
+    std::uint32_t out;
+    std::uint32_t first;
+    std::uint32_t second;
+    std::uint32_t state;
+    value_t       constant;
+    value_t       offset;
+  };
+
+  using sum_t = detail::running_sum<value_t>;
+
+  // window of a moving_average or accumulator, stored in `_history`
+  struct window
+  {
+    std::size_t begin;
+    std::size_t length;
+    std::size_t head;
+    std::size_t count;
+    sum_t       sum;
+    bool        use_zeros;
+  };
+
+  // one parsed line of the description
+  struct declaration
+  {
+    std::size_t                                  line;
+    std::string                                  name;
+    std::string                                  kind;
+    std::vector<std::string>                     arguments;
+    std::unordered_map<std::string, std::string> keys;
+  };
+
+  // arguments and keys a kind takes
+  struct signature_t
+  {
+    int                      nodes;  // -1 for "two or more"
+    int                      numbers;
+    std::vector<std::string> keys;
+  };
+
+  static constexpr std::size_t resync_factor = 32;
+
+public:
+  /*!
+   * \brief  Constructor for `runtime_graph` class.
+   * \param  description Stream to read the graph description from.
+   * \throws std::runtime_error if the description is invalid.
+   */
+  explicit runtime_graph(std::istream & description) {
+    compile(parse(description));
+  }
+
+  /*!
+   * \brief   Get the index of a node, to be used with `set()` and `value()`.
+   * \param   name Name of the node.
+   * \returns Index of the node.
+   * \throws  std::runtime_error if there is no node of that name.
+   */
+  std::size_t index(const std::string & name) const {
+    auto found = _slots.find(name);
+    if (found == _slots.end()) {
+      throw std::runtime_error("unknown node '" + name + "'");
+    }
+    return found->second;
+  }
+
+  /*!
+   * \brief Write a raw value into a channel, see `channel::operator<<`.
+   * \param channel Index of the channel.
+   * \param value Raw value.
+   */
+  void set(std::size_t channel, value_t value) noexcept {
+    _raw[channel] = value;
+  }
+
+  /*!
+   * \brief   Get the value a node had after the last `run()`.
+   * \param   node Index of the node.
+   * \returns Value of the node.
+   */
+  value_t value(std::size_t node) const noexcept { return _values[node]; }
+
+  value_t value(const std::string & name) const { return value(index(name)); }
+
+  /*!
+   * \brief   Get the number of nodes.
+   * \returns Number of nodes, i.e. instructions per run.
+   */
+  std::size_t size() const noexcept { return _program.size(); }
+
+  /*!
+   * \brief Clear the state of all gates; channels keep their raw values.
+   */
+  void reset() noexcept {
+    for (auto & v : _values) { v = value_t(); }
+    for (auto & s : _state) { s = value_t(); }
+    for (auto & h : _history) { h = value_t(); }
+    for (auto & w : _windows) {
+      w.head = w.count = 0;
+      w.sum.clear();
+    }
+  }
+
+  /*!
+   * \brief Evaluate every node once, in topological order.
+   */
+  void run() noexcept {
+    value_t * values = _values.data();
+
+    for (const auto & ins : _program) {
+      value_t & out = values[ins.out];
+
+      switch (ins.op) {
+      case opcode::channel:
+        out = detail::normalize(_raw[ins.first], ins.offset, ins.constant);
+        break;
+      case opcode::factor: out = values[ins.first] * ins.constant; break;
+      case opcode::offset: out = values[ins.first] + ins.constant; break;
+      case opcode::inverter: out = -values[ins.first]; break;
+      case opcode::threshold:
+        out = detail::exceeds(values[ins.first], ins.constant);
+        break;
+      case opcode::approximate:
+        out = detail::within_tolerance(
+          values[ins.first], values[ins.second], ins.constant);
+        break;
+      case opcode::gradient: {
+        value_t & previous = _state[ins.state];
+        value_t   current  = detail::gradient_point(values[ins.first]);
+        out                = current - previous;
+        previous = current;
+        break;
+      }
+      case opcode::moving_average:
+        out = detail::average(push(_windows[ins.state], values[ins.first]),
+                              _windows[ins.state].length);
+        break;
+      case opcode::accumulator:
+        out = push(_windows[ins.state], values[ins.first]);
+        break;
+      case opcode::logical_and: {
+        bool result = true;
+        for (std::uint32_t i = 0; i < ins.second; ++i) {
+          result = result && values[_operands[ins.first + i]] != 0;
+        }
+        out = result;
+        break;
+      }
+      case opcode::logical_or: {
+        bool result = false;
+        for (std::uint32_t i = 0; i < ins.second; ++i) {
+          result = result || values[_operands[ins.first + i]] != 0;
+        }
+        out = result;
+        break;
+      }
+      case opcode::logical_not: out = values[ins.first] == 0; break;
+      case opcode::boolean_counter:
+        out += values[ins.first] != 0;
+        break;
+      case opcode::reset_counter:
+        out = values[ins.first] != 0 ? 0 : out + 1;
+        break;
+      }
+    }
+  }
+
+private:
+  // same steps as moving_average::push(), see detail::running_sum
+  value_t push(window & w, value_t value) noexcept {
+    if (value == 0 && !w.use_zeros) { return w.sum.value(); }
+
+    value_t & slot = _history[w.begin + w.head];
+
+    if (w.count == w.length) {
+      w.sum.remove(slot);
+    } else {
+      ++w.count;
+    }
+    w.sum.add(value);
+
+    slot   = value;
+    w.head = (w.head + 1) % w.length;
+
+    if (w.sum.stale()) {
+      span<const value_t> segments[] = {{&_history[w.begin], w.length}};
+      w.sum.assign(segments);
+    }
+
+    return w.sum.value();
+  }
+
+  [[noreturn]] static void fail(std::size_t line, const std::string & what) {
+    throw std::runtime_error("line " + std::to_string(line) + ": " + what);
+  }
+
+  static std::string trim(const std::string & text) {
+    std::size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) { return ""; }
+
+    std::size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+  }
+
+  static bool is_name(const std::string & text) {
+    if (text.empty() || std::isdigit(static_cast<unsigned char>(text[0]))) {
+      return false;
+    }
+    for (char c : text) {
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static value_t number(const declaration & decl, const std::string & text) {
+    const char * begin = text.c_str();
+    char *       end   = nullptr;
+
+    value_t result = std::strtod(begin, &end);
+    if (text.empty() || end != begin + text.size()) {
+      fail(decl.line, "expected a number, got '" + text + "'");
+    }
+    return result;
+  }
+
+  static std::vector<declaration> parse(std::istream & description) {
+    std::vector<declaration> decls;
+    std::string              text;
+
+    for (std::size_t line = 1; std::getline(description, text); ++line) {
+      text = trim(text.substr(0, text.find('#')));
+      if (text.empty()) { continue; }
+
+      declaration decl{line, "", "", {}, {}};
+
+      std::size_t equals = text.find('=');
+      std::size_t open   = text.find('(');
+      std::size_t close  = text.rfind(')');
+
+      if (equals == std::string::npos || open == std::string::npos ||
+          close == std::string::npos || open < equals || close < open ||
+          !trim(text.substr(close + 1)).empty()) {
+        fail(line, "expected 'name = kind(arguments)'");
+      }
+
+      decl.name = trim(text.substr(0, equals));
+      decl.kind = trim(text.substr(equals + 1, open - equals - 1));
+      if (!is_name(decl.name)) {
+        fail(line, "invalid name '" + decl.name + "'");
+      }
+
+      std::istringstream arguments(text.substr(open + 1, close - open - 1));
+      std::string        argument;
+      while (std::getline(arguments, argument, ',')) {
+        argument = trim(argument);
+
+        std::size_t key = argument.find('=');
+        if (key != std::string::npos) {
+          std::string name  = trim(argument.substr(0, key));
+          std::string value = trim(argument.substr(key + 1));
+
+          if (!is_name(name)) { fail(line, "invalid key '" + name + "'"); }
+          if (!decl.keys.emplace(name, value).second) {
+            fail(line, "duplicate key '" + name + "'");
+          }
+        } else if (!argument.empty()) {
+          decl.arguments.push_back(argument);
+        } else {
+          fail(line, "empty argument");
+        }
+      }
+
+      decls.push_back(std::move(decl));
+    }
+
+    return decls;
+  }
+
+  // looks up the kind of a declaration and checks its keys
+  static const signature_t & signature(const declaration & decl) {
+    static const std::unordered_map<std::string, signature_t> table{
+      {"channel", {0, 0, {"factor", "offset", "unit"}}},
+      {"factor", {1, 1, {}}},
+      {"offset", {1, 1, {}}},
+      {"inverter", {1, 0, {}}},
+      {"threshold", {1, 1, {}}},
+      {"approximate", {2, 1, {}}},
+      {"gradient", {1, 0, {}}},
+      {"moving_average", {1, 1, {"use_zeros"}}},
+      {"accumulator", {1, 1, {"use_zeros"}}},
+      {"and", {-1, 0, {}}},
+      {"or", {-1, 0, {}}},
+      {"not", {1, 0, {}}},
+      {"boolean_counter", {1, 0, {}}},
+      {"reset_counter", {1, 0, {}}}};
+
+    auto found = table.find(decl.kind);
+    if (found == table.end()) {
+      fail(decl.line, "unknown kind '" + decl.kind + "'");
+    }
+
+    auto & keys = found->second.keys;
+    for (auto & key : decl.keys) {
+      if (std::find(keys.begin(), keys.end(), key.first) == keys.end()) {
+        fail(decl.line,
+             "unknown key '" + key.first + "' for '" + decl.kind + "'");
+      }
+    }
+    return found->second;
+  }
+
+  void compile(const std::vector<declaration> & decls) {
+    for (std::size_t d = 0; d < decls.size(); ++d) {
+      if (!_slots.emplace(decls[d].name, d).second) {
+        fail(decls[d].line, "duplicate node '" + decls[d].name + "'");
+      }
+    }
+
+    // resolve inputs, then order the nodes so inputs come first (Kahn)
+    std::vector<std::vector<std::size_t>> inputs(decls.size());
+    std::vector<std::vector<std::size_t>> dependents(decls.size());
+    std::vector<std::size_t>              pending(decls.size());
+
+    for (std::size_t d = 0; d < decls.size(); ++d) {
+      auto & decl = decls[d];
+      auto & sig  = signature(decl);
+
+      std::size_t nodes = sig.nodes < 0 ? decl.arguments.size()
+                                        : static_cast<std::size_t>(sig.nodes);
+      if (decl.arguments.size() != nodes + sig.numbers ||
+          (sig.nodes < 0 && nodes < 2)) {
+        fail(decl.line, "wrong number of arguments for '" + decl.kind + "'");
+      }
+
+      for (std::size_t a = 0; a < nodes; ++a) {
+        auto found = _slots.find(decl.arguments[a]);
+        if (found == _slots.end()) {
+          fail(decl.line, "unknown node '" + decl.arguments[a] + "'");
+        }
+        inputs[d].push_back(found->second);
+        dependents[found->second].push_back(d);
+      }
+      pending[d] = inputs[d].size();
+    }
+
+    std::vector<std::size_t> order;
+    for (std::size_t d = 0; d < decls.size(); ++d) {
+      if (!pending[d]) { order.push_back(d); }
+    }
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      for (auto next : dependents[order[i]]) {
+        if (!--pending[next]) { order.push_back(next); }
+      }
+    }
+
+    if (order.size() != decls.size()) {
+      for (std::size_t d = 0; d < decls.size(); ++d) {
+        if (pending[d]) {
+          fail(decls[d].line, "'" + decls[d].name + "' is part of a cycle");
+        }
+      }
+    }
+
+    // slots follow the evaluation order, so a run walks its values in order
+    std::vector<std::uint32_t> slot(decls.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      slot[order[i]]              = static_cast<std::uint32_t>(i);
+      _slots[decls[order[i]].name] = i;
+    }
+
+    _values.assign(decls.size(), value_t());
+    _raw.assign(decls.size(), value_t());
+
+    for (auto d : order) {
+      std::vector<std::uint32_t> in;
+      for (auto i : inputs[d]) { in.push_back(slot[i]); }
+
+      _program.push_back(translate(decls[d], slot[d], in));
+    }
+  }
+
+  instruction translate(const declaration &                decl,
+                        std::uint32_t                      out,
+                        const std::vector<std::uint32_t> & in) {
+    instruction ins{opcode::channel, out, 0, 0, 0, value_t(1), value_t()};
+    if (!in.empty()) { ins.first = in[0]; }
+    if (in.size() > 1) { ins.second = in[1]; }
+
+    auto constant = [&] { return number(decl, decl.arguments[in.size()]); };
+    auto key      = [&](const std::string & name, value_t fallback) {
+      auto found = decl.keys.find(name);
+      return found == decl.keys.end() ? fallback : number(decl, found->second);
+    };
+
+    const std::string & kind = decl.kind;
+
+    if (kind == "channel") {
+      ins.first    = out;
+      ins.constant = key("factor", 1);
+      ins.offset   = key("offset", 0);
+    } else if (kind == "factor") {
+      ins.op       = opcode::factor;
+      ins.constant = constant();
+    } else if (kind == "offset") {
+      ins.op       = opcode::offset;
+      ins.constant = constant();
+    } else if (kind == "inverter") {
+      ins.op = opcode::inverter;
+    } else if (kind == "threshold") {
+      ins.op       = opcode::threshold;
+      ins.constant = constant();
+    } else if (kind == "approximate") {
+      ins.op       = opcode::approximate;
+      ins.constant = constant();
+    } else if (kind == "gradient") {
+      ins.op    = opcode::gradient;
+      ins.state = static_cast<std::uint32_t>(_state.size());
+      _state.push_back(value_t());
+    } else if (kind == "moving_average" || kind == "accumulator") {
+      value_t length = constant();
+      if (length < 1 || length != static_cast<std::size_t>(length)) {
+        fail(decl.line, "window must be a positive integer");
+      }
+
+      std::size_t width = static_cast<std::size_t>(length);
+
+      ins.op    = kind == "accumulator" ? opcode::accumulator
+                                        : opcode::moving_average;
+      ins.state = static_cast<std::uint32_t>(_windows.size());
+      _windows.push_back({_history.size(),
+                          width,
+                          0,
+                          0,
+                          sum_t(resync_factor * width),
+                          key("use_zeros", 1) != 0});
+      _history.resize(_history.size() + width);
+    } else if (kind == "and" || kind == "or") {
+      ins.op     = kind == "and" ? opcode::logical_and : opcode::logical_or;
+      ins.first  = static_cast<std::uint32_t>(_operands.size());
+      ins.second = static_cast<std::uint32_t>(in.size());
+      _operands.insert(_operands.end(), in.begin(), in.end());
+    } else if (kind == "not") {
+      ins.op = opcode::logical_not;
+    } else if (kind == "boolean_counter") {
+      ins.op = opcode::boolean_counter;
+    } else if (kind == "reset_counter") {
+      ins.op = opcode::reset_counter;
+    }
+
+    return ins;
+  }
+
+private:
+  std::vector<instruction>                     _program;
+  std::vector<value_t>                         _values;
+  std::vector<value_t>                         _raw;
+  std::vector<value_t>                         _state;
+  std::vector<window>                          _windows;
+  std::vector<value_t>                         _history;
+  std::vector<std::uint32_t>                   _operands;
+  std::unordered_map<std::string, std::size_t> _slots;
+};
+
+
+/*!
+ * \brief  Maker function to build a `runtime_graph` from a string.
+ * \param  description Graph description, see `runtime_graph`.
+ * \return Ready to use `runtime_graph` object.
+ * \throws std::runtime_error if the description is invalid.
+ */
+inline runtime_graph make_runtime_graph(const std::string & description) {
+  std::istringstream stream(description);
+  return runtime_graph{stream};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_RUNTIME_GRAPH_H_
@@ -0,0 +1,465 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_SIMD_H_
+#define PIPEBB_SIMD_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && !defined(__clang__) && \
+  (defined(__x86_64__) || defined(__i386__))
+#define PIPEBB_SIMD_X86 1
+#include "simd_avx2.h"
+#include "simd_avx512.h"
+#endif
+
+
+namespace pipebb {
+
+
+/*!
+ * \namespace pipebb::simd
+ * \brief Explicitly vectorized block kernels behind the gates' `process()`.
+ *
+ * The kernels operate on plain arrays of `float`, `double`, `std::int32_t`
+ * or `std::int64_t`. On x86 with GCC, each call dispatches at runtime to an
+ * AVX-512 or AVX2 implementation, depending on what the CPU supports; the
+ * remainder that doesn't fill a whole vector, other element types and other
+ * platforms use the scalar implementation. All implementations produce the
+ * same results as the scalar gates, bit for bit.
+ *
+ * Kernels producing boolean results write packed bitmasks: element `i` maps
+ * to bit `i % 64` of `mask[i / 64]`, and unused bits of the last word are
+ * zero. See `mask_words()` and `test()`.
+ */
+namespace simd {
+
+
+/*!
+ * \brief Instruction sets the kernels are implemented for.
+ */
+enum class isa { scalar, avx2, avx512 };
+
+
+namespace detail {
+
+
+inline isa detect() noexcept {
+#ifdef PIPEBB_SIMD_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f") &&
+      __builtin_cpu_supports("avx512dq")) {
+    return isa::avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) { return isa::avx2; }
+#endif
+
+  return isa::scalar;
+}
+
+inline isa & selected() noexcept {
+  static isa selected = detect();
+  return selected;
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief   Get the best instruction set supported by the CPU.
+ * \returns Best supported instruction set.
+ */
+inline isa detected_isa() noexcept {
+  static const isa detected = detail::detect();
+  return detected;
+}
+
+
+/*!
+ * \brief   Get the instruction set the kernels currently dispatch to.
+ * \returns Instruction set in use; the detected one unless overridden.
+ */
+inline isa active_isa() noexcept {
+  return detail::selected();
+}
+
+
+/*!
+ * \brief   Restrict the kernels to an instruction set, e.g. for testing or
+ *          benchmarking.
+ * \param   requested Instruction set to use.
+ * \returns Instruction set in use, i.e. `requested` or the detected one if
+ *          the CPU does not support `requested`.
+ *
+ * This is a process wide setting; change it before starting any pipelines.
+ */
+inline isa select_isa(isa requested) noexcept {
+  detail::selected() = std::min(requested, detected_isa());
+  return active_isa();
+}
+
+
+/*!
+ * \brief   Number of 64 bit words needed for a bitmask of `n` elements.
+ */
+constexpr std::size_t mask_words(std::size_t n) noexcept {
+  return (n + 63) / 64;
+}
+
+
+/*!
+ * \brief   Read element `i` of a packed bitmask.
+ */
+inline bool test(const std::uint64_t * mask, std::size_t i) noexcept {
+  return (mask[i / 64] >> (i % 64)) & 1;
+}
+
+
+namespace detail {
+
+
+template <typename T>
+using vectorizable =
+  std::integral_constant<bool,
+                         std::is_same<T, float>::value ||
+                           std::is_same<T, double>::value ||
+                           std::is_same<T, std::int32_t>::value ||
+                           std::is_same<T, std::int64_t>::value>;
+
+
+// number of partial sums of simd::dot; one 64 byte vector worth of elements
+template <typename T>
+constexpr std::size_t dot_lanes() noexcept {
+  return 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1;
+}
+
+
+//
+// scalar reference implementations; they process all n elements and start
+// at a mask word boundary, so they also finish what the vector kernels leave
+//
+struct scalar_kernels
+{
+  template <typename T>
+  static void scale(const T * in, T factor, T * out, std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) { out[i] = in[i] * factor; }
+  }
+
+  template <typename T>
+  static void shift(const T * in, T offset, T * out, std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) { out[i] = in[i] + offset; }
+  }
+
+  template <typename T>
+  static void negate(const T * in, T * out, std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) { out[i] = -in[i]; }
+  }
+
+  template <typename T>
+  static void
+  affine(const T * in, T factor, T offset, T * out, std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) { out[i] = in[i] * factor + offset; }
+  }
+
+  template <typename T>
+  static void
+  pass_greater(const T * in, T limit, T * out, std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = in[i] > limit ? in[i] : T{};
+    }
+  }
+
+  template <class P>
+  static void pack(P && predicate, std::uint64_t * mask, std::size_t n) {
+    for (std::size_t w = 0; w < mask_words(n); ++w) {
+      std::size_t   count = std::min<std::size_t>(64, n - w * 64);
+      std::uint64_t bits  = 0;
+      for (std::size_t b = 0; b < count; ++b) {
+        bits |= static_cast<std::uint64_t>(predicate(w * 64 + b)) << b;
+      }
+      mask[w] = bits;
+    }
+  }
+
+  template <typename T>
+  static void greater(const T *       in,
+                      T               limit,
+                      std::uint64_t * mask,
+                      std::size_t     n) noexcept {
+    pack([&](std::size_t i) { return in[i] > limit; }, mask, n);
+  }
+
+  template <typename A, typename B, typename T>
+  static void within(const A *       first,
+                     const B *       second,
+                     T               tolerance,
+                     std::uint64_t * mask,
+                     std::size_t     n) noexcept {
+    pack(
+      [&](std::size_t i) {
+        return (first[i] > second[i] ? first[i] - second[i]
+                                     : second[i] - first[i]) <=
+               tolerance;
+      },
+      mask,
+      n);
+  }
+
+  template <typename T>
+  static void affine_greater(const T *       in,
+                             T               factor,
+                             T               offset,
+                             T               limit,
+                             std::uint64_t * mask,
+                             std::size_t     n) noexcept {
+    pack([&](std::size_t i) { return in[i] * factor + offset > limit; },
+         mask,
+         n);
+  }
+
+  // accumulates whole groups of dot_lanes() elements only
+  template <typename T>
+  static std::size_t
+  dot(const T * a, const T * b, T * acc, std::size_t n) noexcept {
+    constexpr std::size_t lanes = dot_lanes<T>();
+
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      for (std::size_t l = 0; l < lanes; ++l) {
+        acc[l] += a[i + l] * b[i + l];
+      }
+    }
+    return i;
+  }
+};
+
+
+//
+// hands the kernel set of the active instruction set to `kernel`, which runs
+// the vector part and returns the number of elements it processed
+//
+template <class F>
+inline std::size_t dispatch(std::true_type, F && kernel) noexcept {
+#ifdef PIPEBB_SIMD_X86
+  switch (active_isa()) {
+    case isa::avx512: return kernel(avx512_kernels{});
+    case isa::avx2: return kernel(avx2_kernels{});
+    case isa::scalar: break;
+  }
+#else
+  (void)kernel;
+#endif
+
+  return 0;
+}
+
+template <class F>
+inline std::size_t dispatch(std::false_type, F &&) noexcept {
+  return 0;
+}
+
+}  // namespace detail
+
+
+/*!
+ * \brief Multiply each element by a constant: `out[i] = in[i] * factor`.
+ *
+ * Vector kernel of the `factor` gate. `in` and `out` may be the same array.
+ */
+template <typename T>
+inline void scale(const T * in, T factor, T * out, std::size_t n) noexcept {
+  std::size_t done = detail::dispatch(
+    detail::vectorizable<T>{},
+    [&](auto k) { return decltype(k)::scale(in, factor, out, n); });
+
+  detail::scalar_kernels::scale(in + done, factor, out + done, n - done);
+}
+
+
+/*!
+ * \brief Add a constant to each element: `out[i] = in[i] + offset`.
+ *
+ * Vector kernel of the `offset` gate. `in` and `out` may be the same array.
+ */
+template <typename T>
+inline void shift(const T * in, T offset, T * out, std::size_t n) noexcept {
+  std::size_t done = detail::dispatch(
+    detail::vectorizable<T>{},
+    [&](auto k) { return decltype(k)::shift(in, offset, out, n); });
+
+  detail::scalar_kernels::shift(in + done, offset, out + done, n - done);
+}
+
+
+/*!
+ * \brief Negate each element: `out[i] = -in[i]`.
+ *
+ * Vector kernel of the `inverter` gate. `in` and `out` may be the same array.
+ */
+template <typename T>
+inline void negate(const T * in, T * out, std::size_t n) noexcept {
+  std::size_t done =
+    detail::dispatch(detail::vectorizable<T>{}, [&](auto k) {
+      return decltype(k)::negate(in, out, n);
+    });
+
+  detail::scalar_kernels::negate(in + done, out + done, n - done);
+}
+
+
+/*!
+ * \brief Multiply, then add: `out[i] = in[i] * factor + offset`.
+ *
+ * A `factor` feeding an `offset`, fused into a single pass. The product is
+ * rounded before the addition, exactly as with the two gates.
+ */
+template <typename T>
+inline void
+affine(const T * in, T factor, T offset, T * out, std::size_t n) noexcept {
+  std::size_t done = detail::dispatch(
+    detail::vectorizable<T>{},
+    [&](auto k) { return decltype(k)::affine(in, factor, offset, out, n); });
+
+  detail::scalar_kernels::affine(
+    in + done, factor, offset, out + done, n - done);
+}
+
+
+/*!
+ * \brief Keep elements above a limit, zero the others:
+ *        `out[i] = in[i] > limit ? in[i] : 0`.
+ *
+ * Vector kernel of the `threshold_pass_through` gate.
+ */
+template <typename T>
+inline void
+pass_greater(const T * in, T limit, T * out, std::size_t n) noexcept {
+  std::size_t done = detail::dispatch(
+    detail::vectorizable<T>{},
+    [&](auto k) { return decltype(k)::pass_greater(in, limit, out, n); });
+
+  detail::scalar_kernels::pass_greater(in + done, limit, out + done, n - done);
+}
+
+
+/*!
+ * \brief Compare each element against a limit: bit `i` is `in[i] > limit`.
+ *
+ * Vector kernel of the `threshold` gate. `mask` must hold `mask_words(n)`
+ * words.
+ */
+template <typename T>
+inline void
+greater(const T * in, T limit, std::uint64_t * mask, std::size_t n) noexcept {
+  std::size_t done = detail::dispatch(
+    detail::vectorizable<T>{},
+    [&](auto k) { return decltype(k)::greater(in, limit, mask, n); });
+
+  detail::scalar_kernels::greater(
+    in + done, limit, mask + done / 64, n - done);
+}
+
+
+/*!
+ * \brief Compare two arrays element-wise: bit `i` is set if `first[i]` and
+ *        `second[i]` are at most `tolerance` apart.
+ *
+ * Vector kernel of the `approximate` gate; vectorized if all three types are
+ * the same. `mask` must hold `mask_words(n)` words.
+ */
+template <typename A, typename B, typename T>
+inline void within(const A *       first,
+                   const B *       second,
+                   T               tolerance,
+                   std::uint64_t * mask,
+                   std::size_t     n) noexcept {
+  using same_t = std::integral_constant<bool,
+                                        std::is_same<A, B>::value &&
+                                          std::is_same<A, T>::value &&
+                                          detail::vectorizable<T>::value>;
+
+  std::size_t done = detail::dispatch(same_t{}, [&](auto k) {
+    return decltype(k)::within(first, second, tolerance, mask, n);
+  });
+
+  detail::scalar_kernels::within(
+    first + done, second + done, tolerance, mask + done / 64, n - done);
+}
+
+
+/*!
+ * \brief Multiply, add, then compare against a limit: bit `i` is
+ *        `in[i] * factor + offset > limit`.
+ *
+ * A `factor` feeding an `offset` feeding a `threshold`, fused into a single
+ * pass without intermediate arrays. `mask` must hold `mask_words(n)` words.
+ */
+template <typename T>
+inline void affine_greater(const T *       in,
+                           T               factor,
+                           T               offset,
+                           T               limit,
+                           std::uint64_t * mask,
+                           std::size_t     n) noexcept {
+  std::size_t done = detail::dispatch(
+    detail::vectorizable<T>{}, [&](auto k) {
+      return decltype(k)::affine_greater(in, factor, offset, limit, mask, n);
+    });
+
+  detail::scalar_kernels::affine_greater(
+    in + done, factor, offset, limit, mask + done / 64, n - done);
+}
+
+
+/*!
+ * \brief   Dot product of two arrays: `sum_i a[i] * b[i]`.
+ * \returns The sum.
+ *
+ * Vector kernel of the `fir` gate. To give the same result on every
+ * instruction set, the summation order is fixed: element `i` of the leading
+ * whole groups of 64 bytes is added to partial sum `i % (64 / sizeof(T))`,
+ * the partial sums are then added pairwise, and the remaining elements one by
+ * one. Products are rounded before they are added, no fused multiply-add is
+ * used.
+ */
+template <typename T>
+inline T dot(const T * a, const T * b, std::size_t n) noexcept {
+  constexpr std::size_t lanes = detail::dot_lanes<T>();
+
+  T acc[lanes] = {};
+
+  std::size_t done = detail::dispatch(
+    detail::vectorizable<T>{},
+    [&](auto k) { return decltype(k)::dot(a, b, acc, n); });
+  done += detail::scalar_kernels::dot(a + done, b + done, acc, n - done);
+
+  for (std::size_t half = lanes / 2; half > 0; half /= 2) {
+    for (std::size_t l = 0; l < half; ++l) { acc[l] += acc[l + half]; }
+  }
+
+  T sum = acc[0];
+  for (std::size_t i = done; i < n; ++i) { sum += a[i] * b[i]; }
+  return sum;
+}
+
+}  // namespace simd
+}  // namespace pipebb
+
+#endif  // PIPEBB_SIMD_H_
@@ -0,0 +1,371 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_SIMD_AVX2_H_
+#define PIPEBB_SIMD_AVX2_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <immintrin.h>
+
+//
+// everything defined up to the matching pop_options is compiled for AVX2,
+// independent of the flags the including translation unit is compiled with;
+// it must only be called after checking for AVX2 support at runtime
+//
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+
+namespace pipebb {
+namespace simd {
+namespace detail {
+
+
+/*!
+ * \brief Per-type AVX2 vector operations used by `avx2_kernels`.
+ * \param T Template parameter specifying the element type.
+ *
+ * Comparisons return one bit per lane, lane 0 in the least significant bit.
+ */
+template <typename T>
+struct avx2_traits;
+
+template <>
+struct avx2_traits<double>
+{
+  using reg_t = __m256d;
+
+  static constexpr std::size_t width = 4;
+
+  static reg_t load(const double * p) { return _mm256_loadu_pd(p); }
+  static void  store(double * p, reg_t v) { _mm256_storeu_pd(p, v); }
+  static reg_t set1(double v) { return _mm256_set1_pd(v); }
+
+  static reg_t add(reg_t a, reg_t b) { return _mm256_add_pd(a, b); }
+  static reg_t mul(reg_t a, reg_t b) { return _mm256_mul_pd(a, b); }
+  static reg_t neg(reg_t a) { return _mm256_xor_pd(a, set1(-0.0)); }
+
+  static std::uint64_t gt(reg_t a, reg_t b) {
+    return static_cast<unsigned>(
+      _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ)));
+  }
+
+  static reg_t pass_gt(reg_t a, reg_t b) {
+    return _mm256_and_pd(a, _mm256_cmp_pd(a, b, _CMP_GT_OQ));
+  }
+
+  static std::uint64_t within(reg_t a, reg_t b, reg_t tolerance) {
+    reg_t distance = _mm256_andnot_pd(set1(-0.0), _mm256_sub_pd(a, b));
+    return static_cast<unsigned>(_mm256_movemask_pd(
+      _mm256_cmp_pd(distance, tolerance, _CMP_LE_OQ)));
+  }
+};
+
+template <>
+struct avx2_traits<float>
+{
+  using reg_t = __m256;
+
+  static constexpr std::size_t width = 8;
+
+  static reg_t load(const float * p) { return _mm256_loadu_ps(p); }
+  static void  store(float * p, reg_t v) { _mm256_storeu_ps(p, v); }
+  static reg_t set1(float v) { return _mm256_set1_ps(v); }
+
+  static reg_t add(reg_t a, reg_t b) { return _mm256_add_ps(a, b); }
+  static reg_t mul(reg_t a, reg_t b) { return _mm256_mul_ps(a, b); }
+  static reg_t neg(reg_t a) { return _mm256_xor_ps(a, set1(-0.0f)); }
+
+  static std::uint64_t gt(reg_t a, reg_t b) {
+    return static_cast<unsigned>(
+      _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)));
+  }
+
+  static reg_t pass_gt(reg_t a, reg_t b) {
+    return _mm256_and_ps(a, _mm256_cmp_ps(a, b, _CMP_GT_OQ));
+  }
+
+  static std::uint64_t within(reg_t a, reg_t b, reg_t tolerance) {
+    reg_t distance = _mm256_andnot_ps(set1(-0.0f), _mm256_sub_ps(a, b));
+    return static_cast<unsigned>(_mm256_movemask_ps(
+      _mm256_cmp_ps(distance, tolerance, _CMP_LE_OQ)));
+  }
+};
+
+template <>
+struct avx2_traits<std::int32_t>
+{
+  using reg_t = __m256i;
+
+  static constexpr std::size_t width = 8;
+
+  static reg_t load(const std::int32_t * p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static void store(std::int32_t * p, reg_t v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+  static reg_t set1(std::int32_t v) { return _mm256_set1_epi32(v); }
+
+  static reg_t add(reg_t a, reg_t b) { return _mm256_add_epi32(a, b); }
+  static reg_t mul(reg_t a, reg_t b) { return _mm256_mullo_epi32(a, b); }
+  static reg_t neg(reg_t a) {
+    return _mm256_sub_epi32(_mm256_setzero_si256(), a);
+  }
+
+  static std::uint64_t gt(reg_t a, reg_t b) {
+    return static_cast<unsigned>(
+      _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b))));
+  }
+
+  static reg_t pass_gt(reg_t a, reg_t b) {
+    return _mm256_and_si256(a, _mm256_cmpgt_epi32(a, b));
+  }
+
+  // larger minus smaller, like approximate::operator()
+  static std::uint64_t within(reg_t a, reg_t b, reg_t tolerance) {
+    reg_t distance =
+      _mm256_sub_epi32(_mm256_max_epi32(a, b), _mm256_min_epi32(a, b));
+    return ~gt(distance, tolerance) & 0xff;
+  }
+};
+
+template <>
+struct avx2_traits<std::int64_t>
+{
+  using reg_t = __m256i;
+
+  static constexpr std::size_t width = 4;
+
+  static reg_t load(const std::int64_t * p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static void store(std::int64_t * p, reg_t v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+  static reg_t set1(std::int64_t v) {
+    return _mm256_set1_epi64x(static_cast<long long>(v));
+  }
+
+  static reg_t add(reg_t a, reg_t b) { return _mm256_add_epi64(a, b); }
+
+  // AVX2 has no 64 bit multiplication; assemble it from 32 bit halves
+  static reg_t mul(reg_t a, reg_t b) {
+    reg_t low   = _mm256_mul_epu32(a, b);
+    reg_t cross = _mm256_add_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+      _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+  }
+
+  static reg_t neg(reg_t a) {
+    return _mm256_sub_epi64(_mm256_setzero_si256(), a);
+  }
+
+  static std::uint64_t gt(reg_t a, reg_t b) {
+    return static_cast<unsigned>(
+      _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, b))));
+  }
+
+  static reg_t pass_gt(reg_t a, reg_t b) {
+    return _mm256_and_si256(a, _mm256_cmpgt_epi64(a, b));
+  }
+
+  // larger minus smaller, like approximate::operator()
+  static std::uint64_t within(reg_t a, reg_t b, reg_t tolerance) {
+    reg_t greater  = _mm256_cmpgt_epi64(a, b);
+    reg_t distance = _mm256_sub_epi64(_mm256_blendv_epi8(b, a, greater),
+                                      _mm256_blendv_epi8(a, b, greater));
+    return ~gt(distance, tolerance) & 0xf;
+  }
+};
+
+
+/*!
+ * \brief AVX2 block kernels, see `simd.h` for their semantics.
+ *
+ * Each kernel only processes the leading part of the data filling whole
+ * vectors (whole 64 bit mask words for the kernels producing bitmasks) and
+ * returns the number of elements it processed; the caller finishes the rest.
+ */
+struct avx2_kernels
+{
+  template <typename T>
+  static std::size_t
+  scale(const T * in, T factor, T * out, std::size_t n) noexcept {
+    using v = avx2_traits<T>;
+
+    auto        f = v::set1(factor);
+    std::size_t i = 0;
+    for (; i + v::width <= n; i += v::width) {
+      v::store(out + i, v::mul(v::load(in + i), f));
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t
+  shift(const T * in, T offset, T * out, std::size_t n) noexcept {
+    using v = avx2_traits<T>;
+
+    auto        o = v::set1(offset);
+    std::size_t i = 0;
+    for (; i + v::width <= n; i += v::width) {
+      v::store(out + i, v::add(v::load(in + i), o));
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t negate(const T * in, T * out, std::size_t n) noexcept {
+    using v = avx2_traits<T>;
+
+    std::size_t i = 0;
+    for (; i + v::width <= n; i += v::width) {
+      v::store(out + i, v::neg(v::load(in + i)));
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t
+  affine(const T * in, T factor, T offset, T * out, std::size_t n) noexcept {
+    using v = avx2_traits<T>;
+
+    auto        f = v::set1(factor);
+    auto        o = v::set1(offset);
+    std::size_t i = 0;
+    for (; i + v::width <= n; i += v::width) {
+      v::store(out + i, v::add(v::mul(v::load(in + i), f), o));
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t
+  pass_greater(const T * in, T limit, T * out, std::size_t n) noexcept {
+    using v = avx2_traits<T>;
+
+    auto        l = v::set1(limit);
+    std::size_t i = 0;
+    for (; i + v::width <= n; i += v::width) {
+      v::store(out + i, v::pass_gt(v::load(in + i), l));
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t greater(const T *       in,
+                             T               limit,
+                             std::uint64_t * mask,
+                             std::size_t     n) noexcept {
+    using v = avx2_traits<T>;
+
+    auto        l = v::set1(limit);
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+      std::uint64_t bits = 0;
+      for (std::size_t j = 0; j < 64; j += v::width) {
+        bits |= v::gt(v::load(in + i + j), l) << j;
+      }
+      mask[i / 64] = bits;
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t within(const T *       first,
+                            const T *       second,
+                            T               tolerance,
+                            std::uint64_t * mask,
+                            std::size_t     n) noexcept {
+    using v = avx2_traits<T>;
+
+    auto        t = v::set1(tolerance);
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+      std::uint64_t bits = 0;
+      for (std::size_t j = 0; j < 64; j += v::width) {
+        std::uint64_t lanes =
+          v::within(v::load(first + i + j), v::load(second + i + j), t);
+        bits |= lanes << j;
+      }
+      mask[i / 64] = bits;
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t affine_greater(const T *       in,
+                                    T               factor,
+                                    T               offset,
+                                    T               limit,
+                                    std::uint64_t * mask,
+                                    std::size_t     n) noexcept {
+    using v = avx2_traits<T>;
+
+    auto        f = v::set1(factor);
+    auto        o = v::set1(offset);
+    auto        l = v::set1(limit);
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+      std::uint64_t bits = 0;
+      for (std::size_t j = 0; j < 64; j += v::width) {
+        bits |= v::gt(v::add(v::mul(v::load(in + i + j), f), o), l) << j;
+      }
+      mask[i / 64] = bits;
+    }
+    return i;
+  }
+
+  template <typename T>
+  static std::size_t
+  dot(const T * a, const T * b, T * acc, std::size_t n) noexcept {
+    using v = avx2_traits<T>;
+
+    // the partial sums span 64 bytes, see simd::dot
+    constexpr std::size_t regs  = 64 / sizeof(T) / v::width;
+    constexpr std::size_t lanes = regs * v::width;
+
+    typename v::reg_t sum[regs];
+    for (std::size_t r = 0; r < regs; ++r) {
+      sum[r] = v::load(acc + r * v::width);
+    }
+
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      for (std::size_t r = 0; r < regs; ++r) {
+        std::size_t j = i + r * v::width;
+        sum[r]        = v::add(sum[r], v::mul(v::load(a + j), v::load(b + j)));
+      }
+    }
+
+    for (std::size_t r = 0; r < regs; ++r) {
+      v::store(acc + r * v::width, sum[r]);
+    }
+    return i;
+  }
+};
+
+}  // namespace detail
+}  // namespace simd
+}  // namespace pipebb
+
+#pragma GCC pop_options
+
+#endif  // PIPEBB_SIMD_AVX2_H_
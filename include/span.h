@@ -0,0 +1,146 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_SPAN_H_
+#define PIPEBB_SPAN_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "utils.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Non-owning view of a contiguous sequence of elements.
+ * \param T Template parameter specifying the element type; use `const T` for
+ *        read-only views.
+ *
+ * A minimal stand-in for C++20's `std::span` with dynamic extent: a pointer
+ * and a length. It is used wherever pipeBB hands out or accepts blocks of
+ * samples, e.g. the contiguous segments of a `ringbuffer`.
+ */
+template <typename T>
+class span
+{
+  using self_t = span<T>;
+
+public:
+  using element_type    = T;
+  using value_type      = std::remove_cv_t<T>;
+  using size_type       = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer         = T *;
+  using reference       = T &;
+  using iterator        = T *;
+
+public:
+  constexpr span() noexcept = default;
+
+  constexpr span(pointer data, size_type size) noexcept
+   : _data(data), _size(size) {}
+
+  template <std::size_t N>
+  constexpr span(element_type (&array)[N]) noexcept : _data(array), _size(N) {}
+
+  /*!
+   * \brief Constructor from any contiguous container providing `data()` and
+   *        `size()`, e.g. `std::vector`, `std::array` or another `span`.
+   */
+  template <class C,
+            REQUIRES(std::is_convertible<decltype(std::declval<C &>().data()),
+                                         pointer>::value)>
+  constexpr span(C & container) noexcept
+   : _data(container.data()), _size(container.size()) {}
+
+  /*!
+   * \brief Converting constructor, e.g. from `span<T>` to `span<const T>`.
+   */
+  template <class U, REQUIRES(std::is_convertible<U *, pointer>::value)>
+  constexpr span(const span<U> & other) noexcept
+   : _data(other.data()), _size(other.size()) {}
+
+  /*! \name Element access */ /*!@{*/
+  /* ---------------------------------------------------------------------- */
+  constexpr pointer   data() const noexcept { return _data; }
+  constexpr reference operator[](size_type i) const noexcept {
+    return _data[i];
+  }
+  constexpr reference front() const noexcept { return _data[0]; }
+  constexpr reference back() const noexcept { return _data[_size - 1]; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  /*! \name Iterators */ /*!@{*/
+  /* ---------------------------------------------------------------------- */
+  constexpr iterator begin() const noexcept { return _data; }
+  constexpr iterator end() const noexcept { return _data + _size; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  /*! \name Capacity */ /*!@{*/
+  /* ---------------------------------------------------------------------- */
+  constexpr size_type size() const noexcept { return _size; }
+  constexpr bool      empty() const noexcept { return _size == 0; }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+  /*! \name Subviews */ /*!@{*/
+  /* ---------------------------------------------------------------------- */
+  constexpr self_t first(size_type count) const noexcept {
+    return {_data, count};
+  }
+
+  constexpr self_t last(size_type count) const noexcept {
+    return {_data + (_size - count), count};
+  }
+
+  constexpr self_t subspan(size_type offset, size_type count) const noexcept {
+    return {_data + offset, count};
+  }
+  /*!@}*/ /* --------------------------------------------------------------- */
+
+private:
+  pointer   _data{nullptr};
+  size_type _size{0};
+};
+
+
+/*!
+ * \brief   Maker function to facilitate creating `span` objects.
+ * \param   data Pointer to the first element.
+ * \param   size Number of elements.
+ * \returns `span` over `[data, data + size)`.
+ */
+template <typename T>
+inline span<T> make_span(T * data, std::size_t size) noexcept {
+  return {data, size};
+}
+
+/*!
+ * \brief   Maker function to create a `span` over a contiguous container.
+ * \param   container Container providing `data()` and `size()`.
+ * \returns `span` over the container's elements.
+ */
+template <class C>
+inline auto make_span(C & container) noexcept
+  -> span<std::remove_pointer_t<decltype(container.data())>> {
+  return {container.data(), container.size()};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_SPAN_H_
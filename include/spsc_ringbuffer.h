@@ -0,0 +1,289 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PIPEBB_SPSC_RINGBUFFER_H_
+#define PIPEBB_SPSC_RINGBUFFER_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#include "channel.h"
+#include "node.h"
+#include "ringbuffer.h"
+#include "utils.h"
+
+
+namespace pipebb {
+
+
+/*!
+ * \brief Lock-free single producer, single consumer queue.
+ * \param T Template parameter specifying the element type.
+ * \param N Template parameter specifying the capacity.
+ *
+ * The `spsc_ringbuffer` is used to hand samples over from one thread (e.g. a
+ * CAN or serial acquisition thread) to another (the thread evaluating the
+ * pipeline) without locking. Exactly one thread may push and exactly one
+ * thread may pop at any time.
+ *
+ * Head and tail index live on separate cache lines, each next to the
+ * producer's or consumer's cached copy of the other index, so the two threads
+ * only touch each other's cache line when the cached copy runs out. The
+ * indices are free running and the storage is rounded up to a power of two,
+ * so wrap-around is a bit mask.
+ *
+ * _Note: The object is cache line aligned. Prior to C++17, allocating it with
+ * `new` does not respect that alignment; prefer static or automatic storage._
+ */
+template <typename T, std::size_t N>
+class spsc_ringbuffer
+{
+  using self_t   = spsc_ringbuffer<T, N>;
+  using value_t  = T;
+  using layout_t = detail::ringbuffer_layout<masked_indexing, N>;
+  using index_t  = std::size_t;
+
+public:
+  using value_type = value_t;
+  using size_type  = std::size_t;
+
+public:
+  spsc_ringbuffer() = default;
+
+  spsc_ringbuffer(const self_t &) = delete;
+  self_t & operator=(const self_t &) = delete;
+
+  /* Producer -------------------------------------------------------------- */
+  /*!
+   * \brief   Push a single value. Must only be called by the producer.
+   * \returns `true` if the value was pushed, `false` if the queue was full.
+   */
+  bool try_push(const value_t & value) noexcept {
+    return try_push_n(&value, 1) == 1;
+  }
+
+  /*!
+   * \brief   Push up to `count` values. Must only be called by the producer.
+   * \returns Number of values actually pushed.
+   */
+  std::size_t try_push_n(const value_t * values, std::size_t count) noexcept {
+    index_t tail = _tail.load(std::memory_order_relaxed);
+
+    if (N - (tail - _cached_head) < count) {
+      _cached_head = _head.load(std::memory_order_acquire);
+    }
+
+    count = std::min(count, N - (tail - _cached_head));
+    copy_in(tail, values, count);
+
+    _tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+  /* ----------------------------------------------------------------------- */
+
+  /* Consumer -------------------------------------------------------------- */
+  /*!
+   * \brief   Pop a single value. Must only be called by the consumer.
+   * \returns `true` if a value was popped, `false` if the queue was empty.
+   */
+  bool try_pop(value_t & value) noexcept { return try_pop_n(&value, 1) == 1; }
+
+  /*!
+   * \brief   Pop up to `count` values. Must only be called by the consumer.
+   * \returns Number of values actually popped.
+   */
+  std::size_t try_pop_n(value_t * values, std::size_t count) noexcept {
+    index_t head = _head.load(std::memory_order_relaxed);
+
+    if (_cached_tail - head < count) {
+      _cached_tail = _tail.load(std::memory_order_acquire);
+    }
+
+    count = std::min(count, _cached_tail - head);
+    copy_out(head, values, count);
+
+    _head.store(head + count, std::memory_order_release);
+    return count;
+  }
+  /* ----------------------------------------------------------------------- */
+
+  /* Capacity -------------------------------------------------------------- */
+  /*!
+   * \brief Number of queued values. Only a snapshot if the other side is
+   *        active concurrently.
+   */
+  std::size_t size() const noexcept {
+    return _tail.load(std::memory_order_acquire) -
+           _head.load(std::memory_order_acquire);
+  }
+
+  bool        empty() const noexcept { return size() == 0; }
+  std::size_t max_size() const noexcept { return N; }
+  /* ----------------------------------------------------------------------- */
+
+private:
+  void copy_in(index_t pos, const value_t * values, std::size_t count) {
+    std::size_t slot  = layout_t::wrap(pos);
+    std::size_t first = std::min(count, layout_t::size() - slot);
+    std::copy(values, values + first, _data.begin() + slot);
+    std::copy(values + first, values + count, _data.begin());
+  }
+
+  void copy_out(index_t pos, value_t * values, std::size_t count) {
+    std::size_t slot  = layout_t::wrap(pos);
+    std::size_t first = std::min(count, layout_t::size() - slot);
+    std::copy(_data.begin() + slot, _data.begin() + slot + first, values);
+    std::copy(_data.begin(), _data.begin() + (count - first), values + first);
+  }
+
+private:
+  // consumer side
+  alignas(cache_line_size) std::atomic<index_t> _head{0};
+  index_t _cached_tail{0};
+
+  // producer side
+  alignas(cache_line_size) std::atomic<index_t> _tail{0};
+  index_t _cached_head{0};
+
+  alignas(cache_line_size) std::array<value_t, layout_t::size()> _data{};
+};
+
+
+/*!
+ * \brief Class which feeds a `channel` from an `spsc_ringbuffer`.
+ * \param T Template parameter specifying the data type of the channel.
+ * \param N Template parameter specifying the capacity of the queue.
+ *
+ * The `queue_source` gate sits between an acquisition thread pushing into an
+ * `spsc_ringbuffer` and the `channel` it belongs to. At the start of each
+ * evaluation tick, it drains the queue and writes the newest sample into the
+ * channel, so the producer never has to wait for the pipeline thread. Use
+ * `step()` instead if every single sample has to pass through the pipeline.
+ *
+ * Since the queue can't report new samples to the evaluation graph, gates
+ * reading from a `queue_source` are evaluated on every call. Where that
+ * matters, call `drain()` at the start of each tick and connect the gates to
+ * the channel instead, which only propagates actual changes.
+ *
+ * **Usage**
+ * \include make_queue_source.cc
+ *
+ * For further examples, look into the tests.
+ */
+template <typename T, std::size_t N>
+class queue_source
+{
+  using self_t    = queue_source<T, N>;
+  using channel_t = channel<T>;
+  using queue_t   = spsc_ringbuffer<T, N>;
+
+public:
+  using value_t = T;
+
+public:
+  /*!
+   * \brief Constructor for `queue_source` class.
+   * \param chan Channel to feed.
+   * \param queue Queue filled by the producer thread.
+   */
+  queue_source(channel_t & chan, queue_t & queue)
+   : _channel(chan), _queue(queue) {
+    _node.attach(_channel);
+    _node.set_volatile();
+  }
+
+  queue_source(self_t && other) = default;
+
+  /*!
+   * \brief   Pop all queued samples and write the newest one into the channel.
+   * \returns Number of samples popped.
+   */
+  std::size_t drain() noexcept {
+    std::array<value_t, batch_size> batch;
+    std::size_t                     total = 0;
+    std::size_t                     count;
+
+    // stop at the first partial batch, so a busy producer cannot keep the
+    // pipeline thread in here
+    do {
+      count = _queue.try_pop_n(batch.data(), batch_size);
+      if (count) { _channel << batch[count - 1]; }
+      total += count;
+    } while (count == batch_size);
+
+    return total;
+  }
+
+  /*!
+   * \brief   Pop a single sample and write it into the channel.
+   * \returns `true` if a sample was available, `false` if not.
+   */
+  bool step() noexcept {
+    value_t value;
+    if (!_queue.try_pop(value)) { return false; }
+
+    _channel << value;
+    return true;
+  }
+
+  /*!
+   * \brief   Drain the queue, then get the channel's value.
+   * \returns Current value of the channel.
+   *
+   * Every pipeBB gate is callable. When called, it calls the input object and
+   * takes appropriate action with the result.
+   */
+  value_t operator()() noexcept {
+    PIPEBB_PROFILE_GATE("queue_source");
+    if (_node.current()) { return _channel(); }
+    _node.update();
+
+    drain();
+    return _channel();
+  }
+
+  /*!
+   * \brief   Get the gate's node in the evaluation graph.
+   * \returns Reference to the gate's `node`.
+   */
+  node & graph_node() noexcept { return _node; }
+
+private:
+  static constexpr std::size_t batch_size = 64;
+
+  channel_t & _channel;
+  queue_t &   _queue;
+  node        _node;
+};
+
+
+/*!
+ * \brief  Maker function to facilitate creating `queue_source` objects.
+ * \param  chan Channel to feed.
+ * \param  queue Queue filled by the producer thread.
+ * \return Ready to use `queue_source` object.
+ */
+template <typename T, std::size_t N>
+inline queue_source<T, N> make_queue_source(
+  channel<T> & chan, spsc_ringbuffer<T, N> & queue) {
+  return {chan, queue};
+}
+
+}  // namespace pipebb
+
+#endif  // PIPEBB_SPSC_RINGBUFFER_H_
@@ -17,8 +17,26 @@
 #ifndef PIPEBB_THRESHOLD_H_
 #define PIPEBB_THRESHOLD_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "node.h"
+#include "simd.h"
+#include "span.h"
+
 
 namespace pipebb {
+namespace detail {
+
+
+// comparison shared by threshold and lane_threshold
+template <typename T>
+inline bool exceeds(T value, T limit) noexcept {
+  return value > limit;
+}
+
+}  // namespace detail
 
 
 template <class I>
@@ -31,24 +49,61 @@ public:
   using value_t = typename input_t::value_t;
 
 public:
-  threshold(input_t & input, value_t limit) noexcept
-   : _input(input), _limit(limit) {}
+  threshold(input_t & input, value_t limit) : _input(input), _limit(limit) {
+    _node.attach(_input);
+  }
 
   threshold(self_t && other) = default;
 
-  void set_limit(value_t limit) noexcept { _limit = limit; }
+  void set_limit(value_t limit) noexcept {
+    _limit = limit;
+    _node.invalidate();
+  }
+
+  bool operator()() noexcept {
+    PIPEBB_PROFILE_GATE("threshold");
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    return _value = detail::exceeds(_input(), _limit);
+  }
+
+  std::size_t process(span<const value_t> in, span<bool> out) noexcept {
+    std::size_t count = std::min(in.size(), out.size());
+
+    const value_t * src = in.data();
+    bool *          dst = out.data();
+    for (std::size_t i = 0; i < count; ++i) {
+      dst[i] = detail::exceeds(src[i], _limit);
+    }
+
+    _node.invalidate();
+    return count;
+  }
+
+  // packed bitmask output, see simd::greater()
+  std::size_t process(span<const value_t> in,
+                      span<std::uint64_t> mask) noexcept {
+    std::size_t count = std::min(in.size(), mask.size() * 64);
+
+    simd::greater(in.data(), _limit, mask.data(), count);
+
+    _node.invalidate();
+    return count;
+  }
 
-  bool operator()() noexcept { return _input() > _limit; }
+  node & graph_node() noexcept { return _node; }
 
 private:
   input_t & _input;
   value_t   _limit;
+  node      _node;
+  bool      _value{false};
 };
 
 
 template <class I>
-inline threshold<I> make_threshold(I &                 input,
-                                   typename I::value_t limit) noexcept {
+inline threshold<I> make_threshold(I & input, typename I::value_t limit) {
   return {input, limit};
 }
 
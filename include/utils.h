@@ -17,6 +17,9 @@
 #ifndef PIPEBB_UTILS_H_
 #define PIPEBB_UTILS_H_
 
+#include <cstddef>
+#include <type_traits>
+
 #define REQUIRES(...) std::enable_if_t<(__VA_ARGS__)>...
 
 
@@ -30,6 +33,39 @@
  * On the other hand, pipeBB has no dependencies other than the C++ standard
  * library.
  */
-namespace pipebb {}  // namespace pipebb
+namespace pipebb {
+
+
+/*!
+ * \brief Assumed size of a cache line in bytes.
+ *
+ * Used to pad data shared between threads so that independently written
+ * members do not end up on the same cache line (false sharing).
+ * `std::hardware_destructive_interference_size` is a C++17 feature.
+ */
+constexpr std::size_t cache_line_size = 64;
+
+
+/*!
+ * \brief Type of sample timestamps, see `channel::write()`.
+ *
+ * The unit and origin are up to the application; time-aware gates like
+ * `derivative` report rates per that unit.
+ */
+using timestamp_t = double;
+
+
+namespace detail {
+
+
+// M_PI is not part of standard C++
+template <typename T>
+constexpr T pi() noexcept {
+  return static_cast<T>(3.14159265358979323846);
+}
+
+}  // namespace detail
+
+}  // namespace pipebb
 
 #endif  // PIPEBB_UTILS_H_
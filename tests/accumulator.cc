@@ -15,6 +15,9 @@
 //
 
 #include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
 
 #include "catch.h"
 
@@ -27,6 +30,8 @@
 // (enables meaningful test coverage analysis)
 //
 template class pipebb::accumulator<pipebb::channel<double>, 5>;
+template class pipebb::accumulator<pipebb::channel<double>,
+                                   pipebb::dynamic_extent>;
 //
 
 
@@ -56,5 +61,52 @@ TEST_CASE("functionality of the accumulator gates", "[accumulator]") {
     REQUIRE(acc() == 32.5);
     REQUIRE(acc() == 25.0);
     REQUIRE(acc() == 25.0);
+    REQUIRE(acc.report() == 25.0);
+
+    acc.reset();
+    REQUIRE(acc.report() == 0.0);
+    REQUIRE(acc() == 5.0);
+  }
+
+  SECTION("incremental sum") {
+    pipebb::channel<std::int64_t> flow{"flow", "l", 1, 0};
+    auto                          acc = pipebb::make_accumulator<3>(flow);
+
+    std::int64_t values[] = {7, -3, 12, 100, 0, -50, 4};
+    std::int64_t expected[] = {7, 4, 16, 109, 112, 50, -46};
+
+    for (unsigned i = 0; i < 7; ++i) {
+      flow << values[i];
+      REQUIRE(acc() == expected[i]);
+      REQUIRE(acc.report() == expected[i]);
+    }
+  }
+
+  SECTION("runtime window size") {
+    auto acc = pipebb::make_accumulator<4>(overboost);
+    auto dyn = pipebb::make_accumulator(overboost, 4);
+
+    for (int i = 0; i < 12; ++i) {
+      overboost << 2.5 * (i % 5);
+      REQUIRE(dyn() == acc());
+    }
+
+    REQUIRE_THROWS_AS(pipebb::make_accumulator(overboost, 0),
+                      std::invalid_argument);
+  }
+
+  SECTION("block processing") {
+    auto acc = pipebb::make_accumulator<3>(overboost);
+    auto ref = pipebb::make_accumulator<3>(overboost);
+
+    std::vector<double> in{12.5, 5.0, 0.0, -2.5, 7.5};
+    std::vector<double> out(in.size());
+
+    REQUIRE(acc.process(in, out) == in.size());
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      overboost << in[i];
+      REQUIRE(out[i] == ref());
+    }
   }
 }
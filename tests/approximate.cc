@@ -68,4 +68,21 @@ TEST_CASE("functionality of approximator gates", "[approximator]") {
 
     REQUIRE(!approx());
   }
+
+  SECTION("block processing") {
+    pipebb::channel<unsigned> n_rpm_0{"n_rpm", "unit", 1, 0};
+    pipebb::channel<double>   n_rpm_1{"n_rpm", "unit", 1.0, 0.0};
+
+    auto approx = pipebb::make_approximate(n_rpm_0, n_rpm_1, 15);
+
+    unsigned first[]  = {3200, 3200, 3200, 3200};
+    double   second[] = {3215.0, 3216.0, 3185.0, 3184.0};
+    bool     out[4];
+
+    REQUIRE(approx.process(first, second, out) == 4);
+    REQUIRE(out[0]);
+    REQUIRE(!out[1]);
+    REQUIRE(out[2]);
+    REQUIRE(!out[3]);
+  }
 }
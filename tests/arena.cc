@@ -0,0 +1,73 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "catch.h"
+
+#include "arena.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::arena_allocator<double>;
+//
+
+
+TEST_CASE("functionality of the arena", "[arena]") {
+  alignas(64) unsigned char memory[256];
+  pipebb::arena             pool{memory, sizeof(memory)};
+
+  unsigned char * base = memory;
+
+  SECTION("allocation") {
+    REQUIRE(pool.size() == 256);
+    REQUIRE(pool.used() == 0);
+
+    void * a = pool.allocate(3, 1);
+    void * b = pool.allocate(8, 8);
+
+    REQUIRE(a == static_cast<void *>(base));
+    REQUIRE(b == static_cast<void *>(base + 8));
+    REQUIRE(pool.used() == 16);
+    REQUIRE(pool.available() == 240);
+
+    REQUIRE_THROWS_AS(pool.allocate(241, 1), std::bad_alloc);
+
+    pool.release();
+    REQUIRE(pool.used() == 0);
+    REQUIRE(pool.allocate(256, 1) == static_cast<void *>(base));
+  }
+
+  SECTION("allocator") {
+    pipebb::arena_allocator<double>        alloc{pool};
+    pipebb::arena_allocator<std::uint8_t> other{alloc};
+
+    REQUIRE(alloc == other);
+    REQUIRE(&other.source() == &pool);
+
+    std::vector<double, pipebb::arena_allocator<double>> vec(alloc);
+    vec.reserve(4);
+    vec.push_back(1.0);
+
+    REQUIRE(static_cast<void *>(vec.data()) == static_cast<void *>(base));
+    REQUIRE(pool.used() == 4 * sizeof(double));
+  }
+}
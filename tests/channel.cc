@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "catch.h"
 
@@ -76,4 +77,20 @@ TEST_CASE("basic functionality of channel container", "[channel_basics]") {
       REQUIRE(chan() == static_cast<double>((i + i) * i));
     }
   }
+
+  SECTION("block processing") {
+    std::vector<double> raw{0.5, 1.5, 1.5, -2.0, 8.0};
+    std::vector<double> out(raw.size());
+
+    pipebb::channel<double> ref{"ref", "unit", 2.0, 1.0};
+    pipebb::channel<double> blk{"blk", "unit", 2.0, 1.0};
+
+    REQUIRE(blk.process(raw, out) == raw.size());
+
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+      ref << raw[i];
+      REQUIRE(out[i] == ref());
+    }
+    REQUIRE(blk() == ref());
+  }
 }
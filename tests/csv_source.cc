@@ -0,0 +1,247 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "csv_source.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template void pipebb::csv_source::bind<double>(pipebb::channel<double> &);
+template pipebb::span<const double>
+  pipebb::csv_source::block<double>(const pipebb::channel<double> &) const;
+//
+
+
+namespace {
+
+const std::string path = "pipebb_csv_source_test.csv";
+
+void write_file(const std::string & text) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << text;
+}
+
+double parse(const std::string & text) {
+  double value = 0;
+  auto   end   = pipebb::detail::parse_real(
+    text.data(), text.data() + text.size(), value);
+  REQUIRE(end == text.data() + text.size());
+  return value;
+}
+
+}  // namespace
+
+
+TEST_CASE("parsing numbers", "[csv_source]") {
+  SECTION("integers") {
+    std::int32_t i32 = 0;
+    std::string  text = "-2147483648";
+    REQUIRE(pipebb::detail::parse_integer(
+              text.data(), text.data() + text.size(), i32) ==
+            text.data() + text.size());
+    REQUIRE(i32 == -2147483647 - 1);
+
+    text = "2147483648";
+    REQUIRE(pipebb::detail::parse_integer(
+              text.data(), text.data() + text.size(), i32) ==
+            nullptr);
+
+    std::uint64_t u64 = 0;
+    text              = "18446744073709551615";
+    REQUIRE(pipebb::detail::parse_integer(
+              text.data(), text.data() + text.size(), u64) ==
+            text.data() + text.size());
+    REQUIRE(u64 == 18446744073709551615u);
+
+    text = "18446744073709551616";
+    REQUIRE(pipebb::detail::parse_integer(
+              text.data(), text.data() + text.size(), u64) ==
+            nullptr);
+    text = "-1";
+    REQUIRE(pipebb::detail::parse_integer(
+              text.data(), text.data() + text.size(), u64) ==
+            nullptr);
+  }
+
+  SECTION("reals match strtod") {
+    for (auto text : {"0", "-0.0", "1.5", "+2.25e3", "1e-5", "123456.789",
+                      "0.1", "3.14159265358979323846", "1e300", "-4.9e-324",
+                      "12345678901234567890123", "0.000000000000000000001",
+                      "inf", "-nan", "9007199254740993", ".5", "5."}) {
+      double expected = std::strtod(text, nullptr);
+      double value    = parse(text);
+      if (expected != expected) {
+        REQUIRE(value != value);
+      } else {
+        REQUIRE(value == expected);
+      }
+    }
+
+    std::mt19937_64                        rng(42);
+    std::uniform_real_distribution<double> real(-1e6, 1e6);
+    for (int i = 0; i < 10000; ++i) {
+      std::ostringstream text;
+      text.precision(static_cast<int>(rng() % 17 + 1));
+      text << real(rng);
+      REQUIRE(parse(text.str()) == std::strtod(text.str().c_str(), nullptr));
+    }
+
+    double      value;
+    std::string text = "x1";
+    REQUIRE(pipebb::detail::parse_real(
+              text.data(), text.data() + text.size(), value) ==
+            nullptr);
+  }
+
+  SECTION("booleans") {
+    bool value = false;
+    for (auto text : {"1", "300", "-1", "18446744073709551616", "000"}) {
+      std::string  s{text};
+      const char * end = s.data() + s.size();
+      REQUIRE(pipebb::detail::parse_field(s.data(), end, value,
+                                          std::true_type{}) == end);
+      REQUIRE(value == (s != "000"));
+    }
+
+    std::string text = "x";
+    REQUIRE(pipebb::detail::parse_field(text.data(),
+                                        text.data() + text.size(),
+                                        value,
+                                        std::true_type{}) == nullptr);
+  }
+}
+
+
+TEST_CASE("functionality of the CSV source", "[csv_source]") {
+  pipebb::channel<double>       p_rail{"p_rail", "bar", 2.0, 0.0};
+  pipebb::channel<std::int32_t> n_eng{"n_eng"};
+  pipebb::channel<bool>         b_on{"b_on"};
+
+  std::vector<double>       p_data;
+  std::vector<std::int32_t> n_data;
+  std::vector<bool>         b_data;
+
+  std::string text = "time, \"n_eng\" ,p_rail,b_on,comment\r\n";
+  for (int i = 0; i < 5000; ++i) {
+    p_data.push_back(0.125 * i - 100);
+    n_data.push_back(i % 2 ? -i : i);
+    b_data.push_back(i % 3 == 0);
+
+    std::ostringstream line;
+    line << i * 0.01 << ',' << n_data.back() << ", " << p_data.back()
+         << " ," << b_data.back() << ",text\r\n";
+    text += line.str();
+    if (i % 1000 == 999) { text += "\n"; }
+  }
+  write_file(text);
+
+  SECTION("sample by sample") {
+    pipebb::csv_source source(path, 1024, 1);
+    REQUIRE(source.columns().size() == 5);
+    REQUIRE(source.columns()[1] == "n_eng");
+    REQUIRE(source.columns()[4] == "comment");
+
+    source.bind(p_rail);
+    source.bind(n_eng);
+    source.bind(b_on);
+
+    std::size_t i = 0;
+    while (source.step()) {
+      REQUIRE(p_rail() == p_data[i] * 2.0);
+      REQUIRE(n_eng() == n_data[i]);
+      REQUIRE(b_on() == b_data[i]);
+      ++i;
+    }
+    REQUIRE(i == 5000);
+    REQUIRE_FALSE(source.step());
+  }
+
+  SECTION("block by block, in parallel chunks") {
+    for (std::size_t threads : {1, 3}) {
+      pipebb::csv_source source(path, 100, threads, 4096);
+      REQUIRE(source.threads() == threads);
+      source.bind(p_rail);
+      source.bind(n_eng);
+
+      std::vector<double> out(100);
+      std::size_t         total = 0;
+      while (std::size_t count = source.next()) {
+        REQUIRE(count <= 100);
+        auto p = source.block(p_rail);
+        auto n = source.block(n_eng);
+        REQUIRE(p.size() == count);
+
+        p_rail.process(p, pipebb::make_span(out));
+        for (std::size_t i = 0; i < count; ++i) {
+          REQUIRE(out[i] == p_data[total + i] * 2.0);
+          REQUIRE(n[i] == n_data[total + i]);
+        }
+        total += count;
+      }
+      REQUIRE(total == 5000);
+      REQUIRE_THROWS_AS(source.block(b_on), std::runtime_error);
+    }
+  }
+
+  SECTION("invalid use") {
+    pipebb::csv_source source(path);
+    pipebb::channel<double> t_oil{"t_oil"};
+    REQUIRE_THROWS_AS(source.bind(t_oil), std::runtime_error);
+
+    source.bind(p_rail);
+    REQUIRE_THROWS_AS(source.bind(p_rail), std::runtime_error);
+    source.next();
+    REQUIRE_THROWS_AS(source.bind(n_eng), std::runtime_error);
+
+    REQUIRE_THROWS_AS(pipebb::csv_source("pipebb_missing.csv"),
+                      std::runtime_error);
+  }
+
+  SECTION("malformed lines") {
+    for (auto body : {"1,2\n3\n", "1,2\n3,x\n", "1,2\n3,4,5\n",
+                      "1,2\n3,99999999999\n"}) {
+      write_file(std::string("p_rail,n_eng\n") + body);
+
+      pipebb::csv_source source(path, 1024, 2, 2);
+      source.bind(p_rail);
+      source.bind(n_eng);
+      try {
+        while (source.next()) {}
+        FAIL("no exception");
+      } catch (const std::runtime_error & error) {
+        REQUIRE(std::string(error.what()).find("line 3:") == 0);
+      }
+    }
+  }
+
+  std::remove(path.c_str());
+}
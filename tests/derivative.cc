@@ -0,0 +1,213 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "derivative.h"
+#include "moving_average.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::derivative<pipebb::channel<double>>;
+template class pipebb::varstep_derivative<pipebb::channel<double>, 3>;
+template class pipebb::varstep_derivative<pipebb::channel<double>,
+                                          pipebb::dynamic_extent>;
+//
+
+
+namespace {
+
+// samples of a ramp with slope 3 at jittered times
+struct jittered
+{
+  std::vector<pipebb::timestamp_t> time;
+  std::vector<double>              value;
+
+  explicit jittered(std::size_t count) {
+    pipebb::timestamp_t t = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+      t += 0.01 + 0.004 * static_cast<double>(i % 5);
+      time.push_back(t);
+      value.push_back(3.0 * t + (i % 2 ? 0.5 : 0.0));
+    }
+  }
+};
+
+}  // namespace
+
+
+TEST_CASE("timestamped channels", "[derivative]") {
+  pipebb::channel<double> p_rail{"p_rail", "bar", 2.0, 0.0};
+  pipebb::channel<bool>   b_on{"b_on"};
+
+  REQUIRE(p_rail.timestamp() == 0.0);
+
+  p_rail.write(1.5, 0.25);
+  REQUIRE(p_rail() == 3.0);
+  REQUIRE(p_rail.timestamp() == 0.25);
+
+  // a new timestamp alone is a new sample
+  REQUIRE_FALSE(p_rail.graph_node().dirty());
+  p_rail.write(1.5, 0.5);
+  REQUIRE(p_rail.graph_node().dirty());
+
+  b_on.write(true, 1.0);
+  REQUIRE(b_on());
+  REQUIRE(b_on.timestamp() == 1.0);
+
+  std::vector<pipebb::timestamp_t> time{1.0, 2.0, 3.0};
+  std::vector<double>              raw{1.0, 2.0, 4.0};
+  std::vector<double>              out(3);
+  REQUIRE(p_rail.process(time, raw, out) == 3);
+  REQUIRE(out[2] == 8.0);
+  REQUIRE(p_rail.timestamp() == 3.0);
+  REQUIRE(p_rail() == 8.0);
+}
+
+
+TEST_CASE("functionality of the derivative gates", "[derivative]") {
+  pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+  SECTION("derivative") {
+    auto deriv = pipebb::make_derivative(p_rail);
+
+    p_rail.write(10.0, 1.0);
+    REQUIRE(deriv() == 0.0);
+
+    p_rail.write(12.0, 1.5);
+    REQUIRE(deriv() == Approx(4.0));
+
+    p_rail.write(9.0, 3.0);
+    REQUIRE(deriv() == Approx(-2.0));
+
+    // a value at the same time replaces the last sample
+    p_rail.write(6.0, 3.0);
+    REQUIRE(deriv() == Approx(-4.0));
+
+    // an unchanged value at a new time makes for a zero derivative
+    p_rail.write(6.0, 4.0);
+    REQUIRE(deriv() == 0.0);
+
+    deriv.reset();
+    REQUIRE(deriv() == 0.0);
+  }
+
+  SECTION("derivative of integral signals") {
+    pipebb::channel<std::int32_t> n_eng{"n_eng"};
+
+    auto deriv = pipebb::make_derivative(n_eng);
+    static_assert(std::is_same<decltype(deriv)::value_t, double>::value,
+                  "rates of integral signals are double");
+
+    n_eng.write(800, 0.0);
+    deriv();
+    n_eng.write(801, 0.4);
+    REQUIRE(deriv() == Approx(2.5));
+  }
+
+  SECTION("derivative with a separate timestamp source") {
+    auto avg   = pipebb::make_moving_average<2>(p_rail, true);
+    auto deriv = pipebb::make_derivative(avg, p_rail);
+
+    p_rail.write(2.0, 1.0);
+    deriv();
+    p_rail.write(4.0, 2.0);
+    // the average goes from 1 to 3 within one unit of time
+    REQUIRE(deriv() == Approx(2.0));
+  }
+
+  SECTION("varstep_derivative") {
+    jittered samples(40);
+
+    auto fixed = pipebb::make_varstep_derivative<4>(p_rail);
+    auto dyn   = pipebb::make_varstep_derivative(p_rail, 4);
+    REQUIRE(dyn.range().max_size() == 4);
+
+    for (std::size_t i = 0; i < samples.time.size(); ++i) {
+      p_rail.write(samples.value[i], samples.time[i]);
+
+      double value = fixed();
+      REQUIRE(dyn() == value);
+
+      std::size_t first = i < 3 ? 0 : i - 3;
+      double      expected =
+        i == 0 ? 0.0
+               : (samples.value[i] - samples.value[first]) /
+                   (samples.time[i] - samples.time[first]);
+      REQUIRE(value == Approx(expected));
+    }
+    REQUIRE(fixed.times().back() == samples.time.back());
+
+    REQUIRE_THROWS_AS(pipebb::make_varstep_derivative(p_rail, 0),
+                      std::invalid_argument);
+
+    fixed.reset();
+    REQUIRE(fixed.range().empty());
+    REQUIRE(fixed() == 0.0);
+  }
+
+  SECTION("block processing") {
+    jittered samples(50);
+
+    // repeated timestamps within a block take the sequential path
+    samples.time[20] = samples.time[19];
+    samples.time[33] = samples.time[32];
+
+    pipebb::channel<double> ref_in{"ref_in"};
+
+    auto deriv       = pipebb::make_derivative(p_rail);
+    auto varstep     = pipebb::make_varstep_derivative<5>(p_rail);
+    auto ref_deriv   = pipebb::make_derivative(ref_in);
+    auto ref_varstep = pipebb::make_varstep_derivative<5>(ref_in);
+
+    std::vector<double> deriv_out(50), varstep_out(50);
+
+    // blocks of varying length, with and without repeated timestamps
+    std::size_t bounds[] = {0, 1, 3, 18, 30, 50};
+    for (std::size_t b = 0; b + 1 < 6; ++b) {
+      std::size_t first = bounds[b], n = bounds[b + 1] - first;
+      auto time  = pipebb::make_span(samples.time.data() + first, n);
+      auto value = pipebb::make_span(samples.value.data() + first, n);
+
+      REQUIRE(deriv.process(time, value,
+                            pipebb::make_span(deriv_out.data() + first, n)) ==
+              n);
+      REQUIRE(varstep.process(time, value,
+                              pipebb::make_span(varstep_out.data() + first,
+                                                n)) == n);
+    }
+
+    for (std::size_t i = 0; i < 50; ++i) {
+      ref_in.write(samples.value[i], samples.time[i]);
+      REQUIRE(deriv_out[i] == Approx(ref_deriv()));
+      REQUIRE(varstep_out[i] == Approx(ref_varstep()));
+    }
+
+    // the gates continue from the blocks
+    p_rail.write(100.0, 10.0);
+    ref_in.write(100.0, 10.0);
+    REQUIRE(deriv() == Approx(ref_deriv()));
+    REQUIRE(varstep() == Approx(ref_varstep()));
+  }
+}
@@ -0,0 +1,137 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "catch.h"
+
+#include "arena.h"
+#include "dynamic_ringbuffer.h"
+#include "ringbuffer.h"
+
+constexpr int RBSIZE = 16;
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::dynamic_ringbuffer<int>;
+template class pipebb::dynamic_ringbuffer<double,
+                                          pipebb::arena_allocator<double>>;
+//
+
+
+TEST_CASE("basic functionality of dynamic_ringbuffer container",
+          "[dynamic_ringbuffer]") {
+  pipebb::dynamic_ringbuffer<int> buf{RBSIZE};
+  pipebb::ringbuffer<int, RBSIZE> ref;
+
+  SECTION("constructors") {
+    REQUIRE(buf.empty());
+    REQUIRE(buf.size() == 0);
+    REQUIRE(buf.max_size() == RBSIZE);
+    REQUIRE(buf.raw().size() == RBSIZE + 1);
+
+    buf << 1 << 2;
+
+    pipebb::dynamic_ringbuffer<int> copy(buf);
+    REQUIRE(copy == buf);
+
+    pipebb::dynamic_ringbuffer<int> moved(std::move(copy));
+    REQUIRE(moved == buf);
+
+    moved << 3;
+    REQUIRE(moved != buf);
+  }
+
+  SECTION("same semantics as ringbuffer") {
+    for (int i = 0; i < 3 * RBSIZE + 5; ++i) {
+      buf << i;
+      ref << i;
+
+      REQUIRE(buf.size() == ref.size());
+      REQUIRE(buf.front() == ref.front());
+      REQUIRE(buf.back() == ref.back());
+      REQUIRE(*(buf.end()) == int());
+      REQUIRE(std::equal(buf.begin(), buf.end(), ref.begin(), ref.end()));
+      REQUIRE(
+        std::equal(buf.raw().begin(), buf.raw().end(), ref.raw().begin()));
+    }
+
+    std::vector<int> block(40);
+    std::iota(block.begin(), block.end(), 100);
+
+    for (std::size_t count : {3, 9, 0, 17, 40, 1}) {
+      buf.push_n(block.data(), count);
+      ref.push_n(block.data(), count);
+      REQUIRE(std::equal(buf.begin(), buf.end(), ref.begin(), ref.end()));
+
+      auto segs = buf.segments();
+      REQUIRE(segs[0].size() + segs[1].size() == buf.size());
+    }
+
+    int a[4];
+    int b[4];
+    REQUIRE(buf.pop_n(a, 4) == ref.pop_n(b, 4));
+    REQUIRE(std::equal(a, a + 4, b));
+    REQUIRE(std::equal(buf.begin(), buf.end(), ref.begin(), ref.end()));
+
+    for (int i = 0; i < 5; ++i) {
+      buf.pop_front();
+      ref.pop_front();
+      buf.pop_back();
+      ref.pop_back();
+      buf << i;
+      ref << i;
+      REQUIRE(std::equal(buf.begin(), buf.end(), ref.begin(), ref.end()));
+      REQUIRE(*(buf.end()) == int());
+    }
+
+    buf.fill(42);
+    REQUIRE(buf.size() == RBSIZE);
+    REQUIRE(std::all_of(
+      buf.begin(), buf.end(), [](int element) { return element == 42; }));
+  }
+}
+
+
+TEST_CASE("dynamic_ringbuffer drawing from an arena", "[dynamic_arena]") {
+  std::vector<double> memory(1024);
+  pipebb::arena       pool{memory.data(), memory.size() * sizeof(double)};
+
+  pipebb::arena_allocator<double> alloc{pool};
+
+  using buffer_t = pipebb::dynamic_ringbuffer<double, decltype(alloc)>;
+
+  std::vector<buffer_t> windows;
+  windows.reserve(10);
+  for (int i = 0; i < 10; ++i) { windows.emplace_back(31, alloc); }
+
+  // windows are laid out back to back inside the arena
+  REQUIRE(pool.used() == 10 * 32 * sizeof(double));
+  for (int i = 1; i < 10; ++i) {
+    REQUIRE(windows[i].raw().data() == windows[i - 1].raw().data() + 32);
+  }
+
+  windows[3] << 1.0 << 2.0;
+  REQUIRE(windows[3].back() == 2.0);
+  REQUIRE(windows[4].empty());
+
+  REQUIRE_THROWS_AS(buffer_t(1000, alloc), std::bad_alloc);
+}
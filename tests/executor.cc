@@ -0,0 +1,138 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "executor.h"
+#include "gradient.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "threshold.h"
+
+
+namespace {
+
+//
+// an independent pipeline with stateful gates and two sinks sharing their
+// upstream
+//
+struct pipeline
+{
+  using channel_t  = pipebb::channel<double>;
+  using gradient_t = pipebb::gradient<channel_t>;
+  using average_t  = pipebb::moving_average<gradient_t, 4>;
+  using rising_t   = pipebb::threshold<average_t>;
+
+  channel_t                         in{"in", "-", 1.0, 0.0};
+  gradient_t                        grad{in};
+  average_t                         avg{grad, true};
+  rising_t                          rising{avg, 1};
+  pipebb::boolean_counter<rising_t> count{rising};
+  pipebb::reset_counter<rising_t>   streak{rising};
+};
+
+}  // namespace
+
+
+TEST_CASE("functionality of the executor", "[executor]") {
+  const std::size_t P = 24;
+
+  std::deque<pipeline> parallel(P);
+  std::deque<pipeline> sequential(P);
+
+  pipebb::executor exec{4};
+  for (auto & p : parallel) {
+    exec.add_sink(p.count);
+    exec.add_sink(p.streak);
+  }
+
+  REQUIRE(exec.threads() == 4);
+  REQUIRE(exec.components() == P);
+
+  SECTION("results match the sequential pull order") {
+    std::mt19937                        gen{7};
+    std::uniform_int_distribution<int> dist{0, 20};
+
+    for (int t = 0; t < 300; ++t) {
+      for (std::size_t i = 0; i < P; ++i) {
+        // some pipelines see no change for a while
+        if ((i + t / 10) % 4) {
+          double value = dist(gen);
+          parallel[i].in << value;
+          sequential[i].in << value;
+        }
+      }
+
+      // read the results before the reference ticks on the same thread
+      exec.run();
+
+      std::vector<std::uint64_t> counts, streaks;
+      for (auto & p : parallel) {
+        counts.push_back(p.count());
+        streaks.push_back(p.streak());
+      }
+
+      pipebb::tick();
+      for (std::size_t i = 0; i < P; ++i) {
+        REQUIRE(sequential[i].count() == counts[i]);
+        REQUIRE(sequential[i].streak() == streaks[i]);
+      }
+    }
+  }
+
+  SECTION("linked sinks share a subgraph") {
+    pipebb::channel<double> shared{"shared"};
+
+    auto first  = pipebb::make_threshold(shared, 1.0);
+    auto second = pipebb::make_gradient(shared);
+
+    exec.add_sink(first);
+    exec.add_sink(second);
+    REQUIRE(exec.components() == P + 1);
+
+    // joined through a gate downstream of both pipelines
+    auto both = pipebb::make_and_gate(parallel[0].rising, parallel[1].rising);
+    REQUIRE(exec.components() == P + 1);
+
+    exec.add_sink(both);
+    REQUIRE(exec.components() == P);
+
+    shared << 3.0;
+    exec.run();
+    REQUIRE(first());
+    REQUIRE(second() == 3);
+  }
+
+  SECTION("single threaded executor runs inline") {
+    pipebb::executor inline_exec{1};
+    inline_exec.add_sink(parallel[0].count);
+
+    parallel[0].in << 10.0;
+    auto epoch = inline_exec.run();
+    REQUIRE(epoch == pipebb::current_epoch());
+    REQUIRE(parallel[0].count() == 1);
+  }
+
+  pipebb::reset_epoch();
+}
@@ -0,0 +1,142 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <memory>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "expression.h"
+#include "factor.h"
+#include "inverter.h"
+#include "logical.h"
+#include "offset.h"
+#include "threshold.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+using source_t = pipebb::source_expr<pipebb::channel<double>>;
+template class pipebb::source_expr<pipebb::channel<double>>;
+template class pipebb::scale_expr<source_t>;
+template class pipebb::shift_expr<source_t>;
+template class pipebb::negate_expr<source_t>;
+template class pipebb::greater_expr<source_t>;
+template class pipebb::not_expr<pipebb::greater_expr<source_t>>;
+template class pipebb::logic_expr<std::logical_and<bool>,
+                                  pipebb::greater_expr<source_t>,
+                                  pipebb::greater_expr<source_t>>;
+template class pipebb::fused<pipebb::greater_expr<source_t>>;
+//
+
+
+TEST_CASE("functionality of expressions", "[expression]") {
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+  pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+  auto fac    = pipebb::make_factor(p_manifold, 0.5);
+  auto off    = pipebb::make_offset(fac, 20.0);
+  auto inv    = pipebb::make_inverter(off);
+  auto thresh = pipebb::make_threshold(off, 100.0);
+  auto rail   = pipebb::make_threshold(p_rail, 2.0);
+  auto both   = pipebb::make_and_gate(thresh, rail);
+  auto either = pipebb::make_or_gate(thresh, rail);
+  auto neg    = pipebb::make_not_gate(thresh);
+
+  auto x      = pipebb::expr(p_manifold);
+  auto chain  = x * 0.5 + 20.0;
+  auto e_inv  = -chain;
+  auto e_thr  = chain > 100.0;
+  auto e_both = pipebb::and_(e_thr, pipebb::expr(p_rail) > 2.0);
+  auto e_or   = pipebb::or_(e_thr, pipebb::expr(p_rail) > 2.0);
+  auto e_neg  = !e_thr;
+
+  SECTION("same results as the gate objects") {
+    for (int i = -50; i < 400; i += 7) {
+      p_manifold << i;
+      p_rail << i % 5;
+
+      REQUIRE(chain() == off());
+      REQUIRE(e_inv() == inv());
+      REQUIRE(e_thr() == thresh());
+      REQUIRE(e_both() == both());
+      REQUIRE(e_or() == either());
+      REQUIRE(e_neg() == neg());
+      REQUIRE((2.0 * x - 1.0)() == 2.0 * p_manifold() - 1.0);
+    }
+  }
+
+  SECTION("block evaluation") {
+    std::vector<double> in;
+    for (int i = -50; i < 400; i += 7) { in.push_back(i); }
+
+    std::vector<double>     values(in.size());
+    std::unique_ptr<bool[]> flags(new bool[in.size()]);
+    pipebb::span<bool>      out{flags.get(), in.size()};
+
+    REQUIRE(pipebb::process(chain, pipebb::make_span(in), values) ==
+            in.size());
+    REQUIRE(pipebb::process(e_thr, pipebb::make_span(in), out) == in.size());
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      p_manifold << in[i];
+      REQUIRE(values[i] == off());
+      REQUIRE(out[i] == thresh());
+    }
+
+    // window check on a single source
+    auto inside = pipebb::and_(x > 0.0, !(x > 100.0));
+    pipebb::process(inside, pipebb::make_span(in), out);
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      REQUIRE(out[i] == (in[i] > 0.0 && in[i] <= 100.0));
+    }
+  }
+
+  SECTION("fused gates") {
+    auto fused = pipebb::make_fused(e_both);
+    auto count = pipebb::make_boolean_counter(fused);
+
+    // attached to both channels, not volatile
+    REQUIRE_FALSE(fused.graph_node().is_volatile());
+    REQUIRE(fused.graph_node().inputs().size() == 2);
+
+    p_manifold << 300.0;
+    p_rail << 3.0;
+    REQUIRE(fused());
+    REQUIRE_FALSE(fused.graph_node().dirty());
+    REQUIRE(count() == 1);
+    REQUIRE(count() == 2);
+
+    p_rail << 1.0;
+    REQUIRE(fused.graph_node().dirty());
+    REQUIRE_FALSE(fused());
+    REQUIRE(count() == 2);
+
+    std::vector<double>     in{0.0, 300.0};
+    std::unique_ptr<bool[]> flags(new bool[2]);
+    auto thr_gate = pipebb::make_fused(e_thr);
+    REQUIRE(thr_gate.process(pipebb::make_span(in),
+                             pipebb::span<bool>{flags.get(), 2}) == 2);
+    REQUIRE_FALSE(flags[0]);
+    REQUIRE(flags[1]);
+    REQUIRE(thr_gate.graph_node().dirty());
+  }
+}
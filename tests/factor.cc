@@ -15,6 +15,7 @@
 //
 
 #include <cmath>
+#include <vector>
 
 #include "catch.h"
 
@@ -48,4 +49,18 @@ TEST_CASE("functionality of the grading gates", "[grading]") {
     REQUIRE(mul_fac() == 6600.0);
     REQUIRE(div_fac() == 550.0);
   }
+
+  SECTION("block processing") {
+    pipebb::factor<decltype(p_manifold)> mul_fac{p_manifold, 2.0};
+
+    std::vector<double> in{2200.0, -3.5, 0.0, 1.0e6};
+    std::vector<double> out(in.size());
+
+    REQUIRE(mul_fac.process(in, out) == in.size());
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      p_manifold << in[i];
+      REQUIRE(out[i] == mul_fac());
+    }
+  }
 }
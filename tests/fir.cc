@@ -0,0 +1,175 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <array>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "fir.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::fir<pipebb::channel<double>, 64>;
+template class pipebb::fir<pipebb::channel<float>, 17, 4>;
+template struct pipebb::fir_coefficients<double, 64>;
+//
+
+
+namespace {
+
+template <std::size_t Taps>
+double reference(const std::array<double, Taps> & h,
+                 const std::deque<double> &      window) {
+  // window holds the newest value at the back, zeros before the start
+  double y = 0.0;
+  for (std::size_t k = 0; k < Taps && k < window.size(); ++k) {
+    y += h[k] * window[window.size() - 1 - k];
+  }
+  return y;
+}
+
+std::vector<double> make_signal(std::size_t n) {
+  std::vector<double> sig(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    sig[i] = 10.0 * std::sin(0.01 * i) + std::sin(2.5 * i);
+  }
+  return sig;
+}
+
+}  // namespace
+
+
+TEST_CASE("functionality of the fir gate", "[fir]") {
+  pipebb::channel<double> accel{"accel", "m/s2", 1.0, 0.0};
+
+  SECTION("convolution") {
+    std::array<double, 5> h{{1.0, 2.0, 3.0, 4.0, 5.0}};
+    auto                  filter = pipebb::make_fir(accel, h);
+
+    std::deque<double> window;
+    for (int i = 1; i <= 12; ++i) {
+      accel << double(i);
+      window.push_back(i);
+      REQUIRE(filter() == reference(h, window));
+    }
+
+    // the output keeps changing until the window is filled with the input
+    for (int i = 0; i < 5; ++i) {
+      window.push_back(12.0);
+      REQUIRE(filter() == reference(h, window));
+    }
+    REQUIRE(filter() == 15.0 * 12.0);
+
+    filter.reset();
+    filter.set_coefficients({{1.0, 0.0, 0.0, 0.0, -1.0}});
+    REQUIRE(filter() == 12.0);
+  }
+
+  SECTION("designs") {
+    auto lp = pipebb::fir_coefficients<double, 63>::lowpass(50.0, 1000.0);
+    auto bp =
+      pipebb::fir_coefficients<double, 63>::bandpass(100.0, 200.0, 1000.0);
+
+    // symmetric, i.e. linear phase
+    for (std::size_t i = 0; i < 63; ++i) {
+      REQUIRE(lp[i] == Approx(lp[62 - i]));
+      REQUIRE(bp[i] == Approx(bp[62 - i]));
+    }
+
+    auto low  = pipebb::make_fir(accel, lp);
+    auto band = pipebb::make_fir(accel, bp);
+
+    // pass a slow sine, suppress a fast one
+    double max_slow = 0.0, max_fast = 0.0, max_band = 0.0;
+    for (int i = 0; i < 2000; ++i) {
+      accel << std::sin(2 * M_PI * 10.0 * i / 1000.0);
+      double y = low();
+      if (i > 100) { max_slow = std::max(max_slow, y); }
+    }
+    for (int i = 0; i < 2000; ++i) {
+      accel << std::sin(2 * M_PI * 300.0 * i / 1000.0);
+      double y = low();
+      double z = band();
+      if (i > 100) {
+        max_fast = std::max(max_fast, y);
+        max_band = std::max(max_band, z);
+      }
+    }
+
+    REQUIRE(max_slow == Approx(1.0).epsilon(0.01));
+    REQUIRE(max_fast < 0.01);
+    REQUIRE(max_band < 0.05);
+  }
+
+  SECTION("decimation") {
+    std::array<double, 17> h;
+    for (std::size_t i = 0; i < h.size(); ++i) { h[i] = 1.0 / (1 + i); }
+
+    auto full = pipebb::make_fir(accel, h);
+    auto dec  = pipebb::make_fir<4>(accel, h);
+
+    auto sig = make_signal(100);
+    for (std::size_t i = 0; i < sig.size(); ++i) {
+      accel << sig[i];
+      pipebb::tick();
+      double y = full();
+      if (i % 4 == 0) {
+        REQUIRE(dec() == y);
+      } else {
+        REQUIRE(dec() != y);
+      }
+    }
+    pipebb::reset_epoch();
+  }
+
+  SECTION("block processing") {
+    std::array<double, 33> h;
+    for (std::size_t i = 0; i < h.size(); ++i) { h[i] = std::cos(0.3 * i); }
+
+    auto filter = pipebb::make_fir(accel, h);
+    auto dec    = pipebb::make_fir<3>(accel, h);
+    auto ref    = pipebb::make_fir(accel, h);
+
+    auto sig = make_signal(500);
+
+    std::vector<double> out(sig.size()), out_dec(sig.size() / 3 + 1);
+    REQUIRE(filter.process({sig.data(), 200}, out) == 200);
+    REQUIRE(filter.process({sig.data() + 200, 300},
+                           pipebb::make_span(out.data() + 200, 300)) ==
+            300);
+    REQUIRE(dec.process(sig, out_dec) == out_dec.size());
+
+    for (std::size_t i = 0; i < sig.size(); ++i) {
+      accel << sig[i];
+      double y = ref();
+      REQUIRE(out[i] == y);
+      if (i % 3 == 0) { REQUIRE(out_dec[i / 3] == y); }
+    }
+
+    // stops where there is no room for further outputs
+    dec.reset();
+    std::vector<double> two(2);
+    REQUIRE(dec.process(sig, two) == 2);
+    REQUIRE(two[1] == out_dec[1]);
+  }
+}
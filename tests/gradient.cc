@@ -15,6 +15,8 @@
 //
 
 #include <cmath>
+#include <stdexcept>
+#include <vector>
 
 #include "catch.h"
 
@@ -27,6 +29,9 @@
 // (enables meaningful test coverage analysis)
 //
 template class pipebb::gradient<pipebb::channel<double>>;
+template class pipebb::varstep_gradient<pipebb::channel<double>, 3>;
+template class pipebb::varstep_gradient<pipebb::channel<double>,
+                                        pipebb::dynamic_extent>;
 //
 
 
@@ -45,4 +50,58 @@ TEST_CASE("functionality of the gradient gates", "[gradient]") {
     p_manifold << 2370.0;
     REQUIRE(grad() == -200.0);
   }
+
+  SECTION("varstep_gradient with runtime distance") {
+    auto grad = pipebb::make_varstep_gradient<3>(p_manifold);
+    auto dyn  = pipebb::make_varstep_gradient(p_manifold, 3);
+
+    REQUIRE(dyn.range().max_size() == 3);
+
+    for (int i = 0; i < 10; ++i) {
+      p_manifold << 10.0 * i * i;
+      REQUIRE(dyn() == grad());
+    }
+
+    REQUIRE_THROWS_AS(pipebb::make_varstep_gradient(p_manifold, 0),
+                      std::invalid_argument);
+  }
+
+  SECTION("block processing") {
+    auto grad    = pipebb::make_gradient(p_manifold);
+    auto varstep = pipebb::make_varstep_gradient<4>(p_manifold);
+
+    pipebb::channel<double> ref_in{"ref_in", "mbar", 1.0, 0.0};
+
+    auto ref_grad    = pipebb::make_gradient(ref_in);
+    auto ref_varstep = pipebb::make_varstep_gradient<4>(ref_in);
+
+    std::vector<double> in;
+    for (int i = 0; i < 11; ++i) { in.push_back(10.0 * i * i - 3.0 * i); }
+
+    std::vector<decltype(grad)::value_t> grad_out(in.size());
+    std::vector<double>                  varstep_out(in.size());
+
+    // split in two blocks to check that the state carries over
+    auto head = pipebb::make_span(in).first(2);
+    auto tail = pipebb::make_span(in).subspan(2, in.size() - 2);
+    auto gout = pipebb::make_span(grad_out);
+    auto vout = pipebb::make_span(varstep_out);
+
+    REQUIRE(grad.process(head, gout.first(2)) == 2);
+    REQUIRE(grad.process(tail, gout.subspan(2, tail.size())) == tail.size());
+    REQUIRE(varstep.process(head, vout.first(2)) == 2);
+    REQUIRE(varstep.process(tail, vout.subspan(2, tail.size())) ==
+            tail.size());
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      ref_in << in[i];
+      REQUIRE(grad_out[i] == ref_grad());
+      REQUIRE(varstep_out[i] == ref_varstep());
+    }
+
+    p_manifold << 7.0;
+    ref_in << 7.0;
+    REQUIRE(grad() == ref_grad());
+    REQUIRE(varstep() == ref_varstep());
+  }
 }
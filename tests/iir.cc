@@ -0,0 +1,213 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cmath>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "iir.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::ema<pipebb::channel<double>>;
+template class pipebb::ema<pipebb::channel<double>, pipebb::channel<double>>;
+template class pipebb::lowpass<pipebb::channel<double>>;
+template class pipebb::highpass<pipebb::channel<float>>;
+template class pipebb::biquad<pipebb::channel<double>>;
+template struct pipebb::biquad_coefficients<double>;
+//
+
+
+namespace {
+
+// direct form I reference
+struct reference_biquad
+{
+  pipebb::biquad_coefficients<double> c;
+  double x1{}, x2{}, y1{}, y2{};
+
+  double operator()(double x) {
+    double y = c.b0 * x + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
+    x2       = x1;
+    x1       = x;
+    y2       = y1;
+    y1       = y;
+    return y;
+  }
+};
+
+std::vector<double> make_signal(std::size_t n) {
+  std::vector<double> sig(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    sig[i] = 100.0 + 10.0 * std::sin(0.05 * i) + 3.0 * std::sin(1.3 * i);
+  }
+  return sig;
+}
+
+}  // namespace
+
+
+TEST_CASE("functionality of the iir gates", "[iir]") {
+  pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+  SECTION("ema") {
+    auto avg = pipebb::make_ema(p_rail, 0.25);
+
+    double ref = 0.0;
+    for (auto val : make_signal(100)) {
+      p_rail << val;
+      ref += 0.25 * (val - ref);
+      REQUIRE(avg() == Approx(ref).epsilon(1.0e-12));
+    }
+
+    avg.set_alpha(1.0);
+    p_rail << 7.0;
+    REQUIRE(avg() == 7.0);
+
+    avg.reset();
+    avg.set_alpha(0.5);
+    REQUIRE(avg() == 3.5);
+  }
+
+  SECTION("coefficient from another gate") {
+    pipebb::channel<double> alpha{"alpha"};
+    auto                    avg = pipebb::make_ema(p_rail, alpha);
+
+    alpha << 0.5;
+    p_rail << 8.0;
+    REQUIRE(avg() == 4.0);
+
+    alpha << 0.25;
+    REQUIRE(avg() == 5.0);
+  }
+
+  SECTION("settling") {
+    auto avg = pipebb::make_ema(p_rail, 0.5);
+
+    p_rail << 1.0;
+    int calls = 0;
+    while (avg.graph_node().dirty() && calls < 10000) {
+      avg();
+      ++calls;
+    }
+
+    // converges to the input within the precision, then stays clean
+    REQUIRE(calls < 10000);
+    REQUIRE(avg() == 1.0);
+  }
+
+  SECTION("lowpass and highpass") {
+    const double fs = 1000.0;
+    const double fc = 10.0;
+
+    auto lp  = pipebb::make_lowpass(p_rail, fc, fs);
+    auto hp  = pipebb::make_highpass(p_rail, fc, fs);
+    auto avg = pipebb::make_ema(p_rail, 1.0 - std::exp(-2 * M_PI * fc / fs));
+
+    p_rail << 1.0;
+    double y = 0.0;
+    for (int i = 0; i < 2000; ++i) {
+      pipebb::tick();
+      y = lp();
+      REQUIRE(y == Approx(avg()));
+
+      // low and high pass are complementary for a step
+      REQUIRE(y + hp() == Approx(1.0));
+    }
+    pipebb::reset_epoch();
+
+    REQUIRE(y == Approx(1.0));
+    REQUIRE(hp() == Approx(0.0).margin(1.0e-9));
+
+    lp.set_cutoff(100.0);
+    lp.reset();
+    REQUIRE(lp() == Approx(1.0 - std::exp(-2 * M_PI * 0.1)));
+  }
+
+  SECTION("biquad") {
+    auto coeffs = pipebb::biquad_coefficients<double>::lowpass(50.0, 1000.0,
+                                                               0.7071);
+    auto lp     = pipebb::make_biquad(p_rail, coeffs);
+
+    // unity gain at DC
+    REQUIRE((coeffs.b0 + coeffs.b1 + coeffs.b2) /
+              (1 + coeffs.a1 + coeffs.a2) ==
+            Approx(1.0));
+
+    reference_biquad ref{coeffs};
+    for (auto val : make_signal(500)) {
+      p_rail << val;
+      REQUIRE(lp() == Approx(ref(val)).epsilon(1.0e-12));
+    }
+
+    auto notch = pipebb::biquad_coefficients<double>::notch(100.0, 1000.0, 2.0);
+    lp.set_coefficients(notch);
+    ref = reference_biquad{notch};
+    lp.reset();
+    for (auto val : make_signal(100)) {
+      p_rail << val;
+      REQUIRE(lp() == Approx(ref(val)).epsilon(1.0e-12));
+    }
+  }
+
+  SECTION("block processing") {
+    auto sig = make_signal(1000);
+
+    auto coeffs = pipebb::biquad_coefficients<double>::bandpass(30.0, 1000.0,
+                                                                2.0);
+    auto bq     = pipebb::make_biquad(p_rail, coeffs);
+    auto hp     = pipebb::make_highpass(p_rail, 5.0, 1000.0);
+    auto avg    = pipebb::make_ema(p_rail, 0.1);
+
+    reference_biquad ref{coeffs};
+    double           hp_ref  = 0.0;
+    double           avg_ref = 0.0;
+    double           x_prev  = 0.0;
+    double           d       = std::exp(-2 * M_PI * 5.0 / 1000.0);
+
+    // blocks of varying length, leaving tails to the scalar path
+    std::size_t pos = 0;
+    for (std::size_t len : {3, 64, 17, 8, 1, 200, 707}) {
+      std::vector<double> out_bq(len), out_hp(len), out_avg(len);
+      pipebb::span<const double> in{sig.data() + pos, len};
+
+      REQUIRE(bq.process(in, out_bq) == len);
+      REQUIRE(hp.process(in, out_hp) == len);
+      REQUIRE(avg.process(in, out_avg) == len);
+
+      for (std::size_t i = 0; i < len; ++i) {
+        double x = sig[pos + i];
+        hp_ref   = d * (hp_ref + x - x_prev);
+        x_prev   = x;
+        avg_ref += 0.1 * (x - avg_ref);
+
+        REQUIRE(out_bq[i] == Approx(ref(x)).margin(1.0e-9));
+        REQUIRE(out_hp[i] == Approx(hp_ref).margin(1.0e-9));
+        REQUIRE(out_avg[i] == Approx(avg_ref).margin(1.0e-9));
+      }
+      pos += len;
+    }
+
+    // the scalar path continues from the state the blocks left
+    p_rail << 42.0;
+    REQUIRE(bq() == Approx(ref(42.0)).margin(1.0e-9));
+  }
+}
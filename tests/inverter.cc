@@ -15,6 +15,7 @@
 //
 
 #include <cmath>
+#include <vector>
 
 #include "catch.h"
 
@@ -40,4 +41,15 @@ TEST_CASE("functionality of the inverter gate", "[inverter]") {
 
     REQUIRE(inv() == -2500.0);
   }
+
+  SECTION("block processing") {
+    pipebb::inverter<decltype(p_manifold)> inv{p_manifold};
+
+    std::vector<double> in{2500.0, -3.5};
+    std::vector<double> out(in.size());
+
+    REQUIRE(inv.process(in, out) == in.size());
+    REQUIRE(out[0] == -2500.0);
+    REQUIRE(out[1] == 3.5);
+  }
 }
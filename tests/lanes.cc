@@ -0,0 +1,216 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "catch.h"
+
+#include "accumulator.h"
+#include "channel.h"
+#include "counter.h"
+#include "factor.h"
+#include "gradient.h"
+#include "lanes.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "offset.h"
+#include "threshold.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::lane_channel<double>;
+template class pipebb::lane_factor<pipebb::lane_channel<double>>;
+template class pipebb::lane_offset<pipebb::lane_channel<double>>;
+template class pipebb::lane_threshold<pipebb::lane_channel<double>>;
+template class pipebb::lane_gradient<pipebb::lane_channel<double>>;
+template class pipebb::lane_moving_average<pipebb::lane_channel<double>, 8>;
+template class pipebb::lane_accumulator<pipebb::lane_channel<int>, 8>;
+template class pipebb::lane_boolean_counter<
+  pipebb::lane_threshold<pipebb::lane_channel<double>>>;
+template class pipebb::lane_logic_gate<
+  std::logical_and<bool>,
+  pipebb::lane_threshold<pipebb::lane_channel<double>>,
+  pipebb::lane_threshold<pipebb::lane_channel<double>>>;
+//
+
+
+namespace {
+
+//
+// the scalar graph a single lane has to reproduce
+//
+struct scalar_graph
+{
+  using channel_t = pipebb::channel<double>;
+
+  using factor_t   = pipebb::factor<channel_t>;
+  using gradient_t = pipebb::gradient<channel_t>;
+  using high_t     = pipebb::threshold<channel_t>;
+  using rising_t   = pipebb::threshold<gradient_t>;
+  using both_t     = pipebb::and_gate<high_t, rising_t>;
+
+  channel_t                            in{"in", "-", 0.5, 10.0};
+  factor_t                             fac{in, 2.0};
+  pipebb::offset<factor_t>             off{fac, -5.0};
+  gradient_t                           grad{in};
+  pipebb::moving_average<channel_t, 8> avg{in, true};
+  high_t                               high{in, 20.0};
+  rising_t                             rising{grad, 0};
+  both_t                               both{high, rising};
+  pipebb::boolean_counter<both_t>      count{both};
+};
+
+}  // namespace
+
+
+TEST_CASE("lane gates match their scalar counterparts", "[lanes]") {
+  const std::size_t L = 37;
+
+  std::mt19937                           gen{42};
+  std::uniform_real_distribution<double> dist{0.0, 50.0};
+
+  std::deque<scalar_graph> scalars(L);
+
+  auto in     = pipebb::make_lane_channel<double>(L, "in", "-", 0.5, 10.0);
+  auto fac    = pipebb::make_lane_factor(in, 2.0);
+  auto off    = pipebb::make_lane_offset(fac, -5.0);
+  auto grad   = pipebb::make_lane_gradient(in);
+  auto avg    = pipebb::make_lane_moving_average<8>(in);
+  auto high   = pipebb::make_lane_threshold(in, 20.0);
+  auto rising = pipebb::make_lane_threshold(grad, 0);
+  auto both   = pipebb::make_lane_and_gate(high, rising);
+  auto count  = pipebb::make_lane_boolean_counter(both);
+
+  REQUIRE(in.lanes() == L);
+  REQUIRE(count.lanes() == L);
+  REQUIRE(in.name() == "in");
+  REQUIRE(in.unit() == "-");
+
+  std::vector<double> raw(L);
+
+  for (int t = 0; t < 100; ++t) {
+    for (std::size_t l = 0; l < L; ++l) {
+      // hold some lanes constant for a while
+      // integral values, so scalar gradient's integer output compares equal
+      if (l % 3 || t % 10 == 0) { raw[l] = 2.0 * std::round(dist(gen)); }
+      scalars[l].in << raw[l];
+    }
+    in << pipebb::make_span(raw);
+    pipebb::tick();
+
+    auto counts = count();
+    auto offs   = off();
+    auto avgs   = avg();
+    auto grads  = grad();
+
+    REQUIRE(counts.size() == L);
+
+    for (std::size_t l = 0; l < L; ++l) {
+      auto & s = scalars[l];
+
+      REQUIRE(counts[l] == s.count());
+      REQUIRE(offs[l] == s.off());
+      REQUIRE(grads[l] == s.grad());
+      REQUIRE(avgs[l] == Approx(s.avg()));
+    }
+  }
+
+  pipebb::reset_epoch();
+}
+
+
+TEST_CASE("lane windows and graph bookkeeping", "[lanes]") {
+  const std::size_t L = 5;
+
+  SECTION("lane_accumulator") {
+    auto in  = pipebb::make_lane_channel<int>(L, "in");
+    auto acc = pipebb::make_lane_accumulator<3>(in);
+
+    std::vector<int> raw{1, 2, 3, 4, 5};
+    in << pipebb::make_span(raw);
+
+    REQUIRE(acc()[4] == 5);
+    REQUIRE(acc()[4] == 10);
+    REQUIRE(acc()[4] == 15);
+    REQUIRE(acc()[4] == 15);
+    REQUIRE(acc()[0] == 3);
+
+    // a filled window of identical rows settles
+    REQUIRE_FALSE(acc.graph_node().dirty());
+
+    in.set(0, -1);
+    REQUIRE(acc.graph_node().dirty());
+    REQUIRE(acc()[0] == 1);
+    REQUIRE(acc()[1] == 6);
+
+    acc.reset();
+    REQUIRE(acc()[2] == 3);
+  }
+
+  SECTION("lane_gradient settles") {
+    auto in   = pipebb::make_lane_channel<double>(L, "in");
+    auto grad = pipebb::make_lane_gradient(in);
+
+    in.set(2, 4.0);
+    REQUIRE(grad()[2] == 4);
+    REQUIRE(grad.graph_node().dirty());
+    REQUIRE(grad()[2] == 0);
+    REQUIRE_FALSE(grad.graph_node().dirty());
+
+    // unchanged values do not invalidate the channel
+    in.set(2, 4.0);
+    REQUIRE_FALSE(grad.graph_node().dirty());
+
+    in.factor(2.0);
+    REQUIRE(grad()[2] == 4);
+
+    // input values are truncated like in gradient
+    in.set(3, 1.25);
+    REQUIRE(grad()[3] == 2);
+    REQUIRE(grad()[2] == 0);
+  }
+
+  SECTION("lane_logic_gate with more inputs") {
+    auto a = pipebb::make_lane_channel<int>(L, "a");
+    auto b = pipebb::make_lane_channel<int>(L, "b");
+    auto c = pipebb::make_lane_channel<int>(L, "c");
+
+    auto ta = pipebb::make_lane_threshold(a, 0);
+    auto tb = pipebb::make_lane_threshold(b, 0);
+    auto tc = pipebb::make_lane_threshold(c, 0);
+
+    auto all = pipebb::make_lane_and_gate(ta, tb, tc);
+    auto any = pipebb::make_lane_or_gate(ta, tb, tc);
+
+    a.set(0, 1);
+    b.set(0, 1);
+    c.set(0, 1);
+    b.set(1, 1);
+
+    REQUIRE(all()[0]);
+    REQUIRE_FALSE(all()[1]);
+    REQUIRE(any()[1]);
+    REQUIRE_FALSE(any()[2]);
+  }
+}
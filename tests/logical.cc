@@ -131,4 +131,36 @@ TEST_CASE("functionality of the logic gates", "[logic]") {
     REQUIRE(ogt());
     REQUIRE(ogd());
   }
+
+  SECTION("block processing") {
+    pipebb::channel<bool> a{"a"}, b{"b"}, c{"c"};
+
+    // std::less is neither commutative nor associative, so this also checks
+    // the order in which the inputs are folded
+    pipebb::logic_gate<std::less<bool>,
+                       decltype(a),
+                       decltype(b),
+                       decltype(c)>
+      lgt{a, b, c};
+
+    bool in_a[8], in_b[8], in_c[8], out[8];
+    for (unsigned i = 0; i < 8; ++i) {
+      in_a[i] = i & 1;
+      in_b[i] = i & 2;
+      in_c[i] = i & 4;
+    }
+
+    REQUIRE(lgt.process({{in_a, in_b, in_c}}, out) == 8);
+
+    for (unsigned i = 0; i < 8; ++i) {
+      a << in_a[i];
+      b << in_b[i];
+      c << in_c[i];
+      REQUIRE(out[i] == lgt());
+    }
+
+    pipebb::not_gate<decltype(a)> ngt{a};
+    REQUIRE(ngt.process(in_a, out) == 8);
+    for (unsigned i = 0; i < 8; ++i) { REQUIRE(out[i] == !in_a[i]); }
+  }
 }
@@ -15,9 +15,14 @@
 //
 
 #include <cmath>
+#include <deque>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
 
 #include "catch.h"
 
+#include "arena.h"
 #include "channel.h"
 #include "moving_average.h"
 
@@ -27,6 +32,8 @@
 // (enables meaningful test coverage analysis)
 //
 template class pipebb::moving_average<pipebb::channel<double>, 50>;
+template class pipebb::moving_average<pipebb::channel<double>,
+                                      pipebb::dynamic_extent>;
 //
 
 
@@ -50,5 +57,66 @@ TEST_CASE("functionality of the moving_average gates", "[moving_average]") {
 
     mavg.reset();
     REQUIRE(mavg() == 500.0);
+    REQUIRE(mavg.report() == 500.0);
+  }
+
+  SECTION("incremental sum") {
+    const unsigned S = 64;
+    auto           mavg = pipebb::make_moving_average<S>(p_manifold, true);
+
+    std::deque<double> window;
+
+    // values spanning several orders of magnitude to provoke rounding errors
+    for (unsigned i = 0; i < 100000; ++i) {
+      double val = (i % 7 == 0 ? 1.0e8 : 0.1) * std::sin(i);
+
+      p_manifold << val;
+      window.push_back(p_manifold());
+      if (window.size() > S) { window.pop_front(); }
+
+      double avg = mavg();
+      double ref = std::accumulate(window.begin(), window.end(), 0.0) / S;
+
+      REQUIRE(std::abs(avg - ref) <= 1.0e-6);
+      REQUIRE(mavg.report() == avg);
+    }
+  }
+
+  SECTION("runtime window size") {
+    std::vector<double> memory(64);
+    pipebb::arena       pool{memory.data(), memory.size() * sizeof(double)};
+
+    auto mavg = pipebb::make_moving_average<5>(p_manifold, true);
+    auto dyn  = pipebb::make_moving_average(
+      p_manifold, 5, true, pipebb::arena_allocator<double>{pool});
+
+    REQUIRE(pool.used() == 6 * sizeof(double));
+
+    for (int i = 0; i < 20; ++i) {
+      p_manifold << 100.0 * i;
+      REQUIRE(dyn() == mavg());
+    }
+
+    dyn.reset();
+    REQUIRE(dyn.report() == 0.0);
+
+    REQUIRE_THROWS_AS(pipebb::make_moving_average(p_manifold, 0),
+                      std::invalid_argument);
+  }
+
+  SECTION("block processing") {
+    auto mavg = pipebb::make_moving_average<4>(p_manifold);
+    auto ref  = pipebb::make_moving_average<4>(p_manifold);
+
+    std::vector<double> in{4.0, 0.0, 8.0, 12.0, 0.0, 16.0, 20.0};
+    std::vector<double> out(in.size());
+
+    REQUIRE(mavg.process(in, out) == in.size());
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      p_manifold << in[i];
+      REQUIRE(out[i] == ref());
+    }
+    REQUIRE(mavg.report() == ref.report());
   }
 }
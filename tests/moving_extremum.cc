@@ -0,0 +1,142 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+#include "catch.h"
+
+#include "arena.h"
+#include "channel.h"
+#include "moving_extremum.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::moving_extremum<pipebb::channel<double>,
+                                       16,
+                                       std::less<double>>;
+template class pipebb::moving_extremum<pipebb::channel<double>,
+                                       pipebb::dynamic_extent,
+                                       std::greater<double>>;
+template class pipebb::moving_range<pipebb::channel<double>, 16>;
+template class pipebb::moving_range<pipebb::channel<double>,
+                                    pipebb::dynamic_extent>;
+//
+
+
+TEST_CASE("functionality of the moving extremum gates", "[moving_extremum]") {
+  pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+  SECTION("moving_min, moving_max, moving_range") {
+    const unsigned S = 3;
+    auto           lo    = pipebb::make_moving_min<S>(p_rail);
+    auto           hi    = pipebb::make_moving_max<S>(p_rail);
+    auto           range = pipebb::make_moving_range<S>(p_rail);
+
+    std::vector<double> in{5.0, 3.0, 4.0, 4.0, 9.0, 1.0, 1.0, 2.0, 2.0};
+    std::vector<double> mins{5.0, 3.0, 3.0, 3.0, 4.0, 1.0, 1.0, 1.0, 1.0};
+    std::vector<double> maxs{5.0, 5.0, 5.0, 4.0, 9.0, 9.0, 9.0, 2.0, 2.0};
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      p_rail << in[i];
+      REQUIRE(lo() == mins[i]);
+      REQUIRE(hi() == maxs[i]);
+      REQUIRE(range() == maxs[i] - mins[i]);
+    }
+
+    // the extremum keeps sliding while the input stays unchanged
+    REQUIRE(lo() == 2.0);
+    REQUIRE(hi() == 2.0);
+    REQUIRE(range() == 0.0);
+
+    lo.reset();
+    range.reset();
+    p_rail << 7.0;
+    REQUIRE(lo() == 7.0);
+    REQUIRE(range() == 0.0);
+  }
+
+  SECTION("against brute force") {
+    const unsigned S  = 50;
+    auto           lo = pipebb::make_moving_min<S>(p_rail);
+    auto           hi = pipebb::make_moving_max<S>(p_rail);
+
+    std::deque<double> window;
+    unsigned           seed = 1;
+
+    for (unsigned i = 0; i < 10000; ++i) {
+      // coarse values to get plenty of ties; ramps to fill the deque
+      seed       = seed * 1103515245u + 12345u;
+      double val = (i / 500) % 2 ? double(i % 200) : double(seed >> 28);
+
+      p_rail << val;
+      window.push_back(val);
+      if (window.size() > S) { window.pop_front(); }
+
+      REQUIRE(lo() == *std::min_element(window.begin(), window.end()));
+      REQUIRE(hi() == *std::max_element(window.begin(), window.end()));
+    }
+  }
+
+  SECTION("runtime window size") {
+    std::vector<char> memory(1024);
+    pipebb::arena     pool{memory.data(), memory.size()};
+
+    auto range = pipebb::make_moving_range<7>(p_rail);
+    auto dyn   = pipebb::make_moving_range(
+      p_rail, 7, pipebb::arena_allocator<double>{pool});
+    auto dyn_hi = pipebb::make_moving_max(p_rail, 7);
+
+    REQUIRE(pool.used() > 0);
+
+    for (int i = 0; i < 40; ++i) {
+      p_rail << double((i * 37) % 11);
+      double val = dyn();
+      REQUIRE(val == range());
+      REQUIRE(dyn_hi() >= val);
+    }
+
+    REQUIRE_THROWS_AS(pipebb::make_moving_max(p_rail, 0),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(pipebb::make_moving_range(p_rail, 0),
+                      std::invalid_argument);
+  }
+
+  SECTION("block processing") {
+    auto lo    = pipebb::make_moving_min<4>(p_rail);
+    auto range = pipebb::make_moving_range<4>(p_rail);
+    auto ref   = pipebb::make_moving_min<4>(p_rail);
+    auto rref  = pipebb::make_moving_range<4>(p_rail);
+
+    std::vector<double> in{4.0, 0.0, 8.0, 12.0, 0.0, 16.0, 20.0, 3.0};
+    std::vector<double> out(in.size());
+    std::vector<double> rout(in.size());
+
+    REQUIRE(lo.process(in, out) == in.size());
+    REQUIRE(range.process(in, rout) == in.size());
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      p_rail << in[i];
+      REQUIRE(out[i] == ref());
+      REQUIRE(rout[i] == rref());
+    }
+  }
+}
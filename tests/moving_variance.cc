@@ -0,0 +1,147 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "moving_average.h"
+#include "moving_variance.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+using mavg_t = pipebb::moving_average<pipebb::channel<double>, 16>;
+template class pipebb::moving_variance<mavg_t>;
+template class pipebb::moving_stddev<pipebb::moving_variance<mavg_t>>;
+template class pipebb::zscore<pipebb::moving_variance<mavg_t>>;
+//
+
+
+namespace {
+
+double variance_of(const std::deque<double> & window) {
+  if (window.empty()) { return 0.0; }
+
+  double mean =
+    std::accumulate(window.begin(), window.end(), 0.0) / window.size();
+  double m2 = 0.0;
+  for (auto x : window) { m2 += (x - mean) * (x - mean); }
+  return m2 / window.size();
+}
+
+}  // namespace
+
+
+TEST_CASE("functionality of the moving variance gates", "[moving_variance]") {
+  pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+  SECTION("moving_variance, moving_stddev, zscore") {
+    auto mavg   = pipebb::make_moving_average<4>(p_rail, true);
+    auto var    = pipebb::make_moving_variance(mavg);
+    auto stddev = pipebb::make_moving_stddev(var);
+    auto z      = pipebb::make_zscore(var);
+
+    std::vector<double> in{2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+    std::deque<double>  window;
+
+    for (auto val : in) {
+      p_rail << val;
+      window.push_back(val);
+      if (window.size() > 4) { window.pop_front(); }
+
+      pipebb::tick();
+      double ref  = variance_of(window);
+      double mean =
+        std::accumulate(window.begin(), window.end(), 0.0) / window.size();
+
+      REQUIRE(var() == Approx(ref).margin(1.0e-12));
+      REQUIRE(var.mean() == Approx(mean));
+      REQUIRE(var.count() == window.size());
+      REQUIRE(stddev() == Approx(std::sqrt(ref)).margin(1.0e-12));
+      if (ref > 0.0) {
+        REQUIRE(z() == Approx((val - mean) / std::sqrt(ref)));
+      } else {
+        REQUIRE(z() == 0.0);
+      }
+
+      // window shared with the average, which advanced only once
+      REQUIRE(mavg() == Approx(mean * window.size() / 4));
+    }
+    pipebb::reset_epoch();
+
+    // window of zeros after resetting the average, then the current value
+    mavg.reset();
+    REQUIRE(var() == Approx(variance_of({0.0, 0.0, 0.0, 9.0})));
+    REQUIRE(var.count() == 4);
+  }
+
+  SECTION("large mean, long run") {
+    auto mavg = pipebb::make_moving_average<64>(p_rail, true);
+    auto var  = pipebb::make_moving_variance(mavg);
+
+    std::deque<double> window;
+
+    // a small ripple on a huge offset defeats the sum of squares formula
+    for (unsigned i = 0; i < 20000; ++i) {
+      double val = 1.0e9 + std::sin(0.1 * i) + (i % 3);
+
+      p_rail << val;
+      window.push_back(val);
+      if (window.size() > 64) { window.pop_front(); }
+
+      double res = var();
+      if (i % 97 == 0) {
+        REQUIRE(res == Approx(variance_of(window)).epsilon(1.0e-6));
+      }
+    }
+  }
+
+  SECTION("average without zeros and blocks") {
+    auto mavg = pipebb::make_moving_average<8>(p_rail);
+    auto var  = pipebb::make_moving_variance(mavg);
+
+    std::deque<double> window;
+    for (int i = 0; i < 30; ++i) {
+      double val = (i % 4 == 0) ? 0.0 : double(i * i % 13);
+
+      p_rail << val;
+      if (val != 0.0) {
+        window.push_back(val);
+        if (window.size() > 8) { window.pop_front(); }
+      }
+
+      double res = var();
+      REQUIRE(res == Approx(variance_of(window)).margin(1.0e-9));
+    }
+
+    std::vector<double> block{1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0};
+    std::vector<double> out(block.size());
+    mavg.process(block, out);
+
+    // the average pulls the current input on top of the block
+    window.assign(block.begin() + 2, block.end());
+    window.push_back(p_rail());
+    REQUIRE(var() == Approx(variance_of(window)));
+    REQUIRE(var.count() == 8);
+  }
+}
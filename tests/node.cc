@@ -0,0 +1,286 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "catch.h"
+
+#include <utility>
+
+#include "channel.h"
+#include "counter.h"
+#include "gradient.h"
+#include "factor.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "node.h"
+#include "threshold.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::logic_gate<
+  std::logical_or<bool>,
+  pipebb::threshold<pipebb::gradient<pipebb::channel<double>>>,
+  pipebb::threshold<pipebb::gradient<pipebb::channel<double>>>>;
+//
+
+
+namespace {
+
+// leaves epoch mode when a section ends, so that other tests are unaffected
+struct epoch_guard
+{
+  ~epoch_guard() { pipebb::reset_epoch(); }
+};
+
+// counts how often its input is actually pulled
+template <class I>
+struct probe
+{
+  using value_t = typename I::value_t;
+
+  explicit probe(I & input) : _input(input) { _node.attach(_input); }
+
+  value_t operator()() noexcept {
+    if (_node.current()) { return _value; }
+    _node.update();
+
+    ++calls;
+    return _value = _input();
+  }
+
+  pipebb::node & graph_node() noexcept { return _node; }
+
+  I &          _input;
+  pipebb::node _node;
+  value_t      _value{};
+  unsigned     calls{0};
+};
+
+// an input without a node
+struct constant_source
+{
+  using value_t = double;
+
+  value_t operator()() noexcept { return value; }
+
+  value_t value{0.0};
+};
+
+}  // namespace
+
+
+TEST_CASE("per-tick memoization of gates", "[node]") {
+  epoch_guard guard;
+
+  pipebb::channel<double> p_manifold{"p_manifold", "mbar", 1.0, 0.0};
+
+  auto grad = pipebb::make_gradient(p_manifold);
+
+  pipebb::threshold<decltype(grad)> rising{grad, 5};
+  pipebb::threshold<decltype(grad)> steep{grad, 50};
+
+  SECTION("epochs") {
+    REQUIRE(pipebb::current_epoch() == 0);
+    REQUIRE(pipebb::tick() == 1);
+    REQUIRE(pipebb::tick() == 2);
+    REQUIRE(pipebb::current_epoch() == 2);
+
+    pipebb::reset_epoch();
+    REQUIRE(pipebb::current_epoch() == 0);
+  }
+
+  SECTION("without epochs every call evaluates") {
+    p_manifold << 10.0;
+    REQUIRE(grad() == 10);
+    REQUIRE(grad() == 0);
+  }
+
+  SECTION("shared input advances once per tick") {
+    auto either = pipebb::make_or_gate(rising, steep);
+
+    p_manifold << 10.0;
+    pipebb::tick();
+    REQUIRE(rising());
+    REQUIRE(!steep());
+    REQUIRE(either());
+    REQUIRE(grad() == 10);
+
+    p_manifold << 70.0;
+    pipebb::tick();
+    REQUIRE(either());
+    REQUIRE(rising());
+    REQUIRE(steep());
+    REQUIRE(grad() == 60);
+
+    pipebb::tick();
+    REQUIRE(!either());
+    REQUIRE(grad() == 0);
+  }
+
+  SECTION("reset discards the cached value") {
+    p_manifold << 10.0;
+    pipebb::tick();
+    REQUIRE(grad() == 10);
+
+    grad.reset();
+    REQUIRE(grad() == 10);
+  }
+
+  SECTION("setters discard the cached value") {
+    p_manifold << 10.0;
+    pipebb::tick();
+    REQUIRE(rising());
+
+    rising.set_limit(20);
+    REQUIRE(!rising());
+    REQUIRE(grad() == 10);
+  }
+
+  SECTION("stateful counters step once per tick") {
+    auto counter = pipebb::make_boolean_counter(rising);
+
+    p_manifold << 10.0;
+    pipebb::tick();
+    REQUIRE(counter() == 1);
+    REQUIRE(counter() == 1);
+
+    p_manifold << 30.0;
+    pipebb::tick();
+    REQUIRE(counter() == 2);
+    REQUIRE(counter() == 2);
+  }
+}
+
+
+TEST_CASE("dirty propagation between gates", "[node]") {
+  pipebb::channel<double> T_water{"T_water", "deg", 1.0, 0.0};
+
+  probe<decltype(T_water)> watch{T_water};
+
+  auto scaled = pipebb::make_factor(watch, 2.0);
+
+  pipebb::threshold<decltype(scaled)> hot{scaled, 200.0};
+
+  SECTION("unchanged channels short-circuit the graph") {
+    T_water << 90.0;
+    REQUIRE(!hot());
+    REQUIRE(watch.calls == 1);
+
+    T_water << 90.0;
+    REQUIRE(!hot());
+    REQUIRE(!hot());
+    REQUIRE(watch.calls == 1);
+
+    T_water << 110.0;
+    REQUIRE(hot());
+    REQUIRE(scaled() == 220.0);
+    REQUIRE(watch.calls == 2);
+  }
+
+  SECTION("setters mark downstream gates dirty") {
+    T_water << 90.0;
+    REQUIRE(!hot());
+
+    scaled.set_constant(3.0);
+    REQUIRE(hot());
+    REQUIRE(watch.calls == 1);
+  }
+
+  SECTION("moved gates stay linked") {
+    auto moved = std::move(hot);
+
+    T_water << 90.0;
+    REQUIRE(!moved());
+
+    T_water << 110.0;
+    REQUIRE(moved());
+    REQUIRE(hot.graph_node().inputs().empty());
+  }
+
+  SECTION("dynamic normalization channels propagate") {
+    pipebb::channel<double> gain{"gain"};
+    T_water.factor(&gain);
+
+    gain << 1.0;
+    T_water << 90.0;
+    REQUIRE(!hot());
+
+    gain << 2.0;
+    REQUIRE(hot());
+
+    T_water.factor(nullptr);
+    REQUIRE(!hot());
+  }
+
+  SECTION("gradient settles on unchanged input") {
+    probe<decltype(T_water)> raw{T_water};
+    auto                     grad = pipebb::make_gradient(raw);
+
+    T_water << 10.0;
+    REQUIRE(grad() == 10);
+    REQUIRE(grad() == 0);
+    REQUIRE(!grad.graph_node().dirty());
+    REQUIRE(grad() == 0);
+    REQUIRE(raw.calls == 1);
+
+    T_water << 15.0;
+    REQUIRE(grad() == 5);
+    REQUIRE(grad() == 0);
+  }
+
+  SECTION("windows settle once filled with the same value") {
+    auto avg = pipebb::make_moving_average<3>(T_water, true);
+
+    T_water << 3.0;
+    REQUIRE(avg() == Approx(1.0));
+    REQUIRE(avg() == Approx(2.0));
+    REQUIRE(avg() == Approx(3.0));
+    REQUIRE(!avg.graph_node().dirty());
+    REQUIRE(avg() == Approx(3.0));
+  }
+
+  SECTION("counters keep counting while their input holds") {
+    auto counter = pipebb::make_boolean_counter(hot);
+    auto resets  = pipebb::make_reset_counter(hot);
+
+    T_water << 110.0;
+    REQUIRE(counter() == 1);
+    REQUIRE(counter() == 2);
+    REQUIRE(resets() == 0);
+    REQUIRE(resets() == 0);
+
+    T_water << 90.0;
+    REQUIRE(counter() == 2);
+    REQUIRE(counter() == 2);
+    REQUIRE(resets() == 1);
+    REQUIRE(resets() == 2);
+  }
+
+  SECTION("inputs without a node make gates volatile") {
+    constant_source                      source;
+    pipebb::threshold<constant_source>   positive{source, 0.0};
+    pipebb::not_gate<decltype(positive)> negative{positive};
+
+    REQUIRE(positive.graph_node().is_volatile());
+    REQUIRE(negative.graph_node().is_volatile());
+
+    REQUIRE(negative());
+    source.value = 1.0;
+    REQUIRE(!negative());
+  }
+}
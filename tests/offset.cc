@@ -15,6 +15,7 @@
 //
 
 #include <cmath>
+#include <vector>
 
 #include "catch.h"
 
@@ -48,4 +49,15 @@ TEST_CASE("functionality of the offset gates", "[offset]") {
     REQUIRE(add_off() == 2650.0);
     REQUIRE(sub_off() == 2350.0);
   }
+
+  SECTION("block processing") {
+    pipebb::offset<decltype(p_manifold)> add_off{p_manifold, 200.0};
+
+    std::vector<double> in{2500.0, -3.5, 0.0};
+    std::vector<double> out(2);
+
+    REQUIRE(add_off.process(in, out) == out.size());
+    REQUIRE(out[0] == 2700.0);
+    REQUIRE(out[1] == 196.5);
+  }
 }
@@ -0,0 +1,179 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "catch.h"
+
+#include "arena.h"
+#include "channel.h"
+#include "counter.h"
+#include "gradient.h"
+#include "moving_average.h"
+#include "node.h"
+#include "parallel_run.h"
+#include "threshold.h"
+
+
+namespace {
+
+double sample(std::size_t stream, std::size_t i) {
+  return static_cast<double>((stream * 7 + i * i) % 23);
+}
+
+
+//
+// graph without an arena, stateful gates only
+//
+struct plain_graph
+{
+  using channel_t  = pipebb::channel<double>;
+  using gradient_t = pipebb::gradient<channel_t>;
+  using rising_t   = pipebb::threshold<gradient_t>;
+
+  channel_t                         in{"in"};
+  gradient_t                        grad{in};
+  rising_t                          rising{grad, 2};
+  pipebb::boolean_counter<rising_t> count{rising};
+};
+
+std::uint64_t run_plain(plain_graph & graph, std::size_t stream) {
+  for (std::size_t i = 0; i < 200; ++i) {
+    graph.in << sample(stream, i);
+    pipebb::tick();
+    graph.count();
+  }
+  return graph.count();
+}
+
+
+//
+// graph with its window drawn from the worker's arena
+//
+struct arena_graph
+{
+  using channel_t = pipebb::channel<double>;
+  using alloc_t   = pipebb::arena_allocator<double>;
+  using average_t =
+    pipebb::moving_average<channel_t, pipebb::dynamic_extent, alloc_t>;
+
+  explicit arena_graph(pipebb::arena & source)
+   : avg{in, 16, true, alloc_t{source}} {}
+
+  channel_t in{"in"};
+  average_t avg;
+};
+
+double run_arena(arena_graph & graph, std::size_t stream) {
+  double out = 0.0;
+  for (std::size_t i = 0; i < 100; ++i) {
+    graph.in << sample(stream, i);
+    out = graph.avg();
+  }
+  return out;
+}
+
+}  // namespace
+
+
+TEST_CASE("functionality of parallel_run", "[parallel_run]") {
+  const std::size_t S = 97;
+
+  pipebb::run_options options;
+  options.threads = 4;
+
+  SECTION("results match a sequential run, in stream order") {
+    std::vector<std::uint64_t> expected;
+    for (std::size_t s = 0; s < S; ++s) {
+      plain_graph graph;
+      expected.push_back(run_plain(graph, s));
+    }
+    pipebb::reset_epoch();
+
+    for (std::size_t chunk : {1, 8, 200}) {
+      options.chunk = chunk;
+      REQUIRE(pipebb::parallel_run<plain_graph>(S, run_plain, options) ==
+              expected);
+    }
+
+    options.threads = 1;
+    REQUIRE(pipebb::parallel_run<plain_graph>(S, run_plain, options) ==
+            expected);
+
+    options.threads     = 3;
+    options.pin_threads = true;
+    REQUIRE(pipebb::parallel_run<plain_graph>(S, run_plain, options) ==
+            expected);
+
+    // the calling thread's epoch is left alone
+    REQUIRE(pipebb::current_epoch() == 0);
+  }
+
+  SECTION("graphs constructed from the worker's arena") {
+    options.arena_size = 4096;
+
+    auto results = pipebb::parallel_run<arena_graph>(S, run_arena, options);
+    REQUIRE(results.size() == S);
+
+    std::vector<unsigned char> buffer(4096);
+    for (std::size_t s = 0; s < S; ++s) {
+      pipebb::arena source(buffer.data(), buffer.size());
+      arena_graph   graph{source};
+      REQUIRE(results[s] == run_arena(graph, s));
+    }
+
+    // every stream gets a fresh arena; too small a one throws
+    options.arena_size = 64;
+    REQUIRE_THROWS_AS(
+      pipebb::parallel_run<arena_graph>(S, run_arena, options),
+      std::bad_alloc);
+  }
+
+  SECTION("exceptions from the body are rethrown") {
+    auto failing = [](plain_graph &, std::size_t stream) -> int {
+      if (stream == 42) { throw std::runtime_error("stream 42"); }
+      return 0;
+    };
+
+    REQUIRE_THROWS_AS(
+      pipebb::parallel_run<plain_graph>(S, failing, options),
+      std::runtime_error);
+  }
+
+  SECTION("worker blocks span whole cache lines") {
+    for (std::size_t size : {1, 64, 65, 200}) {
+      pipebb::detail::cache_aligned_block block(size);
+      auto address = reinterpret_cast<std::uintptr_t>(block.data());
+
+      REQUIRE(address % pipebb::cache_line_size == 0);
+      REQUIRE(block.size() % pipebb::cache_line_size == 0);
+      REQUIRE(block.size() >= size);
+      REQUIRE(block.size() < size + pipebb::cache_line_size);
+    }
+
+#ifdef __linux__
+    REQUIRE(!pipebb::detail::allowed_cpus().empty());
+#endif
+  }
+
+  SECTION("no streams") {
+    REQUIRE(pipebb::parallel_run<plain_graph>(0, run_plain, options).empty());
+  }
+}
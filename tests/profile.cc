@@ -0,0 +1,220 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "factor.h"
+#include "gradient.h"
+#include "logical.h"
+#include "profile.h"
+#include "threshold.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::channel<double>;
+template class pipebb::factor<pipebb::channel<double>>;
+//
+
+
+namespace {
+
+const pipebb::profile::entry *
+find(const std::vector<pipebb::profile::entry> & entries,
+     const std::string &                         name) {
+  for (auto & e : entries) {
+    if (e.name == name) { return &e; }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+
+TEST_CASE("functionality of profile", "[profile]") {
+  REQUIRE(pipebb::profile::enabled);
+
+  pipebb::channel<double> rpm{"rpm", "1/min", 1.0, 0.0};
+  pipebb::channel<double> load{"load", "%", 1.0, 0.0};
+
+  auto scaled = pipebb::make_factor(rpm, 0.001);
+  auto high   = pipebb::make_threshold(scaled, 3.0);
+  auto loaded = pipebb::make_threshold(load, 50.0);
+  auto both   = pipebb::make_and_gate(high, loaded);
+  scaled.graph_node().set_name("rpm_scaled");
+  both.graph_node().set_name("both");
+  loaded.graph_node().set_name("loaded");
+
+  pipebb::profile::reset();
+
+  rpm << 1000.0;
+  load << 80.0;
+  REQUIRE(both() == false);
+  REQUIRE(both() == false);  // all clean, served from cache
+
+  rpm << 4000.0;
+  REQUIRE(both() == true);
+
+  auto entries = pipebb::profile::snapshot();
+
+  // call counts and cache hits
+  auto e_both = find(entries, "both");
+  REQUIRE(e_both != nullptr);
+  REQUIRE(e_both->kind == "logic_gate");
+  REQUIRE(e_both->calls == 3);
+  REQUIRE(e_both->hits == 1);
+  REQUIRE(e_both->hit_rate() == Approx(1.0 / 3));
+
+  // load did not change for the last evaluation, so it was not pulled
+  auto e_loaded = find(entries, "loaded");
+  REQUIRE(e_loaded != nullptr);
+  REQUIRE(e_loaded->kind == "threshold");
+  REQUIRE(e_loaded->calls == 2);
+  REQUIRE(e_loaded->hits == 1);
+
+  auto e_load = find(entries, "load");
+  REQUIRE(e_load != nullptr);
+  REQUIRE(e_load->kind == "channel");
+  REQUIRE(e_load->calls == 1);
+
+  auto e_rpm = find(entries, "rpm");
+  REQUIRE(e_rpm != nullptr);
+  REQUIRE(e_rpm->calls == 2);
+  REQUIRE(e_rpm->hits == 0);
+
+  auto e_scaled = find(entries, "rpm_scaled");
+  REQUIRE(e_scaled != nullptr);
+  REQUIRE(e_scaled->kind == "factor");
+  REQUIRE(e_scaled->calls == 2);
+
+  // unnamed gates are listed by kind
+  REQUIRE(find(entries, "threshold#1") != nullptr);
+  REQUIRE(find(entries, "threshold#2") == nullptr);
+
+  // cycles; inclusive time of the root covers the time of its inputs
+  REQUIRE(e_both->total_cycles >= e_both->self_cycles);
+  REQUIRE(e_both->total_cycles >= e_both->max_cycles);
+  REQUIRE(e_both->total_cycles >= e_rpm->total_cycles);
+
+  // output
+  std::ostringstream json;
+  pipebb::profile::print_json(json, entries);
+  REQUIRE(json.str().front() == '{');
+  REQUIRE(json.str().find("\"rpm\": {\"kind\": \"channel\", "
+                          "\"calls\": 2, \"hits\": 0,") !=
+          std::string::npos);
+
+  std::ostringstream table;
+  auto               flags = table.flags();
+  pipebb::profile::print_table(table, entries);
+  REQUIRE(table.str().find("rpm_scaled") != std::string::npos);
+  REQUIRE(table.str().find("self_cycles") != std::string::npos);
+
+  // the caller's formatting is left alone
+  REQUIRE(table.flags() == flags);
+  REQUIRE(table.precision() == 6);
+
+  // control characters in names are escaped
+  pipebb::profile::entry odd{"a\"b\\c\nd\te\x01", "channel", 0, 0, 0, 0, 0};
+  std::ostringstream     odd_json;
+  pipebb::profile::print_json(odd_json, {odd});
+  REQUIRE(odd_json.str().find("\"a\\\"b\\\\c\\nd\\te\\u0001\": {") !=
+          std::string::npos);
+
+  // reset
+  pipebb::profile::reset();
+  REQUIRE(pipebb::profile::snapshot().empty());
+}
+
+
+TEST_CASE("profile of ticked graphs", "[profile]") {
+  pipebb::channel<int> speed{"speed"};
+  auto                 slope = pipebb::make_gradient(speed);
+  auto                 up    = pipebb::make_threshold(slope, 0);
+  auto                 steep = pipebb::make_threshold(slope, 5);
+  slope.graph_node().set_name("slope");
+
+  pipebb::profile::reset();
+
+  for (int i = 0; i < 10; ++i) {
+    speed << i;
+    pipebb::tick();
+    up();
+    steep();
+  }
+  pipebb::reset_epoch();
+
+  // the gradient is pulled twice per tick but evaluated once
+  auto entries = pipebb::profile::snapshot();
+  auto e       = find(entries, "slope");
+  REQUIRE(e != nullptr);
+  REQUIRE(e->calls == 20);
+  REQUIRE(e->hits == 10);
+}
+
+
+TEST_CASE("profile of destroyed gates", "[profile]") {
+  pipebb::channel<double> rpm{"rpm"};
+
+  pipebb::profile::reset();
+
+  for (int i = 0; i < 3; ++i) {
+    auto scaled = pipebb::make_factor(rpm, 2.0);
+    auto high   = pipebb::make_threshold(scaled, 1.0);
+    scaled.graph_node().set_name("scaled");
+
+    rpm << static_cast<double>(i);
+    high();
+  }
+
+  // one entry per name or kind, however many gates were destroyed
+  auto entries = pipebb::profile::snapshot();
+  REQUIRE(entries.size() == 3);
+  REQUIRE(find(entries, "rpm") != nullptr);
+
+  auto e_scaled = find(entries, "scaled (destroyed)");
+  REQUIRE(e_scaled != nullptr);
+  REQUIRE(e_scaled->kind == "factor");
+  REQUIRE(e_scaled->calls == 3);
+
+  auto e_high = find(entries, "threshold (destroyed)");
+  REQUIRE(e_high != nullptr);
+  REQUIRE(e_high->calls == 3);
+  REQUIRE(e_high->total_cycles >= e_high->max_cycles);
+
+  pipebb::profile::reset();
+  REQUIRE(pipebb::profile::snapshot().empty());
+}
+
+
+TEST_CASE("naming in profile", "[profile]") {
+  pipebb::channel<double> a{"dup"};
+  pipebb::channel<double> b{"dup"};
+  pipebb::channel<double> moved{std::move(b)};
+  a();
+  moved();
+
+  auto entries = pipebb::profile::snapshot();
+  REQUIRE(find(entries, "dup") != nullptr);
+  REQUIRE(find(entries, "dup#2") != nullptr);
+}
@@ -0,0 +1,185 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "pass_through.h"
+#include "rate_scheduler.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::buffered_pass_through<pipebb::channel<double>,
+                                             pipebb::rate_clock>;
+//
+
+
+namespace {
+
+// leaves epoch mode when a section ends, so that other tests are unaffected
+struct epoch_guard
+{
+  ~epoch_guard() { pipebb::reset_epoch(); }
+};
+
+//
+// passes its input through and counts how often it was pulled, at most once
+// per epoch
+//
+template <class I>
+struct probe
+{
+  using value_t = typename I::value_t;
+
+  probe(I & in) : input(in) {
+    _node.attach(input);
+    _node.set_volatile();
+  }
+
+  value_t operator()() {
+    if (_node.current()) { return value; }
+    _node.update();
+
+    ++calls;
+    return value = input();
+  }
+
+  pipebb::node & graph_node() { return _node; }
+
+  I &          input;
+  value_t      value{};
+  std::size_t  calls{0};
+  pipebb::node _node;
+};
+
+}  // namespace
+
+
+TEST_CASE("functionality of the rate scheduler", "[rate_scheduler]") {
+  epoch_guard guard;
+
+  using channel_t = pipebb::channel<double>;
+
+  pipebb::rate_scheduler sched{1000.0};
+
+  channel_t fast_in{"fast", "-", 1.0, 0.0};
+  channel_t mid_in{"mid", "-", 1.0, 0.0};
+  channel_t slow_in{"slow", "-", 1.0, 0.0};
+
+  probe<channel_t> fast{fast_in};
+  probe<channel_t> mid{mid_in};
+  probe<channel_t> slow{slow_in};
+
+  std::vector<std::size_t> fed;
+
+  sched.add_sink(slow, 100.0);
+  sched.add_sink(mid, 250.0);
+  sched.add_sink(fast, 1000.0);
+
+  sched.add_source([&] { fast_in << static_cast<double>(sched.now()); },
+                   1000.0);
+  sched.add_source([&] { slow_in << static_cast<double>(sched.now()); },
+                   100.0);
+  sched.add_source([&] { fed.push_back(sched.now()); }, 100.0);
+
+  SECTION("rates and hyperperiod") {
+    REQUIRE(sched.base_rate() == 1000.0);
+    REQUIRE(sched.hyperperiod() == 20);
+
+    REQUIRE(sched.clock(100.0).period() == 10);
+    REQUIRE(sched.clock(250.0).period() == 4);
+    REQUIRE(&sched.clock(250.0) == &sched.clock(250.0));
+
+    REQUIRE_THROWS_AS(sched.clock(300.0), std::invalid_argument);
+    REQUIRE_THROWS_AS(sched.clock(2000.0), std::invalid_argument);
+    REQUIRE_THROWS_AS(sched.clock(0.0), std::invalid_argument);
+    REQUIRE_THROWS_AS(pipebb::rate_scheduler{0.0}, std::invalid_argument);
+  }
+
+  SECTION("sinks are evaluated on their ticks only") {
+    for (std::size_t t = 0; t < 40; ++t) { sched.run(); }
+
+    REQUIRE(sched.ticks() == 40);
+    REQUIRE(fast.calls == 40);
+    REQUIRE(mid.calls == 10);
+    REQUIRE(slow.calls == 4);
+
+    // sources run before the sinks of the same tick
+    REQUIRE(fast.value == 39.0);
+    REQUIRE(slow.value == 30.0);
+    REQUIRE(fed == std::vector<std::size_t>{0, 10, 20, 30});
+  }
+
+  SECTION("clocks are true on their ticks") {
+    auto & clock = sched.clock(250.0);
+
+    REQUIRE(!clock());
+    for (std::size_t t = 0; t < 12; ++t) {
+      sched.run();
+      bool due = clock();
+
+      REQUIRE(due == (t % 4 == 0));
+      REQUIRE(clock.elapsed() == t % 4);
+    }
+  }
+
+  SECTION("clocks are invalidated when their value changes only") {
+    auto & base = sched.clock(1000.0);
+    auto & mid  = sched.clock(250.0);
+
+    sched.run();
+    REQUIRE(base());
+    REQUIRE(mid());
+
+    for (std::size_t t = 1; t < 8; ++t) {
+      sched.run();
+      REQUIRE(base.graph_node().dirty() == false);
+      REQUIRE(mid.graph_node().dirty() == (t % 4 <= 1));
+      REQUIRE(mid() == (t % 4 == 0));
+    }
+  }
+
+  SECTION("rates can be added between runs") {
+    for (std::size_t t = 0; t < 5; ++t) { sched.run(); }
+
+    channel_t        extra_in{"extra", "-", 1.0, 0.0};
+    probe<channel_t> extra{extra_in};
+    sched.add_sink(extra, 125.0);
+
+    REQUIRE(sched.hyperperiod() == 40);
+    REQUIRE(sched.clock(250.0)());
+
+    // ticks 5 through 20 contain those of 125 Hz at 8 and 16
+    for (std::size_t t = 5; t < 21; ++t) { sched.run(); }
+    REQUIRE(extra.calls == 2);
+    REQUIRE(slow.calls == 3);
+  }
+
+  SECTION("overlong hyperperiods are rejected") {
+    pipebb::rate_scheduler odd{7.0 * 11 * 13 * 17 * 19 * 23};
+    odd.clock(odd.base_rate() / (7 * 11 * 13));
+    odd.clock(odd.base_rate() / (17 * 19 * 23));
+
+    REQUIRE_THROWS_AS(odd.run(), std::length_error);
+  }
+}
@@ -0,0 +1,141 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstddef>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "rate_scheduler.h"
+#include "rate_transition.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::decimating_average<pipebb::channel<double>, 4>;
+template class pipebb::decimating_average<pipebb::channel<double>,
+                                          pipebb::dynamic_extent>;
+template class pipebb::interpolator<pipebb::channel<double>>;
+//
+
+
+namespace {
+
+// leaves epoch mode when a section ends, so that other tests are unaffected
+struct epoch_guard
+{
+  ~epoch_guard() { pipebb::reset_epoch(); }
+};
+
+}  // namespace
+
+
+TEST_CASE("functionality of rate transition gates", "[rate_transition]") {
+  epoch_guard guard;
+
+  pipebb::rate_scheduler sched{4.0};
+
+  auto & fast_clock = sched.clock(4.0);
+  auto & slow_clock = sched.clock(1.0);
+  REQUIRE(fast_clock.period() == 1);
+  REQUIRE(slow_clock.period() == 4);
+
+  pipebb::channel<double> fast{"fast", "-", 1.0, 0.0};
+  pipebb::channel<double> slow{"slow", "-", 1.0, 0.0};
+
+  // the fast channel counts base ticks, the slow one steps by ten
+  sched.add_source([&] { fast << static_cast<double>(sched.now()); }, 4.0);
+  sched.add_source(
+    [&] { slow << 10.0 * static_cast<double>(sched.now() / 4 + 1); }, 1.0);
+
+  SECTION("sample_and_hold") {
+    auto hold = pipebb::make_sample_and_hold(fast, slow_clock);
+    sched.add_sink(hold, 4.0);
+
+    std::vector<double> values;
+    for (std::size_t t = 0; t < 10; ++t) {
+      sched.run();
+      values.push_back(hold());
+    }
+
+    REQUIRE(values == std::vector<double>{0, 0, 0, 0, 4, 4, 4, 4, 8, 8});
+  }
+
+  SECTION("decimating_average") {
+    auto fixed   = pipebb::make_decimating_average<4>(fast, slow_clock);
+    auto dynamic = pipebb::make_decimating_average(fast, slow_clock, 4);
+    sched.add_sink(fixed, 4.0);
+    sched.add_sink(dynamic, 4.0);
+
+    std::vector<double> values;
+    for (std::size_t t = 0; t < 13; ++t) {
+      sched.run();
+      values.push_back(fixed());
+      REQUIRE(dynamic() == values.back());
+    }
+
+    // averages of 1..4 and 5..8 on ticks 4 and 8
+    REQUIRE(values[3] == 0.0);
+    REQUIRE(values[4] == 2.5);
+    REQUIRE(values[7] == 2.5);
+    REQUIRE(values[8] == 6.5);
+    REQUIRE(values[12] == 10.5);
+
+    // tick 12 is one of the slow clock, the window restarts with 12
+    fixed.reset();
+    REQUIRE(fixed() == 3.0);
+  }
+
+  SECTION("interpolator") {
+    auto interp = pipebb::make_interpolator(slow, slow_clock);
+    sched.add_sink(interp, 4.0);
+
+    std::vector<double> values;
+    for (std::size_t t = 0; t < 10; ++t) {
+      sched.run();
+      values.push_back(interp());
+    }
+
+    REQUIRE(values == std::vector<double>{10.0,
+                                          10.0,
+                                          10.0,
+                                          10.0,
+                                          10.0,
+                                          12.5,
+                                          15.0,
+                                          17.5,
+                                          20.0,
+                                          22.5});
+  }
+
+  SECTION("a slow subgraph is only evaluated on its ticks") {
+    auto avg    = pipebb::make_moving_average<2>(slow, true);
+    auto hold   = pipebb::make_sample_and_hold(avg, slow_clock);
+    auto interp = pipebb::make_interpolator(avg, slow_clock);
+    sched.add_sink(hold, 4.0);
+    sched.add_sink(interp, 4.0);
+
+    // the window sees every slow value once, and no value twice
+    for (std::size_t t = 0; t < 9; ++t) { sched.run(); }
+
+    REQUIRE(avg.updates() == 3);
+    REQUIRE(hold() == 25.0);
+    REQUIRE(interp() == 15.0);
+  }
+}
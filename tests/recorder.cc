@@ -0,0 +1,178 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "counter.h"
+#include "executor.h"
+#include "moving_average.h"
+#include "recorder.h"
+#include "recording.h"
+#include "threshold.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template void
+  pipebb::recorder::add(pipebb::channel<double> &, std::string, std::string);
+//
+
+
+namespace {
+
+const std::string path = "pipebb_recorder_test.rec";
+
+// leaves epoch mode when a section ends, so that other tests are unaffected
+struct epoch_guard
+{
+  ~epoch_guard() { pipebb::reset_epoch(); }
+};
+
+}  // namespace
+
+
+TEST_CASE("functionality of the recorder", "[recorder]") {
+  epoch_guard guard;
+
+  pipebb::channel<double> p_rail{"p_rail", "bar", 1.0, 0.0};
+
+  auto high  = pipebb::make_threshold(p_rail, 50.0);
+  auto count = pipebb::make_boolean_counter(high);
+  auto avg   = pipebb::make_moving_average<4>(p_rail, true);
+
+  std::vector<double>        p_values, avg_values;
+  std::vector<bool>          high_values;
+  std::vector<std::uint64_t> count_values;
+
+  auto feed = [&](std::size_t i) {
+    p_rail << static_cast<double>(i % 100);
+    pipebb::tick();
+  };
+  auto expect = [&] {
+    p_values.push_back(p_rail());
+    high_values.push_back(high());
+    count_values.push_back(count());
+    avg_values.push_back(avg());
+  };
+  auto check = [&](std::size_t samples) {
+    pipebb::recording rec(path);
+    REQUIRE(rec.size() == samples);
+    REQUIRE(rec.columns() == 4);
+    REQUIRE(rec.column(0).name == "p_rail");
+    REQUIRE(rec.column(0).unit == "bar");
+    REQUIRE(rec.column(0).factor == 1.0);
+    REQUIRE(rec.column(0).offset == 0.0);
+    REQUIRE(rec.column(3).name == "avg");
+    REQUIRE(rec.column(1).type == pipebb::sample_type::boolean);
+    REQUIRE(rec.column(2).type == pipebb::sample_type::uint64);
+
+    auto p = rec.data<double>(0);
+    auto h = rec.data<bool>(1);
+    auto c = rec.data<std::uint64_t>(2);
+    auto a = rec.data<double>(3);
+    for (std::size_t i = 0; i < samples; ++i) {
+      REQUIRE(p[i] == p_values[i]);
+      REQUIRE(h[i] == high_values[i]);
+      REQUIRE(c[i] == count_values[i]);
+      REQUIRE(a[i] == avg_values[i]);
+    }
+  };
+
+  SECTION("recording over several chunks") {
+    for (std::size_t samples : {1000, 640, 5}) {
+      {
+        pipebb::recorder rec(path, 64);
+        rec.add(p_rail, "p_rail", "bar");
+        rec.add(high, "high");
+        rec.add(count, "count");
+        rec.add(avg, "avg");
+        REQUIRE(rec.columns() == 4);
+        REQUIRE(rec.chunk() == 64);
+
+        p_values.clear();
+        high_values.clear();
+        count_values.clear();
+        avg_values.clear();
+        for (std::size_t i = 0; i < samples; ++i) {
+          feed(i);
+          REQUIRE(rec() == i + 1);
+          expect();
+        }
+        REQUIRE(rec.size() == samples);
+
+        rec.close();
+        rec.close();
+      }
+      check(samples);
+    }
+  }
+
+  SECTION("recording in the destructor, without samples") {
+    {
+      pipebb::recorder rec(path);
+      rec.add(p_rail, "p_rail", "bar");
+      rec.add(high, "high");
+      rec.add(count, "count");
+      rec.add(avg, "avg");
+    }
+    check(0);
+  }
+
+  SECTION("recording as an executor sink") {
+    pipebb::recorder rec(path, 16);
+    rec.add(p_rail, "p_rail", "bar");
+    rec.add(high, "high");
+    rec.add(count, "count");
+    rec.add(avg, "avg");
+
+    pipebb::executor ex(2);
+    ex.add_sink(rec);
+    REQUIRE(ex.components() == 1);
+
+    for (std::size_t i = 0; i < 100; ++i) {
+      p_rail << static_cast<double>(i % 100);
+      ex.run();
+      expect();
+    }
+    rec.close();
+    check(100);
+  }
+
+  SECTION("invalid use") {
+    pipebb::recorder rec(path);
+    rec.add(p_rail, "p_rail", "bar");
+    feed(0);
+    rec();
+    REQUIRE_THROWS_AS(rec.add(high, "high"), std::runtime_error);
+    rec.close();
+    REQUIRE_THROWS_AS(rec.add(high, "high"), std::runtime_error);
+
+    pipebb::recorder unwritable("pipebb_missing/recorder.rec");
+    unwritable.add(p_rail, "p_rail");
+    REQUIRE_THROWS_AS(unwritable(), std::runtime_error);
+  }
+
+  std::remove(path.c_str());
+}
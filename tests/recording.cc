@@ -0,0 +1,193 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "recording.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template void pipebb::recording_writer::add<double>(
+  const pipebb::channel<double> &, pipebb::span<const double>);
+template pipebb::span<const double>
+  pipebb::recording::data<double>(std::size_t) const;
+template void pipebb::replay::bind<double>(pipebb::channel<double> &);
+//
+
+
+namespace {
+
+const std::string path = "pipebb_recording_test.rec";
+
+}  // namespace
+
+
+TEST_CASE("functionality of recordings", "[recording]") {
+  pipebb::channel<double>       p_rail{"p_rail", "bar", 0.5, 1.0};
+  pipebb::channel<std::int32_t> n_eng{"n_eng", "rpm", 2, 0};
+  pipebb::channel<bool>         b_on{"b_on"};
+
+  std::vector<double>       p_data;
+  std::vector<std::int32_t> n_data;
+  std::vector<char>         b_bytes;
+  for (int i = 0; i < 1000; ++i) {
+    p_data.push_back(0.25 * i);
+    n_data.push_back(800 + i % 37);
+    b_bytes.push_back(i % 3 == 0);
+  }
+  bool b_data[1000];
+  for (std::size_t i = 0; i < 1000; ++i) { b_data[i] = b_bytes[i]; }
+
+  pipebb::recording_writer writer;
+  writer.add(p_rail, p_data);
+  writer.add(n_eng, n_data);
+  writer.add(b_on, b_data);
+  REQUIRE(writer.size() == 1000);
+  REQUIRE(writer.columns() == 3);
+  writer.write(path);
+
+  SECTION("header and column data") {
+    pipebb::recording rec(path);
+    REQUIRE(rec.size() == 1000);
+    REQUIRE(rec.columns() == 3);
+
+    REQUIRE(rec.index("n_eng") == 1);
+    const auto & desc = rec.column(0);
+    REQUIRE(desc.name == "p_rail");
+    REQUIRE(desc.unit == "bar");
+    REQUIRE(desc.factor == 0.5);
+    REQUIRE(desc.offset == 1.0);
+    REQUIRE(desc.type == pipebb::sample_type::float64);
+    REQUIRE(rec.column(1).type == pipebb::sample_type::int32);
+    REQUIRE(rec.column(2).type == pipebb::sample_type::boolean);
+
+    auto p = rec.data<double>(0);
+    auto n = rec.data<std::int32_t>(1);
+    auto b = rec.data<bool>(2);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(p.data()) % 64 == 0);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(n.data()) % 64 == 0);
+    for (std::size_t i = 0; i < 1000; ++i) {
+      REQUIRE(p[i] == p_data[i]);
+      REQUIRE(n[i] == n_data[i]);
+      REQUIRE(b[i] == b_data[i]);
+    }
+
+    auto ch = rec.make_channel<double>(0);
+    REQUIRE(ch.name() == "p_rail");
+    REQUIRE(ch.unit() == "bar");
+    REQUIRE(ch.factor() == 0.5);
+    REQUIRE(ch.offset() == 1.0);
+    REQUIRE(rec.make_channel<bool>(2).name() == "b_on");
+
+    REQUIRE_THROWS_AS(rec.index("t_oil"), std::runtime_error);
+    REQUIRE_THROWS_AS(rec.data<float>(0), std::runtime_error);
+    REQUIRE_THROWS_AS(rec.make_channel<std::int64_t>(1), std::runtime_error);
+
+    REQUIRE_THROWS_AS(rec.column(3), std::out_of_range);
+    REQUIRE_THROWS_AS(rec.data<double>(3), std::out_of_range);
+    REQUIRE_THROWS_AS(rec.make_channel<double>(3), std::out_of_range);
+
+    pipebb::replay source(rec);
+    REQUIRE_THROWS_AS(source.bind(p_rail, 3), std::out_of_range);
+  }
+
+  SECTION("replay sample by sample") {
+    pipebb::recording rec(path);
+    pipebb::replay    source(rec);
+    source.bind(p_rail);
+    source.bind(n_eng);
+    source.bind(b_on);
+
+    std::size_t i = 0;
+    while (source.step()) {
+      REQUIRE(p_rail() == (p_data[i] + 1.0) * 0.5);
+      REQUIRE(n_eng() == n_data[i] * 2);
+      REQUIRE(b_on() == b_data[i]);
+      ++i;
+    }
+    REQUIRE(i == 1000);
+    REQUIRE(source.position() == 1000);
+    REQUIRE_FALSE(source.step());
+
+    source.rewind();
+    REQUIRE(source.step());
+    REQUIRE(p_rail() == 0.5);
+  }
+
+  SECTION("replay block by block") {
+    pipebb::recording rec(path);
+    pipebb::replay    source(rec, 64);
+    source.bind(p_rail);
+    source.bind(n_eng);
+
+    std::vector<double>       p_out(64);
+    std::vector<std::int32_t> n_out(64);
+    std::size_t               total = 0;
+    while (std::size_t count = source.next()) {
+      auto p = source.block(p_rail);
+      auto n = source.block(n_eng);
+      REQUIRE(p.size() == count);
+      REQUIRE(p.data() == rec.data<double>(0).data() + total);
+
+      p_rail.process(p, pipebb::make_span(p_out));
+      n_eng.process(n, pipebb::make_span(n_out));
+      for (std::size_t i = 0; i < count; ++i) {
+        REQUIRE(p_out[i] == (p_data[total + i] + 1.0) * 0.5);
+        REQUIRE(n_out[i] == n_data[total + i] * 2);
+      }
+      total += count;
+      REQUIRE(p_rail() == (p_data[total - 1] + 1.0) * 0.5);
+    }
+    REQUIRE(total == 1000);
+    REQUIRE(source.next() == 0);
+    REQUIRE_THROWS_AS(source.block(b_on), std::runtime_error);
+  }
+
+  SECTION("invalid input") {
+    std::vector<double> short_data(10);
+    pipebb::channel<double> t_oil{"t_oil"};
+    REQUIRE_THROWS_AS(writer.add(t_oil, short_data), std::runtime_error);
+    REQUIRE_THROWS_AS(writer.add(p_rail, p_data), std::runtime_error);
+
+    REQUIRE_THROWS_AS(pipebb::recording("pipebb_missing.rec"),
+                      std::runtime_error);
+
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file << "PIPEBBRC";
+    }
+    REQUIRE_THROWS_AS(pipebb::recording(path), std::runtime_error);
+
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file << "not a recording at all, but long enough for a header";
+    }
+    REQUIRE_THROWS_AS(pipebb::recording(path), std::runtime_error);
+  }
+
+  std::remove(path.c_str());
+}
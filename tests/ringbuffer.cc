@@ -16,6 +16,8 @@
 
 #include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <vector>
 
 #include "catch.h"
 
@@ -80,4 +82,139 @@ TEST_CASE("basic functionality of ringbuffer container",
     std::for_each(
       buf.begin(), buf.end(), [](auto element) { REQUIRE((element == 42)); });
   }
+
+  SECTION("deque operations") {
+    for (int i = 0; i < RBSIZE + 3; ++i) { buf << i; }
+
+    buf.pop_front();
+    REQUIRE(buf.front() == 4);
+    REQUIRE(buf.size() == RBSIZE - 1);
+
+    buf.pop_back();
+    REQUIRE(buf.back() == RBSIZE + 1);
+    REQUIRE(*(buf.end()) == int());
+    REQUIRE(buf.size() == RBSIZE - 2);
+
+    buf << 99;
+    REQUIRE(buf.back() == 99);
+    REQUIRE(buf.front() == 4);
+
+    while (buf.size() > 1) { buf.pop_back(); }
+    REQUIRE(buf.front() == 4);
+    REQUIRE(buf.back() == 4);
+
+    buf.pop_front();
+    REQUIRE(buf.empty());
+    REQUIRE(buf.begin() == buf.end());
+  }
+}
+
+
+TEST_CASE("masked indexing policy of ringbuffer container",
+          "[ringbuffer_masked]") {
+  pipebb::ringbuffer<int, RBSIZE>        buf;
+  pipebb::masked_ringbuffer<int, RBSIZE> mbuf;
+
+  SECTION("layout") {
+    REQUIRE(buf.raw().size() == RBSIZE + 1);
+    REQUIRE(mbuf.raw().size() == 32);
+    REQUIRE(mbuf.max_size() == RBSIZE);
+
+    pipebb::masked_ringbuffer<int, 15> tight;
+    REQUIRE(tight.raw().size() == 16);
+  }
+
+  SECTION("same semantics as modulo indexing") {
+    for (int i = 0; i < 5 * RBSIZE + 3; ++i) {
+      buf << i;
+      mbuf << i;
+
+      REQUIRE(mbuf.size() == buf.size());
+      REQUIRE(mbuf.front() == buf.front());
+      REQUIRE(mbuf.back() == buf.back());
+      REQUIRE(*(mbuf.end()) == int());
+      REQUIRE(std::equal(mbuf.begin(), mbuf.end(), buf.begin(), buf.end()));
+      REQUIRE(
+        std::equal(mbuf.rbegin(), mbuf.rend(), buf.rbegin(), buf.rend()));
+
+      for (std::size_t j = 0; j < buf.size(); ++j) {
+        REQUIRE(mbuf[j] == buf[j]);
+      }
+    }
+
+    mbuf.fill(42);
+    REQUIRE(mbuf.size() == RBSIZE);
+    std::for_each(mbuf.begin(), mbuf.end(), [](auto element) {
+      REQUIRE((element == 42));
+    });
+  }
+}
+
+
+template <class B>
+void check_bulk_operations() {
+  B           buf;
+  std::size_t cap = buf.max_size();
+
+  std::vector<int> ref;
+  std::vector<int> block(3 * cap);
+  std::iota(block.begin(), block.end(), 1);
+
+  auto content = [&buf] {
+    std::vector<int> out;
+    for (auto & seg : buf.segments()) {
+      out.insert(out.end(), seg.begin(), seg.end());
+    }
+    return out;
+  };
+
+  auto push_ref = [&ref, cap](const int * values, std::size_t count) {
+    ref.insert(ref.end(), values, values + count);
+    if (ref.size() > cap) { ref.erase(ref.begin(), ref.end() - cap); }
+  };
+
+  // push blocks of varying size, wrapping around repeatedly
+  for (std::size_t count : {1, 3, 7, 2, 16, 5, 0, 11, 40, 9, 6}) {
+    buf.push_n(block.data(), count);
+    push_ref(block.data(), count);
+
+    REQUIRE(buf.size() == ref.size());
+    REQUIRE(content() == ref);
+    REQUIRE(std::equal(buf.begin(), buf.end(), ref.begin(), ref.end()));
+    REQUIRE(*(buf.end()) == int());
+  }
+
+  // pop from the front, then keep pushing single values
+  int out[5];
+  REQUIRE(buf.pop_n(out, 5) == 5);
+  REQUIRE(std::equal(out, out + 5, ref.begin()));
+  ref.erase(ref.begin(), ref.begin() + 5);
+  REQUIRE(content() == ref);
+
+  REQUIRE(buf.pop_n(nullptr, 2) == 2);
+  ref.erase(ref.begin(), ref.begin() + 2);
+
+  for (int i = 100; i < 130; ++i) {
+    buf << i;
+    push_ref(&i, 1);
+    REQUIRE(content() == ref);
+    REQUIRE(buf.front() == ref.front());
+    REQUIRE(buf.back() == ref.back());
+  }
+
+  REQUIRE(buf.pop_n(out, 5 * cap) == cap);
+  REQUIRE(buf.empty());
+  REQUIRE(buf.segments()[0].empty());
+  REQUIRE(buf.segments()[1].empty());
+}
+
+
+TEST_CASE("bulk operations of ringbuffer container", "[ringbuffer_bulk]") {
+  SECTION("modulo indexing") {
+    check_bulk_operations<pipebb::ringbuffer<int, RBSIZE>>();
+  }
+
+  SECTION("masked indexing") {
+    check_bulk_operations<pipebb::masked_ringbuffer<int, RBSIZE>>();
+  }
 }
@@ -0,0 +1,177 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "catch.h"
+
+#include "accumulator.h"
+#include "approximate.h"
+#include "channel.h"
+#include "counter.h"
+#include "factor.h"
+#include "gradient.h"
+#include "inverter.h"
+#include "logical.h"
+#include "moving_average.h"
+#include "node.h"
+#include "offset.h"
+#include "runtime_graph.h"
+#include "threshold.h"
+
+
+namespace {
+
+const char * description = R"(
+  # nodes in no particular order
+  duration = boolean_counter(boost)
+  boost    = and(high, rising, not_low)
+  high     = threshold(smoothed, 0.5)
+  smoothed = moving_average(scaled, 8)
+  scaled   = factor(p_boost, 0.001)
+  p_boost  = channel(unit=mbar, factor=2, offset=-100)
+
+  slope    = gradient(p_boost)
+  rising   = threshold(slope, 0)
+  low      = threshold(negated, -10)
+  negated  = inverter(shifted)
+  shifted  = offset(p_boost, 5)
+  not_low  = not(low)
+
+  total    = accumulator(p_ref, 4, use_zeros=0)
+  p_ref    = channel()
+  close    = approximate(p_boost, p_ref, 50)
+  apart    = reset_counter(close)
+  any      = or(close, high)
+)";
+
+
+double sample(int t) { return 400.0 + 300.0 * std::sin(0.3 * t); }
+
+}  // namespace
+
+
+TEST_CASE("functionality of the runtime_graph", "[runtime_graph]") {
+  using channel_t = pipebb::channel<double>;
+
+  SECTION("matches the template graph") {
+    auto graph = pipebb::make_runtime_graph(description);
+    REQUIRE(graph.size() == 17);
+
+    channel_t p_boost{"p_boost", "mbar", 2.0, -100.0};
+    channel_t p_ref{"p_ref"};
+
+    auto scaled   = pipebb::make_factor(p_boost, 0.001);
+    auto smoothed = pipebb::make_moving_average<8>(scaled, true);
+    auto high     = pipebb::make_threshold(smoothed, 0.5);
+    auto slope    = pipebb::make_gradient(p_boost);
+    auto rising   = pipebb::make_threshold(slope, 0);
+    auto shifted  = pipebb::make_offset(p_boost, 5.0);
+    auto negated  = pipebb::make_inverter(shifted);
+    auto low      = pipebb::make_threshold(negated, -10.0);
+    auto not_low  = pipebb::make_not_gate(low);
+    auto boost    = pipebb::make_and_gate(high, rising, not_low);
+    auto duration = pipebb::make_boolean_counter(boost);
+    auto total    = pipebb::accumulator<channel_t, 4>{p_ref, false};
+    auto close    = pipebb::make_approximate(p_boost, p_ref, 50.0);
+    auto apart    = pipebb::make_reset_counter(close);
+    auto any      = pipebb::make_or_gate(close, high);
+
+    auto in_boost = graph.index("p_boost");
+    auto in_ref   = graph.index("p_ref");
+
+    for (int t = 0; t < 200; ++t) {
+      double ref = (t % 3) ? 0.0 : sample(t + 5);
+
+      p_boost << sample(t);
+      p_ref << ref;
+      graph.set(in_boost, sample(t));
+      graph.set(in_ref, ref);
+
+      // every template gate pulled once per tick, like the interpreter
+      pipebb::tick();
+      slope();
+      smoothed();
+
+      graph.run();
+
+      REQUIRE(graph.value("duration") == duration());
+      // same compensated window sums, so no rounding differences either
+      REQUIRE(graph.value("smoothed") == smoothed());
+      REQUIRE(graph.value("slope") == slope());
+      REQUIRE(graph.value("negated") == negated());
+      REQUIRE(graph.value("total") == total());
+      REQUIRE(graph.value("apart") == apart());
+      REQUIRE(graph.value("any") == any());
+    }
+
+    pipebb::reset_epoch();
+
+    graph.reset();
+    REQUIRE(graph.value("duration") == 0);
+    graph.set(in_ref, 7.0);
+    graph.run();
+    REQUIRE(graph.value("total") == 7.0);
+  }
+
+  SECTION("errors name the offending line") {
+    auto message = [](const std::string & text) -> std::string {
+      try {
+        pipebb::make_runtime_graph(text);
+      } catch (const std::runtime_error & e) {
+        return e.what();
+      }
+      return "";
+    };
+
+    REQUIRE(message("a = channel()\nb = frobnicate(a)") ==
+            "line 2: unknown kind 'frobnicate'");
+    REQUIRE(message("a = channel()\n\nb = factor(c, 2)") ==
+            "line 3: unknown node 'c'");
+    REQUIRE(message("a = factor(b, 2)\nb = factor(a, 2)") ==
+            "line 1: 'a' is part of a cycle");
+    REQUIRE(message("a = channel()\na = channel()") ==
+            "line 2: duplicate node 'a'");
+    REQUIRE(message("a = channel()\nb = factor(a)") ==
+            "line 2: wrong number of arguments for 'factor'");
+    REQUIRE(message("a = channel()\nb = factor(a, x2)") ==
+            "line 2: expected a number, got 'x2'");
+    REQUIRE(message("a = channel()\nb = and(a)") ==
+            "line 2: wrong number of arguments for 'and'");
+    REQUIRE(message("a = channel()\nb = moving_average(a, 2.5)") ==
+            "line 2: window must be a positive integer");
+    REQUIRE(message("channel()") ==
+            "line 1: expected 'name = kind(arguments)'");
+    REQUIRE(message("1a = channel()") == "line 1: invalid name '1a'");
+    REQUIRE(message("a = channel()\nb = moving_average(a, 4, use_zero=0)") ==
+            "line 2: unknown key 'use_zero' for 'moving_average'");
+    REQUIRE(message("a = channel(factr=2)") ==
+            "line 1: unknown key 'factr' for 'channel'");
+    REQUIRE(message("a = channel()\nb = factor(a, 2, factor=3)") ==
+            "line 2: unknown key 'factor' for 'factor'");
+    REQUIRE(message("a = channel(factor=2, offset=1, factor=3)") ==
+            "line 1: duplicate key 'factor'");
+    REQUIRE(message("a = channel(=2)") == "line 1: invalid key ''");
+
+    std::istringstream stream("a = channel()");
+    pipebb::runtime_graph graph{stream};
+    REQUIRE_THROWS_AS(graph.index("b"), std::runtime_error);
+  }
+}
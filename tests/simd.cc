@@ -0,0 +1,237 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "catch.h"
+
+#include "approximate.h"
+#include "channel.h"
+#include "factor.h"
+#include "simd.h"
+#include "threshold.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::threshold<pipebb::channel<float>>;
+template class pipebb::approximate<pipebb::channel<std::int32_t>,
+                                   pipebb::channel<std::int32_t>>;
+//
+
+
+namespace {
+
+// restores the detected instruction set when a test ends
+struct isa_guard
+{
+  ~isa_guard() { pipebb::simd::select_isa(pipebb::simd::detected_isa()); }
+};
+
+
+template <typename T>
+std::vector<T> make_data(std::size_t n, int seed) {
+  std::vector<T> data(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    data[i] = static_cast<T>(((i * 7919 + seed * 104729) % 2001)) - T(1000);
+  }
+  return data;
+}
+
+
+// the documented summation order of simd::dot
+template <typename T>
+T reference_dot(const std::vector<T> & a, const std::vector<T> & b) {
+  const std::size_t lanes = 64 / sizeof(T);
+  const std::size_t whole = a.size() / lanes * lanes;
+
+  std::vector<T> acc(lanes);
+  for (std::size_t i = 0; i < whole; ++i) { acc[i % lanes] += a[i] * b[i]; }
+  for (std::size_t half = lanes / 2; half > 0; half /= 2) {
+    for (std::size_t l = 0; l < half; ++l) { acc[l] += acc[l + half]; }
+  }
+  for (std::size_t i = whole; i < a.size(); ++i) { acc[0] += a[i] * b[i]; }
+  return acc[0];
+}
+
+
+// every kernel must match the scalar gates for all sizes around the vector
+// widths and the mask word size
+template <typename T>
+void check_kernels() {
+  const T factor = T(3), offset = T(-7), limit = T(11), tolerance = T(500);
+
+  for (std::size_t n : {0, 1, 3, 7, 15, 16, 17, 63, 64, 65, 130, 1000}) {
+    auto in    = make_data<T>(n, 1);
+    auto other = make_data<T>(n, 2);
+
+    std::vector<T>             out(n);
+    std::vector<std::uint64_t> mask(pipebb::simd::mask_words(n), ~0ull);
+
+    pipebb::simd::scale(in.data(), factor, out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) { REQUIRE(out[i] == in[i] * factor); }
+
+    pipebb::simd::shift(in.data(), offset, out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) { REQUIRE(out[i] == in[i] + offset); }
+
+    pipebb::simd::negate(in.data(), out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) { REQUIRE(out[i] == -in[i]); }
+
+    pipebb::simd::affine(in.data(), factor, offset, out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      REQUIRE(out[i] == in[i] * factor + offset);
+    }
+
+    pipebb::simd::pass_greater(in.data(), limit, out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      REQUIRE(out[i] == (in[i] > limit ? in[i] : T{}));
+    }
+
+    pipebb::simd::greater(in.data(), limit, mask.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      REQUIRE(pipebb::simd::test(mask.data(), i) == (in[i] > limit));
+    }
+    if (n % 64) { REQUIRE((mask.back() >> (n % 64)) == 0); }
+
+    pipebb::simd::within(
+      in.data(), other.data(), tolerance, mask.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      T distance = in[i] > other[i] ? in[i] - other[i] : other[i] - in[i];
+      REQUIRE(pipebb::simd::test(mask.data(), i) == (distance <= tolerance));
+    }
+
+    pipebb::simd::affine_greater(
+      in.data(), factor, offset, limit, mask.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      REQUIRE(pipebb::simd::test(mask.data(), i) ==
+              (in[i] * factor + offset > limit));
+    }
+
+    // scaled down so that float products and sums get rounded
+    for (auto & x : out) { x = T(1) + (&x - out.data()) % 5; }
+    for (auto & x : in) { x = x / T(7); }
+    REQUIRE(pipebb::simd::dot(in.data(), out.data(), n) ==
+            reference_dot(in, out));
+  }
+}
+
+
+template <typename T>
+void check_all_isas() {
+  isa_guard guard;
+
+  for (auto isa : {pipebb::simd::isa::scalar,
+                   pipebb::simd::isa::avx2,
+                   pipebb::simd::isa::avx512}) {
+    if (pipebb::simd::select_isa(isa) != isa) { continue; }
+    check_kernels<T>();
+  }
+}
+
+}  // namespace
+
+
+TEST_CASE("simd kernels match the scalar gates", "[simd]") {
+  SECTION("instruction set selection") {
+    isa_guard guard;
+
+    REQUIRE(pipebb::simd::active_isa() == pipebb::simd::detected_isa());
+    REQUIRE(pipebb::simd::select_isa(pipebb::simd::isa::scalar) ==
+            pipebb::simd::isa::scalar);
+    REQUIRE(pipebb::simd::select_isa(pipebb::simd::isa::avx512) ==
+            pipebb::simd::detected_isa());
+  }
+
+  SECTION("float") { check_all_isas<float>(); }
+  SECTION("double") { check_all_isas<double>(); }
+  SECTION("int32") { check_all_isas<std::int32_t>(); }
+  SECTION("int64") { check_all_isas<std::int64_t>(); }
+  SECTION("other types use the scalar kernels") {
+    check_all_isas<unsigned>();
+  }
+
+  SECTION("floating point edge cases") {
+    isa_guard guard;
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<double>        in(64, 0.0), out(64);
+    std::vector<std::uint64_t> mask(1);
+    in[3] = nan;
+    in[5] = -0.0;
+
+    for (auto isa : {pipebb::simd::isa::scalar,
+                     pipebb::simd::isa::avx2,
+                     pipebb::simd::isa::avx512}) {
+      if (pipebb::simd::select_isa(isa) != isa) { continue; }
+
+      pipebb::simd::greater(in.data(), -1.0, mask.data(), in.size());
+      REQUIRE(mask[0] == ~(1ull << 3));
+
+      pipebb::simd::within(in.data(), in.data(), 0.0, mask.data(), in.size());
+      REQUIRE(mask[0] == ~(1ull << 3));
+
+      pipebb::simd::negate(in.data(), out.data(), in.size());
+      REQUIRE(std::signbit(out[0]));
+      REQUIRE(!std::signbit(out[5]));
+    }
+  }
+}
+
+
+TEST_CASE("gates with bitmask output", "[simd]") {
+  SECTION("threshold") {
+    pipebb::channel<float>             T_oil{"T_oil", "deg", 1.0f, 0.0f};
+    pipebb::threshold<decltype(T_oil)> hot{T_oil, 120.0f};
+
+    auto in = make_data<float>(100, 3);
+
+    std::vector<std::uint64_t> mask(2);
+
+    REQUIRE(hot.process(in, mask) == 100);
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      T_oil << in[i];
+      REQUIRE(pipebb::simd::test(mask.data(), i) == hot());
+    }
+  }
+
+  SECTION("approximate") {
+    pipebb::channel<std::int32_t> n_0{"n_0", "rpm", 1, 0};
+    pipebb::channel<std::int32_t> n_1{"n_1", "rpm", 1, 0};
+
+    auto approx = pipebb::make_approximate(n_0, n_1, 100);
+
+    auto first  = make_data<std::int32_t>(70, 4);
+    auto second = make_data<std::int32_t>(70, 5);
+
+    std::vector<std::uint64_t> mask(1);
+
+    REQUIRE(approx.process(first, second, mask) == 64);
+
+    for (std::size_t i = 0; i < 64; ++i) {
+      n_0 << first[i];
+      n_1 << second[i];
+      REQUIRE(pipebb::simd::test(mask.data(), i) == approx());
+    }
+  }
+}
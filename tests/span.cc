@@ -0,0 +1,78 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <array>
+#include <numeric>
+#include <vector>
+
+#include "catch.h"
+
+#include "span.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::span<double>;
+template class pipebb::span<const double>;
+//
+
+
+TEST_CASE("functionality of span", "[span]") {
+  std::vector<double> vec{1.0, 2.0, 3.0, 4.0};
+
+  SECTION("constructors") {
+    pipebb::span<double> empty;
+    REQUIRE(empty.empty());
+    REQUIRE(empty.data() == nullptr);
+
+    pipebb::span<double> from_vec{vec};
+    REQUIRE(from_vec.size() == 4);
+    REQUIRE(from_vec.data() == vec.data());
+
+    pipebb::span<const double> to_const{from_vec};
+    REQUIRE(to_const.data() == vec.data());
+
+    std::array<int, 3> arr{{1, 2, 3}};
+    auto               from_arr = pipebb::make_span(arr);
+    REQUIRE(from_arr.size() == 3);
+
+    int  c_arr[5] = {};
+    auto from_c   = pipebb::span<int>{c_arr};
+    REQUIRE(from_c.size() == 5);
+  }
+
+  SECTION("access and subviews") {
+    auto view = pipebb::make_span(vec.data(), vec.size());
+
+    REQUIRE(view.front() == 1.0);
+    REQUIRE(view.back() == 4.0);
+    REQUIRE(std::accumulate(view.begin(), view.end(), 0.0) == 10.0);
+
+    view[1] = 5.0;
+    REQUIRE(vec[1] == 5.0);
+
+    REQUIRE(view.first(2).size() == 2);
+    REQUIRE(view.last(1).front() == 4.0);
+    REQUIRE(view.subspan(1, 2).front() == 5.0);
+    REQUIRE(view.subspan(1, 2).back() == 3.0);
+
+    pipebb::span<const double> read_only = view.first(2);
+    REQUIRE(read_only.size() == 2);
+    REQUIRE(read_only.data() == vec.data());
+  }
+}
@@ -0,0 +1,144 @@
+//
+// Copyright 2018- Florian Eich <florian.eich@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "catch.h"
+
+#include "channel.h"
+#include "spsc_ringbuffer.h"
+
+
+//
+// explicitly instantiate class to make sure compiler generates the class fully
+// (enables meaningful test coverage analysis)
+//
+template class pipebb::spsc_ringbuffer<double, 16>;
+template class pipebb::queue_source<double, 16>;
+//
+
+
+TEST_CASE("functionality of the spsc_ringbuffer", "[spsc_ringbuffer]") {
+  SECTION("single threaded") {
+    pipebb::spsc_ringbuffer<int, 5> queue;
+
+    REQUIRE(queue.empty());
+    REQUIRE(queue.max_size() == 5);
+
+    for (int i = 0; i < 5; ++i) { REQUIRE(queue.try_push(i)); }
+    REQUIRE(!queue.try_push(5));
+    REQUIRE(queue.size() == 5);
+
+    int value;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(queue.try_push(5));
+
+    int values[8];
+    REQUIRE(queue.try_pop_n(values, 8) == 5);
+    for (int i = 0; i < 5; ++i) { REQUIRE(values[i] == i + 1); }
+
+    REQUIRE(!queue.try_pop(value));
+  }
+
+  SECTION("batches wrapping around") {
+    pipebb::spsc_ringbuffer<int, 7> queue;
+
+    int in[5];
+    int out[5];
+    int next = 0;
+
+    for (int round = 0; round < 20; ++round) {
+      for (int & v : in) { v = next++; }
+
+      REQUIRE(queue.try_push_n(in, 5) == 5);
+      REQUIRE(queue.try_push_n(in, 5) == 2);
+      REQUIRE(queue.try_pop_n(out, 5) == 5);
+      for (int i = 0; i < 5; ++i) { REQUIRE(out[i] == in[i]); }
+      REQUIRE(queue.try_pop_n(out, 5) == 2);
+      REQUIRE(out[0] == in[0]);
+      REQUIRE(out[1] == in[1]);
+    }
+  }
+
+  SECTION("producer and consumer thread") {
+    pipebb::spsc_ringbuffer<std::uint64_t, 64> queue;
+
+    constexpr std::uint64_t count = 200000;
+
+    std::thread producer{[&queue] {
+      std::uint64_t next = 0;
+      std::uint64_t batch[3];
+      while (next < count) {
+        std::size_t n = 0;
+        for (; n < 3 && next + n < count; ++n) { batch[n] = next + n; }
+        std::size_t pushed = queue.try_push_n(batch, n);
+        if (!pushed) { std::this_thread::yield(); }
+        next += pushed;
+      }
+    }};
+
+    std::uint64_t expected = 0;
+    bool          in_order = true;
+    while (expected < count) {
+      std::uint64_t value;
+      if (queue.try_pop(value)) {
+        in_order &= (value == expected++);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(queue.empty());
+  }
+}
+
+
+TEST_CASE("functionality of the queue_source gate", "[queue_source]") {
+  pipebb::channel<double>               p_rail{"p_rail", "bar", 2.0, 0.0};
+  pipebb::spsc_ringbuffer<double, 1024> queue;
+
+  auto source = pipebb::make_queue_source(p_rail, queue);
+
+  SECTION("drain") {
+    for (int i = 1; i <= 200; ++i) { queue.try_push(i); }
+
+    REQUIRE(source.drain() == 200);
+    REQUIRE(queue.empty());
+    REQUIRE(p_rail() == 400.0);
+
+    REQUIRE(source() == 400.0);
+
+    queue.try_push(7.0);
+    REQUIRE(source() == 14.0);
+  }
+
+  SECTION("step") {
+    queue.try_push(1.0);
+    queue.try_push(2.0);
+
+    REQUIRE(source.step());
+    REQUIRE(p_rail() == 2.0);
+    REQUIRE(source.step());
+    REQUIRE(p_rail() == 4.0);
+    REQUIRE(!source.step());
+  }
+}
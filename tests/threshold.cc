@@ -39,4 +39,19 @@ TEST_CASE("functionality of threshold gates", "[threshold]") {
     n_rpm << 3200;
     REQUIRE(thresh());
   }
+
+
+  SECTION("block processing") {
+    pipebb::channel<unsigned>          n_rpm{"n_rpm", "unit", 1, 0};
+    pipebb::threshold<decltype(n_rpm)> thresh{n_rpm, 3000};
+
+    unsigned in[] = {2500, 3000, 3001, 0};
+    bool     out[4];
+
+    REQUIRE(thresh.process(in, out) == 4);
+    REQUIRE(!out[0]);
+    REQUIRE(!out[1]);
+    REQUIRE(out[2]);
+    REQUIRE(!out[3]);
+  }
 }